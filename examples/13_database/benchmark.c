@@ -0,0 +1,752 @@
+// Copyright 2025 Vladislav Aleinik
+#include <string.h>
+#include <time.h>
+
+#include "database.h"
+#include "utils.h"
+
+// Количество запросов на поиск для каждого размера базы данных.
+#define NUM_SEARCHES 4000000U
+
+// Размеры баз данных для измерений.
+#define NUM_SIZES 3U
+const uint32_t DB_SIZES[NUM_SIZES] = {1000000U, 10000000U, 100000000U};
+
+// Наибольший размер базы данных по умолчанию: 100 млн записей требуют нескольких гигабайт памяти.
+#define DEFAULT_MAX_SIZE 10000000U
+
+// Размер пакета при заполнении базы данных для измерения скорости сохранения.
+#define FILL_BATCH_SIZE 65536U
+
+// Количество потоков-читателей для измерения масштабируемости поиска.
+#define NUM_THREAD_COUNTS 4U
+const uint32_t THREAD_COUNTS[NUM_THREAD_COUNTS] = {1U, 2U, 4U, 8U};
+
+// Количество вставок случайных ключей для измерения масштабируемости вставки.
+#define NUM_SHARDED_INSERTS 50000U
+// Количество бит номера сегмента сегментированной базы данных.
+#define BENCHMARK_SHARD_BITS 4U
+
+// Размер базы данных и количество циклов вставки-удаления для измерения политик ёмкости.
+#define CHURN_BASE_SIZE 250000U
+#define NUM_CHURN_CYCLES 20U
+
+// Имя файла для измерения скорости сохранения базы данных.
+const char* DUMP_FILENAME = "res/benchmark.db";
+
+// Размер базы данных для измерения степени сжатия блочного формата.
+#define COMPRESSION_SIZE 50000000U
+// Количество запросов на поиск в файле блочного формата.
+#define NUM_FILE_SEARCHES 100000U
+// Имя файла в блочном формате.
+const char* BLOCKS_FILENAME = "res/benchmark-blocks.db";
+
+// Значения базы данных для измерения степени сжатия.
+#define NUM_HOSTNAMES 8U
+const char* HOSTNAMES[NUM_HOSTNAMES] =
+{
+    "avacado", "potato", "grape", "lemon", "apple", "banana", "tomato", "melon"
+};
+
+//==================================================================================================
+// Функция: time_now
+// Назначение: Возвращает текущее время в секундах.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// отсутствуют.
+//
+// Возвращаемое значение:
+// Время по монотонным часам.
+//==================================================================================================
+double time_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+//==================================================================================================
+// Функция: measure_search
+// Назначение: Измеряет среднее время поиска одного ключа в базе данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db   (in) - указатель на базу данных.
+// keys (in) - массив из NUM_SEARCHES ключей для поиска.
+//
+// Возвращаемое значение:
+// Среднее время поиска в наносекундах.
+//==================================================================================================
+double measure_search(const struct Database* db, const uint32_t* keys)
+{
+    // Контрольная сумма - защита от удаления цикла компилятором.
+    uint32_t checksum = 0U;
+
+    // Начало измеряемого отрезка времени.
+    double start = time_now();
+
+    for (uint32_t i = 0U; i < NUM_SEARCHES; ++i)
+    {
+        char value[VALUE_SIZE];
+        uint32_t index;
+        bool found = db_search(db, keys[i], value, &index);
+
+        checksum += found? index : 0U;
+    }
+
+    // Конец измеряемого отрезка времени.
+    double end = time_now();
+
+    verify_contract(checksum != 0U, "Unexpected search results\n");
+
+    return 1e9 * (end - start) / NUM_SEARCHES;
+}
+
+//==================================================================================================
+// Функция: measure_build
+// Назначение: Измеряет время построения базы данных из неупорядоченного набора ключей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// size (in) - количество ключей.
+//
+// Возвращаемое значение:
+// Время построения в секундах.
+//==================================================================================================
+double measure_build(uint32_t size)
+{
+    // Набор случайных ключей и значений.
+    uint32_t* keys = calloc(size, sizeof(uint32_t));
+    char (*values)[VALUE_SIZE] = calloc(size, VALUE_SIZE);
+    verify_contract(keys != NULL && values != NULL, "Unable to allocate memory\n");
+
+    for (uint32_t i = 0U; i < size; ++i)
+    {
+        keys[i] = (uint32_t) rand() * 2U + (rand() & 1U);
+    }
+
+    // Начало измеряемого отрезка времени.
+    double start = time_now();
+
+    struct Database db;
+    db_build_from_unsorted(&db, keys, values, size);
+
+    // Конец измеряемого отрезка времени.
+    double end = time_now();
+
+    db_free(&db);
+    free(keys);
+    free(values);
+
+    return end - start;
+}
+
+//==================================================================================================
+// Функция: dump_per_entry
+// Назначение: Сохраняет базу данных в файл двумя вызовами fwrite на запись
+//             (исходная реализация db_dump_to_file, точка отсчёта для сравнения).
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db       (in) - указатель на базу данных.
+// filename (in) - имя файла для сохранения данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void dump_per_entry(const struct Database* db, const char* filename)
+{
+    FILE* file = fopen(filename, "wb+");
+    verify_contract(file != NULL, "Unable to open file \'%s\'\n", filename);
+
+    uint32_t magics[2] = {my_htobe32(MAGIC0), my_htobe32(MAGIC1)};
+    fwrite(magics, sizeof(MAGIC0), 2, file);
+
+    for (uint32_t i = 0U; i < db->size; ++i)
+    {
+        uint32_t key = my_htobe32(db->entries[i].key);
+
+        fwrite(&key, sizeof(uint32_t), 1U, file);
+        fwrite(db->entries[i].value, 1U, VALUE_SIZE, file);
+    }
+
+    fclose(file);
+}
+
+//==================================================================================================
+// Функция: measure_dump
+// Назначение: Измеряет скорость сохранения базы данных в файл.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db   (in) - указатель на базу данных.
+// dump (in) - функция сохранения базы данных.
+//
+// Возвращаемое значение:
+// Скорость сохранения в мегабайтах в секунду.
+//==================================================================================================
+double measure_dump(const struct Database* db, void (*dump)(const struct Database*, const char*))
+{
+    // Начало измеряемого отрезка времени.
+    double start = time_now();
+
+    dump(db, DUMP_FILENAME);
+
+    // Конец измеряемого отрезка времени.
+    double end = time_now();
+
+    unlink(DUMP_FILENAME);
+
+    return 1e-6 * (DB_HEADER_SIZE + (double) db->size * sizeof(Entry_t)) / (end - start);
+}
+
+// Аргументы потока-читателя.
+struct ReaderArgs
+{
+    // База данных для поиска.
+    const struct Database* db;
+    // Ключи для поиска.
+    const uint32_t* keys;
+    // Количество запросов на поиск.
+    uint32_t num_searches;
+    // Блокировка, которой защищается поиск (NULL для поиска в режиме одновременного доступа).
+    pthread_mutex_t* lock;
+};
+
+//==================================================================================================
+// Функция: reader_thread
+// Назначение: Поток, выполняющий запросы на поиск.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// arg (in) - указатель на struct ReaderArgs.
+//
+// Возвращаемое значение:
+// NULL.
+//==================================================================================================
+void* reader_thread(void* arg)
+{
+    const struct ReaderArgs* args = arg;
+
+    // Контрольная сумма - защита от удаления цикла компилятором.
+    uint32_t checksum = 0U;
+
+    for (uint32_t i = 0U; i < args->num_searches; ++i)
+    {
+        char value[VALUE_SIZE];
+        uint32_t index;
+        bool found;
+
+        if (args->lock != NULL)
+        {
+            pthread_mutex_lock(args->lock);
+            found = db_search(args->db, args->keys[i], value, &index);
+            pthread_mutex_unlock(args->lock);
+        }
+        else
+        {
+            found = db_search_concurrent(args->db, args->keys[i], value, &index);
+        }
+
+        checksum += found? index : 0U;
+    }
+
+    verify_contract(checksum != 0U, "Unexpected search results\n");
+
+    return NULL;
+}
+
+//==================================================================================================
+// Функция: measure_readers
+// Назначение: Измеряет суммарную пропускную способность поиска несколькими потоками.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db          (in) - указатель на базу данных.
+// keys        (in) - массив из NUM_SEARCHES ключей для поиска.
+// num_threads (in) - количество потоков-читателей.
+// lock        (in) - блокировка, которой защищается поиск (NULL для db_search_concurrent).
+//
+// Возвращаемое значение:
+// Количество запросов на поиск в секунду, миллионов.
+//==================================================================================================
+double measure_readers(const struct Database* db, const uint32_t* keys, uint32_t num_threads,
+                       pthread_mutex_t* lock)
+{
+    pthread_t threads[num_threads];
+    struct ReaderArgs args[num_threads];
+
+    // Начало измеряемого отрезка времени.
+    double start = time_now();
+
+    for (uint32_t thread_i = 0U; thread_i < num_threads; ++thread_i)
+    {
+        args[thread_i] = (struct ReaderArgs) {
+            .db           = db,
+            .keys         = keys,
+            .num_searches = NUM_SEARCHES,
+            .lock         = lock
+        };
+
+        int ret = pthread_create(&threads[thread_i], NULL, reader_thread, &args[thread_i]);
+        verify_contract(ret == 0, "Unable to create thread\n");
+    }
+
+    for (uint32_t thread_i = 0U; thread_i < num_threads; ++thread_i)
+    {
+        pthread_join(threads[thread_i], NULL);
+    }
+
+    // Конец измеряемого отрезка времени.
+    double end = time_now();
+
+    return 1e-6 * num_threads * NUM_SEARCHES / (end - start);
+}
+
+// Аргументы потока-писателя.
+struct WriterArgs
+{
+    // База данных, защищаемая блокировкой lock (если sdb равна NULL).
+    struct Database* db;
+    pthread_mutex_t* lock;
+    // Сегментированная база данных.
+    struct ShardedDatabase* sdb;
+    // Ключи для вставки.
+    const uint32_t* keys;
+    // Количество вставок.
+    uint32_t num_inserts;
+};
+
+//==================================================================================================
+// Функция: writer_thread
+// Назначение: Поток, выполняющий вставки.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// arg (in) - указатель на struct WriterArgs.
+//
+// Возвращаемое значение:
+// NULL.
+//==================================================================================================
+void* writer_thread(void* arg)
+{
+    const struct WriterArgs* args = arg;
+
+    char value[VALUE_SIZE] = {};
+
+    for (uint32_t i = 0U; i < args->num_inserts; ++i)
+    {
+        if (args->sdb != NULL)
+        {
+            sdb_insert(args->sdb, args->keys[i], value);
+        }
+        else
+        {
+            pthread_mutex_lock(args->lock);
+            db_insert(args->db, args->keys[i], value);
+            pthread_mutex_unlock(args->lock);
+        }
+    }
+
+    return NULL;
+}
+
+//==================================================================================================
+// Функция: measure_writers
+// Назначение: Измеряет суммарную пропускную способность вставки несколькими потоками.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// num_threads (in) - количество потоков-писателей.
+// sharded     (in) - вставлять в сегментированную базу данных (иначе - в одну под блокировкой).
+//
+// Возвращаемое значение:
+// Количество вставок в секунду, тысяч.
+//==================================================================================================
+double measure_writers(uint32_t num_threads, bool sharded)
+{
+    uint32_t* keys = calloc(NUM_SHARDED_INSERTS, sizeof(uint32_t));
+    verify_contract(keys != NULL, "Unable to allocate memory\n");
+
+    for (uint32_t i = 0U; i < NUM_SHARDED_INSERTS; ++i)
+    {
+        keys[i] = (uint32_t) rand() * 2654435761U;
+    }
+
+    struct Database db;
+    pthread_mutex_t lock;
+    struct ShardedDatabase sdb;
+
+    db_alloc(&db);
+    pthread_mutex_init(&lock, NULL);
+    sdb_alloc(&sdb, BENCHMARK_SHARD_BITS);
+
+    pthread_t threads[num_threads];
+    struct WriterArgs args[num_threads];
+
+    // Начало измеряемого отрезка времени.
+    double start = time_now();
+
+    for (uint32_t thread_i = 0U; thread_i < num_threads; ++thread_i)
+    {
+        uint32_t first = thread_i * (NUM_SHARDED_INSERTS / num_threads);
+
+        args[thread_i] = (struct WriterArgs) {
+            .db          = &db,
+            .lock        = &lock,
+            .sdb         = sharded? &sdb : NULL,
+            .keys        = &keys[first],
+            .num_inserts = NUM_SHARDED_INSERTS / num_threads
+        };
+
+        int ret = pthread_create(&threads[thread_i], NULL, writer_thread, &args[thread_i]);
+        verify_contract(ret == 0, "Unable to create thread\n");
+    }
+
+    for (uint32_t thread_i = 0U; thread_i < num_threads; ++thread_i)
+    {
+        pthread_join(threads[thread_i], NULL);
+    }
+
+    // Конец измеряемого отрезка времени.
+    double end = time_now();
+
+    db_free(&db);
+    pthread_mutex_destroy(&lock);
+    sdb_free(&sdb);
+    free(keys);
+
+    return 1e-3 * (NUM_SHARDED_INSERTS / num_threads) * num_threads / (end - start);
+}
+
+//==================================================================================================
+// Функция: measure_churn
+// Назначение: Измеряет время вставки и удаления при колебании размера базы данных
+//             вблизи порога уменьшения ёмкости.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// policy  (in)  - политика управления ёмкостью.
+// resizes (out) - количество изменений ёмкости.
+//
+// Возвращаемое значение:
+// Среднее время одной операции в наносекундах.
+//==================================================================================================
+double measure_churn(const DbCapacityPolicy* policy, uint64_t* resizes)
+{
+    struct Database db;
+    db_alloc(&db);
+    db_set_capacity_policy(&db, policy);
+
+    // Размер базы данных - ровно четверть ёмкости.
+    db_reserve(&db, 4U * CHURN_BASE_SIZE);
+
+    char value[VALUE_SIZE] = {};
+    for (uint32_t key = 0U; key < CHURN_BASE_SIZE; ++key)
+    {
+        db_insert(&db, key, value);
+    }
+
+    DbCapacityStats before;
+    db_capacity_stats(&db, &before);
+
+    // Начало измеряемого отрезка времени.
+    double start = time_now();
+
+    // Размер колеблется между CHURN_BASE_SIZE и удвоенным значением.
+    for (uint32_t cycle = 0U; cycle < NUM_CHURN_CYCLES; ++cycle)
+    {
+        for (uint32_t key = CHURN_BASE_SIZE; key <= 2U * CHURN_BASE_SIZE; ++key)
+        {
+            db_insert(&db, key, value);
+        }
+
+        for (uint32_t key = 2U * CHURN_BASE_SIZE + 1U; key-- > CHURN_BASE_SIZE;)
+        {
+            db_remove(&db, key, value);
+        }
+    }
+
+    // Конец измеряемого отрезка времени.
+    double end = time_now();
+
+    DbCapacityStats after;
+    db_capacity_stats(&db, &after);
+
+    *resizes = (after.num_grows + after.num_shrinks) - (before.num_grows + before.num_shrinks);
+
+    db_free(&db);
+
+    return 1e9 * (end - start) / (2.0 * NUM_CHURN_CYCLES * (CHURN_BASE_SIZE + 1U));
+}
+
+//==================================================================================================
+// Функция: file_size
+// Назначение: Возвращает размер файла.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// filename (in) - имя файла.
+//
+// Возвращаемое значение:
+// Размер файла в байтах.
+//==================================================================================================
+double file_size(const char* filename)
+{
+    struct stat file_stat;
+    int ret = stat(filename, &file_stat);
+    verify_contract(ret != -1, "Unable to measure size for file \'%s\'\n", filename);
+
+    return file_stat.st_size;
+}
+
+//==================================================================================================
+// Функция: measure_scan
+// Назначение: Измеряет время чтения базы данных из файла.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// filename (in) - имя файла.
+//
+// Возвращаемое значение:
+// Время чтения в секундах.
+//==================================================================================================
+double measure_scan(const char* filename)
+{
+    // Начало измеряемого отрезка времени.
+    double start = time_now();
+
+    struct Database db;
+    db_scan_from_file(&db, filename);
+
+    // Конец измеряемого отрезка времени.
+    double end = time_now();
+
+    db_free(&db);
+
+    return end - start;
+}
+
+int main(int argc, char** argv)
+{
+    // Максимальный размер базы данных задаётся аргументом командной строки
+    // (make benchmark MAX_SIZE=100000000 для измерений на 100 млн записей).
+    uint32_t max_size = (argc > 1)? strtoul(argv[1], NULL, 10) : DEFAULT_MAX_SIZE;
+
+    // Ключи для поиска.
+    uint32_t* keys = calloc(NUM_SEARCHES, sizeof(uint32_t));
+    verify_contract(keys != NULL, "Unable to allocate memory\n");
+
+    // Задаём семя для генератора случайных чисел.
+    srand(100500);
+
+    printf("Время поиска ключа, нс:\n");
+    printf("      Размер   Сортировка    Эйтцингер          Хеш\n");
+
+    for (uint32_t size_i = 0U; size_i < NUM_SIZES && DB_SIZES[size_i] <= max_size; ++size_i)
+    {
+        uint32_t size = DB_SIZES[size_i];
+
+        // Заполняем базу данных нечётными ключами в порядке возрастания.
+        struct Database db;
+        db_alloc(&db);
+
+        for (uint32_t i = 0U; i < size; ++i)
+        {
+            char value[VALUE_SIZE] = {};
+            db_insert(&db, 2U * i + 1U, value);
+        }
+
+        // Каждый второй ключ присутствует в базе данных.
+        for (uint32_t i = 0U; i < NUM_SEARCHES; ++i)
+        {
+            keys[i] = rand() % (2U * size);
+        }
+
+        double sorted_ns = measure_search(&db, keys);
+
+        db_layout_eytzinger(&db);
+
+        double eytzinger_ns = measure_search(&db, keys);
+
+        db_hash_enable(&db);
+
+        double hash_ns = measure_search(&db, keys);
+
+        printf("%12u %12.1lf %12.1lf %12.1lf\n", size, sorted_ns, eytzinger_ns, hash_ns);
+
+        db_free(&db);
+    }
+
+    // Масштабируемость поиска по числу потоков на наименьшей базе данных.
+    {
+        uint32_t size = DB_SIZES[0];
+
+        struct Database db;
+        db_alloc(&db);
+
+        for (uint32_t i = 0U; i < size; ++i)
+        {
+            char value[VALUE_SIZE] = {};
+            db_insert(&db, 2U * i + 1U, value);
+        }
+
+        for (uint32_t i = 0U; i < NUM_SEARCHES; ++i)
+        {
+            keys[i] = rand() % (2U * size);
+        }
+
+        pthread_mutex_t lock;
+        pthread_mutex_init(&lock, NULL);
+
+        db_concurrent_enable(&db);
+
+        printf("Пропускная способность поиска в %u записях, млн запросов/с:\n", size);
+        printf("     Потоки     Мьютекс      Seqlock\n");
+
+        for (uint32_t count_i = 0U; count_i < NUM_THREAD_COUNTS; ++count_i)
+        {
+            uint32_t num_threads = THREAD_COUNTS[count_i];
+
+            double mutex_mops   = measure_readers(&db, keys, num_threads, &lock);
+            double seqlock_mops = measure_readers(&db, keys, num_threads, NULL);
+
+            printf("%11u %11.2lf %12.2lf\n", num_threads, mutex_mops, seqlock_mops);
+        }
+
+        pthread_mutex_destroy(&lock);
+        db_free(&db);
+    }
+
+    free(keys);
+
+    printf("Пропускная способность вставки случайных ключей, тыс. вставок/с:\n");
+    printf("      Потоки   Блокировка     Сегменты\n");
+
+    for (uint32_t count_i = 0U; count_i < NUM_THREAD_COUNTS; ++count_i)
+    {
+        uint32_t num_threads = THREAD_COUNTS[count_i];
+
+        printf("%12u %12.1lf %12.1lf\n", num_threads,
+               measure_writers(num_threads, false), measure_writers(num_threads, true));
+    }
+
+    // Политика с запасом после уменьшения: порог уменьшения ниже заполнения после него.
+    DbCapacityPolicy default_policy    = DB_CAPACITY_POLICY_DEFAULT;
+    DbCapacityPolicy hysteresis_policy = DB_CAPACITY_POLICY_DEFAULT;
+    hysteresis_policy.growth_percent = 300U;
+    hysteresis_policy.shrink_divisor = 8U;
+
+    uint64_t default_resizes, hysteresis_resizes;
+    double default_ns    = measure_churn(&default_policy,    &default_resizes);
+    double hysteresis_ns = measure_churn(&hysteresis_policy, &hysteresis_resizes);
+
+    printf("Вставка и удаление у порога уменьшения ёмкости (время операции, нс):\n");
+    printf("    Политика     Операция    Изменений\n");
+    printf("     x2, 1/4 %12.1lf %12lu\n", default_ns, default_resizes);
+    printf("     x3, 1/8 %12.1lf %12lu\n", hysteresis_ns, hysteresis_resizes);
+
+    printf("Время построения базы данных из неупорядоченных ключей, с:\n");
+    printf("      Размер        Время\n");
+
+    for (uint32_t size_i = 0U; size_i < NUM_SIZES && DB_SIZES[size_i] <= max_size; ++size_i)
+    {
+        printf("%12u %12.3lf\n", DB_SIZES[size_i], measure_build(DB_SIZES[size_i]));
+    }
+
+    // Ключи и значения для заполнения базы данных пакетами.
+    uint32_t* fill_keys = calloc(FILL_BATCH_SIZE, sizeof(uint32_t));
+    char (*fill_values)[VALUE_SIZE] = calloc(FILL_BATCH_SIZE, VALUE_SIZE);
+    verify_contract(fill_keys != NULL && fill_values != NULL, "Unable to allocate memory\n");
+
+    printf("Скорость сохранения базы данных в файл, МБ/с:\n");
+    printf("      Размер       fwrite   Big Endian   Нативный\n");
+
+    for (uint32_t size_i = 0U; size_i < NUM_SIZES && DB_SIZES[size_i] <= max_size; ++size_i)
+    {
+        uint32_t size = DB_SIZES[size_i];
+
+        // Заполняем базу данных ключами в порядке возрастания.
+        struct Database db;
+        db_alloc(&db);
+
+        for (uint32_t start = 0U; start < size; start += FILL_BATCH_SIZE)
+        {
+            uint32_t n = (size - start < FILL_BATCH_SIZE)? size - start : FILL_BATCH_SIZE;
+
+            for (uint32_t i = 0U; i < n; ++i)
+            {
+                fill_keys[i] = start + i;
+            }
+
+            db_insert_batch(&db, fill_keys, (const char (*)[VALUE_SIZE]) fill_values, n);
+        }
+
+        double per_entry_mbs = measure_dump(&db, dump_per_entry);
+        double big_endian_mbs = measure_dump(&db, db_dump_to_file);
+        double native_mbs = measure_dump(&db, db_dump_to_file_native);
+
+        printf("%12u %12.1lf %12.1lf %12.1lf\n", size, per_entry_mbs, big_endian_mbs, native_mbs);
+
+        db_free(&db);
+    }
+
+
+    // Сравнение форматов файла на адресах хостов с повторяющимися именами.
+    uint32_t compression_size = (COMPRESSION_SIZE <= max_size)? COMPRESSION_SIZE : max_size;
+    {
+        struct Database db;
+        db_alloc(&db);
+
+        uint32_t key = 0U;
+        for (uint32_t start = 0U; start < compression_size; start += FILL_BATCH_SIZE)
+        {
+            uint32_t n = (compression_size - start < FILL_BATCH_SIZE)?
+                compression_size - start : FILL_BATCH_SIZE;
+
+            for (uint32_t i = 0U; i < n; ++i)
+            {
+                key += 1U + rand() % 64U;
+
+                fill_keys[i] = key;
+                memset(fill_values[i], 0, VALUE_SIZE);
+                strcpy(fill_values[i], HOSTNAMES[rand() % NUM_HOSTNAMES]);
+            }
+
+            db_insert_batch(&db, fill_keys, (const char (*)[VALUE_SIZE]) fill_values, n);
+        }
+
+        db_dump_to_file(&db, DUMP_FILENAME);
+        db_dump_to_file_blocks(&db, BLOCKS_FILENAME);
+
+        double raw_size    = file_size(DUMP_FILENAME);
+        double blocks_size = file_size(BLOCKS_FILENAME);
+
+        double raw_scan    = measure_scan(DUMP_FILENAME);
+        double blocks_scan = measure_scan(BLOCKS_FILENAME);
+
+        // Поиск случайных ключей в файле без загрузки базы данных.
+        struct DbBlockFile file;
+        db_block_file_open(&file, BLOCKS_FILENAME);
+
+        uint32_t num_found = 0U;
+        double start = time_now();
+
+        for (uint32_t i = 0U; i < NUM_FILE_SEARCHES; ++i)
+        {
+            char value[VALUE_SIZE];
+            num_found += db_block_file_search(&file, rand() % key, value);
+        }
+
+        double search_us = 1e6 * (time_now() - start) / NUM_FILE_SEARCHES;
+
+        verify_contract(num_found != 0U, "Unexpected search results\n");
+        db_block_file_close(&file);
+
+        printf("Форматы файла для %u записей:\n", compression_size);
+        printf("      Формат   Размер, МБ    Чтение, с\n");
+        printf("     Простой %12.1lf %12.3lf\n", 1e-6 * raw_size, raw_scan);
+        printf("     Блочный %12.1lf %12.3lf\n", 1e-6 * blocks_size, blocks_scan);
+        printf("Степень сжатия: %.1lf\n", raw_size / blocks_size);
+        printf("Поиск в файле блочного формата (один блок на запрос): %.1lf мкс\n", search_us);
+
+        unlink(DUMP_FILENAME);
+        unlink(BLOCKS_FILENAME);
+        db_free(&db);
+    }
+
+    free(fill_keys);
+    free(fill_values);
+
+    return EXIT_SUCCESS;
+}
@@ -1,6 +1,15 @@
 // Copyright 2025 Vladislav Aleinik
+#include <inttypes.h>
+#include <stddef.h>
 #include <stdint.h>
-#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "utils.h"
 
@@ -8,20 +17,332 @@
 // Структура данных //
 //==================//
 
+// Разрядность ключа и размер значения могут быть заданы непосредственно
+// перед подключением заголовочного файла database.h:
+//     #define DB_KEY_BITS 64
+//     #define VALUE_SIZE 24U
+//     #include "database.h"
+// Сравнения ключей, перестановка байт, хеширование и размещение записи
+// выбираются на этапе компиляции и не требуют проверок во время работы.
+
+// Разрядность ключа: 32 или 64 бита.
+#ifndef DB_KEY_BITS
+#define DB_KEY_BITS 32
+#endif
+
+#if DB_KEY_BITS == 32
+
+// Тип ключа.
+typedef uint32_t DbKey_t;
+// Наибольший ключ.
+#define DB_KEY_MAX 0xFFFFFFFFU
+// Преобразование ключа в порядок байт Big Endian и обратно.
+#define db_key_htobe(key) my_htobe32(key)
+#define db_key_betoh(key) my_be32toh(key)
+// Множитель мультипликативного хеширования (2^32 / золотое сечение).
+#define DB_KEY_HASH_MULTIPLIER 0x9E3779B1U
+
+#elif DB_KEY_BITS == 64
+
+typedef uint64_t DbKey_t;
+#define DB_KEY_MAX 0xFFFFFFFFFFFFFFFFULL
+#define db_key_htobe(key) my_htobe64(key)
+#define db_key_betoh(key) my_be64toh(key)
+#define DB_KEY_HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+#else
+#error "DB_KEY_BITS must be 32 or 64"
+#endif
+
+// Размер ключа в байтах.
+#define DB_KEY_BYTES (DB_KEY_BITS / 8U)
+
 // Размер значения в базе данных.
+#ifndef VALUE_SIZE
 #define VALUE_SIZE 12U
+#endif
 
 // Пара ключ-значение в базе данных.
 typedef struct {
     // По ключу производится поиск в базе данных.
-    uint32_t key;
+    DbKey_t key;
 
     // Значение - то, что непосредственно хранится в базе данных.
     char value[VALUE_SIZE];
 } Entry_t;
 
+// Генерируем ошибку сборки при наличии дыр в структуре:
+// размер значения должен быть кратен размеру ключа.
+STATIC_ASSERT(sizeof(Entry_t) == DB_KEY_BYTES + VALUE_SIZE, entry_t_size);
+
+// Способ размещения записей в массиве entries.
+typedef enum
+{
+    // Записи упорядочены по возрастанию ключа.
+    DB_LAYOUT_SORTED    = 0,
+    // Записи размещены в порядке обхода в ширину неявного двоичного дерева поиска
+    // (размещение Эйтцингера): дочерние узлы записи с номером k (с единицы) - 2k и 2k + 1.
+    DB_LAYOUT_EYTZINGER = 1
+} DbLayout;
+
+// Ёмкость буфера записи в log-structured режиме.
+#define DB_LSM_BUFFER_SIZE 4096U
+// Количество фрагментов журнала, при котором запускается фоновое слияние.
+#define DB_LSM_COMPACT_RUNS 4U
+// Максимальное количество фрагментов журнала.
+#define DB_LSM_MAX_RUNS 16U
+
+// Индекс, возвращаемый db_search при наличии в журнале неслитых изменений.
+#define DB_NO_INDEX 0xFFFFFFFFU
+
+// Запись журнала изменений.
+typedef struct {
+    // Пара ключ-значение.
+    Entry_t entry;
+    // Признак удаления ключа (tombstone).
+    bool removed;
+} LogEntry_t;
+
+// Неизменяемый упорядоченный по ключу фрагмент журнала изменений.
+typedef struct {
+    LogEntry_t* entries;
+    uint32_t size;
+} DbRun;
+
+// Журнал изменений базы данных в log-structured режиме.
+struct DbLog
+{
+    // Буфер записи: упорядоченный по ключу массив последних изменений.
+    LogEntry_t* buffer;
+    // Количество записей в буфере.
+    uint32_t buffer_size;
+
+    // Фрагменты журнала от старых к новым.
+    DbRun runs[DB_LSM_MAX_RUNS];
+    // Количество фрагментов.
+    uint32_t num_runs;
+
+    // Количество ключей в базе данных с учётом журнала.
+    uint32_t live_size;
+
+    // Поток фонового слияния.
+    pthread_t compactor;
+    // Флаг наличия запущенного слияния.
+    bool compacting;
+    // Флаг завершения слияния (записывается потоком слияния).
+    bool compaction_done;
+    // Количество старейших фрагментов, сливаемых с основным массивом.
+    uint32_t num_compacting;
+
+    // Основной массив на момент запуска слияния.
+    const Entry_t* main_entries;
+    uint32_t main_size;
+
+    // Результат слияния.
+    Entry_t* merged;
+    uint32_t merged_size;
+};
+
+// Количество записей журнала предзаписи, сбрасываемых на диск одним вызовом fdatasync.
+#define DB_WAL_GROUP_SIZE 256U
+// Количество записей в файле журнала предзаписи, при котором создаётся новый снимок.
+#define DB_WAL_CHECKPOINT_SIZE (1U << 20U)
+
+// Вид операции в журнале предзаписи.
+// Значения выбраны так, чтобы случайные байты в файле не принимались за операцию.
+typedef enum
+{
+    DB_WAL_INSERT = 0x494E5352, // "INSR"
+    DB_WAL_REMOVE = 0x52454D56  // "REMV"
+} DbWalOp;
+
+// Заголовок файла журнала предзаписи. По нему журнал, созданный базой данных
+// с другим типом ключа или размером значения, отвергается при открытии.
+typedef struct {
+    // Магическое число DB_WAL_MAGIC.
+    uint32_t magic;
+    // Разрядность ключа (DB_KEY_BITS) и размер значения (VALUE_SIZE).
+    uint32_t key_bits;
+    uint32_t value_size;
+} WalHeader_t;
+
+// Магическое число журнала предзаписи ("WAL1").
+#define DB_WAL_MAGIC 0x57414C31U
+
+// Запись журнала предзаписи в файле.
+typedef struct {
+#if DB_KEY_BITS == 32
+    // Вид операции (DbWalOp).
+    uint32_t op;
+    // Ключ и значение (значение не используется при удалении).
+    DbKey_t key;
+    char value[VALUE_SIZE];
+#else
+    // Ключ и значение (значение не используется при удалении).
+    // Ключ размещается первым, чтобы поля не разделялись выравниванием.
+    DbKey_t key;
+    char value[VALUE_SIZE];
+    // Вид операции (DbWalOp).
+    uint32_t op;
+#endif
+    // Контрольная сумма предыдущих полей: по ней обнаруживается запись,
+    // не дописанная до конца из-за сбоя.
+    uint32_t checksum;
+} WalRecord_t;
+
 // Генерируем ошибку сборки при наличии дыр в структуре.
-STATIC_ASSERT(sizeof(Entry_t) == 16U, entry_t_size);
+STATIC_ASSERT(sizeof(WalRecord_t) == DB_KEY_BYTES + VALUE_SIZE + 2U * sizeof(uint32_t),
+              wal_record_t_size);
+
+// Журнал предзаписи базы данных.
+struct DbWal
+{
+    // Файловый дескриптор журнала, открытого на дозапись.
+    int fd;
+    // Количество записей в файле журнала.
+    uint32_t num_records;
+
+    // Имена файла снимка базы данных и файла журнала.
+    char* snapshot_filename;
+    char* wal_filename;
+
+    // Группа записей, ещё не записанных в файл.
+    WalRecord_t group[DB_WAL_GROUP_SIZE];
+    uint32_t group_size;
+};
+
+// Массив записей, заменённый писателем, и эпоха, в которую он был заменён.
+typedef struct {
+    Entry_t* entries;
+    uint32_t epoch;
+} DbRetired;
+
+// Состояние режима одновременного доступа: читатели не блокируют друг друга,
+// писатели упорядочиваются блокировкой и публикуют изменения через счётчик версий (seqlock).
+struct DbSync
+{
+    // Счётчик версий: нечётен во время изменения базы данных.
+    uint32_t seq;
+    // Блокировка, упорядочивающая писателей.
+    pthread_mutex_t write_lock;
+
+    // Текущая эпоха и количество читателей, вошедших в чётную и нечётную эпохи.
+    uint32_t epoch;
+    uint32_t readers[2];
+
+    // Массивы записей, заменённые при изменении ёмкости, в порядке замены. Они могут
+    // читаться запоздавшими читателями и освобождаются, когда читатели эпохи замены завершатся.
+    DbRetired* retired;
+    uint32_t num_retired;
+    uint32_t retired_capacity;
+};
+
+// Режим значений переменной длины доступен, если ссылка на значение в области значений
+// (8 байт) помещается в поле value вместе с признаком DB_ARENA_REF. При меньшем поле value
+// функции db_arena_enable, db_value, db_insert_value, db_search_value и db_remove_value
+// не определены.
+#if VALUE_SIZE > 8U
+#define DB_ARENA_SUPPORTED
+#endif
+
+#ifdef DB_ARENA_SUPPORTED
+
+// Наибольшая длина значения, хранящегося непосредственно в записи в режиме значений
+// переменной длины. Длина хранится в последнем байте поля value и не должна совпадать
+// с признаком DB_ARENA_REF, поэтому при длинных полях value ограничена 254 байтами.
+#define DB_INLINE_VALUE_MAX ((VALUE_SIZE - 1U < 0xFEU)? VALUE_SIZE - 1U : 0xFEU)
+// Признак значения, хранящегося в области значений (записывается в последний байт поля value).
+#define DB_ARENA_REF 0xFFU
+
+// Генерируем ошибку сборки, если длина значения в записи совпадает с признаком ссылки.
+STATIC_ASSERT(DB_INLINE_VALUE_MAX < DB_ARENA_REF, inline_value_max);
+
+// Ссылка на значение в области значений (хранится в начале поля value).
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+} ArenaRef_t;
+
+// Генерируем ошибку сборки, если ссылка не помещается в поле value вместе с признаком.
+STATIC_ASSERT(VALUE_SIZE > sizeof(ArenaRef_t), arena_ref_t_size);
+
+// Область хранения значений переменной длины: значения дописываются в конец,
+// место удалённых и перезаписанных значений освобождается при уплотнении.
+struct DbArena
+{
+    // Байты значений.
+    char* bytes;
+    // Количество занятых байт.
+    uint32_t size;
+    // Размер выделенной памяти.
+    uint32_t capacity;
+    // Количество байт, занятых удалёнными и перезаписанными значениями.
+    uint32_t garbage;
+};
+
+#endif // DB_ARENA_SUPPORTED
+
+// Ячейка хеш-индекса.
+typedef struct {
+    // Ключ записи.
+    DbKey_t key;
+    // Индекс записи в базе данных (DB_NO_INDEX для свободной ячейки).
+    uint32_t index;
+} HashSlot_t;
+
+// Хеш-индекс с открытой адресацией и линейным пробированием: отображает ключ в индекс записи.
+struct DbHash
+{
+    // Ячейки хеш-таблицы.
+    HashSlot_t* slots;
+    // Количество ячеек (степень двойки).
+    uint32_t capacity;
+    // Сдвиг результата хеш-функции: DB_KEY_BITS - log2(capacity).
+    uint32_t shift;
+};
+
+// Политика управления ёмкостью массива записей.
+typedef struct {
+    // Коэффициент увеличения ёмкости при заполнении массива, в процентах (200 - удвоение).
+    uint32_t growth_percent;
+    // Наименьшая ёмкость, до которой может быть уменьшен массив.
+    uint32_t min_capacity;
+    // Массив уменьшается, когда занято не более 1/shrink_divisor его ёмкости (0 - никогда).
+    uint32_t shrink_divisor;
+    // Необходимость уменьшения проверяется раз в shrink_period удалений
+    // (1 - при каждом удалении, 0 - только явным вызовом db_shrink).
+    uint32_t shrink_period;
+    // Массивы не меньше этого размера в байтах размещаются в больших страницах (0 - никогда).
+    size_t huge_page_bytes;
+} DbCapacityPolicy;
+
+// Политика по умолчанию: удвоение при заполнении, уменьшение вдвое при заполнении на четверть.
+#define DB_CAPACITY_POLICY_DEFAULT ((DbCapacityPolicy) { \
+    .growth_percent  = 200U,                            \
+    .min_capacity    = 1U,                              \
+    .shrink_divisor  = 4U,                              \
+    .shrink_period   = 1U,                              \
+    .huge_page_bytes = 0U                               \
+})
+
+// Размер большой страницы памяти.
+#define DB_HUGE_PAGE_SIZE (2U << 20U)
+
+// Счётчики операций изменения ёмкости массива записей.
+typedef struct {
+    // Количество увеличений и уменьшений ёмкости.
+    uint64_t num_grows;
+    uint64_t num_shrinks;
+    // Количество массивов, размещённых в больших страницах.
+    uint64_t num_huge_allocs;
+    // Объём записей, перенесённых при изменении ёмкости, в байтах
+    // (оценка сверху: realloc может расширить массив без копирования).
+    uint64_t bytes_moved;
+    // Количество удалений записей (определяет моменты проверки необходимости уменьшения).
+    uint64_t num_removes;
+    // Наибольшая ёмкость массива.
+    uint32_t peak_capacity;
+} DbCapacityStats;
 
 // Представление ассоциативной поисковой структуры данных
 struct Database
@@ -32,399 +353,5861 @@ struct Database
     uint32_t size;
     // Размер массива.
     uint32_t capacity;
+
+    // Отображение файла базы данных в память (NULL для базы данных в динамической памяти).
+    // Для отображённой базы данных массив entries указывает внутрь отображения.
+    void* mapped;
+    // Размер отображения файла в память.
+    size_t mapped_size;
+
+    // Способ размещения записей в массиве entries.
+    DbLayout layout;
+    // Для размещения DB_LAYOUT_EYTZINGER: позиция в массиве entries записи с заданным индексом
+    // (порядковым номером по возрастанию ключа) и обратное отображение.
+    uint32_t* rank_to_pos;
+    uint32_t* pos_to_rank;
+
+    // Журнал изменений (NULL, если log-structured режим не включён).
+    // В log-structured режиме массив entries не изменяется при вставке и удалении.
+    struct DbLog* log;
+
+    // Журнал предзаписи (NULL для базы данных без сохранения изменений на диск).
+    struct DbWal* wal;
+
+    // Состояние режима одновременного доступа (NULL, если режим не включён).
+    struct DbSync* sync;
+
+    // Область значений переменной длины (NULL, если значения имеют длину VALUE_SIZE).
+    struct DbArena* arena;
+
+    // Хеш-индекс для поиска по ключу (NULL, если индекс не построен).
+    struct DbHash* hash;
+
+    // Политика управления ёмкостью массива entries и счётчики её применения.
+    DbCapacityPolicy policy;
+    DbCapacityStats capacity_stats;
 };
 
-//======================//
-// Управление ресурсами //
-//======================//
+// Макроопределение DB_STORE - запись поля базы данных, читаемого поиском без блокировок
+// (указателя на массив записей и размера). Запись атомарна и упорядочена после записи
+// содержимого массива, поэтому читатель, загрузивший указатель, видит записи нового массива.
+#define DB_STORE(FIELD, VALUE) __atomic_store_n(&(FIELD), (VALUE), __ATOMIC_RELEASE)
+
+// Количество записей в блоке файла блочного формата.
+#define DB_BLOCK_SIZE 1024U
+
+// Файл базы данных в блочном формате, открытый для поиска без загрузки в память.
+struct DbBlockFile
+{
+    // Файловый дескриптор и имя файла (для сообщений об ошибках).
+    int fd;
+    char* filename;
+    // Количество записей в файле.
+    uint32_t num_entries;
+
+    // Разреженный индекс блоков: наименьший ключ, смещение и размер каждого блока.
+    uint32_t num_blocks;
+    DbKey_t* first_keys;
+    uint64_t* offsets;
+    uint32_t* sizes;
+
+    // Буфер для чтения блока из файла.
+    uint8_t* buffer;
+
+    // Последний декодированный блок.
+    Entry_t* block;
+    uint32_t block_index;
+    uint32_t block_size;
+
+    // Количество блоков, декодированных за время работы с файлом.
+    uint32_t num_decoded;
+};
+
+// Курсор для последовательного обхода записей с ключами из заданного диапазона.
+typedef struct {
+    // База данных, по которой производится обход.
+    const struct Database* db;
+    // Индекс следующей записи.
+    uint32_t index;
+    // Индекс первой записи за пределами диапазона.
+    uint32_t end;
+} DbCursor;
+
+// Наибольшее количество старших бит ключа, по которым записи распределяются по сегментам.
+#define DB_MAX_SHARD_BITS 8U
+
+// База данных, разделённая по старшим битам ключа на независимые сегменты.
+struct ShardedDatabase
+{
+    // Количество старших бит ключа, задающих номер сегмента.
+    uint32_t shard_bits;
+    // Количество сегментов.
+    uint32_t num_shards;
+
+    // Сегменты и их блокировки.
+    struct Database* shards;
+    pthread_rwlock_t* locks;
+};
+
+// Курсор для последовательного обхода записей сегментированной базы данных.
+typedef struct {
+    // База данных, по которой производится обход.
+    const struct ShardedDatabase* sdb;
+    // Полуинтервал ключей.
+    DbKey_t lo;
+    DbKey_t hi;
+    // Текущий и последний сегменты диапазона.
+    uint32_t shard;
+    uint32_t last_shard;
+    // Курсор в текущем сегменте.
+    DbCursor cursor;
+} SdbCursor;
+
+//=========================//
+// Инструментирование (БД) //
+//=========================//
+
+// Инструментирование включается определением макроса DB_STATS до подключения заголовка:
+//     #define DB_STATS
+//     #include "database.h"
+// Без него макросы DB_STATS_* не порождают кода.
+
+// Операции, для которых строятся гистограммы задержки.
+typedef enum {
+    DB_OP_SEARCH = 0,
+    DB_OP_INSERT = 1,
+    DB_OP_REMOVE = 2,
+    DB_NUM_OPS   = 3
+} DbOp;
+
+// Количество интервалов гистограммы задержки: интервал i содержит задержки [2^i, 2^(i+1)) нс.
+#define DB_STATS_NUM_BUCKETS 32U
+
+// Счётчики и гистограммы одного потока.
+struct DbStats
+{
+    // Количество операций каждого вида.
+    uint64_t num_ops[DB_NUM_OPS];
+    // Гистограммы задержки операций.
+    uint64_t latency[DB_NUM_OPS][DB_STATS_NUM_BUCKETS];
+
+    // Количество обращений к записям при поиске (глубина бинарного поиска и пробирования).
+    uint64_t num_probes;
+    // Объём данных, перемещённых memmove при вставке и удалении, в байтах.
+    uint64_t bytes_moved;
+    // Количество изменений ёмкости массива записей.
+    uint64_t num_reallocs;
+
+    // Глубина вложенности измеряемых операций (учитывается только внешняя).
+    uint32_t depth;
+
+    // Следующий элемент списка счётчиков всех потоков.
+    struct DbStats* next;
+};
+
+// Формат вывода счётчиков.
+typedef enum {
+    DB_STATS_TEXT = 0,
+    DB_STATS_JSON = 1
+} DbStatsFormat;
+
+#ifdef DB_STATS
+
+// Счётчики текущего потока. Каждый поток обновляет только свои счётчики,
+// поэтому обновление не требует атомарных операций и не вызывает разделения кеш-линий.
+__thread struct DbStats* db_stats_local = NULL;
+
+// Список счётчиков всех потоков. Счётчики завершившихся потоков сохраняются в списке.
+struct DbStats* db_stats_list = NULL;
+pthread_mutex_t db_stats_lock = PTHREAD_MUTEX_INITIALIZER;
 
 //==================================================================================================
-// Функция: db_alloc
-// Назначение: Инициализирует базу данных.
+// Функция: db_stats_thread
+// Назначение: Возвращает счётчики текущего потока, создавая их при первом обращении.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// db (out) - указатель на базу данных.
+// отсутствуют.
 //
 // Возвращаемое значение:
-// Отсутствует
+// Указатель на счётчики текущего потока.
 //==================================================================================================
-void db_alloc(struct Database* db)
+struct DbStats* db_stats_thread(void)
 {
-    // Выделяем память под базу данных минимального размера.
-    db->entries = calloc(1U, sizeof(Entry_t));
-    verify_contract(db->entries != NULL,
-        "db_alloc: unable to allocate memory\n");
+    if (__builtin_expect(db_stats_local != NULL, 1))
+    {
+        return db_stats_local;
+    }
 
-    // Устанавливаем размер и ёмкость.
-    db->size     = 0;
-    db->capacity = 1;
+    struct DbStats* stats = calloc(1U, sizeof(struct DbStats));
+    verify_contract(stats != NULL,
+        "db_stats_thread: unable to allocate memory\n");
+
+    pthread_mutex_lock(&db_stats_lock);
+    stats->next   = db_stats_list;
+    db_stats_list = stats;
+    pthread_mutex_unlock(&db_stats_lock);
+
+    db_stats_local = stats;
+    return stats;
 }
 
+// Измеряемая операция: задержка записывается при выходе из области видимости.
+typedef struct {
+    DbOp op;
+    uint64_t start;
+} DbStatsScope;
+
 //==================================================================================================
-// Функция: db_free
-// Назначение: Освобождает ресурсы под базу данных.
+// Функция: db_stats_clock
+// Назначение: Возвращает текущее время в наносекундах.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// db (in) - указатель на базу данных.
+// отсутствуют.
 //
 // Возвращаемое значение:
-// Отсутствует
+// Время по монотонным часам.
 //==================================================================================================
-void db_free(struct Database* db)
+uint64_t db_stats_clock(void)
 {
-    free(db->entries);
+    // Вызов выполняется через vDSO без перехода в ядро.
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
 
-    // Записываем мусорные значения в переменные.
-    db->entries  = NULL;
-    db->size     = 0;
-    db->capacity = 0;
+    return 1000000000ULL * ts.tv_sec + ts.tv_nsec;
 }
 
-//===============================//
-// Доступ к элементам по индексу //
-//===============================//
-
 //==================================================================================================
-// Функция: db_size
-// Назначение: Возвращает количество элементов в базе данных.
+// Функция: db_stats_begin
+// Назначение: Начинает измерение операции.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// db (in) - указатель на базу данных.
+// op (in) - вид операции.
 //
 // Возвращаемое значение:
-// Количество элементов в базе данных.
+// Состояние измерения.
 //==================================================================================================
-uint32_t db_size(const struct Database* db)
+DbStatsScope db_stats_begin(DbOp op)
 {
-    return db->size;
+    db_stats_thread()->depth++;
+
+    return (DbStatsScope) {.op = op, .start = db_stats_clock()};
 }
 
 //==================================================================================================
-// Функция: db_at_index
-// Назначение: Считывает ключ и значение по индексу в базе данных.
+// Функция: db_stats_end
+// Назначение: Завершает измерение операции и записывает задержку в гистограмму.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// db    (in)  - указатель на базу данных.
-// index (in)  - индекс элемента а базе данных.
-// key   (out) - указатель на записываемый функцию ключ.
-// value (out) - указатель на записываемое функцией значение.
+// scope (in) - состояние измерения.
 //
 // Возвращаемое значение:
 // Отсутствует.
 //
 // Примечания:
-// - Вызов функций db_insert и db_remove могут менять ключ-значение по индексу. 
+// - Вызывается автоматически при выходе из функции (__attribute__((cleanup))),
+//   поэтому измерение охватывает все точки возврата.
+// - Вложенные операции (поиск внутри удаления) не учитываются.
 //==================================================================================================
-void db_at_index(const struct Database* db, uint32_t index, uint32_t* key, char value[VALUE_SIZE])
+void db_stats_end(DbStatsScope* scope)
 {
-    verify_contract(index < db->size,
-        "db_at_index: unable to get element at index %u (size is %u)\n",
-        index, db->size);
+    struct DbStats* stats = db_stats_thread();
+    if (--stats->depth != 0U)
+    {
+        return;
+    }
+
+    uint64_t elapsed = db_stats_clock() - scope->start;
+
+    // Номер интервала - номер старшего единичного бита задержки.
+    uint32_t bucket = 63U - __builtin_clzll(elapsed | 1U);
+    if (bucket >= DB_STATS_NUM_BUCKETS)
+    {
+        bucket = DB_STATS_NUM_BUCKETS - 1U;
+    }
 
-    *key = db->entries[index].key;
-    memcpy(value, db->entries[index].value, VALUE_SIZE);
+    stats->num_ops[scope->op]++;
+    stats->latency[scope->op][bucket]++;
 }
 
-//================================//
-// Доступ к элементам БД по ключу //
-//================================//
+// Измерение задержки операции op до выхода из текущей области видимости.
+#define DB_STATS_SCOPE(op) \
+    DbStatsScope db_stats_scope __attribute__((cleanup(db_stats_end))) = db_stats_begin(op)
+
+// Увеличение счётчика field текущего потока на n.
+#define DB_STATS_ADD(field, n) \
+    (db_stats_thread()->field += (n))
+
+#else
+
+#define DB_STATS_SCOPE(op) do {} while (0)
+#define DB_STATS_ADD(field, n) ((void) 0)
+
+#endif // DB_STATS
 
 //==================================================================================================
-// Функция: db_search
-// Назначение: Ищет в базе данных значение по заданному ключу.
+// Функция: db_stats_collect
+// Назначение: Суммирует счётчики всех потоков.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// db    (in) - указатель на базу данных.
-// key   (in) - искомый ключ.
-// value (in) - указатель на записываемое функцией значение.
-// index (in) - указатель на индекс элемента а базе данных.
+// total (out) - суммарные счётчики.
 //
 // Возвращаемое значение:
-// TRUE  - значение по ключу найдено.
-// FALSE - значение по ключу отсутствует. 
+// Отсутствует.
 //
 // Примечания:
-// - Вызов функций db_insert и db_remove могут менять ключ-значение по индексу. 
+// - Счётчики работающих потоков читаются без синхронизации и могут отставать
+//   на несколько последних операций.
+// - Без DB_STATS все счётчики равны нулю.
 //==================================================================================================
-bool db_search(const struct Database* db, uint32_t key, char value[VALUE_SIZE], uint32_t* index)
+void db_stats_collect(struct DbStats* total)
 {
-    if (db->size == 0)
-    {
-        return false;
-    }
+    memset(total, 0, sizeof(*total));
 
-    // Индексы в массиве.
-    uint32_t low  = 0;
-    uint32_t high = db->size;
+#ifdef DB_STATS
+    pthread_mutex_lock(&db_stats_lock);
 
-    // Производим бинарный поиск в отсортированном массиве.
-    while (low < high)
+    for (const struct DbStats* stats = db_stats_list; stats != NULL; stats = stats->next)
     {
-        uint32_t mid = low + (high - low)/2;
-
-        if (db->entries[mid].key > key)
-        {
-            high = mid;
-        }
-        else if (db->entries[mid].key < key)
-        {
-            low = mid + 1;
-        }
-        else
+        for (uint32_t op = 0U; op < DB_NUM_OPS; ++op)
         {
-            memcpy(value, db->entries[mid].value, VALUE_SIZE);
-            *index = mid;
-            return true;
+            total->num_ops[op] += stats->num_ops[op];
+
+            for (uint32_t bucket = 0U; bucket < DB_STATS_NUM_BUCKETS; ++bucket)
+            {
+                total->latency[op][bucket] += stats->latency[op][bucket];
+            }
         }
+
+        total->num_probes   += stats->num_probes;
+        total->bytes_moved  += stats->bytes_moved;
+        total->num_reallocs += stats->num_reallocs;
     }
 
-    // Ключ отсутствует в массиве. 
-    return false;
+    pthread_mutex_unlock(&db_stats_lock);
+#endif // DB_STATS
 }
 
 //==================================================================================================
-// Функция: db_insert
-// Назначение: Вставляет в базу данных значение по заданному ключу.
+// Функция: db_stats_reset
+// Назначение: Обнуляет счётчики всех потоков.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// db    (in) - указатель на базу данных.
-// key   (in) - ключ для вставки в базу данных.
-// value (in) - значение для вставки в базу данных.
+// отсутствуют.
 //
 // Возвращаемое значение:
-// FALSE - элемент уже присутствовал в базе данных, значение обновлено.
-// TRUE  - элемент успешно добавлен в базу данных.
+// Отсутствует.
+//
+// Примечания:
+// - Вызывается, когда другие потоки не выполняют операций с базами данных.
 //==================================================================================================
-bool db_insert(struct Database* db, uint32_t key, const char value[VALUE_SIZE])
+void db_stats_reset(void)
 {
-    if (db->size == db->capacity)
+#ifdef DB_STATS
+    pthread_mutex_lock(&db_stats_lock);
+
+    for (struct DbStats* stats = db_stats_list; stats != NULL; stats = stats->next)
     {
-        // Двукратно увеличивем объём выделенной памяти.
-        db->capacity *= 2U;
+        struct DbStats* next = stats->next;
+        uint32_t depth = stats->depth;
 
-        db->entries = realloc(db->entries, db->capacity * sizeof(Entry_t));
-        verify_contract(db->entries != NULL, "db_insert: unable to reallocate memory\n");
+        memset(stats, 0, sizeof(*stats));
+
+        stats->next  = next;
+        stats->depth = depth;
     }
 
-    // Индексы в базе данных.
-    uint32_t low  = 0;
-    uint32_t high = db->size; 
+    pthread_mutex_unlock(&db_stats_lock);
+#endif // DB_STATS
+}
 
-    // Находим место для вставки элемента.
-    while (low < high)
+//==================================================================================================
+// Функция: db_stats_percentile
+// Назначение: Оценивает перцентиль задержки операции по гистограмме.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// stats      (in) - счётчики.
+// op         (in) - вид операции.
+// percentile (in) - перцентиль (от 0 до 100).
+//
+// Возвращаемое значение:
+// Верхняя граница интервала гистограммы, содержащего перцентиль, в наносекундах
+// (0 при отсутствии операций).
+//==================================================================================================
+uint64_t db_stats_percentile(const struct DbStats* stats, DbOp op, uint32_t percentile)
+{
+    // Номер операции, задержка которой соответствует перцентилю.
+    uint64_t rank = (stats->num_ops[op] * percentile + 99U) / 100U;
+    if (rank == 0U)
     {
-        uint32_t mid = low + (high - low)/2;
+        rank = 1U;
+    }
 
-        if (db->entries[mid].key <= key)
-        {
-            low = mid + 1;
-        }
-        else
+    uint64_t seen = 0U;
+    for (uint32_t bucket = 0U; bucket < DB_STATS_NUM_BUCKETS && stats->num_ops[op] != 0U; ++bucket)
+    {
+        seen += stats->latency[op][bucket];
+        if (seen >= rank)
         {
-            high = mid;
+            return 2ULL << bucket;
         }
     }
 
-    // Место для вставки элемента.
-    uint32_t pos = high;
+    return 0U;
+}
 
-    // Обновляем значение для заданного ключа. 
-    if (pos != 0 && db->entries[pos - 1].key == key)
-    {
-        memcpy(db->entries[pos - 1].value, value, VALUE_SIZE);
+//==================================================================================================
+// Функция: db_stats_dump
+// Назначение: Выводит суммарные счётчики всех потоков.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// file   (in) - поток вывода.
+// format (in) - формат вывода: текст или JSON.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_stats_dump(FILE* file, DbStatsFormat format)
+{
+    static const char* op_names[DB_NUM_OPS] = {"search", "insert", "remove"};
+
+    struct DbStats total;
+    db_stats_collect(&total);
+
+    if (format == DB_STATS_JSON)
+    {
+        fprintf(file, "{\n  \"probes\": %" PRIu64 ",\n  \"bytes_moved\": %" PRIu64 ",\n"
+                      "  \"reallocs\": %" PRIu64 ",\n",
+                total.num_probes, total.bytes_moved, total.num_reallocs);
+        fprintf(file, "  \"ops\": {\n");
+
+        for (uint32_t op = 0U; op < DB_NUM_OPS; ++op)
+        {
+            fprintf(file, "    \"%s\": {\"count\": %" PRIu64 ", \"p50_ns\": %" PRIu64 ", "
+                          "\"p99_ns\": %" PRIu64 ", \"latency_ns\": [",
+                    op_names[op], total.num_ops[op],
+                    db_stats_percentile(&total, op, 50U), db_stats_percentile(&total, op, 99U));
+
+            for (uint32_t bucket = 0U; bucket < DB_STATS_NUM_BUCKETS; ++bucket)
+            {
+                fprintf(file, "%s%" PRIu64, (bucket == 0U)? "" : ", ", total.latency[op][bucket]);
+            }
+
+            fprintf(file, "]}%s\n", (op + 1U == DB_NUM_OPS)? "" : ",");
+        }
+
+        fprintf(file, "  }\n}\n");
+        return;
+    }
+
+    fprintf(file, "Обращений при поиске: %" PRIu64 "\n", total.num_probes);
+    fprintf(file, "Перемещено при сдвигах, байт: %" PRIu64 "\n", total.bytes_moved);
+    fprintf(file, "Изменений ёмкости: %" PRIu64 "\n", total.num_reallocs);
+
+    for (uint32_t op = 0U; op < DB_NUM_OPS; ++op)
+    {
+        fprintf(file, "Операция %s: %" PRIu64 ", p50 < %" PRIu64 " нс, p99 < %" PRIu64 " нс\n",
+                op_names[op], total.num_ops[op],
+                db_stats_percentile(&total, op, 50U), db_stats_percentile(&total, op, 99U));
+
+        for (uint32_t bucket = 0U; bucket < DB_STATS_NUM_BUCKETS; ++bucket)
+        {
+            if (total.latency[op][bucket] != 0U)
+            {
+                fprintf(file, "    [%10" PRIu64 ", %10" PRIu64 ") нс: %" PRIu64 "\n",
+                        (uint64_t) 1U << bucket, (uint64_t) 2U << bucket,
+                        total.latency[op][bucket]);
+            }
+        }
+    }
+}
+
+//======================//
+// Управление ресурсами //
+//======================//
+
+//==================================================================================================
+// Функция: db_alloc
+// Назначение: Инициализирует базу данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (out) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует
+//==================================================================================================
+void db_alloc(struct Database* db)
+{
+    // Выделяем память под базу данных минимального размера.
+    db->entries = calloc(1U, sizeof(Entry_t));
+    verify_contract(db->entries != NULL,
+        "db_alloc: unable to allocate memory\n");
+
+    // Устанавливаем размер и ёмкость.
+    db->size     = 0;
+    db->capacity = 1;
+
+    // База данных размещается в динамической памяти.
+    db->mapped      = NULL;
+    db->mapped_size = 0U;
+
+    // Записи упорядочены по ключу.
+    db->layout      = DB_LAYOUT_SORTED;
+    db->rank_to_pos = NULL;
+    db->pos_to_rank = NULL;
+
+    // Изменения вносятся непосредственно в массив entries и не сохраняются на диск.
+    db->log = NULL;
+    db->wal = NULL;
+
+    // Доступ к базе данных производится из одного потока.
+    db->sync = NULL;
+
+    // Значения имеют фиксированную длину.
+    db->arena = NULL;
+
+    // Поиск производится по упорядоченному массиву.
+    db->hash = NULL;
+
+    // Ёмкость изменяется по политике по умолчанию.
+    db->policy         = DB_CAPACITY_POLICY_DEFAULT;
+    db->capacity_stats = (DbCapacityStats) {.peak_capacity = db->capacity};
+}
+
+// Предварительная декларация функции освобождения журнала изменений.
+void db_lsm_release(struct Database* db);
+
+// Предварительная декларация функции закрытия журнала предзаписи.
+void db_wal_close(struct Database* db);
+
+// Предварительная декларация функции выхода из режима одновременного доступа.
+void db_concurrent_disable(struct Database* db);
+
+//==================================================================================================
+// Функция: db_free
+// Назначение: Освобождает ресурсы под базу данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует
+//
+// Примечания:
+// - Политика управления ёмкостью сохраняется, счётчики её применения обнуляются.
+//==================================================================================================
+void db_free(struct Database* db)
+{
+    // Сбрасываем на диск и закрываем журнал предзаписи.
+    db_wal_close(db);
+
+    // Освобождаем заменённые массивы записей.
+    db_concurrent_disable(db);
+
+    // Дожидаемся фонового слияния и освобождаем журнал изменений.
+    db_lsm_release(db);
+
+    if (db->mapped != NULL)
+    {
+        // Массив entries принадлежит отображению файла в память.
+        int ret = munmap(db->mapped, db->mapped_size);
+        verify_contract(ret == 0,
+            "db_free: unable to unmap database file\n");
+    }
+    else
+    {
+        free(db->entries);
+    }
+
+    free(db->rank_to_pos);
+    free(db->pos_to_rank);
+
+#ifdef DB_ARENA_SUPPORTED
+    if (db->arena != NULL)
+    {
+        free(db->arena->bytes);
+        free(db->arena);
+    }
+#endif // DB_ARENA_SUPPORTED
+
+    if (db->hash != NULL)
+    {
+        free(db->hash->slots);
+        free(db->hash);
+    }
+
+    // Записываем мусорные значения в переменные.
+    db->entries     = NULL;
+    db->size        = 0;
+    db->capacity    = 0;
+    db->mapped      = NULL;
+    db->mapped_size = 0U;
+    db->layout      = DB_LAYOUT_SORTED;
+    db->rank_to_pos = NULL;
+    db->pos_to_rank = NULL;
+    db->arena       = NULL;
+    db->hash        = NULL;
+
+    // Политика управления ёмкостью является настройкой, а не ресурсом, и не сбрасывается.
+    db->capacity_stats = (DbCapacityStats) {.peak_capacity = db->capacity};
+}
+
+//==================================================================================================
+// Функция: db_release_entries
+// Назначение: Освобождает массив записей, заменяемый новым.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - В режиме одновременного доступа массив может читаться другими потоками,
+//   поэтому его освобождение откладывается до завершения читателей текущей эпохи
+//   (см. db_reclaim_retired).
+//==================================================================================================
+void db_release_entries(struct Database* db)
+{
+    struct DbSync* sync = db->sync;
+    if (sync == NULL)
+    {
+        free(db->entries);
+        return;
+    }
+
+    if (sync->num_retired == sync->retired_capacity)
+    {
+        sync->retired_capacity = (sync->retired_capacity == 0U)? 16U : 2U * sync->retired_capacity;
+
+        sync->retired = realloc(sync->retired, sync->retired_capacity * sizeof(DbRetired));
+        verify_contract(sync->retired != NULL,
+            "db_release_entries: unable to reallocate memory\n");
+    }
+
+    sync->retired[sync->num_retired++] = (DbRetired) {
+        .entries = db->entries,
+        .epoch   = sync->epoch
+    };
+}
+
+//==================================================================================================
+// Функция: db_allocate_entries
+// Назначение: Выделяет память под массив записей заданной ёмкости.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db       (in) - указатель на базу данных.
+// capacity (in) - ёмкость массива.
+//
+// Возвращаемое значение:
+// Указатель на выделенный массив (освобождается функцией free).
+//
+// Примечания:
+// - Массивы не меньше policy.huge_page_bytes выравниваются по границе большой страницы,
+//   и ядру сообщается о желательности размещения их в больших страницах (MADV_HUGEPAGE).
+//   Это сокращает промахи TLB при поиске в больших базах данных.
+//==================================================================================================
+Entry_t* db_allocate_entries(struct Database* db, uint32_t capacity)
+{
+    size_t bytes = (size_t) capacity * sizeof(Entry_t);
+
+    if (db->policy.huge_page_bytes == 0U || bytes < db->policy.huge_page_bytes)
+    {
+        Entry_t* entries = malloc(bytes);
+        verify_contract(entries != NULL,
+            "db_allocate_entries: unable to allocate memory\n");
+
+        return entries;
+    }
+
+    // Память выделяется целым числом больших страниц.
+    size_t huge_bytes = (bytes + DB_HUGE_PAGE_SIZE - 1U) & ~((size_t) DB_HUGE_PAGE_SIZE - 1U);
+
+    void* entries = NULL;
+    int ret = posix_memalign(&entries, DB_HUGE_PAGE_SIZE, huge_bytes);
+    verify_contract(ret == 0,
+        "db_allocate_entries: unable to allocate memory\n");
+
+    // Отказ в размещении в больших страницах не является ошибкой.
+    madvise(entries, huge_bytes, MADV_HUGEPAGE);
+
+    db->capacity_stats.num_huge_allocs++;
+
+    return entries;
+}
+
+//==================================================================================================
+// Функция: db_resize_entries
+// Назначение: Изменяет ёмкость массива записей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db       (in) - указатель на базу данных.
+// capacity (in) - новая ёмкость массива (не меньше размера базы данных).
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_resize_entries(struct Database* db, uint32_t capacity)
+{
+    DbCapacityStats* stats = &db->capacity_stats;
+    DB_STATS_ADD(num_reallocs, 1U);
+
+    if (capacity > db->capacity)
+    {
+        stats->num_grows++;
+    }
+    else
+    {
+        stats->num_shrinks++;
+    }
+
+    stats->bytes_moved += (uint64_t) db->size * sizeof(Entry_t);
+
+    if (capacity > stats->peak_capacity)
+    {
+        stats->peak_capacity = capacity;
+    }
+
+    bool huge = db->policy.huge_page_bytes != 0U &&
+                (size_t) capacity * sizeof(Entry_t) >= db->policy.huge_page_bytes;
+
+    if (db->sync == NULL && !huge)
+    {
+        Entry_t* entries = realloc(db->entries, capacity * sizeof(Entry_t));
+        verify_contract(entries != NULL,
+            "db_resize_entries: unable to reallocate memory\n");
+
+        DB_STORE(db->entries, entries);
+    }
+    else
+    {   // Старый массив остаётся доступным читателям, записи копируются в новый.
+        // Выровненный массив для больших страниц также не может быть получен через realloc.
+        Entry_t* entries = db_allocate_entries(db, capacity);
+
+        memcpy(entries, db->entries, db->size * sizeof(Entry_t));
+
+        db_release_entries(db);
+        DB_STORE(db->entries, entries);
+    }
+
+    db->capacity = capacity;
+}
+
+//==================================================================================================
+// Функция: db_grow_entries
+// Назначение: Увеличивает ёмкость массива записей по политике базы данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db     (in) - указатель на базу данных.
+// needed (in) - необходимая ёмкость массива.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_grow_entries(struct Database* db, uint32_t needed)
+{
+    if (needed <= db->capacity)
+    {
+        return;
+    }
+
+    // Ёмкость увеличивается геометрически, чтобы вставка выполнялась за амортизированное O(n).
+    uint64_t capacity = (uint64_t) db->capacity * db->policy.growth_percent / 100U;
+    if (capacity < needed)
+    {
+        capacity = needed;
+    }
+    if (capacity < db->policy.min_capacity)
+    {
+        capacity = db->policy.min_capacity;
+    }
+    if (capacity > 0xFFFFFFFFU / sizeof(Entry_t))
+    {
+        capacity = (needed > 0xFFFFFFFFU / sizeof(Entry_t))? needed : 0xFFFFFFFFU / sizeof(Entry_t);
+    }
+
+    db_resize_entries(db, capacity);
+}
+
+//==================================================================================================
+// Функция: db_shrink_target
+// Назначение: Вычисляет ёмкость, до которой уменьшается массив записей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Ёмкость массива после уменьшения.
+//
+// Примечания:
+// - После уменьшения в массиве остаётся запас в growth_percent процентов от размера:
+//   следующее увеличение потребует столько же вставок, сколько удалений - следующее
+//   уменьшение. Благодаря этому чередование вставок и удалений вблизи порога
+//   не приводит к изменению ёмкости при каждой операции.
+//==================================================================================================
+uint32_t db_shrink_target(const struct Database* db)
+{
+    uint64_t capacity = (uint64_t) db->size * db->policy.growth_percent / 100U;
+    if (capacity < db->policy.min_capacity)
+    {
+        capacity = db->policy.min_capacity;
+    }
+    if (capacity == 0U)
+    {
+        capacity = 1U;
+    }
+
+    return (capacity < db->capacity)? capacity : db->capacity;
+}
+
+//==================================================================================================
+// Функция: db_set_capacity_policy
+// Назначение: Устанавливает политику управления ёмкостью массива записей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db     (in/out) - указатель на базу данных.
+// policy (in)     - политика управления ёмкостью.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Для гистерезиса порог уменьшения должен лежать ниже заполнения после уменьшения:
+//   shrink_divisor * 100 > growth_percent.
+//==================================================================================================
+void db_set_capacity_policy(struct Database* db, const DbCapacityPolicy* policy)
+{
+    verify_contract(policy->growth_percent > 100U,
+        "db_set_capacity_policy: growth factor must exceed 100%%\n");
+    verify_contract(policy->shrink_divisor == 0U ||
+                    (uint64_t) policy->shrink_divisor * 100U > policy->growth_percent,
+        "db_set_capacity_policy: shrink threshold must lie below post-shrink fill\n");
+
+    db->policy = *policy;
+}
+
+//==================================================================================================
+// Функция: db_capacity_stats
+// Назначение: Возвращает счётчики операций изменения ёмкости массива записей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in)  - указатель на базу данных.
+// stats (out) - счётчики.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_capacity_stats(const struct Database* db, DbCapacityStats* stats)
+{
+    *stats = db->capacity_stats;
+}
+
+//==================================================================================================
+// Функция: db_reserve
+// Назначение: Заранее увеличивает ёмкость массива записей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db       (in/out) - указатель на базу данных.
+// capacity (in)     - необходимая ёмкость.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Последующие вставки до заданной ёмкости не изменяют массив.
+// - Удаления могут уменьшить ёмкость по политике; чтобы сохранить зарезервированный
+//   объём, следует установить policy.min_capacity.
+//==================================================================================================
+void db_reserve(struct Database* db, uint32_t capacity)
+{
+    verify_contract(db->mapped == NULL,
+        "db_reserve: database is mapped from file and is read-only\n");
+    verify_contract(db->log == NULL,
+        "db_reserve: array is replaced on compaction in log-structured mode\n");
+
+    if (capacity > db->capacity)
+    {
+        db_resize_entries(db, capacity);
+    }
+}
+
+//==================================================================================================
+// Функция: db_shrink
+// Назначение: Уменьшает ёмкость массива записей до размера с запасом по политике базы данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Позволяет выполнить уменьшение однократно после серии удалений
+//   (при policy.shrink_period, равном 0, удаления сами ёмкость не уменьшают).
+//==================================================================================================
+void db_shrink(struct Database* db)
+{
+    verify_contract(db->mapped == NULL,
+        "db_shrink: database is mapped from file and is read-only\n");
+    verify_contract(db->log == NULL,
+        "db_shrink: array is replaced on compaction in log-structured mode\n");
+
+    uint32_t capacity = db_shrink_target(db);
+    if (capacity < db->capacity)
+    {
+        db_resize_entries(db, capacity);
+    }
+}
+
+//=============================//
+// Размещение записей в памяти //
+//=============================//
+
+//==================================================================================================
+// Функция: db_eytzinger_fill
+// Назначение: Рекурсивно заполняет поддерево в размещении Эйтцингера.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db     (in/out) - указатель на базу данных с выделенными массивами rank_to_pos и pos_to_rank.
+// sorted (in)     - записи, упорядоченные по возрастанию ключа.
+// eytz   (out)    - массив записей в размещении Эйтцингера.
+// rank   (in)     - индекс первой записи поддерева в упорядоченном массиве.
+// k      (in)     - номер (с единицы) корня поддерева в размещении Эйтцингера.
+//
+// Возвращаемое значение:
+// Индекс записи в упорядоченном массиве, следующей за последней записью поддерева.
+//==================================================================================================
+uint32_t db_eytzinger_fill(struct Database* db, const Entry_t* sorted, Entry_t* eytz,
+                           uint32_t rank, size_t k)
+{
+    if (k > db->size)
+    {
+        return rank;
+    }
+
+    // Центрированный обход: левое поддерево, корень, правое поддерево.
+    rank = db_eytzinger_fill(db, sorted, eytz, rank, 2U * k);
+
+    eytz[k - 1U]            = sorted[rank];
+    db->rank_to_pos[rank]   = k - 1U;
+    db->pos_to_rank[k - 1U] = rank;
+    rank++;
+
+    return db_eytzinger_fill(db, sorted, eytz, rank, 2U * k + 1U);
+}
+
+//==================================================================================================
+// Функция: db_layout_eytzinger
+// Назначение: Переупорядочивает записи базы данных в размещение Эйтцингера.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Размещение оптимизировано для чтения: верхние уровни неявного дерева поиска лежат в начале
+//   массива и постоянно находятся в кеше, а потомки узла на два уровня ниже занимают одну-две
+//   кеш-линии и могут быть подгружены заранее.
+// - Индексы db_at_index и db_search сохраняют смысл порядковых номеров по возрастанию ключа
+//   благодаря массивам rank_to_pos и pos_to_rank (дополнительно 8 байт на запись).
+// - Вызовы db_insert и db_remove возвращают базу данных к упорядоченному размещению.
+// - Отображённая в память база данных копируется в динамическую память.
+// - Размещение несовместимо с log-structured режимом.
+//==================================================================================================
+void db_layout_eytzinger(struct Database* db)
+{
+    verify_contract(db->log == NULL,
+        "db_layout_eytzinger: layout is incompatible with log-structured mode\n");
+    verify_contract(db->sync == NULL,
+        "db_layout_eytzinger: layout is incompatible with concurrent access mode\n");
+
+    if (db->layout == DB_LAYOUT_EYTZINGER)
+    {
+        return;
+    }
+
+    // Выделяем массивы для нового размещения.
+    Entry_t* eytz = calloc(db->size + 1U, sizeof(Entry_t));
+    db->rank_to_pos = calloc(db->size + 1U, sizeof(uint32_t));
+    db->pos_to_rank = calloc(db->size + 1U, sizeof(uint32_t));
+    verify_contract(eytz != NULL && db->rank_to_pos != NULL && db->pos_to_rank != NULL,
+        "db_layout_eytzinger: unable to allocate memory\n");
+
+    // Переносим записи в новое размещение.
+    db_eytzinger_fill(db, db->entries, eytz, 0U, 1U);
+
+    // Освобождаем память под старое размещение.
+    if (db->mapped != NULL)
+    {
+        int ret = munmap(db->mapped, db->mapped_size);
+        verify_contract(ret == 0,
+            "db_layout_eytzinger: unable to unmap database file\n");
+
+        db->mapped      = NULL;
+        db->mapped_size = 0U;
+    }
+    else
+    {
+        free(db->entries);
+    }
+
+    DB_STORE(db->entries, eytz);
+    db->capacity = db->size + 1U;
+    db->layout   = DB_LAYOUT_EYTZINGER;
+}
+
+//==================================================================================================
+// Функция: db_layout_sorted
+// Назначение: Возвращает записи базы данных к упорядоченному по ключу размещению.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_layout_sorted(struct Database* db)
+{
+    if (db->layout == DB_LAYOUT_SORTED)
+    {
+        return;
+    }
+
+    // Выделяем массив для упорядоченного размещения.
+    Entry_t* sorted = calloc(db->capacity, sizeof(Entry_t));
+    verify_contract(sorted != NULL,
+        "db_layout_sorted: unable to allocate memory\n");
+
+    for (uint32_t rank = 0U; rank < db->size; ++rank)
+    {
+        sorted[rank] = db->entries[db->rank_to_pos[rank]];
+    }
+
+    free(db->entries);
+    free(db->rank_to_pos);
+    free(db->pos_to_rank);
+
+    DB_STORE(db->entries, sorted);
+    db->layout      = DB_LAYOUT_SORTED;
+    db->rank_to_pos = NULL;
+    db->pos_to_rank = NULL;
+}
+
+//==================================================================================================
+// Функция: db_entry
+// Назначение: Возвращает запись по индексу в базе данных независимо от размещения.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in) - указатель на базу данных.
+// index (in) - индекс (порядковый номер по возрастанию ключа) записи в базе данных.
+//
+// Возвращаемое значение:
+// Указатель на запись.
+//==================================================================================================
+const Entry_t* db_entry(const struct Database* db, uint32_t index)
+{
+    if (db->layout == DB_LAYOUT_EYTZINGER)
+    {
+        return &db->entries[db->rank_to_pos[index]];
+    }
+
+    return &db->entries[index];
+}
+
+//===================================//
+// Журнал изменений (log-structured) //
+//===================================//
+
+//==================================================================================================
+// Функция: db_run_find
+// Назначение: Ищет запись по ключу в упорядоченном массиве записей журнала.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// entries (in) - упорядоченный по ключу массив записей журнала.
+// size    (in) - количество записей.
+// key     (in) - искомый ключ.
+//
+// Возвращаемое значение:
+// Индекс первой записи с ключом не меньше искомого.
+//==================================================================================================
+uint32_t db_run_find(const LogEntry_t* entries, uint32_t size, DbKey_t key)
+{
+    uint32_t low  = 0U;
+    uint32_t high = size;
+
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low)/2U;
+
+        if (entries[mid].entry.key < key)
+        {
+            low = mid + 1U;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+//==================================================================================================
+// Функция: db_lsm_find
+// Назначение: Ищет последнее изменение ключа в журнале.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// log (in) - журнал изменений.
+// key (in) - искомый ключ.
+//
+// Возвращаемое значение:
+// Указатель на запись журнала или NULL, если ключ в журнале не изменялся.
+//
+// Примечания:
+// - Буфер записи и фрагменты просматриваются от новых изменений к старым.
+//==================================================================================================
+const LogEntry_t* db_lsm_find(const struct DbLog* log, DbKey_t key)
+{
+    uint32_t pos = db_run_find(log->buffer, log->buffer_size, key);
+    if (pos < log->buffer_size && log->buffer[pos].entry.key == key)
+    {
+        return &log->buffer[pos];
+    }
+
+    for (uint32_t run_i = log->num_runs; run_i > 0U; --run_i)
+    {
+        const DbRun* run = &log->runs[run_i - 1U];
+
+        pos = db_run_find(run->entries, run->size, key);
+        if (pos < run->size && run->entries[pos].entry.key == key)
+        {
+            return &run->entries[pos];
+        }
+    }
+
+    return NULL;
+}
+
+//==================================================================================================
+// Функция: db_lsm_pending
+// Назначение: Проверяет наличие в журнале изменений, не слитых с основным массивом.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// TRUE  - журнал содержит неслитые изменения.
+// FALSE - содержимое базы данных полностью находится в массиве entries.
+//==================================================================================================
+bool db_lsm_pending(const struct Database* db)
+{
+    return db->log != NULL && (db->log->buffer_size != 0U || db->log->num_runs != 0U);
+}
+
+//==================================================================================================
+// Функция: db_lsm_merge_runs
+// Назначение: Сливает два фрагмента журнала в один.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// older (in) - более старый фрагмент.
+// newer (in) - более новый фрагмент.
+//
+// Возвращаемое значение:
+// Новый фрагмент. При совпадении ключей сохраняется запись из более нового фрагмента.
+//==================================================================================================
+DbRun db_lsm_merge_runs(DbRun older, DbRun newer)
+{
+    DbRun merged;
+    merged.entries = calloc(older.size + newer.size, sizeof(LogEntry_t));
+    merged.size    = 0U;
+    verify_contract(merged.entries != NULL,
+        "db_lsm_merge_runs: unable to allocate memory\n");
+
+    uint32_t i = 0U;
+    uint32_t j = 0U;
+    while (i < older.size || j < newer.size)
+    {
+        if (j == newer.size ||
+            (i < older.size && older.entries[i].entry.key < newer.entries[j].entry.key))
+        {
+            merged.entries[merged.size++] = older.entries[i++];
+        }
+        else
+        {
+            if (i < older.size && older.entries[i].entry.key == newer.entries[j].entry.key)
+            {   // Старая запись перекрыта новой.
+                i++;
+            }
+
+            merged.entries[merged.size++] = newer.entries[j++];
+        }
+    }
+
+    return merged;
+}
+
+//==================================================================================================
+// Функция: db_lsm_compactor
+// Назначение: Точка входа потока фонового слияния журнала с основным массивом.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// arg (in) - указатель на журнал изменений (struct DbLog).
+//
+// Возвращаемое значение:
+// NULL.
+//
+// Примечания:
+// - Поток только читает основной массив и фрагменты runs[0..num_compacting), которые не
+//   изменяются до завершения слияния, и записывает результат в собственный массив merged.
+//   Поэтому основной поток продолжает поиск и запись в буфер без блокировок.
+//==================================================================================================
+void* db_lsm_compactor(void* arg)
+{
+    struct DbLog* log = arg;
+
+    // Сливаем сливаемые фрагменты в один, от старых к новым.
+    DbRun combined = log->runs[0];
+    for (uint32_t run_i = 1U; run_i < log->num_compacting; ++run_i)
+    {
+        DbRun next = db_lsm_merge_runs(combined, log->runs[run_i]);
+
+        if (run_i > 1U)
+        {
+            free(combined.entries);
+        }
+
+        combined = next;
+    }
+
+    // Сливаем фрагмент с основным массивом, отбрасывая удалённые ключи.
+    log->merged = calloc(log->main_size + combined.size + 1U, sizeof(Entry_t));
+    verify_contract(log->merged != NULL,
+        "db_lsm_compactor: unable to allocate memory\n");
+
+    uint32_t size = 0U;
+    uint32_t i    = 0U;
+    uint32_t j    = 0U;
+    while (i < log->main_size || j < combined.size)
+    {
+        if (j == combined.size ||
+            (i < log->main_size && log->main_entries[i].key < combined.entries[j].entry.key))
+        {
+            log->merged[size++] = log->main_entries[i++];
+        }
+        else
+        {
+            if (i < log->main_size && log->main_entries[i].key == combined.entries[j].entry.key)
+            {   // Запись основного массива перекрыта записью журнала.
+                i++;
+            }
+
+            if (!combined.entries[j].removed)
+            {
+                log->merged[size++] = combined.entries[j].entry;
+            }
+
+            j++;
+        }
+    }
+
+    log->merged_size = size;
+
+    if (log->num_compacting > 1U)
+    {
+        free(combined.entries);
+    }
+
+    // Сообщаем основному потоку о завершении слияния.
+    __atomic_store_n(&log->compaction_done, true, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+//==================================================================================================
+// Функция: db_lsm_start_compaction
+// Назначение: Запускает фоновое слияние всех фрагментов журнала с основным массивом.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_lsm_start_compaction(struct Database* db)
+{
+    struct DbLog* log = db->log;
+
+    if (log->compacting || log->num_runs == 0U)
+    {
+        return;
+    }
+
+    log->compacting      = true;
+    log->compaction_done = false;
+    log->num_compacting  = log->num_runs;
+    log->main_entries    = db->entries;
+    log->main_size       = db->size;
+    log->merged          = NULL;
+    log->merged_size     = 0U;
+
+    int ret = pthread_create(&log->compactor, NULL, db_lsm_compactor, log);
+    verify_contract(ret == 0,
+        "db_lsm_start_compaction: unable to create compaction thread\n");
+}
+
+//==================================================================================================
+// Функция: db_lsm_finish_compaction
+// Назначение: Устанавливает результат фонового слияния в качестве основного массива.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db   (in/out) - указатель на базу данных.
+// wait (in)     - дожидаться ли завершения слияния.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Без ожидания функция ничего не делает, если слияние ещё не завершено.
+//==================================================================================================
+void db_lsm_finish_compaction(struct Database* db, bool wait)
+{
+    struct DbLog* log = db->log;
+
+    if (!log->compacting)
+    {
+        return;
+    }
+
+    if (!wait && !__atomic_load_n(&log->compaction_done, __ATOMIC_ACQUIRE))
+    {
+        return;
+    }
+
+    int ret = pthread_join(log->compactor, NULL);
+    verify_contract(ret == 0,
+        "db_lsm_finish_compaction: unable to join compaction thread\n");
+
+    // Заменяем основной массив результатом слияния.
+    free(db->entries);
+
+    // Массив merged выделен с запасом как минимум в один элемент.
+    DB_STORE(db->entries, log->merged);
+    DB_STORE(db->size,    log->merged_size);
+    db->capacity = log->merged_size + 1U;
+
+    // Освобождаем слитые фрагменты и сдвигаем оставшиеся.
+    for (uint32_t run_i = 0U; run_i < log->num_compacting; ++run_i)
+    {
+        free(log->runs[run_i].entries);
+    }
+
+    for (uint32_t run_i = log->num_compacting; run_i < log->num_runs; ++run_i)
+    {
+        log->runs[run_i - log->num_compacting] = log->runs[run_i];
+    }
+
+    log->num_runs      -= log->num_compacting;
+    log->num_compacting = 0U;
+    log->compacting     = false;
+    log->merged         = NULL;
+}
+
+//==================================================================================================
+// Функция: db_lsm_freeze_buffer
+// Назначение: Превращает буфер записи в неизменяемый фрагмент журнала.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - При накоплении DB_LSM_COMPACT_RUNS фрагментов запускается фоновое слияние.
+// - При заполнении всех DB_LSM_MAX_RUNS фрагментов функция дожидается слияния.
+//==================================================================================================
+void db_lsm_freeze_buffer(struct Database* db)
+{
+    struct DbLog* log = db->log;
+
+    if (log->buffer_size == 0U)
+    {
+        return;
+    }
+
+    while (log->num_runs == DB_LSM_MAX_RUNS)
+    {
+        db_lsm_start_compaction(db);
+        db_lsm_finish_compaction(db, true);
+    }
+
+    // Буфер становится новейшим фрагментом.
+    log->runs[log->num_runs].entries = log->buffer;
+    log->runs[log->num_runs].size    = log->buffer_size;
+    log->num_runs++;
+
+    // Выделяем новый буфер.
+    log->buffer      = calloc(DB_LSM_BUFFER_SIZE, sizeof(LogEntry_t));
+    log->buffer_size = 0U;
+    verify_contract(log->buffer != NULL,
+        "db_lsm_freeze_buffer: unable to allocate memory\n");
+
+    if (log->num_runs >= DB_LSM_COMPACT_RUNS)
+    {
+        db_lsm_start_compaction(db);
+    }
+}
+
+//==================================================================================================
+// Функция: db_lsm_put
+// Назначение: Записывает изменение ключа в буфер записи.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db      (in/out) - указатель на базу данных.
+// key     (in)     - изменяемый ключ.
+// value   (in)     - новое значение (игнорируется при удалении).
+// removed (in)     - признак удаления ключа.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Стоимость записи ограничена размером буфера и не зависит от размера базы данных.
+//==================================================================================================
+void db_lsm_put(struct Database* db, DbKey_t key, const char value[VALUE_SIZE], bool removed)
+{
+    struct DbLog* log = db->log;
+
+    // Устанавливаем результат завершившегося слияния.
+    db_lsm_finish_compaction(db, false);
+
+    uint32_t pos = db_run_find(log->buffer, log->buffer_size, key);
+    if (pos == log->buffer_size || log->buffer[pos].entry.key != key)
+    {   // Ключ отсутствует в буфере.
+        if (log->buffer_size == DB_LSM_BUFFER_SIZE)
+        {
+            db_lsm_freeze_buffer(db);
+            pos = 0U;
+        }
+
+        // Сдвигаем записи буфера на одну вправо.
+        memmove(&log->buffer[pos + 1U], &log->buffer[pos],
+            (log->buffer_size - pos) * sizeof(LogEntry_t));
+        log->buffer_size++;
+    }
+
+    log->buffer[pos].entry.key = key;
+    log->buffer[pos].removed   = removed;
+    if (!removed)
+    {
+        memcpy(log->buffer[pos].entry.value, value, VALUE_SIZE);
+    }
+}
+
+//==================================================================================================
+// Функция: db_lsm_enable
+// Назначение: Включает log-structured режим для базы данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - В log-structured режиме db_insert и db_remove записывают изменения в небольшой буфер
+//   (удаление - запись-надгробие), буфер при заполнении становится неизменяемым фрагментом,
+//   а фрагменты сливаются с основным массивом в фоновом потоке.
+// - Поиск просматривает буфер, затем фрагменты от новых к старым, затем основной массив.
+// - Доступ по индексу (db_at_index), запись в файл и индекс, возвращаемый db_search, требуют
+//   предварительного вызова db_lsm_flush.
+//==================================================================================================
+void db_lsm_enable(struct Database* db)
+{
+    verify_contract(db->mapped == NULL,
+        "db_lsm_enable: database is mapped read-only\n");
+    verify_contract(db->sync == NULL,
+        "db_lsm_enable: log-structured mode is incompatible with concurrent access mode\n");
+    verify_contract(db->arena == NULL,
+        "db_lsm_enable: log-structured mode is incompatible with variable-length values\n");
+    verify_contract(db->hash == NULL,
+        "db_lsm_enable: log-structured mode is incompatible with hash index\n");
+
+    if (db->log != NULL)
+    {
+        return;
+    }
+
+    // Журнал работает поверх упорядоченного массива.
+    db_layout_sorted(db);
+
+    db->log = calloc(1U, sizeof(struct DbLog));
+    verify_contract(db->log != NULL,
+        "db_lsm_enable: unable to allocate memory\n");
+
+    db->log->buffer = calloc(DB_LSM_BUFFER_SIZE, sizeof(LogEntry_t));
+    verify_contract(db->log->buffer != NULL,
+        "db_lsm_enable: unable to allocate memory\n");
+
+    db->log->live_size = db->size;
+}
+
+//==================================================================================================
+// Функция: db_lsm_flush
+// Назначение: Сливает все изменения из журнала с основным массивом.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Функция дожидается завершения слияния.
+//==================================================================================================
+void db_lsm_flush(struct Database* db)
+{
+    if (db->log == NULL)
+    {
+        return;
+    }
+
+    db_lsm_freeze_buffer(db);
+
+    // Дожидаемся текущего слияния, затем сливаем оставшиеся фрагменты.
+    db_lsm_finish_compaction(db, true);
+    db_lsm_start_compaction(db);
+    db_lsm_finish_compaction(db, true);
+}
+
+//==================================================================================================
+// Функция: db_lsm_release
+// Назначение: Освобождает журнал изменений без слияния с основным массивом.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_lsm_release(struct Database* db)
+{
+    if (db->log == NULL)
+    {
+        return;
+    }
+
+    db_lsm_finish_compaction(db, true);
+
+    for (uint32_t run_i = 0U; run_i < db->log->num_runs; ++run_i)
+    {
+        free(db->log->runs[run_i].entries);
+    }
+
+    free(db->log->buffer);
+    free(db->log);
+
+    db->log = NULL;
+}
+
+//==================================================================================================
+// Функция: db_lsm_disable
+// Назначение: Выключает log-structured режим для базы данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_lsm_disable(struct Database* db)
+{
+    db_lsm_flush(db);
+    db_lsm_release(db);
+}
+
+//===============================//
+// Доступ к элементам по индексу //
+//===============================//
+
+//==================================================================================================
+// Функция: db_size
+// Назначение: Возвращает количество элементов в базе данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Количество элементов в базе данных.
+//==================================================================================================
+uint32_t db_size(const struct Database* db)
+{
+    if (db->log != NULL)
+    {
+        return db->log->live_size;
+    }
+
+    return db->size;
+}
+
+//==================================================================================================
+// Функция: db_at_index
+// Назначение: Считывает ключ и значение по индексу в базе данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in)  - указатель на базу данных.
+// index (in)  - индекс элемента а базе данных.
+// key   (out) - указатель на записываемый функцию ключ.
+// value (out) - указатель на записываемое функцией значение.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Вызов функций db_insert и db_remove могут менять ключ-значение по индексу. 
+//==================================================================================================
+void db_at_index(const struct Database* db, uint32_t index, DbKey_t* key, char value[VALUE_SIZE])
+{
+    verify_contract(!db_lsm_pending(db),
+        "db_at_index: log-structured database must be flushed first\n");
+    verify_contract(index < db->size,
+        "db_at_index: unable to get element at index %u (size is %u)\n",
+        index, db->size);
+
+    const Entry_t* entry = db_entry(db, index);
+
+    *key = entry->key;
+    memcpy(value, entry->value, VALUE_SIZE);
+}
+
+//============//
+// Хеш-индекс //
+//============//
+
+// Наименьшее количество ячеек хеш-индекса.
+#define DB_HASH_MIN_CAPACITY 16U
+
+//==================================================================================================
+// Функция: db_hash_home
+// Назначение: Вычисляет номер ячейки, с которой начинается поиск ключа в хеш-индексе.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// hash (in) - указатель на хеш-индекс.
+// key  (in) - ключ.
+//
+// Возвращаемое значение:
+// Номер ячейки.
+//
+// Примечания:
+// - Мультипликативное хеширование: старшие биты произведения зависят от всех битов ключа,
+//   поэтому последовательные ключи (например, адреса одной подсети) не образуют кластеров.
+//==================================================================================================
+uint32_t db_hash_home(const struct DbHash* hash, DbKey_t key)
+{
+    return (uint32_t) ((DbKey_t) (key * DB_KEY_HASH_MULTIPLIER) >> hash->shift);
+}
+
+//==================================================================================================
+// Функция: db_hash_put
+// Назначение: Добавляет в хеш-индекс отсутствующий в нём ключ.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// hash  (in) - указатель на хеш-индекс.
+// key   (in) - ключ.
+// index (in) - индекс записи с этим ключом.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_hash_put(struct DbHash* hash, DbKey_t key, uint32_t index)
+{
+    uint32_t mask = hash->capacity - 1U;
+    uint32_t slot = db_hash_home(hash, key);
+
+    while (hash->slots[slot].index != DB_NO_INDEX)
+    {
+        slot = (slot + 1U) & mask;
+    }
+
+    hash->slots[slot].key   = key;
+    hash->slots[slot].index = index;
+}
+
+//==================================================================================================
+// Функция: db_hash_rebuild
+// Назначение: Строит хеш-индекс заново по записям базы данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на базу данных с хеш-индексом.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Размер таблицы выбирается так, чтобы она была заполнена не более чем наполовину.
+// - Перестроение занимает O(size) и используется после пакетной вставки
+//   и при увеличении таблицы.
+//==================================================================================================
+void db_hash_rebuild(struct Database* db)
+{
+    struct DbHash* hash = db->hash;
+
+    uint32_t capacity = DB_HASH_MIN_CAPACITY;
+    uint32_t shift    = DB_KEY_BITS - 4U;
+    while (capacity < 2U * db->size)
+    {
+        capacity *= 2U;
+        shift    -= 1U;
+    }
+
+    if (capacity != hash->capacity)
+    {
+        free(hash->slots);
+
+        hash->slots = malloc(capacity * sizeof(HashSlot_t));
+        verify_contract(hash->slots != NULL,
+            "db_hash_rebuild: unable to allocate memory\n");
+
+        hash->capacity = capacity;
+        hash->shift    = shift;
+    }
+
+    // Все байты свободной ячейки равны 0xFF.
+    memset(hash->slots, 0xFF, capacity * sizeof(HashSlot_t));
+
+    for (uint32_t i = 0U; i < db->size; ++i)
+    {
+        db_hash_put(hash, db_entry(db, i)->key, i);
+    }
+}
+
+//==================================================================================================
+// Функция: db_hash_enable
+// Назначение: Строит хеш-индекс для поиска записей по ключу за O(1).
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Индекс отображает ключ в индекс записи и поддерживается функциями db_insert,
+//   db_remove и db_insert_batch. db_search обращается к памяти дважды (ячейка таблицы
+//   и запись) вместо log2(size) зависимых обращений бинарного поиска.
+// - Обход диапазона ключей по-прежнему использует упорядоченный массив.
+// - Индекс несовместим с log-structured режимом.
+//==================================================================================================
+void db_hash_enable(struct Database* db)
+{
+    verify_contract(db->log == NULL,
+        "db_hash_enable: hash index is incompatible with log-structured mode\n");
+
+    if (db->hash != NULL)
+    {
+        return;
+    }
+
+    db->hash = calloc(1U, sizeof(struct DbHash));
+    verify_contract(db->hash != NULL,
+        "db_hash_enable: unable to allocate memory\n");
+
+    db->hash->slots    = NULL;
+    db->hash->capacity = 0U;
+    db->hash->shift    = 0U;
+
+    db_hash_rebuild(db);
+}
+
+//==================================================================================================
+// Функция: db_hash_disable
+// Назначение: Освобождает хеш-индекс.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_hash_disable(struct Database* db)
+{
+    if (db->hash == NULL)
+    {
+        return;
+    }
+
+    free(db->hash->slots);
+    free(db->hash);
+
+    db->hash = NULL;
+}
+
+//==================================================================================================
+// Функция: db_hash_slot
+// Назначение: Находит ячейку хеш-индекса, содержащую ключ.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// hash (in) - указатель на хеш-индекс.
+// key  (in) - ключ.
+//
+// Возвращаемое значение:
+// Номер ячейки с ключом или номер свободной ячейки, если ключ отсутствует.
+//==================================================================================================
+uint32_t db_hash_slot(const struct DbHash* hash, DbKey_t key)
+{
+    uint32_t mask = hash->capacity - 1U;
+    uint32_t slot = db_hash_home(hash, key);
+
+    while (hash->slots[slot].index != DB_NO_INDEX)
+    {
+        DB_STATS_ADD(num_probes, 1U);
+
+        if (hash->slots[slot].key == key)
+        {
+            return slot;
+        }
+
+        slot = (slot + 1U) & mask;
+    }
+
+    return slot;
+}
+
+//==================================================================================================
+// Функция: db_hash_find
+// Назначение: Находит индекс записи по ключу в хеш-индексе.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// hash (in) - указатель на хеш-индекс.
+// key  (in) - ключ.
+//
+// Возвращаемое значение:
+// Индекс записи или DB_NO_INDEX, если ключ отсутствует.
+//==================================================================================================
+uint32_t db_hash_find(const struct DbHash* hash, DbKey_t key)
+{
+    return hash->slots[db_hash_slot(hash, key)].index;
+}
+
+//==================================================================================================
+// Функция: db_hash_renumber
+// Назначение: Обновляет в хеш-индексе индексы записей, сдвинутых вставкой или удалением.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in/out) - указатель на базу данных с хеш-индексом.
+// first (in)     - индекс первой сдвинутой записи.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Обновляются только ячейки записей с индексами от first до конца массива: стоимость
+//   пропорциональна сдвигу массива entries, а не размеру таблицы.
+//==================================================================================================
+void db_hash_renumber(struct Database* db, uint32_t first)
+{
+    struct DbHash* hash = db->hash;
+
+    for (uint32_t i = first; i < db->size; ++i)
+    {
+        hash->slots[db_hash_slot(hash, db_entry(db, i)->key)].index = i;
+    }
+}
+
+//==================================================================================================
+// Функция: db_hash_insert_at
+// Назначение: Учитывает в хеш-индексе вставку записи.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in/out) - указатель на базу данных с хеш-индексом.
+// key   (in)     - ключ вставленной записи.
+// index (in)     - индекс вставленной записи.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Вызывается после вставки: индексы последующих записей увеличились на единицу.
+//==================================================================================================
+void db_hash_insert_at(struct Database* db, DbKey_t key, uint32_t index)
+{
+    struct DbHash* hash = db->hash;
+
+    if (2U * db->size > hash->capacity)
+    {   // Таблица заполнена больше чем наполовину.
+        db_hash_rebuild(db);
+        return;
+    }
+
+    db_hash_renumber(db, index + 1U);
+    db_hash_put(hash, key, index);
+}
+
+//==================================================================================================
+// Функция: db_hash_remove_at
+// Назначение: Учитывает в хеш-индексе удаление записи.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in/out) - указатель на базу данных с хеш-индексом.
+// key   (in)     - ключ удалённой записи.
+// index (in)     - индекс удалённой записи.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Вызывается после удаления: индексы последующих записей уменьшились на единицу.
+// - Ячейка удаляется сдвигом последующих ячеек цепочки назад, без пометок об удалении:
+//   длина цепочек не растёт при чередовании вставок и удалений.
+//==================================================================================================
+void db_hash_remove_at(struct Database* db, DbKey_t key, uint32_t index)
+{
+    struct DbHash* hash = db->hash;
+    uint32_t mask = hash->capacity - 1U;
+
+    // Находим ячейку удаляемого ключа.
+    uint32_t hole = db_hash_slot(hash, key);
+
+    // Сдвигаем назад ячейки, начальная ячейка которых не лежит между дырой и ними.
+    for (uint32_t slot = (hole + 1U) & mask;
+         hash->slots[slot].index != DB_NO_INDEX;
+         slot = (slot + 1U) & mask)
+    {
+        uint32_t home = db_hash_home(hash, hash->slots[slot].key);
+
+        if (((slot - home) & mask) >= ((slot - hole) & mask))
+        {
+            hash->slots[hole] = hash->slots[slot];
+            hole = slot;
+        }
+    }
+
+    hash->slots[hole].index = DB_NO_INDEX;
+
+    db_hash_renumber(db, index);
+}
+
+//==================================================================================================
+// Функция: db_search_hash
+// Назначение: Ищет в базе данных значение по заданному ключу при помощи хеш-индекса.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in)  - указатель на базу данных с хеш-индексом.
+// key   (in)  - искомый ключ.
+// value (out) - указатель на записываемое функцией значение.
+// index (out) - указатель на индекс элемента в базе данных.
+//
+// Возвращаемое значение:
+// TRUE  - значение по ключу найдено.
+// FALSE - значение по ключу отсутствует.
+//==================================================================================================
+bool db_search_hash(const struct Database* db, DbKey_t key, char value[VALUE_SIZE],
+                    uint32_t* index)
+{
+    uint32_t found = db_hash_find(db->hash, key);
+    if (found == DB_NO_INDEX)
+    {
+        return false;
+    }
+
+    memcpy(value, db_entry(db, found)->value, VALUE_SIZE);
+    *index = found;
+    return true;
+}
+
+//================================//
+// Доступ к элементам БД по ключу //
+//================================//
+
+//==================================================================================================
+// Функция: db_search_eytzinger
+// Назначение: Ищет значение по ключу в базе данных с размещением Эйтцингера.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in)  - указатель на базу данных.
+// key   (in)  - искомый ключ.
+// value (out) - указатель на записываемое функцией значение.
+// index (out) - указатель на индекс элемента в базе данных.
+//
+// Возвращаемое значение:
+// TRUE  - значение по ключу найдено.
+// FALSE - значение по ключу отсутствует.
+//
+// Примечания:
+// - Спуск по дереву не содержит условных переходов: номер следующего узла вычисляется
+//   из результата сравнения. По окончании спуска номер узла, в котором поиск последний раз
+//   свернул налево, восстанавливается из младших битов номера.
+//==================================================================================================
+bool db_search_eytzinger(const struct Database* db, DbKey_t key, char value[VALUE_SIZE],
+                         uint32_t* index)
+{
+    // Номер текущего узла неявного дерева (с единицы).
+    size_t k = 1U;
+
+    while (k <= db->size)
+    {
+        // Подгружаем в кеш потомков текущего узла на два уровня ниже (узлы 4k..4k+3).
+        // У узлов вблизи листьев таких потомков нет: адрес за концом массива не вычисляется.
+        if (4U * k + 2U < db->size)
+        {
+            __builtin_prefetch(&db->entries[4U * k - 1U]);
+            __builtin_prefetch(&db->entries[4U * k + 2U]);
+        }
+        else if (4U * k - 1U < db->size)
+        {
+            __builtin_prefetch(&db->entries[4U * k - 1U]);
+        }
+
+        k = 2U * k + (db->entries[k - 1U].key < key);
+        DB_STATS_ADD(num_probes, 1U);
+    }
+
+    // Отбрасываем повороты направо после последнего поворота налево.
+    k >>= __builtin_ffsll((long long) ~k);
+
+    if (k == 0U || db->entries[k - 1U].key != key)
+    {
+        return false;
+    }
+
+    memcpy(value, db->entries[k - 1U].value, VALUE_SIZE);
+    *index = db->pos_to_rank[k - 1U];
+    return true;
+}
+
+//==================================================================================================
+// Функция: db_search_sorted
+// Назначение: Ищет значение по ключу в упорядоченном массиве entries.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in)  - указатель на базу данных.
+// key   (in)  - искомый ключ.
+// value (out) - указатель на записываемое функцией значение.
+// index (out) - указатель на индекс элемента в массиве entries.
+//
+// Возвращаемое значение:
+// TRUE  - значение по ключу найдено.
+// FALSE - значение по ключу отсутствует. 
+//==================================================================================================
+bool db_search_sorted(const struct Database* db, DbKey_t key, char value[VALUE_SIZE],
+                      uint32_t* index)
+{
+    if (db->size == 0)
+    {
+        return false;
+    }
+
+    // Индексы в массиве.
+    uint32_t low  = 0;
+    uint32_t high = db->size;
+
+    // Производим бинарный поиск в отсортированном массиве.
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low)/2;
+        DB_STATS_ADD(num_probes, 1U);
+
+        if (db->entries[mid].key > key)
+        {
+            high = mid;
+        }
+        else if (db->entries[mid].key < key)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            memcpy(value, db->entries[mid].value, VALUE_SIZE);
+            *index = mid;
+            return true;
+        }
+    }
+
+    // Ключ отсутствует в массиве. 
+    return false;
+}
+
+//==================================================================================================
+// Функция: db_search
+// Назначение: Ищет в базе данных значение по заданному ключу.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in) - указатель на базу данных.
+// key   (in) - искомый ключ.
+// value (in) - указатель на записываемое функцией значение.
+// index (in) - указатель на индекс элемента а базе данных.
+//
+// Возвращаемое значение:
+// TRUE  - значение по ключу найдено.
+// FALSE - значение по ключу отсутствует. 
+//
+// Примечания:
+// - Вызов функций db_insert и db_remove могут менять ключ-значение по индексу. 
+// - В log-structured режиме при наличии неслитых изменений индекс равен DB_NO_INDEX.
+//==================================================================================================
+bool db_search(const struct Database* db, DbKey_t key, char value[VALUE_SIZE], uint32_t* index)
+{
+    DB_STATS_SCOPE(DB_OP_SEARCH);
+
+    if (db->log != NULL)
+    {
+        // Последнее изменение ключа находится в журнале.
+        const LogEntry_t* logged = db_lsm_find(db->log, key);
+        if (logged != NULL)
+        {
+            if (logged->removed)
+            {
+                return false;
+            }
+
+            memcpy(value, logged->entry.value, VALUE_SIZE);
+            *index = DB_NO_INDEX;
+            return true;
+        }
+    }
+
+    if (db->hash != NULL)
+    {
+        return db_search_hash(db, key, value, index);
+    }
+
+    if (db->layout == DB_LAYOUT_EYTZINGER)
+    {
+        return db_search_eytzinger(db, key, value, index);
+    }
+
+    bool found = db_search_sorted(db, key, value, index);
+    if (found && db_lsm_pending(db))
+    {
+        *index = DB_NO_INDEX;
+    }
+
+    return found;
+}
+
+// Количество ключей, бинарный поиск которых db_search_batch выполняет одновременно.
+#define DB_BATCH_GROUP 16U
+
+//==================================================================================================
+// Функция: db_search_batch
+// Назначение: Ищет в базе данных значения по набору ключей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db     (in)  - указатель на базу данных.
+// keys   (in)  - массив искомых ключей.
+// n      (in)  - количество искомых ключей.
+// values (out) - массив значений, values[i] записывается только при found[i] == TRUE.
+// found  (out) - массив флагов наличия ключа keys[i] в базе данных.
+//
+// Возвращаемое значение:
+// Количество найденных ключей.
+//
+// Примечания:
+// - Ключи обрабатываются группами по DB_BATCH_GROUP. Бинарные поиски внутри группы выполняются
+//   синхронно: на каждом шаге для всех ключей группы производится по одному обращению в память.
+//   Обращения для разных ключей независимы, поэтому процессор выполняет их параллельно,
+//   а не дожидается каждого промаха кеша по очереди, как при вызове db_search в цикле.
+// - Шаг поиска не содержит условных переходов, а элементы следующего шага заранее
+//   подгружаются в кеш при помощи __builtin_prefetch.
+//==================================================================================================
+uint32_t db_search_batch(const struct Database* db, const DbKey_t keys[], uint32_t n,
+                         char values[][VALUE_SIZE], bool found[])
+{
+    // Количество найденных ключей.
+    uint32_t num_found = 0U;
+
+    if (db->layout == DB_LAYOUT_EYTZINGER || db->log != NULL || db->hash != NULL)
+    {
+        // Поиск в размещении Эйтцингера сам подгружает в кеш следующие узлы,
+        // в log-structured режиме каждый ключ требует проверки журнала,
+        // а поиск по хеш-индексу не содержит зависимых обращений в память.
+        for (uint32_t i = 0U; i < n; ++i)
+        {
+            uint32_t index;
+            found[i] = db_search(db, keys[i], values[i], &index);
+            num_found += found[i];
+        }
+
+        return num_found;
+    }
+
+    for (uint32_t group = 0U; group < n; group += DB_BATCH_GROUP)
+    {
+        // Количество ключей в текущей группе.
+        uint32_t count = (n - group < DB_BATCH_GROUP)? (n - group) : DB_BATCH_GROUP;
+
+        if (db->size == 0U)
+        {
+            for (uint32_t i = 0U; i < count; ++i)
+            {
+                found[group + i] = false;
+            }
+
+            continue;
+        }
+
+        // Начала диапазонов поиска для ключей группы.
+        // Длина диапазона на каждом шаге одинакова для всех ключей.
+        uint32_t base[DB_BATCH_GROUP] = {};
+        uint32_t len = db->size;
+
+        // Производим бинарный поиск последнего элемента с ключом не больше искомого.
+        while (len > 1U)
+        {
+            uint32_t half = len / 2U;
+            // Смещение элемента, к которому произойдёт обращение на следующем шаге.
+            uint32_t next_half = (len - half) / 2U;
+
+            for (uint32_t i = 0U; i < count; ++i)
+            {
+                // Подгружаем в кеш оба возможных элемента следующего шага.
+                __builtin_prefetch(&db->entries[base[i] + next_half]);
+                __builtin_prefetch(&db->entries[base[i] + half + next_half]);
+
+                base[i] += (db->entries[base[i] + half].key <= keys[group + i])? half : 0U;
+            }
+
+            len -= half;
+        }
+
+        // Проверяем, что найденный элемент имеет искомый ключ.
+        for (uint32_t i = 0U; i < count; ++i)
+        {
+            const Entry_t* entry = &db->entries[base[i]];
+
+            found[group + i] = (entry->key == keys[group + i]);
+            if (found[group + i])
+            {
+                memcpy(values[group + i], entry->value, VALUE_SIZE);
+                num_found++;
+            }
+        }
+    }
+
+    return num_found;
+}
+
+// Предварительная декларация функций записи операций в журнал предзаписи.
+void db_wal_append(struct Database* db, DbWalOp op, DbKey_t key, const char value[VALUE_SIZE]);
+void db_wal_append_batch(struct Database* db, const DbKey_t keys[],
+                         const char values[][VALUE_SIZE], uint32_t n);
+
+//==================================================================================================
+// Функция: db_insert_entry
+// Назначение: Вставляет в базу данных запись с заданными ключом и полем значения.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in) - указатель на базу данных.
+// key   (in) - ключ для вставки в базу данных.
+// value (in) - поле значения записи.
+//
+// Возвращаемое значение:
+// FALSE - элемент уже присутствовал в базе данных, значение обновлено.
+// TRUE  - элемент успешно добавлен в базу данных.
+//
+// Примечания:
+// - В отличие от db_insert, допускает режим значений переменной длины: через неё
+//   db_insert_value записывает закодированное поле значения.
+//==================================================================================================
+bool db_insert_entry(struct Database* db, DbKey_t key, const char value[VALUE_SIZE])
+{
+    DB_STATS_SCOPE(DB_OP_INSERT);
+
+    verify_contract(db->mapped == NULL,
+        "db_insert: database is mapped read-only\n");
+    verify_contract(db->sync == NULL || (db->sync->seq & 1U) != 0U,
+        "db_insert: use db_insert_concurrent in concurrent access mode\n");
+
+    // Операция записывается в журнал предзаписи до изменения базы данных.
+    db_wal_append(db, DB_WAL_INSERT, key, value);
+
+    if (db->log != NULL)
+    {   // Изменение записывается в журнал.
+        char old_value[VALUE_SIZE];
+        uint32_t index;
+        bool existed = db_search(db, key, old_value, &index);
+
+        db_lsm_put(db, key, value, false);
+
+        if (!existed)
+        {
+            db->log->live_size++;
+        }
+
+        return !existed;
+    }
+
+    // Вставка производится в упорядоченный массив.
+    db_layout_sorted(db);
+
+    if (db->size == db->capacity)
+    {
+        // Увеличиваем объём выделенной памяти по политике базы данных.
+        db_grow_entries(db, db->size + 1U);
+    }
+
+    // Индексы в базе данных.
+    uint32_t low  = 0;
+    uint32_t high = db->size; 
+
+    // Находим место для вставки элемента.
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low)/2;
+        DB_STATS_ADD(num_probes, 1U);
+
+        if (db->entries[mid].key <= key)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    // Место для вставки элемента.
+    uint32_t pos = high;
+
+    // Обновляем значение для заданного ключа. 
+    if (pos != 0 && db->entries[pos - 1].key == key)
+    {
+        memcpy(db->entries[pos - 1].value, value, VALUE_SIZE);
+        return false;
+    }
+
+    if (pos != db->size)
+    {
+        // Сдвигаем элементы на один вправо.
+        memmove(&db->entries[pos + 1], &db->entries[pos], (db->size - pos)  * sizeof(Entry_t));
+        DB_STATS_ADD(bytes_moved, (db->size - pos) * sizeof(Entry_t));
+    }
+
+    // Производим вставку элемента.
+    db->entries[pos].key = key;
+    memcpy(db->entries[pos].value, value, VALUE_SIZE);
+    DB_STORE(db->size, db->size + 1U);
+
+    if (db->hash != NULL)
+    {
+        db_hash_insert_at(db, key, pos);
+    }
+
+    return true;
+}
+
+//==================================================================================================
+// Функция: db_insert
+// Назначение: Вставляет в базу данных значение по заданному ключу.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in) - указатель на базу данных.
+// key   (in) - ключ для вставки в базу данных.
+// value (in) - значение для вставки в базу данных.
+//
+// Возвращаемое значение:
+// FALSE - элемент уже присутствовал в базе данных, значение обновлено.
+// TRUE  - элемент успешно добавлен в базу данных.
+//==================================================================================================
+bool db_insert(struct Database* db, DbKey_t key, const char value[VALUE_SIZE])
+{
+    verify_contract(db->arena == NULL,
+        "db_insert: use db_insert_value for variable-length values\n");
+
+    return db_insert_entry(db, key, value);
+}
+
+//==================================================================================================
+// Функция: db_remove_entry
+// Назначение: Удаляет из базы данных запись по заданному ключу.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in)  - указатель на базу данных.
+// key   (in)  - ключ для поиска в базе данных.
+// value (out) - поле значения удалённой записи.
+//
+// Возвращаемое значение:
+// FALSE - элемент уже отсутствует в базе данных.
+// TRUE  - элемент успешно удалён из базы данных.
+//
+// Примечания:
+// - В отличие от db_remove, допускает режим значений переменной длины: через неё
+//   db_remove_value получает закодированное поле значения для освобождения.
+//==================================================================================================
+bool db_remove_entry(struct Database* db, DbKey_t key, char value[VALUE_SIZE])
+{
+    DB_STATS_SCOPE(DB_OP_REMOVE);
+
+    verify_contract(db->mapped == NULL,
+        "db_remove: database is mapped read-only\n");
+    verify_contract(db->sync == NULL || (db->sync->seq & 1U) != 0U,
+        "db_remove: use db_remove_concurrent in concurrent access mode\n");
+
+    // Операция записывается в журнал предзаписи до изменения базы данных.
+    db_wal_append(db, DB_WAL_REMOVE, key, NULL);
+
+    if (db->log != NULL)
+    {   // Удаление записывается в журнал в виде надгробия.
+        uint32_t index;
+        if (!db_search(db, key, value, &index))
+        {
+            return false;
+        }
+
+        db_lsm_put(db, key, NULL, true);
+        db->log->live_size--;
+
+        return true;
+    }
+
+    // Удаление производится из упорядоченного массива.
+    db_layout_sorted(db);
+
+    // Индекс элемента для удаления.
+    uint32_t removeIndex;
+
+    // Производим поиск элемента в массиве.
+    bool found = db_search(db, key, value, &removeIndex);
+    if (!found)
+    {
+        return false;
+    }
+
+    // Сдвигаем элементы на один влево.
+    if (removeIndex != db->size - 1)
+    {
+        memmove(
+            &db->entries[removeIndex],
+            &db->entries[removeIndex + 1],
+            (db->size - (removeIndex + 1))  * sizeof(Entry_t));
+        DB_STATS_ADD(bytes_moved, (db->size - (removeIndex + 1)) * sizeof(Entry_t));
+    }
+
+    DB_STORE(db->size, db->size - 1U);
+
+    if (db->hash != NULL)
+    {
+        db_hash_remove_at(db, key, removeIndex);
+    }
+
+    // Освобождаем память, если это необходимо.
+    const DbCapacityPolicy* policy = &db->policy;
+    db->capacity_stats.num_removes++;
+
+    if (policy->shrink_divisor != 0U && policy->shrink_period != 0U &&
+        db->capacity_stats.num_removes % policy->shrink_period == 0U &&
+        db->size <= db->capacity / policy->shrink_divisor && db_shrink_target(db) < db->capacity)
+    {
+        db_resize_entries(db, db_shrink_target(db));
+    }
+
+    return true;
+}
+
+//==================================================================================================
+// Функция: db_remove
+// Назначение: Удаляет из базы данных значение по заданному ключу.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in)  - указатель на базу данных.
+// key   (in)  - ключ для поиска в базе данных.
+// value (out) - значение, которое удалено из базы данных.
+//
+// Возвращаемое значение:
+// FALSE - элемент уже отсутствует в базе данных.
+// TRUE  - элемент успешно удалён из базы данных.
+//==================================================================================================
+bool db_remove(struct Database* db, DbKey_t key, char value[VALUE_SIZE])
+{
+    verify_contract(db->arena == NULL,
+        "db_remove: use db_remove_value for variable-length values\n");
+
+    return db_remove_entry(db, key, value);
+}
+
+//========================//
+// Обход диапазона ключей //
+//========================//
+
+//==================================================================================================
+// Функция: db_lower_bound
+// Назначение: Находит индекс первой записи с ключом, не меньшим заданного.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db  (in) - указатель на базу данных.
+// key (in) - ключ.
+//
+// Возвращаемое значение:
+// Индекс записи (размер базы данных, если все ключи меньше заданного).
+//==================================================================================================
+uint32_t db_lower_bound(const struct Database* db, DbKey_t key)
+{
+    uint32_t low  = 0U;
+    uint32_t high = db->size;
+
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low)/2;
+
+        if (db_entry(db, mid)->key < key)
+        {
+            low = mid + 1U;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+//==================================================================================================
+// Функция: db_range
+// Назначение: Устанавливает курсор на записи с ключами из полуинтервала [lo, hi).
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db     (in)  - указатель на базу данных.
+// lo     (in)  - наименьший ключ диапазона.
+// hi     (in)  - ключ, следующий за наибольшим ключом диапазона.
+// cursor (out) - курсор.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Границы диапазона находятся двумя бинарными поисками, после чего записи выдаются
+//   подряд без повторного поиска.
+// - Вызов db_insert и db_remove делает курсор недействительным.
+//==================================================================================================
+void db_range(const struct Database* db, DbKey_t lo, DbKey_t hi, DbCursor* cursor)
+{
+    verify_contract(!db_lsm_pending(db),
+        "db_range: log-structured database must be flushed first\n");
+
+    cursor->db    = db;
+    cursor->index = db_lower_bound(db, lo);
+    cursor->end   = (lo < hi)? db_lower_bound(db, hi) : cursor->index;
+}
+
+//==================================================================================================
+// Функция: db_prefix
+// Назначение: Устанавливает курсор на записи, старшие биты ключа которых совпадают с заданными.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db          (in)  - указатель на базу данных.
+// prefix      (in)  - ключ, старшие биты которого задают префикс.
+// prefix_bits (in)  - количество старших бит префикса (от 0 до DB_KEY_BITS).
+// cursor      (out) - курсор.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Например, все адреса подсети 10.0.0.0/16 обходятся вызовом
+//   db_prefix(db, IP_ADDRESS(10, 0, 0, 0), 16U, &cursor).
+//==================================================================================================
+void db_prefix(const struct Database* db, DbKey_t prefix, uint32_t prefix_bits, DbCursor* cursor)
+{
+    verify_contract(!db_lsm_pending(db),
+        "db_prefix: log-structured database must be flushed first\n");
+    verify_contract(prefix_bits <= DB_KEY_BITS,
+        "db_prefix: invalid prefix length %u\n", prefix_bits);
+
+    // Младшие биты, не входящие в префикс.
+    DbKey_t suffix_mask = (prefix_bits == 0U)? DB_KEY_MAX :
+                          ((DbKey_t) 1U << (DB_KEY_BITS - prefix_bits)) - 1U;
+
+    DbKey_t first = prefix & ~suffix_mask;
+    DbKey_t last  = prefix |  suffix_mask;
+
+    cursor->db    = db;
+    cursor->index = db_lower_bound(db, first);
+    cursor->end   = (last == DB_KEY_MAX)? db->size : db_lower_bound(db, last + 1U);
+}
+
+//==================================================================================================
+// Функция: db_cursor_next
+// Назначение: Возвращает очередную запись диапазона.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// cursor (in/out) - курсор.
+//
+// Возвращаемое значение:
+// Указатель на запись в базе данных (без копирования) или NULL, если диапазон исчерпан.
+//==================================================================================================
+const Entry_t* db_cursor_next(DbCursor* cursor)
+{
+    if (cursor->index == cursor->end)
+    {
+        return NULL;
+    }
+
+    return db_entry(cursor->db, cursor->index++);
+}
+
+//==================================================================================================
+// Функция: db_cursor_next_n
+// Назначение: Возвращает очередной непрерывный участок записей диапазона.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// cursor (in/out) - курсор.
+// run    (out)    - указатель на первую запись участка в базе данных (без копирования).
+// n      (in)     - наибольшее количество записей в участке.
+//
+// Возвращаемое значение:
+// Количество записей в участке (0, если диапазон исчерпан).
+//
+// Примечания:
+// - Записи участка расположены в памяти подряд по возрастанию ключа, поэтому один вызов
+//   заменяет n вызовов db_cursor_next.
+// - При размещении Эйтцингера соседние по ключу записи не расположены рядом,
+//   и участок состоит из одной записи.
+//==================================================================================================
+uint32_t db_cursor_next_n(DbCursor* cursor, const Entry_t** run, uint32_t n)
+{
+    uint32_t count = cursor->end - cursor->index;
+    if (count > n)
+    {
+        count = n;
+    }
+
+    if (cursor->db->layout == DB_LAYOUT_EYTZINGER && count > 1U)
+    {
+        count = 1U;
+    }
+
+    if (count != 0U)
+    {
+        *run = db_entry(cursor->db, cursor->index);
+        cursor->index += count;
+    }
+
+    return count;
+}
+
+//===========================//
+// Значения переменной длины //
+//===========================//
+
+#ifdef DB_ARENA_SUPPORTED
+
+// Наименьший размер области значений, при котором производится уплотнение.
+#define DB_ARENA_COMPACT_MIN 4096U
+
+//==================================================================================================
+// Функция: db_arena_enable
+// Назначение: Включает режим хранения значений переменной длины.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на пустую базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Записи остаются 16-байтными. Значение длиной до DB_INLINE_VALUE_MAX байт хранится
+//   в поле value записи, его длина - в последнем байте поля. Более длинное значение
+//   дописывается в область значений, а поле value хранит ссылку (смещение, длина)
+//   и признак DB_ARENA_REF в последнем байте.
+// - Значения вставляются, ищутся и удаляются функциями db_insert_value, db_search_value
+//   и db_remove_value, читаются по записи функцией db_value.
+// - Режим несовместим с сохранением в файл, журналом предзаписи, log-structured режимом
+//   и режимом одновременного доступа.
+//==================================================================================================
+void db_arena_enable(struct Database* db)
+{
+    verify_contract(db->size == 0U && db->mapped == NULL,
+        "db_arena_enable: database must be empty\n");
+    verify_contract(db->log == NULL && db->wal == NULL && db->sync == NULL,
+        "db_arena_enable: variable-length values are incompatible with current database mode\n");
+
+    if (db->arena != NULL)
+    {
+        return;
+    }
+
+    struct DbArena* arena = calloc(1U, sizeof(struct DbArena));
+    verify_contract(arena != NULL,
+        "db_arena_enable: unable to allocate memory\n");
+
+    arena->bytes    = NULL;
+    arena->size     = 0U;
+    arena->capacity = 0U;
+    arena->garbage  = 0U;
+
+    db->arena = arena;
+}
+
+//==================================================================================================
+// Функция: db_value
+// Назначение: Возвращает значение переменной длины, хранящееся в записи.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db     (in)  - указатель на базу данных в режиме значений переменной длины.
+// entry  (in)  - запись базы данных (например, полученная от курсора).
+// length (out) - длина значения.
+//
+// Возвращаемое значение:
+// Указатель на значение (без копирования). Указатель действителен до изменения базы данных.
+//==================================================================================================
+const char* db_value(const struct Database* db, const Entry_t* entry, uint32_t* length)
+{
+    uint8_t tag = entry->value[VALUE_SIZE - 1U];
+
+    if (tag != DB_ARENA_REF)
+    {   // Короткое значение хранится в самой записи.
+        *length = tag;
+        return entry->value;
+    }
+
+    ArenaRef_t ref;
+    memcpy(&ref, entry->value, sizeof(ArenaRef_t));
+
+    *length = ref.length;
+    return &db->arena->bytes[ref.offset];
+}
+
+//==================================================================================================
+// Функция: db_arena_append
+// Назначение: Дописывает байты в конец области значений.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// arena  (in) - указатель на область значений.
+// value  (in) - значение.
+// length (in) - длина значения.
+//
+// Возвращаемое значение:
+// Смещение значения в области значений.
+//==================================================================================================
+uint32_t db_arena_append(struct DbArena* arena, const char* value, uint32_t length)
+{
+    verify_contract(length <= 0xFFFFFFFFU - arena->size,
+        "db_arena_append: value arena is full\n");
+
+    if (arena->size + length > arena->capacity)
+    {
+        // Увеличиваем объём выделенной памяти как минимум двукратно.
+        uint64_t capacity = 2U * (uint64_t) arena->capacity;
+        if (capacity < arena->size + length)
+        {
+            capacity = arena->size + length;
+        }
+        if (capacity > 0xFFFFFFFFU)
+        {
+            capacity = 0xFFFFFFFFU;
+        }
+
+        arena->bytes = realloc(arena->bytes, capacity);
+        verify_contract(arena->bytes != NULL,
+            "db_arena_append: unable to reallocate memory\n");
+
+        arena->capacity = capacity;
+    }
+
+    uint32_t offset = arena->size;
+
+    memcpy(&arena->bytes[offset], value, length);
+    arena->size += length;
+
+    return offset;
+}
+
+//==================================================================================================
+// Функция: db_arena_compact
+// Назначение: Уплотняет область значений, удаляя из неё неиспользуемые значения.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на базу данных в режиме значений переменной длины.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Значения переписываются в новую область в порядке возрастания ключа,
+//   поэтому при обходе диапазона ключей значения читаются последовательно.
+// - Вызывается автоматически, когда неиспользуемые значения занимают больше
+//   половины области значений.
+//==================================================================================================
+void db_arena_compact(struct Database* db)
+{
+    struct DbArena* arena = db->arena;
+    verify_contract(arena != NULL,
+        "db_arena_compact: variable-length values are not enabled\n");
+
+    struct DbArena compacted = {
+        .bytes    = NULL,
+        .size     = 0U,
+        .capacity = 0U,
+        .garbage  = 0U
+    };
+
+    uint32_t live_size = arena->size - arena->garbage;
+    if (live_size != 0U)
+    {
+        compacted.bytes = malloc(live_size);
+        verify_contract(compacted.bytes != NULL,
+            "db_arena_compact: unable to allocate memory\n");
+
+        compacted.capacity = live_size;
+    }
+
+    for (uint32_t i = 0U; i < db->size; ++i)
+    {
+        Entry_t* entry = (Entry_t*) db_entry(db, i);
+
+        if ((uint8_t) entry->value[VALUE_SIZE - 1U] != DB_ARENA_REF)
+        {
+            continue;
+        }
+
+        ArenaRef_t ref;
+        memcpy(&ref, entry->value, sizeof(ArenaRef_t));
+
+        ref.offset = db_arena_append(&compacted, &arena->bytes[ref.offset], ref.length);
+        memcpy(entry->value, &ref, sizeof(ArenaRef_t));
+    }
+
+    free(arena->bytes);
+    *arena = compacted;
+}
+
+//==================================================================================================
+// Функция: db_arena_release
+// Назначение: Учитывает значение, которое больше не используется.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in) - указатель на базу данных в режиме значений переменной длины.
+// value (in) - поле value удалённой или перезаписанной записи.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_arena_release(struct Database* db, const char value[VALUE_SIZE])
+{
+    if ((uint8_t) value[VALUE_SIZE - 1U] != DB_ARENA_REF)
+    {
+        return;
+    }
+
+    ArenaRef_t ref;
+    memcpy(&ref, value, sizeof(ArenaRef_t));
+
+    db->arena->garbage += ref.length;
+}
+
+//==================================================================================================
+// Функция: db_insert_value
+// Назначение: Вставляет в базу данных значение переменной длины по заданному ключу.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db     (in) - указатель на базу данных в режиме значений переменной длины.
+// key    (in) - ключ для вставки в базу данных.
+// value  (in) - значение для вставки в базу данных.
+// length (in) - длина значения.
+//
+// Возвращаемое значение:
+// FALSE - элемент уже присутствовал в базе данных, значение обновлено.
+// TRUE  - элемент успешно добавлен в базу данных.
+//==================================================================================================
+bool db_insert_value(struct Database* db, DbKey_t key, const char* value, uint32_t length)
+{
+    struct DbArena* arena = db->arena;
+    verify_contract(arena != NULL,
+        "db_insert_value: variable-length values are not enabled\n");
+
+    // Представление значения в поле value записи.
+    char encoded[VALUE_SIZE] = {};
+
+    if (length <= DB_INLINE_VALUE_MAX)
+    {
+        memcpy(encoded, value, length);
+        encoded[VALUE_SIZE - 1U] = length;
+    }
+    else
+    {
+        ArenaRef_t ref = {
+            .offset = db_arena_append(arena, value, length),
+            .length = length
+        };
+
+        memcpy(encoded, &ref, sizeof(ArenaRef_t));
+        encoded[VALUE_SIZE - 1U] = (char) DB_ARENA_REF;
+    }
+
+    // Старое значение по этому ключу перестаёт использоваться.
+    char old_value[VALUE_SIZE];
+    uint32_t index;
+    if (db_search(db, key, old_value, &index))
+    {
+        db_arena_release(db, old_value);
+    }
+
+    bool inserted = db_insert_entry(db, key, encoded);
+
+    if (arena->size >= DB_ARENA_COMPACT_MIN && arena->garbage > arena->size / 2U)
+    {
+        db_arena_compact(db);
+    }
+
+    return inserted;
+}
+
+//==================================================================================================
+// Функция: db_search_value
+// Назначение: Производит поиск значения переменной длины в базе данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db     (in)  - указатель на базу данных в режиме значений переменной длины.
+// key    (in)  - ключ для поиска в базе данных.
+// value  (out) - указатель на найденное значение (без копирования).
+// length (out) - длина найденного значения.
+//
+// Возвращаемое значение:
+// FALSE - элемент не найден.
+// TRUE  - элемент найден.
+//
+// Примечания:
+// - Указатель на значение действителен до изменения базы данных.
+//==================================================================================================
+bool db_search_value(const struct Database* db, DbKey_t key, const char** value, uint32_t* length)
+{
+    verify_contract(db->arena != NULL,
+        "db_search_value: variable-length values are not enabled\n");
+
+    uint32_t index;
+    char encoded[VALUE_SIZE];
+    if (!db_search(db, key, encoded, &index))
+    {
+        return false;
+    }
+
+    *value = db_value(db, db_entry(db, index), length);
+    return true;
+}
+
+//==================================================================================================
+// Функция: db_remove_value
+// Назначение: Удаляет из базы данных значение переменной длины по заданному ключу.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db  (in) - указатель на базу данных в режиме значений переменной длины.
+// key (in) - ключ для поиска в базе данных.
+//
+// Возвращаемое значение:
+// FALSE - элемент уже отсутствует в базе данных.
+// TRUE  - элемент успешно удалён из базы данных.
+//==================================================================================================
+bool db_remove_value(struct Database* db, DbKey_t key)
+{
+    struct DbArena* arena = db->arena;
+    verify_contract(arena != NULL,
+        "db_remove_value: variable-length values are not enabled\n");
+
+    char encoded[VALUE_SIZE];
+    if (!db_remove_entry(db, key, encoded))
+    {
+        return false;
+    }
+
+    db_arena_release(db, encoded);
+
+    if (arena->size >= DB_ARENA_COMPACT_MIN && arena->garbage > arena->size / 2U)
+    {
+        db_arena_compact(db);
+    }
+
+    return true;
+}
+
+#endif // DB_ARENA_SUPPORTED
+
+//==================//
+// Пакетная вставка //
+//==================//
+
+//==================================================================================================
+// Функция: db_sort_entries
+// Назначение: Сортирует записи по возрастанию ключа.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// entries (in/out) - массив записей для сортировки.
+// buffer  (in)     - вспомогательный массив такого же размера.
+// n       (in)     - количество записей.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Используется поразрядная сортировка по байтам ключа (от младшего к старшему) за O(n).
+// - Сортировка устойчива: записи с равными ключами сохраняют взаимный порядок.
+//==================================================================================================
+void db_sort_entries(Entry_t* entries, Entry_t* buffer, uint32_t n)
+{
+    // Массивы, между которыми перекладываются записи на каждом проходе.
+    Entry_t* src = entries;
+    Entry_t* dst = buffer;
+
+    for (uint32_t shift = 0U; shift < DB_KEY_BITS; shift += 8U)
+    {
+        // Позиции начала групп записей с одинаковым значением текущего байта ключа.
+        uint32_t offsets[256U] = {};
+
+        for (uint32_t i = 0U; i < n; ++i)
+        {
+            offsets[(src[i].key >> shift) & 0xFFU]++;
+        }
+
+        uint32_t total = 0U;
+        for (uint32_t byte = 0U; byte < 256U; ++byte)
+        {
+            uint32_t count = offsets[byte];
+            offsets[byte] = total;
+            total += count;
+        }
+
+        for (uint32_t i = 0U; i < n; ++i)
+        {
+            dst[offsets[(src[i].key >> shift) & 0xFFU]++] = src[i];
+        }
+
+        Entry_t* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    // После чётного числа проходов результат находится в массиве entries.
+}
+
+//==================================================================================================
+// Функция: db_insert_batch
+// Назначение: Вставляет в базу данных набор значений по заданным ключам.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db     (in) - указатель на базу данных.
+// keys   (in) - массив ключей для вставки в базу данных.
+// values (in) - массив значений для вставки в базу данных.
+// n      (in) - количество вставляемых пар ключ-значение.
+//
+// Возвращаемое значение:
+// Количество добавленных в базу данных элементов (без учёта обновлённых).
+//
+// Примечания:
+// - Результат совпадает с результатом вызова db_insert для каждой пары по порядку:
+//   при повторении ключа сохраняется последнее значение.
+// - Набор сортируется за O(n), после чего сливается с массивом entries за один проход
+//   от конца массива к началу. Итоговая сложность - O(size + n) вместо O(size * n).
+//==================================================================================================
+uint32_t db_insert_batch(struct Database* db, const DbKey_t keys[], const char values[][VALUE_SIZE],
+                         uint32_t n)
+{
+    verify_contract(db->mapped == NULL,
+        "db_insert_batch: database is mapped read-only\n");
+    verify_contract(db->sync == NULL || (db->sync->seq & 1U) != 0U,
+        "db_insert_batch: use db_insert_batch_concurrent in concurrent access mode\n");
+    verify_contract(db->arena == NULL,
+        "db_insert_batch: use db_insert_value for variable-length values\n");
+
+    // Набор записывается в журнал предзаписи до изменения базы данных.
+    db_wal_append_batch(db, keys, values, n);
+
+    // Набор сливается непосредственно с основным массивом.
+    db_lsm_flush(db);
+
+    // Вставка производится в упорядоченный массив.
+    db_layout_sorted(db);
+
+    if (n == 0U)
+    {
+        return 0U;
+    }
+
+    // Копируем набор и сортируем его по ключу.
+    Entry_t* batch  = calloc(n, sizeof(Entry_t));
+    Entry_t* buffer = calloc(n, sizeof(Entry_t));
+    verify_contract(batch != NULL && buffer != NULL,
+        "db_insert_batch: unable to allocate memory\n");
+
+    for (uint32_t i = 0U; i < n; ++i)
+    {
+        batch[i].key = keys[i];
+        memcpy(batch[i].value, values[i], VALUE_SIZE);
+    }
+
+    db_sort_entries(batch, buffer, n);
+    free(buffer);
+
+    // Оставляем последнее значение для каждого повторяющегося ключа.
+    uint32_t batch_size = 0U;
+    for (uint32_t i = 0U; i < n; ++i)
+    {
+        if (i + 1U < n && batch[i].key == batch[i + 1U].key)
+        {
+            continue;
+        }
+
+        batch[batch_size++] = batch[i];
+    }
+
+    // Подсчитываем ключи набора, уже присутствующие в базе данных.
+    uint32_t common = 0U;
+    for (uint32_t i = 0U, j = 0U; i < db->size && j < batch_size;)
+    {
+        if (db->entries[i].key < batch[j].key)
+        {
+            i++;
+        }
+        else if (db->entries[i].key > batch[j].key)
+        {
+            j++;
+        }
+        else
+        {
+            common++;
+            i++;
+            j++;
+        }
+    }
+
+    // Итоговый размер базы данных.
+    uint32_t new_size = db->size + batch_size - common;
+
+    // Увеличиваем объём выделенной памяти по политике базы данных. Пустая база данных
+    // заполняется набором целиком, поэтому ёмкость сразу берётся с запасом по политике:
+    // иначе следующая вставка потребовала бы перераспределения массива.
+    uint64_t needed = new_size;
+    if (db->size == 0U)
+    {
+        needed = needed * db->policy.growth_percent / 100U;
+    }
+    if (needed > 0xFFFFFFFFU / sizeof(Entry_t))
+    {
+        needed = new_size;
+    }
+
+    db_grow_entries(db, (uint32_t) needed);
+
+    // Сливаем массивы, начиная с наибольших ключей.
+    // Запись в позицию dst никогда не затирает ещё не обработанные записи базы данных.
+    uint32_t i   = db->size;
+    uint32_t j   = batch_size;
+    uint32_t dst = new_size;
+
+    while (j > 0U)
+    {
+        if (i > 0U && db->entries[i - 1U].key > batch[j - 1U].key)
+        {
+            db->entries[--dst] = db->entries[--i];
+        }
+        else
+        {
+            if (i > 0U && db->entries[i - 1U].key == batch[j - 1U].key)
+            {   // Значение по существующему ключу обновляется.
+                i--;
+            }
+
+            db->entries[--dst] = batch[--j];
+        }
+    }
+
+    DB_STORE(db->size, new_size);
+
+    if (db->log != NULL)
+    {
+        db->log->live_size = new_size;
+    }
+
+    free(batch);
+
+    // Индексы записей сдвинуты слиянием.
+    if (db->hash != NULL)
+    {
+        db_hash_rebuild(db);
+    }
+
+    return batch_size - common;
+}
+
+//==================================================================================================
+// Функция: db_build_from_unsorted
+// Назначение: Инициализирует базу данных набором пар ключ-значение в произвольном порядке.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db     (out) - указатель на базу данных.
+// keys   (in)  - массив ключей.
+// values (in)  - массив значений.
+// n      (in)  - количество пар ключ-значение.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Для базы данных должна быть вызвана функция db_free.
+//==================================================================================================
+void db_build_from_unsorted(struct Database* db, const DbKey_t keys[],
+                            const char values[][VALUE_SIZE], uint32_t n)
+{
+    db_alloc(db);
+
+    db_insert_batch(db, keys, values, n);
+}
+
+//===========================//
+// Одновременный доступ к БД //
+//===========================//
+
+//==================================================================================================
+// Функция: db_concurrent_enable
+// Назначение: Включает режим одновременного доступа к базе данных из нескольких потоков.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - В этом режиме читатели вызывают db_search_concurrent и не блокируют друг друга:
+//   чтение изменяет только счётчик читателей своей эпохи, а записи базы данных
+//   не изменяет.
+// - Писатели вызывают db_insert_concurrent, db_remove_concurrent и
+//   db_insert_batch_concurrent. Писатели упорядочиваются блокировкой; читатель,
+//   пересёкшийся по времени с писателем, повторяет поиск.
+// - Массивы записей, заменённые писателем, освобождаются по мере завершения читателей,
+//   которые могли их застать (см. db_reclaim_retired).
+// - Режим несовместим с размещением Эйтцингера и log-structured режимом.
+//==================================================================================================
+void db_concurrent_enable(struct Database* db)
+{
+    verify_contract(db->log == NULL,
+        "db_concurrent_enable: concurrent access mode is incompatible with log-structured mode\n");
+    verify_contract(db->arena == NULL,
+        "db_concurrent_enable: concurrent access mode is incompatible with variable-length values\n");
+
+    if (db->sync != NULL)
+    {
+        return;
+    }
+
+    // Читатели выполняют бинарный поиск по упорядоченному массиву.
+    db_layout_sorted(db);
+
+    struct DbSync* sync = calloc(1U, sizeof(struct DbSync));
+    verify_contract(sync != NULL,
+        "db_concurrent_enable: unable to allocate memory\n");
+
+    int ret = pthread_mutex_init(&sync->write_lock, NULL);
+    verify_contract(ret == 0,
+        "db_concurrent_enable: unable to initialize mutex\n");
+
+    sync->seq              = 0U;
+    sync->epoch            = 0U;
+    sync->readers[0]       = 0U;
+    sync->readers[1]       = 0U;
+    sync->retired          = NULL;
+    sync->num_retired      = 0U;
+    sync->retired_capacity = 0U;
+
+    db->sync = sync;
+}
+
+//==================================================================================================
+// Функция: db_concurrent_disable
+// Назначение: Выключает режим одновременного доступа и освобождает заменённые массивы записей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in/out) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Вызывается, когда ни один поток не обращается к базе данных.
+//==================================================================================================
+void db_concurrent_disable(struct Database* db)
+{
+    struct DbSync* sync = db->sync;
+    if (sync == NULL)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0U; i < sync->num_retired; ++i)
+    {
+        free(sync->retired[i].entries);
+    }
+
+    free(sync->retired);
+
+    int ret = pthread_mutex_destroy(&sync->write_lock);
+    verify_contract(ret == 0,
+        "db_concurrent_disable: unable to destroy mutex\n");
+
+    free(sync);
+    db->sync = NULL;
+}
+
+//==================================================================================================
+// Функция: db_write_begin
+// Назначение: Начинает изменение базы данных в режиме одновременного доступа.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_write_begin(struct Database* db)
+{
+    struct DbSync* sync = db->sync;
+    verify_contract(sync != NULL,
+        "db_write_begin: concurrent access mode is not enabled\n");
+
+    int ret = pthread_mutex_lock(&sync->write_lock);
+    verify_contract(ret == 0,
+        "db_write_begin: unable to lock mutex\n");
+
+    // Нечётная версия: читатели, заставшие изменение, повторят поиск.
+    __atomic_store_n(&sync->seq, sync->seq + 1U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+//==================================================================================================
+// Функция: db_reclaim_retired
+// Назначение: Продвигает эпоху и освобождает заменённые массивы, которые уже не читаются.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// sync (in/out) - состояние режима одновременного доступа.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Вызывается писателем под блокировкой write_lock.
+// - Эпоха E продвигается до E + 1, только если не осталось читателей эпохи E - 1 (счётчик
+//   той же чётности, что и E + 1). После продвижения читатели находятся в эпохах E и E + 1
+//   и видят массивы, опубликованные не позже эпохи E, поэтому массивы, заменённые в эпохи
+//   до E - 1 включительно, освобождаются.
+//==================================================================================================
+void db_reclaim_retired(struct DbSync* sync)
+{
+    uint32_t epoch = sync->epoch;
+
+    if (__atomic_load_n(&sync->readers[(epoch + 1U) & 1U], __ATOMIC_SEQ_CST) != 0U)
+    {
+        return;
+    }
+
+    epoch++;
+    __atomic_store_n(&sync->epoch, epoch, __ATOMIC_SEQ_CST);
+
+    uint32_t num_freed = 0U;
+    while (num_freed < sync->num_retired && epoch - sync->retired[num_freed].epoch >= 2U)
+    {
+        free(sync->retired[num_freed].entries);
+        num_freed++;
+    }
+
+    sync->num_retired -= num_freed;
+    memmove(sync->retired, &sync->retired[num_freed], sync->num_retired * sizeof(DbRetired));
+}
+
+//==================================================================================================
+// Функция: db_write_end
+// Назначение: Завершает изменение базы данных в режиме одновременного доступа.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Каждая запись проверяет, можно ли освободить заменённые ранее массивы записей.
+//==================================================================================================
+void db_write_end(struct Database* db)
+{
+    struct DbSync* sync = db->sync;
+
+    // Публикуем новую чётную версию после всех изменений.
+    __atomic_store_n(&sync->seq, sync->seq + 1U, __ATOMIC_RELEASE);
+
+    if (sync->num_retired != 0U)
+    {
+        db_reclaim_retired(sync);
+    }
+
+    int ret = pthread_mutex_unlock(&sync->write_lock);
+    verify_contract(ret == 0,
+        "db_write_end: unable to unlock mutex\n");
+}
+
+//==================================================================================================
+// Функция: db_epoch_enter
+// Назначение: Регистрирует читателя в текущей эпохе.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// sync (in/out) - состояние режима одновременного доступа.
+//
+// Возвращаемое значение:
+// Эпоха, в которой зарегистрирован читатель (передаётся в db_epoch_exit).
+//
+// Примечания:
+// - Пока читатель зарегистрирован, массивы записей, которые он может прочитать,
+//   не освобождаются писателем.
+//==================================================================================================
+uint32_t db_epoch_enter(struct DbSync* sync)
+{
+    while (true)
+    {
+        uint32_t epoch = __atomic_load_n(&sync->epoch, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&sync->readers[epoch & 1U], 1U, __ATOMIC_SEQ_CST);
+
+        // Эпоха могла продвинуться до регистрации: писатель не учёл этого читателя.
+        if (__atomic_load_n(&sync->epoch, __ATOMIC_SEQ_CST) == epoch)
+        {
+            return epoch;
+        }
+
+        __atomic_fetch_sub(&sync->readers[epoch & 1U], 1U, __ATOMIC_RELEASE);
+    }
+}
+
+//==================================================================================================
+// Функция: db_epoch_exit
+// Назначение: Снимает регистрацию читателя в эпохе.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// sync  (in/out) - состояние режима одновременного доступа.
+// epoch (in)     - эпоха, возвращённая db_epoch_enter.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_epoch_exit(struct DbSync* sync, uint32_t epoch)
+{
+    // Все чтения массива записей завершаются до снятия регистрации.
+    __atomic_fetch_sub(&sync->readers[epoch & 1U], 1U, __ATOMIC_RELEASE);
+}
+
+//==================================================================================================
+// Функция: db_read_begin
+// Назначение: Дожидается отсутствия писателя и возвращает версию базы данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// sync (in) - состояние режима одновременного доступа.
+//
+// Возвращаемое значение:
+// Чётная версия базы данных.
+//==================================================================================================
+uint32_t db_read_begin(const struct DbSync* sync)
+{
+    while (true)
+    {
+        uint32_t seq = __atomic_load_n(&sync->seq, __ATOMIC_ACQUIRE);
+        if ((seq & 1U) == 0U)
+        {
+            return seq;
+        }
+
+        // Уступаем процессор писателю.
+        sched_yield();
+    }
+}
+
+//==================================================================================================
+// Функция: db_read_retry
+// Назначение: Проверяет, изменилась ли база данных с начала чтения.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// sync (in) - состояние режима одновременного доступа.
+// seq  (in) - версия, возвращённая db_read_begin.
+//
+// Возвращаемое значение:
+// TRUE, если прочитанные данные могут быть несогласованными и чтение нужно повторить.
+//==================================================================================================
+bool db_read_retry(const struct DbSync* sync, uint32_t seq)
+{
+    // Все чтения данных завершаются до повторного чтения версии.
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    return __atomic_load_n(&sync->seq, __ATOMIC_RELAXED) != seq;
+}
+
+//==================================================================================================
+// Функция: db_search_concurrent
+// Назначение: Производит поиск в базе данных параллельно с другими потоками.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in)  - указатель на базу данных в режиме одновременного доступа.
+// key   (in)  - ключ для поиска в базе данных.
+// value (out) - найденное значение.
+// index (out) - индекс элемента в базе данных.
+//
+// Возвращаемое значение:
+// FALSE - элемент не найден.
+// TRUE  - элемент найден.
+//
+// Примечания:
+// - Указатель на массив и размер считываются согласованной парой: если версия не изменилась
+//   за время их чтения, ёмкость массива не меньше размера. Массив, заменённый писателем
+//   после этого, не освобождается до завершения поиска (читатель зарегистрирован в эпохе),
+//   поэтому поиск не выходит за границы памяти даже при пересечении с писателем;
+//   результат такого поиска отбрасывается.
+// - Писатель публикует указатель и размер через DB_STORE, а указатель загружается
+//   с семантикой acquire: содержимое нового массива видно читателю до поиска в нём.
+//==================================================================================================
+bool db_search_concurrent(const struct Database* db, DbKey_t key, char value[VALUE_SIZE],
+                          uint32_t* index)
+{
+    struct DbSync* sync = db->sync;
+    verify_contract(sync != NULL,
+        "db_search_concurrent: concurrent access mode is not enabled\n");
+
+    uint32_t epoch = db_epoch_enter(sync);
+
+    while (true)
+    {
+        uint32_t seq = db_read_begin(sync);
+
+        // Представление базы данных в момент начала чтения.
+        struct Database view = {};
+        view.entries = __atomic_load_n(&db->entries, __ATOMIC_ACQUIRE);
+        view.size    = __atomic_load_n(&db->size,    __ATOMIC_RELAXED);
+        view.layout  = DB_LAYOUT_SORTED;
+
+        if (db_read_retry(sync, seq))
+        {
+            continue;
+        }
+
+        char found_value[VALUE_SIZE];
+        uint32_t found_index;
+        bool found = db_search_sorted(&view, key, found_value, &found_index);
+
+        if (db_read_retry(sync, seq))
+        {
+            continue;
+        }
+
+        db_epoch_exit(sync, epoch);
+
+        if (found)
+        {
+            memcpy(value, found_value, VALUE_SIZE);
+            *index = found_index;
+        }
+
+        return found;
+    }
+}
+
+//==================================================================================================
+// Функция: db_insert_concurrent
+// Назначение: Вставляет в базу данных значение по заданному ключу параллельно с читателями.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in) - указатель на базу данных в режиме одновременного доступа.
+// key   (in) - ключ для вставки в базу данных.
+// value (in) - значение для вставки в базу данных.
+//
+// Возвращаемое значение:
+// Совпадает с возвращаемым значением db_insert.
+//==================================================================================================
+bool db_insert_concurrent(struct Database* db, DbKey_t key, const char value[VALUE_SIZE])
+{
+    db_write_begin(db);
+    bool inserted = db_insert(db, key, value);
+    db_write_end(db);
+
+    return inserted;
+}
+
+//==================================================================================================
+// Функция: db_remove_concurrent
+// Назначение: Удаляет из базы данных значение по заданному ключу параллельно с читателями.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in)  - указатель на базу данных в режиме одновременного доступа.
+// key   (in)  - ключ для поиска в базе данных.
+// value (out) - значение, которое удалено из базы данных.
+//
+// Возвращаемое значение:
+// Совпадает с возвращаемым значением db_remove.
+//==================================================================================================
+bool db_remove_concurrent(struct Database* db, DbKey_t key, char value[VALUE_SIZE])
+{
+    db_write_begin(db);
+    bool removed = db_remove(db, key, value);
+    db_write_end(db);
+
+    return removed;
+}
+
+//==================================================================================================
+// Функция: db_insert_batch_concurrent
+// Назначение: Вставляет в базу данных набор значений параллельно с читателями.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db     (in) - указатель на базу данных в режиме одновременного доступа.
+// keys   (in) - массив ключей для вставки в базу данных.
+// values (in) - массив значений для вставки в базу данных.
+// n      (in) - количество вставляемых пар ключ-значение.
+//
+// Возвращаемое значение:
+// Совпадает с возвращаемым значением db_insert_batch.
+//==================================================================================================
+uint32_t db_insert_batch_concurrent(struct Database* db, const DbKey_t keys[],
+                                    const char values[][VALUE_SIZE], uint32_t n)
+{
+    db_write_begin(db);
+    uint32_t inserted = db_insert_batch(db, keys, values, n);
+    db_write_end(db);
+
+    return inserted;
+}
+
+//=================================//
+// Чтение из файла и запись в файл //
+//=================================//
+
+// Магические числа.
+// Используются для идентификации формата базы даных.
+// Вторые магические числа различаются для ключей разной разрядности,
+// поэтому файл не может быть прочитан базой данных с другим типом ключа.
+const uint32_t MAGIC0 = 0xDEADBEEF;
+
+#if DB_KEY_BITS == 32
+
+const uint32_t MAGIC1 = 0xB01DFACE;
+
+// Второе магическое число для формата с естественным порядком байт.
+// Записывается в файл без смены порядка байт: по нему определяется,
+// совпадает ли порядок байт в файле с порядком байт текущей машины.
+const uint32_t MAGIC1_NATIVE = 0xB01DF00D;
+
+// Второе магическое число для блочного формата со сжатием (записывается в формате Big Endian).
+const uint32_t MAGIC1_BLOCKS = 0xB01DB10C;
+
+#else
+
+const uint32_t MAGIC1        = 0xB01D64CE;
+const uint32_t MAGIC1_NATIVE = 0xB01D640D;
+const uint32_t MAGIC1_BLOCKS = 0xB01D640C;
+
+#endif
+
+// Размер заголовка файла базы данных.
+#define DB_HEADER_SIZE (2U * sizeof(uint32_t))
+
+// Количество записей, преобразуемых и записываемых в файл за один вызов write.
+#define DB_DUMP_CHUNK_SIZE 65536U
+
+//==================================================================================================
+// Функция: db_write_all
+// Назначение: Записывает в файл блок данных целиком.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// fd       (in) - файловый дескриптор.
+// data     (in) - данные для записи.
+// size     (in) - размер данных в байтах.
+// filename (in) - имя файла (для сообщения об ошибке).
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_write_all(int fd, const void* data, size_t size, const char* filename)
+{
+    const char* bytes = data;
+
+    while (size != 0U)
+    {
+        ssize_t written = write(fd, bytes, size);
+        verify_contract(written > 0,
+            "db_write_all: Unable to write data to file \'%s\'\n", filename);
+
+        bytes += written;
+        size  -= written;
+    }
+}
+
+//==================================================================================================
+// Функция: db_dump_entries
+// Назначение: Сохраняет записи базы данных в файл крупными блоками.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db       (in) - указатель на базу данных.
+// filename (in) - имя файла для сохранения данных.
+// magic1   (in) - второе магическое число в том виде, в котором оно записывается в файл.
+// swap     (in) - признак преобразования ключей в формат Big Endian.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Записи копируются в промежуточный буфер по DB_DUMP_CHUNK_SIZE штук, ключи преобразуются
+//   в буфере отдельным циклом без вызовов функций (цикл остаётся скалярным: по одной
+//   инструкции bswap на запись), и буфер записывается в файл одним вызовом write.
+//   Упорядоченные записи без преобразования записываются непосредственно из массива entries.
+//==================================================================================================
+void db_dump_entries(const struct Database* db, const char* filename, uint32_t magic1, bool swap)
+{
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    verify_contract(fd != -1,
+        "db_dump_entries: Unable to open file \'%s\'\n", filename);
+
+    // Первое магическое число записывается в формате Big Endian.
+    uint32_t magics[2] = {
+        my_htobe32(MAGIC0),
+        magic1
+    };
+
+    db_write_all(fd, magics, sizeof(magics), filename);
+
+    if (!swap && db->layout == DB_LAYOUT_SORTED)
+    {   // Записи уже хранятся в том виде, в котором они сохраняются в файл.
+        db_write_all(fd, db->entries, (size_t) db->size * sizeof(Entry_t), filename);
+    }
+    else
+    {
+        Entry_t* chunk = malloc(DB_DUMP_CHUNK_SIZE * sizeof(Entry_t));
+        verify_contract(chunk != NULL,
+            "db_dump_entries: Unable to allocate memory\n");
+
+        for (uint32_t start = 0U; start < db->size; start += DB_DUMP_CHUNK_SIZE)
+        {
+            uint32_t chunk_size = db->size - start;
+            if (chunk_size > DB_DUMP_CHUNK_SIZE)
+            {
+                chunk_size = DB_DUMP_CHUNK_SIZE;
+            }
+
+            // Копируем записи в порядке возрастания ключа.
+            if (db->layout == DB_LAYOUT_SORTED)
+            {
+                memcpy(chunk, &db->entries[start], chunk_size * sizeof(Entry_t));
+            }
+            else
+            {
+                for (uint32_t i = 0U; i < chunk_size; ++i)
+                {
+                    chunk[i] = *db_entry(db, start + i);
+                }
+            }
+
+            // Меняем порядок байт ключей.
+            if (swap)
+            {
+                for (uint32_t i = 0U; i < chunk_size; ++i)
+                {
+                    chunk[i].key = db_key_htobe(chunk[i].key);
+                }
+            }
+
+            db_write_all(fd, chunk, chunk_size * sizeof(Entry_t), filename);
+        }
+
+        free(chunk);
+    }
+
+    // Закрываем файл.
+    int ret = close(fd);
+    verify_contract(ret != -1,
+        "db_dump_entries: Detected error on file close operation \'%s\'\n", filename);
+}
+
+//==================================================================================================
+// Функция: db_dump_to_file
+// Назначение: Сохраняет базу данных в файл.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db       (in) - указатель на базу данных.
+// filename (in) - имя файла для сохранения данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_dump_to_file(const struct Database* db, const char* filename)
+{
+    verify_contract(!db_lsm_pending(db),
+        "db_dump_to_file: log-structured database must be flushed first\n");
+    verify_contract(db->arena == NULL,
+        "db_dump_to_file: variable-length values are not supported by file format\n");
+
+    // Ключи и магические числа записываются в формате Big Endian.
+    db_dump_entries(db, filename, my_htobe32(MAGIC1), true);
+}
+
+// Предварительная декларация функции чтения файла в блочном формате.
+void db_scan_blocks(struct Database* db, FILE* file, long fileSize, const char* filename);
+
+//==================================================================================================
+// Функция: db_scan_from_file
+// Назначение: Считывает базу данных из файла.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db       (out) - указатель на базу данных.
+// filename (in)  - имя файла для чтения данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Структура базы данных инициализируется заново, как функцией db_alloc: политика
+//   управления ёмкостью устанавливается по умолчанию (DB_CAPACITY_POLICY_DEFAULT),
+//   и другую политику следует задавать функцией db_set_capacity_policy после загрузки.
+//==================================================================================================
+void db_scan_from_file(struct Database* db, const char* filename)
+{
+    // Открываем файл на чтение в бинарном виде
+    FILE* file = fopen(filename, "rb+");
+    verify_contract(file != NULL,
+        "Unable to open file \'%s\'\n", filename);
+
+    // Измеряем размер файла.
+    int ret = fseek(file, 0L, SEEK_END);
+    verify_contract(
+        ret != -1,
+        "Unable to find end of file: %s\n", filename
+    );
+
+    long fileSize = ftell(file);
+    verify_contract(
+        fileSize != -1,
+        "Unable to measure size for file: %s\n", filename
+    );
+
+    // Возвращаем каретку на исходную точку.
+    ret = fseek(file, 0L, SEEK_SET);
+    verify_contract(
+        ret != -1,
+        "Unable to rewind to start of file: %s\n", filename
+    );
+
+    // Считываем и проверяем магические числа.
+    uint32_t magics[2];
+
+    size_t retf = fread(magics, sizeof(MAGIC0), 2, file);
+    verify_contract(retf == 2,
+        "Unable to read magic number from file \'%s\'\n",
+        filename);
+    verify_contract(
+        my_be32toh(magics[0]) == MAGIC0 &&
+        (my_be32toh(magics[1]) == MAGIC1 || magics[1] == MAGIC1_NATIVE ||
+         my_be32toh(magics[1]) == MAGIC1_BLOCKS),
+        "Invalid magic numbers\n");
+
+    if (my_be32toh(magics[1]) == MAGIC1_BLOCKS)
+    {   // Файл в блочном формате декодируется поблочно.
+        db_scan_blocks(db, file, fileSize, filename);
+
+        ret = fclose(file);
+        verify_contract(ret != EOF,
+            "Detected error on file close operation \'%s\'\n", filename);
+        return;
+    }
+
+    // Ключи в формате с естественным порядком байт не требуют преобразования.
+    bool native = (magics[1] == MAGIC1_NATIVE);
+
+    // Вычисляем количество элементов в базе данных.
+    db->size = (fileSize - sizeof(MAGIC0) - sizeof(MAGIC1)) / sizeof(Entry_t);
+    db->capacity = db->size;
+
+    // База данных размещается в динамической памяти.
+    db->mapped      = NULL;
+    db->mapped_size = 0U;
+
+    // Записи в файле упорядочены по ключу.
+    db->layout      = DB_LAYOUT_SORTED;
+    db->rank_to_pos = NULL;
+    db->pos_to_rank = NULL;
+    db->log         = NULL;
+    db->wal         = NULL;
+    db->sync        = NULL;
+    db->arena       = NULL;
+    db->hash        = NULL;
+
+    db->policy         = DB_CAPACITY_POLICY_DEFAULT;
+    db->capacity_stats = (DbCapacityStats) {.peak_capacity = db->capacity};
+
+    // Выделяем массив для хранения элементов базы данных.
+    db->entries = calloc(db->size, sizeof(Entry_t));
+    verify_contract(db->entries != NULL,
+        "Unable to allocate memory\n");
+
+    // Считываем элементы базы данных
+    retf = fread(db->entries, sizeof(Entry_t), db->size, file);
+    verify_contract(retf == db->size,
+        "Unable to read data from file \'%s\'\n", filename);
+
+    // Меняем эндианность ключей.
+    if (!native)
+    {
+        for (uint32_t i = 0; i < db->size; ++i)
+        {
+            db->entries[i].key = db_key_betoh(db->entries[i].key);
+        }
+    }
+
+    // Закрываем файл.
+    ret = fclose(file);
+    verify_contract(ret != EOF,
+        "Detected error on file close operation \'%s\'\n", filename);
+}
+
+//==================================================================================================
+// Функция: db_dump_to_file_native
+// Назначение: Сохраняет базу данных в файл с естественным порядком байт.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db       (in) - указатель на базу данных.
+// filename (in) - имя файла для сохранения данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Записи сохраняются в файл в том же виде, что и в памяти, единственным вызовом write.
+// - Файл в таком формате может быть открыт функцией db_open_mmap без копирования и
+//   преобразования записей, но только на машине с тем же порядком байт.
+//==================================================================================================
+void db_dump_to_file_native(const struct Database* db, const char* filename)
+{
+    verify_contract(!db_lsm_pending(db),
+        "db_dump_to_file_native: log-structured database must be flushed first\n");
+    verify_contract(db->arena == NULL,
+        "db_dump_to_file_native: variable-length values are not supported by file format\n");
+
+    // Второе магическое число и ключи записываются без преобразования.
+    db_dump_entries(db, filename, MAGIC1_NATIVE, false);
+}
+
+//==================================================================================================
+// Функция: db_open_mmap
+// Назначение: Открывает базу данных из файла через отображение файла в память.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db       (out) - указатель на базу данных.
+// filename (in)  - имя файла с базой данных в формате с естественным порядком байт.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Время открытия не зависит от размера файла: записи не копируются и не преобразуются,
+//   страницы файла подгружаются операционной системой при первом обращении.
+// - Открытая таким образом база данных доступна только для чтения (db_search, db_at_index).
+//   Вызов db_insert и db_remove для неё приводит к ошибке.
+// - Файл должен быть создан функцией db_dump_to_file_native.
+// - Структура базы данных инициализируется заново, как функцией db_alloc: политика
+//   управления ёмкостью устанавливается по умолчанию (DB_CAPACITY_POLICY_DEFAULT),
+//   и другую политику следует задавать функцией db_set_capacity_policy после загрузки.
+//==================================================================================================
+void db_open_mmap(struct Database* db, const char* filename)
+{
+    // Открываем файл на чтение.
+    int fd = open(filename, O_RDONLY);
+    verify_contract(fd != -1,
+        "db_open_mmap: Unable to open file \'%s\'\n", filename);
+
+    // Измеряем размер файла.
+    struct stat file_stat;
+    int ret = fstat(fd, &file_stat);
+    verify_contract(ret != -1,
+        "db_open_mmap: Unable to measure size for file \'%s\'\n", filename);
+
+    size_t fileSize = file_stat.st_size;
+    verify_contract(fileSize >= DB_HEADER_SIZE,
+        "db_open_mmap: File \'%s\' is too small\n", filename);
+
+    // Отображаем файл в память целиком.
+    void* mapped = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    verify_contract(mapped != MAP_FAILED,
+        "db_open_mmap: Unable to map file \'%s\'\n", filename);
+
+    // Отображение сохраняется после закрытия файлового дескриптора.
+    ret = close(fd);
+    verify_contract(ret != -1,
+        "db_open_mmap: Detected error on file close operation \'%s\'\n", filename);
+
+    // Проверяем магические числа.
+    const uint32_t* magics = mapped;
+    verify_contract(my_be32toh(magics[0]) == MAGIC0,
+        "db_open_mmap: Invalid magic numbers\n");
+    verify_contract(magics[1] == MAGIC1_NATIVE,
+        "db_open_mmap: File \'%s\' is not in native byte order format\n", filename);
+
+    // Бинарный поиск обращается к страницам файла в случайном порядке.
+    madvise(mapped, fileSize, MADV_RANDOM);
+
+    // Массив записей начинается сразу после заголовка.
+    db->entries     = (Entry_t*) ((char*) mapped + DB_HEADER_SIZE);
+    db->size        = (fileSize - DB_HEADER_SIZE) / sizeof(Entry_t);
+    db->capacity    = db->size;
+    db->mapped      = mapped;
+    db->mapped_size = fileSize;
+    db->layout      = DB_LAYOUT_SORTED;
+    db->rank_to_pos = NULL;
+    db->pos_to_rank = NULL;
+    db->log         = NULL;
+    db->wal         = NULL;
+    db->sync        = NULL;
+    db->arena       = NULL;
+    db->hash        = NULL;
+
+    db->policy         = DB_CAPACITY_POLICY_DEFAULT;
+    db->capacity_stats = (DbCapacityStats) {.peak_capacity = db->capacity};
+}
+
+//======================//
+// Блочный формат файла //
+//======================//
+
+// Версия блочного формата.
+#define DB_BLOCKS_VERSION 1U
+
+// Размер заголовка (магические числа, версия, размер блока) и концевика
+// (количество записей, количество блоков, смещение индекса блоков) файла.
+#define DB_BLOCKS_HEADER_SIZE  (4U * sizeof(uint32_t))
+#define DB_BLOCKS_TRAILER_SIZE (4U * sizeof(uint32_t))
+
+// Размер описания блока в индексе: наименьший ключ, смещение (два слова), размер.
+#define DB_BLOCKS_INDEX_ENTRY_SIZE (DB_KEY_BYTES + 3U * sizeof(uint32_t))
+
+// Размер заголовка блока: количество записей, первый ключ, ширина разности ключей,
+// размер словаря значений, ширина номера значения в словаре.
+#define DB_BLOCK_HEADER_SIZE (DB_KEY_BYTES + 4U * sizeof(uint32_t))
+
+// Наибольший размер закодированного блока (с запасом на выравнивание битового потока).
+#define DB_BLOCK_MAX_BYTES \
+    (DB_BLOCK_HEADER_SIZE + DB_BLOCK_SIZE * (VALUE_SIZE + DB_KEY_BYTES + sizeof(uint32_t)) + 8U)
+
+//==================================================================================================
+// Функция: db_put_be32
+// Назначение: Записывает 32-битное число в буфер в формате Big Endian.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// dst (out) - буфер.
+// val (in)  - число.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_put_be32(uint8_t* dst, uint32_t val)
+{
+    val = my_htobe32(val);
+    memcpy(dst, &val, sizeof(uint32_t));
+}
+
+//==================================================================================================
+// Функция: db_get_be32
+// Назначение: Считывает из буфера 32-битное число в формате Big Endian.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// src (in) - буфер.
+//
+// Возвращаемое значение:
+// Число с естественным порядком байт.
+//==================================================================================================
+uint32_t db_get_be32(const uint8_t* src)
+{
+    uint32_t val;
+    memcpy(&val, src, sizeof(uint32_t));
+
+    return my_be32toh(val);
+}
+
+//==================================================================================================
+// Функция: db_put_key
+// Назначение: Записывает ключ в буфер в формате Big Endian.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// dst (out) - буфер размера DB_KEY_BYTES.
+// key (in)  - ключ.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_put_key(uint8_t* dst, DbKey_t key)
+{
+    key = db_key_htobe(key);
+    memcpy(dst, &key, DB_KEY_BYTES);
+}
+
+//==================================================================================================
+// Функция: db_get_key
+// Назначение: Считывает из буфера ключ в формате Big Endian.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// src (in) - буфер размера DB_KEY_BYTES.
+//
+// Возвращаемое значение:
+// Ключ с естественным порядком байт.
+//==================================================================================================
+DbKey_t db_get_key(const uint8_t* src)
+{
+    DbKey_t key;
+    memcpy(&key, src, DB_KEY_BYTES);
+
+    return db_key_betoh(key);
+}
+
+//==================================================================================================
+// Функция: db_bit_width
+// Назначение: Вычисляет количество бит, необходимое для записи числа.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// val (in) - число.
+//
+// Возвращаемое значение:
+// Количество значащих бит числа (0 для нуля).
+//==================================================================================================
+uint32_t db_bit_width(uint64_t val)
+{
+    return (val == 0U)? 0U : 64U - __builtin_clzll(val);
+}
+
+//==================================================================================================
+// Функция: db_bits_put
+// Назначение: Записывает число заданной ширины в битовый поток.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// bytes   (in/out) - битовый поток (заполненный нулями до записи).
+// bit_pos (in)     - номер первого бита числа в потоке.
+// val     (in)     - число.
+// width   (in)     - ширина числа в битах (от 0 до 32).
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Биты заполняют байты потока от младших к старшим, поэтому формат
+//   не зависит от порядка байт машины.
+//==================================================================================================
+void db_bits_put(uint8_t* bytes, uint64_t bit_pos, uint64_t val, uint32_t width)
+{
+    uint64_t bits  = val << (bit_pos % 8U);
+    uint32_t total = width + bit_pos % 8U;
+
+    for (uint32_t i = 0U; 8U * i < total; ++i)
+    {
+        bytes[bit_pos / 8U + i] |= (uint8_t) (bits >> (8U * i));
+    }
+}
+
+//==================================================================================================
+// Функция: db_bits_get
+// Назначение: Считывает число заданной ширины из битового потока.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// bytes   (in) - битовый поток.
+// bit_pos (in) - номер первого бита числа в потоке.
+// width   (in) - ширина числа в битах (от 0 до 32).
+//
+// Возвращаемое значение:
+// Число.
+//==================================================================================================
+uint32_t db_bits_get(const uint8_t* bytes, uint64_t bit_pos, uint32_t width)
+{
+    uint32_t total = width + bit_pos % 8U;
+
+    uint64_t bits = 0U;
+    for (uint32_t i = 0U; 8U * i < total; ++i)
+    {
+        bits |= (uint64_t) bytes[bit_pos / 8U + i] << (8U * i);
+    }
+
+    return (bits >> (bit_pos % 8U)) & ((1ULL << width) - 1U);
+}
+
+//==================================================================================================
+// Функция: db_bits_put_key
+// Назначение: Записывает разность ключей заданной ширины в битовый поток.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// bytes   (in/out) - битовый поток (заполненный нулями до записи).
+// bit_pos (in)     - номер первого бита числа в потоке.
+// val     (in)     - разность ключей.
+// width   (in)     - ширина разности в битах (от 0 до DB_KEY_BITS).
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Разность шире 32 бит записывается двумя частями: вместе со сдвигом внутри байта
+//   она не помещается в 64-битное слово. Для 32-битных ключей ветвь удаляется компилятором.
+//==================================================================================================
+void db_bits_put_key(uint8_t* bytes, uint64_t bit_pos, DbKey_t val, uint32_t width)
+{
+    if (DB_KEY_BITS > 32U && width > 32U)
+    {
+        db_bits_put(bytes, bit_pos,       (uint32_t) val,     32U);
+        db_bits_put(bytes, bit_pos + 32U, (uint64_t) val >> 32U, width - 32U);
+        return;
+    }
+
+    db_bits_put(bytes, bit_pos, val, width);
+}
+
+//==================================================================================================
+// Функция: db_bits_get_key
+// Назначение: Считывает разность ключей заданной ширины из битового потока.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// bytes   (in) - битовый поток.
+// bit_pos (in) - номер первого бита числа в потоке.
+// width   (in) - ширина разности в битах (от 0 до DB_KEY_BITS).
+//
+// Возвращаемое значение:
+// Разность ключей.
+//==================================================================================================
+DbKey_t db_bits_get_key(const uint8_t* bytes, uint64_t bit_pos, uint32_t width)
+{
+    if (DB_KEY_BITS > 32U && width > 32U)
+    {
+        uint64_t low  = db_bits_get(bytes, bit_pos, 32U);
+        uint64_t high = db_bits_get(bytes, bit_pos + 32U, width - 32U);
+
+        return (DbKey_t) ((high << 32U) | low);
+    }
+
+    return db_bits_get(bytes, bit_pos, width);
+}
+
+//==================================================================================================
+// Функция: db_block_encode
+// Назначение: Кодирует блок последовательных записей базы данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in)  - указатель на базу данных.
+// start (in)  - индекс первой записи блока.
+// count (in)  - количество записей в блоке (не более DB_BLOCK_SIZE).
+// out   (out) - буфер размера DB_BLOCK_MAX_BYTES.
+//
+// Возвращаемое значение:
+// Размер закодированного блока в байтах.
+//
+// Примечания:
+// - Ключи возрастают, поэтому хранится первый ключ и разности соседних ключей минус один,
+//   упакованные в наименьшую общую для блока ширину.
+// - Различные значения блока образуют словарь; для каждой записи хранится номер
+//   значения в словаре, также упакованный в наименьшую ширину.
+//==================================================================================================
+size_t db_block_encode(const struct Database* db, uint32_t start, uint32_t count, uint8_t* out)
+{
+    // Ширина разностей ключей.
+    DbKey_t max_delta = 0U;
+    for (uint32_t i = 1U; i < count; ++i)
+    {
+        DbKey_t delta = db_entry(db, start + i)->key - db_entry(db, start + i - 1U)->key - 1U;
+        max_delta = (delta > max_delta)? delta : max_delta;
+    }
+
+    uint32_t key_bits = db_bit_width(max_delta);
+
+    // Строим словарь значений при помощи хеш-таблицы с линейным пробированием.
+    // Ячейка хранит номер значения в словаре, увеличенный на единицу (ноль - свободная ячейка).
+    uint16_t table[2U * DB_BLOCK_SIZE] = {};
+    uint32_t dict_first[DB_BLOCK_SIZE];
+    uint32_t dict_index[DB_BLOCK_SIZE];
+    uint32_t dict_size = 0U;
+
+    for (uint32_t i = 0U; i < count; ++i)
+    {
+        const char* value = db_entry(db, start + i)->value;
+
+        uint32_t hash = 2166136261U;
+        for (uint32_t byte_i = 0U; byte_i < VALUE_SIZE; ++byte_i)
+        {
+            hash = (hash ^ (uint8_t) value[byte_i]) * 16777619U;
+        }
+
+        uint32_t slot = hash % (2U * DB_BLOCK_SIZE);
+        while (table[slot] != 0U &&
+               memcmp(db_entry(db, start + dict_first[table[slot] - 1U])->value, value, VALUE_SIZE) != 0)
+        {
+            slot = (slot + 1U) % (2U * DB_BLOCK_SIZE);
+        }
+
+        if (table[slot] == 0U)
+        {
+            dict_first[dict_size] = i;
+            table[slot] = ++dict_size;
+        }
+
+        dict_index[i] = table[slot] - 1U;
+    }
+
+    uint32_t index_bits = db_bit_width(dict_size - 1U);
+
+    // Заголовок блока.
+    db_put_be32(out, count);
+    db_put_key(out + 4U, db_entry(db, start)->key);
+    db_put_be32(out + 4U + DB_KEY_BYTES, key_bits);
+    db_put_be32(out + 8U + DB_KEY_BYTES, dict_size);
+    db_put_be32(out + 12U + DB_KEY_BYTES, index_bits);
+
+    // Словарь значений.
+    uint8_t* dict = out + DB_BLOCK_HEADER_SIZE;
+    for (uint32_t i = 0U; i < dict_size; ++i)
+    {
+        memcpy(dict + i * VALUE_SIZE, db_entry(db, start + dict_first[i])->value, VALUE_SIZE);
+    }
+
+    // Битовый поток: разности ключей, затем номера значений.
+    uint8_t* bits = dict + dict_size * VALUE_SIZE;
+    uint64_t num_bits = (uint64_t) (count - 1U) * key_bits + (uint64_t) count * index_bits;
+    memset(bits, 0, (num_bits + 7U) / 8U);
+
+    uint64_t bit_pos = 0U;
+    for (uint32_t i = 1U; i < count; ++i)
+    {
+        DbKey_t delta = db_entry(db, start + i)->key - db_entry(db, start + i - 1U)->key - 1U;
+
+        db_bits_put_key(bits, bit_pos, delta, key_bits);
+        bit_pos += key_bits;
+    }
+
+    for (uint32_t i = 0U; i < count; ++i)
+    {
+        db_bits_put(bits, bit_pos, dict_index[i], index_bits);
+        bit_pos += index_bits;
+    }
+
+    return (bits - out) + (num_bits + 7U) / 8U;
+}
+
+//==================================================================================================
+// Функция: db_block_decode
+// Назначение: Декодирует блок записей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// data     (in)  - закодированный блок.
+// size     (in)  - размер закодированного блока в байтах.
+// out      (out) - массив из DB_BLOCK_SIZE записей.
+// filename (in)  - имя файла (для сообщения об ошибке).
+//
+// Возвращаемое значение:
+// Количество записей в блоке.
+//==================================================================================================
+uint32_t db_block_decode(const uint8_t* data, size_t size, Entry_t* out, const char* filename)
+{
+    verify_contract(size >= DB_BLOCK_HEADER_SIZE,
+        "db_block_decode: Corrupted block in file \'%s\'\n", filename);
+
+    uint32_t count      = db_get_be32(data);
+    DbKey_t key         = db_get_key(data + 4U);
+    uint32_t key_bits   = db_get_be32(data + 4U + DB_KEY_BYTES);
+    uint32_t dict_size  = db_get_be32(data + 8U + DB_KEY_BYTES);
+    uint32_t index_bits = db_get_be32(data + 12U + DB_KEY_BYTES);
+
+    verify_contract(1U <= count && count <= DB_BLOCK_SIZE &&
+                    1U <= dict_size && dict_size <= count &&
+                    key_bits <= DB_KEY_BITS && index_bits <= 32U,
+        "db_block_decode: Corrupted block header in file \'%s\'\n", filename);
+
+    const uint8_t* dict = data + DB_BLOCK_HEADER_SIZE;
+    const uint8_t* bits = dict + dict_size * VALUE_SIZE;
+    uint64_t num_bits = (uint64_t) (count - 1U) * key_bits + (uint64_t) count * index_bits;
+
+    verify_contract((size_t) (bits - data) + (num_bits + 7U) / 8U <= size,
+        "db_block_decode: Truncated block in file \'%s\'\n", filename);
+
+    // Восстанавливаем ключи по разностям.
+    out[0].key = key;
+
+    uint64_t bit_pos = 0U;
+    for (uint32_t i = 1U; i < count; ++i)
+    {
+        key += db_bits_get_key(bits, bit_pos, key_bits) + 1U;
+        bit_pos += key_bits;
+
+        out[i].key = key;
+    }
+
+    // Восстанавливаем значения по словарю.
+    for (uint32_t i = 0U; i < count; ++i)
+    {
+        uint32_t dict_i = db_bits_get(bits, bit_pos, index_bits);
+        bit_pos += index_bits;
+
+        verify_contract(dict_i < dict_size,
+            "db_block_decode: Corrupted block in file \'%s\'\n", filename);
+
+        memcpy(out[i].value, dict + dict_i * VALUE_SIZE, VALUE_SIZE);
+    }
+
+    return count;
+}
+
+//==================================================================================================
+// Функция: db_dump_to_file_blocks
+// Назначение: Сохраняет базу данных в файл в блочном формате со сжатием.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db       (in) - указатель на базу данных.
+// filename (in) - имя файла для сохранения данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Формат файла: заголовок (MAGIC0, MAGIC1_BLOCKS, версия, размер блока), блоки
+//   по DB_BLOCK_SIZE записей, индекс блоков и концевик. Все числа записываются
+//   в формате Big Endian.
+// - Индекс блоков хранит наименьший ключ каждого блока, поэтому для поиска ключа
+//   достаточно прочитать и декодировать один блок (см. db_block_file_open).
+// - Файл читается функцией db_scan_from_file.
+//==================================================================================================
+void db_dump_to_file_blocks(const struct Database* db, const char* filename)
+{
+    verify_contract(!db_lsm_pending(db),
+        "db_dump_to_file_blocks: log-structured database must be flushed first\n");
+    verify_contract(db->arena == NULL,
+        "db_dump_to_file_blocks: variable-length values are not supported by file format\n");
+
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    verify_contract(fd != -1,
+        "db_dump_to_file_blocks: Unable to open file \'%s\'\n", filename);
+
+    // Заголовок файла.
+    uint8_t header[DB_BLOCKS_HEADER_SIZE];
+    db_put_be32(header +  0U, MAGIC0);
+    db_put_be32(header +  4U, MAGIC1_BLOCKS);
+    db_put_be32(header +  8U, DB_BLOCKS_VERSION);
+    db_put_be32(header + 12U, DB_BLOCK_SIZE);
+
+    db_write_all(fd, header, DB_BLOCKS_HEADER_SIZE, filename);
+
+    // Индекс блоков накапливается в памяти и записывается после блоков.
+    uint32_t num_blocks = (db->size + DB_BLOCK_SIZE - 1U) / DB_BLOCK_SIZE;
+    uint8_t* index = malloc((size_t) num_blocks * DB_BLOCKS_INDEX_ENTRY_SIZE + 1U);
+    uint8_t* block = malloc(DB_BLOCK_MAX_BYTES);
+    verify_contract(index != NULL && block != NULL,
+        "db_dump_to_file_blocks: Unable to allocate memory\n");
+
+    uint64_t offset = DB_BLOCKS_HEADER_SIZE;
+
+    for (uint32_t block_i = 0U; block_i < num_blocks; ++block_i)
+    {
+        uint32_t start = block_i * DB_BLOCK_SIZE;
+        uint32_t count = (db->size - start < DB_BLOCK_SIZE)? db->size - start : DB_BLOCK_SIZE;
+
+        size_t size = db_block_encode(db, start, count, block);
+        db_write_all(fd, block, size, filename);
+
+        uint8_t* index_entry = index + (size_t) block_i * DB_BLOCKS_INDEX_ENTRY_SIZE;
+        db_put_key(index_entry, db_entry(db, start)->key);
+        db_put_be32(index_entry + DB_KEY_BYTES, offset >> 32U);
+        db_put_be32(index_entry + DB_KEY_BYTES + 4U, offset & 0xFFFFFFFFU);
+        db_put_be32(index_entry + DB_KEY_BYTES + 8U, size);
+
+        offset += size;
+    }
+
+    db_write_all(fd, index, (size_t) num_blocks * DB_BLOCKS_INDEX_ENTRY_SIZE, filename);
+
+    // Концевик файла.
+    uint8_t trailer[DB_BLOCKS_TRAILER_SIZE];
+    db_put_be32(trailer +  0U, db->size);
+    db_put_be32(trailer +  4U, num_blocks);
+    db_put_be32(trailer +  8U, offset >> 32U);
+    db_put_be32(trailer + 12U, offset & 0xFFFFFFFFU);
+
+    db_write_all(fd, trailer, DB_BLOCKS_TRAILER_SIZE, filename);
+
+    free(index);
+    free(block);
+
+    int ret = close(fd);
+    verify_contract(ret != -1,
+        "db_dump_to_file_blocks: Detected error on file close operation \'%s\'\n", filename);
+}
+
+//==================================================================================================
+// Функция: db_pread_all
+// Назначение: Считывает из файла блок данных целиком по заданному смещению.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// fd       (in)  - файловый дескриптор.
+// data     (out) - буфер для данных.
+// size     (in)  - размер данных в байтах.
+// offset   (in)  - смещение данных в файле.
+// filename (in)  - имя файла (для сообщения об ошибке).
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_pread_all(int fd, void* data, size_t size, uint64_t offset, const char* filename)
+{
+    char* bytes = data;
+
+    while (size != 0U)
+    {
+        ssize_t bytes_read = pread(fd, bytes, size, offset);
+        verify_contract(bytes_read > 0,
+            "db_pread_all: Unable to read data from file \'%s\'\n", filename);
+
+        bytes  += bytes_read;
+        size   -= bytes_read;
+        offset += bytes_read;
+    }
+}
+
+//==================================================================================================
+// Функция: db_blocks_read_index
+// Назначение: Проверяет заголовок файла в блочном формате и считывает индекс блоков.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// fd        (in)  - файловый дескриптор.
+// file_size (in)  - размер файла.
+// filename  (in)  - имя файла (для сообщения об ошибке).
+// file      (out) - структура, в которую записываются количество записей и индекс блоков.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_blocks_read_index(int fd, uint64_t file_size, const char* filename, struct DbBlockFile* file)
+{
+    verify_contract(file_size >= DB_BLOCKS_HEADER_SIZE + DB_BLOCKS_TRAILER_SIZE,
+        "db_blocks_read_index: File \'%s\' is too small\n", filename);
+
+    // Проверяем заголовок.
+    uint8_t header[DB_BLOCKS_HEADER_SIZE];
+    db_pread_all(fd, header, DB_BLOCKS_HEADER_SIZE, 0U, filename);
+
+    verify_contract(db_get_be32(header + 0U) == MAGIC0 && db_get_be32(header + 4U) == MAGIC1_BLOCKS,
+        "db_blocks_read_index: Invalid magic numbers\n");
+    verify_contract(db_get_be32(header + 8U) == DB_BLOCKS_VERSION,
+        "db_blocks_read_index: Unsupported version of file \'%s\'\n", filename);
+    verify_contract(db_get_be32(header + 12U) == DB_BLOCK_SIZE,
+        "db_blocks_read_index: Unsupported block size in file \'%s\'\n", filename);
+
+    // Считываем концевик.
+    uint8_t trailer[DB_BLOCKS_TRAILER_SIZE];
+    db_pread_all(fd, trailer, DB_BLOCKS_TRAILER_SIZE, file_size - DB_BLOCKS_TRAILER_SIZE, filename);
+
+    file->num_entries = db_get_be32(trailer + 0U);
+    file->num_blocks  = db_get_be32(trailer + 4U);
+
+    uint64_t index_offset = ((uint64_t) db_get_be32(trailer + 8U) << 32U) | db_get_be32(trailer + 12U);
+    uint64_t index_size   = (uint64_t) file->num_blocks * DB_BLOCKS_INDEX_ENTRY_SIZE;
+
+    verify_contract(index_offset + index_size + DB_BLOCKS_TRAILER_SIZE == file_size &&
+                    file->num_blocks == (file->num_entries + DB_BLOCK_SIZE - 1U) / DB_BLOCK_SIZE,
+        "db_blocks_read_index: Corrupted index in file \'%s\'\n", filename);
+
+    // Считываем и разбираем индекс блоков.
+    uint8_t* index = malloc(index_size + 1U);
+    file->first_keys = calloc(file->num_blocks + 1U, sizeof(DbKey_t));
+    file->offsets    = calloc(file->num_blocks + 1U, sizeof(uint64_t));
+    file->sizes      = calloc(file->num_blocks + 1U, sizeof(uint32_t));
+    verify_contract(index != NULL && file->first_keys != NULL &&
+                    file->offsets != NULL && file->sizes != NULL,
+        "db_blocks_read_index: Unable to allocate memory\n");
+
+    db_pread_all(fd, index, index_size, index_offset, filename);
+
+    for (uint32_t block_i = 0U; block_i < file->num_blocks; ++block_i)
+    {
+        const uint8_t* index_entry = index + (size_t) block_i * DB_BLOCKS_INDEX_ENTRY_SIZE;
+
+        file->first_keys[block_i] = db_get_key(index_entry);
+        file->offsets[block_i]    = ((uint64_t) db_get_be32(index_entry + DB_KEY_BYTES) << 32U) |
+                                    db_get_be32(index_entry + DB_KEY_BYTES + 4U);
+        file->sizes[block_i]      = db_get_be32(index_entry + DB_KEY_BYTES + 8U);
+
+        verify_contract(file->sizes[block_i] <= DB_BLOCK_MAX_BYTES &&
+                        file->offsets[block_i] + file->sizes[block_i] <= index_offset,
+            "db_blocks_read_index: Corrupted index in file \'%s\'\n", filename);
+    }
+
+    free(index);
+}
+
+//==================================================================================================
+// Функция: db_scan_blocks
+// Назначение: Считывает базу данных из файла в блочном формате.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db       (out) - указатель на базу данных.
+// file     (in)  - файл, открытый на чтение.
+// fileSize (in)  - размер файла.
+// filename (in)  - имя файла (для сообщения об ошибке).
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Вызывается из db_scan_from_file. Блоки декодируются непосредственно в массив entries.
+// - Политика управления ёмкостью устанавливается по умолчанию, как в db_scan_from_file.
+//==================================================================================================
+void db_scan_blocks(struct Database* db, FILE* file, long fileSize, const char* filename)
+{
+    int fd = fileno(file);
+
+    struct DbBlockFile index;
+    db_blocks_read_index(fd, fileSize, filename, &index);
+
+    // Последний блок декодируется в массив с запасом до полного блока.
+    db->size     = index.num_entries;
+    db->capacity = index.num_blocks * DB_BLOCK_SIZE + 1U;
+
+    db->entries = calloc(db->capacity, sizeof(Entry_t));
+    uint8_t* block = malloc(DB_BLOCK_MAX_BYTES);
+    verify_contract(db->entries != NULL && block != NULL,
+        "db_scan_blocks: Unable to allocate memory\n");
+
+    uint32_t decoded = 0U;
+    for (uint32_t block_i = 0U; block_i < index.num_blocks; ++block_i)
+    {
+        db_pread_all(fd, block, index.sizes[block_i], index.offsets[block_i], filename);
+
+        decoded += db_block_decode(block, index.sizes[block_i], &db->entries[decoded], filename);
+    }
+
+    verify_contract(decoded == db->size,
+        "db_scan_blocks: Corrupted file \'%s\'\n", filename);
+
+    free(block);
+    free(index.first_keys);
+    free(index.offsets);
+    free(index.sizes);
+
+    // База данных размещается в динамической памяти.
+    db->mapped      = NULL;
+    db->mapped_size = 0U;
+
+    // Записи в файле упорядочены по ключу.
+    db->layout      = DB_LAYOUT_SORTED;
+    db->rank_to_pos = NULL;
+    db->pos_to_rank = NULL;
+    db->log         = NULL;
+    db->wal         = NULL;
+    db->sync        = NULL;
+    db->arena       = NULL;
+    db->hash        = NULL;
+
+    db->policy         = DB_CAPACITY_POLICY_DEFAULT;
+    db->capacity_stats = (DbCapacityStats) {.peak_capacity = db->capacity};
+}
+
+//==================================================================================================
+// Функция: db_block_file_open
+// Назначение: Открывает файл в блочном формате для поиска без загрузки базы данных в память.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// file     (out) - указатель на открытый файл.
+// filename (in)  - имя файла, созданного функцией db_dump_to_file_blocks.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - В память загружается только индекс блоков (16 байт на DB_BLOCK_SIZE записей).
+//==================================================================================================
+void db_block_file_open(struct DbBlockFile* file, const char* filename)
+{
+    file->fd = open(filename, O_RDONLY);
+    verify_contract(file->fd != -1,
+        "db_block_file_open: Unable to open file \'%s\'\n", filename);
+
+    file->filename = strdup(filename);
+    verify_contract(file->filename != NULL,
+        "db_block_file_open: Unable to allocate memory\n");
+
+    struct stat file_stat;
+    int ret = fstat(file->fd, &file_stat);
+    verify_contract(ret != -1,
+        "db_block_file_open: Unable to measure size for file \'%s\'\n", filename);
+
+    db_blocks_read_index(file->fd, file_stat.st_size, filename, file);
+
+    file->buffer = malloc(DB_BLOCK_MAX_BYTES);
+    file->block  = calloc(DB_BLOCK_SIZE, sizeof(Entry_t));
+    verify_contract(file->buffer != NULL && file->block != NULL,
+        "db_block_file_open: Unable to allocate memory\n");
+
+    file->block_index = DB_NO_INDEX;
+    file->block_size  = 0U;
+    file->num_decoded = 0U;
+}
+
+//==================================================================================================
+// Функция: db_block_file_search
+// Назначение: Ищет значение по ключу в файле в блочном формате.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// file  (in)  - указатель на открытый файл.
+// key   (in)  - искомый ключ.
+// value (out) - указатель на записываемое функцией значение.
+//
+// Возвращаемое значение:
+// TRUE  - значение по ключу найдено.
+// FALSE - значение по ключу отсутствует.
+//
+// Примечания:
+// - Блок, который может содержать ключ, находится бинарным поиском по индексу блоков,
+//   после чего с диска читается и декодируется только он. Последний декодированный
+//   блок сохраняется, поэтому близкие ключи ищутся без повторного декодирования.
+//==================================================================================================
+bool db_block_file_search(struct DbBlockFile* file, DbKey_t key, char value[VALUE_SIZE])
+{
+    // Находим последний блок с наименьшим ключом, не превосходящим искомый.
+    uint32_t low  = 0U;
+    uint32_t high = file->num_blocks;
+
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low)/2;
+
+        if (file->first_keys[mid] <= key)
+        {
+            low = mid + 1U;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    if (low == 0U)
+    {
         return false;
     }
 
-    if (pos != db->size)
+    uint32_t block_i = low - 1U;
+
+    if (file->block_index != block_i)
+    {
+        db_pread_all(file->fd, file->buffer, file->sizes[block_i], file->offsets[block_i],
+                     file->filename);
+
+        file->block_size  = db_block_decode(file->buffer, file->sizes[block_i], file->block,
+                                            file->filename);
+        file->block_index = block_i;
+        file->num_decoded++;
+    }
+
+    // Ищем ключ в декодированном блоке.
+    struct Database view = {};
+    view.entries = file->block;
+    view.size    = file->block_size;
+    view.layout  = DB_LAYOUT_SORTED;
+
+    uint32_t index;
+    return db_search_sorted(&view, key, value, &index);
+}
+
+//==================================================================================================
+// Функция: db_block_file_close
+// Назначение: Закрывает файл в блочном формате.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// file (in) - указатель на открытый файл.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_block_file_close(struct DbBlockFile* file)
+{
+    int ret = close(file->fd);
+    verify_contract(ret != -1,
+        "db_block_file_close: Detected error on file close operation \'%s\'\n", file->filename);
+
+    free(file->first_keys);
+    free(file->offsets);
+    free(file->sizes);
+    free(file->buffer);
+    free(file->block);
+    free(file->filename);
+}
+
+//=================================//
+// Журнал предзаписи (write-ahead) //
+//=================================//
+
+//==================================================================================================
+// Функция: db_wal_checksum
+// Назначение: Вычисляет контрольную сумму записи журнала предзаписи (FNV-1a).
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// record (in) - указатель на запись журнала.
+//
+// Возвращаемое значение:
+// Контрольная сумма всех полей записи, кроме поля checksum.
+//==================================================================================================
+uint32_t db_wal_checksum(const WalRecord_t* record)
+{
+    const unsigned char* bytes = (const unsigned char*) record;
+
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0U; i < offsetof(WalRecord_t, checksum); ++i)
+    {
+        hash = (hash ^ bytes[i]) * 16777619U;
+    }
+
+    return hash;
+}
+
+//==================================================================================================
+// Функция: db_wal_write_group
+// Назначение: Записывает накопленную группу записей в файл журнала и сбрасывает её на диск.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// wal (in) - указатель на журнал предзаписи.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Группа записывается одним вызовом write и фиксируется одним вызовом fdatasync
+//   (group commit): стоимость синхронизации с диском делится между всеми записями группы.
+//==================================================================================================
+void db_wal_write_group(struct DbWal* wal)
+{
+    if (wal->group_size == 0U)
+    {
+        return;
+    }
+
+    db_write_all(wal->fd, wal->group, wal->group_size * sizeof(WalRecord_t), wal->wal_filename);
+
+    int ret = fdatasync(wal->fd);
+    verify_contract(ret != -1,
+        "db_wal_write_group: Unable to sync file \'%s\'\n", wal->wal_filename);
+
+    wal->num_records += wal->group_size;
+    wal->group_size   = 0U;
+}
+
+//==================================================================================================
+// Функция: db_wal_sync_file
+// Назначение: Сбрасывает на диск содержимое файла или каталога.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// filename (in) - имя файла или каталога.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_wal_sync_file(const char* filename)
+{
+    int fd = open(filename, O_RDONLY);
+    verify_contract(fd != -1,
+        "db_wal_sync_file: Unable to open \'%s\'\n", filename);
+
+    int ret = fsync(fd);
+    verify_contract(ret != -1,
+        "db_wal_sync_file: Unable to sync \'%s\'\n", filename);
+
+    ret = close(fd);
+    verify_contract(ret != -1,
+        "db_wal_sync_file: Detected error on file close operation \'%s\'\n", filename);
+}
+
+//==================================================================================================
+// Функция: db_wal_checkpoint
+// Назначение: Атомарно сохраняет снимок базы данных и очищает журнал предзаписи.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in) - указатель на базу данных с журналом предзаписи.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Снимок записывается во временный файл, который после fsync переименовывается
+//   в файл снимка. Переименование атомарно: при сбое на диске остаётся либо старый,
+//   либо новый снимок целиком.
+// - Журнал очищается после переименования. Если сбой произошёл между переименованием
+//   и очисткой, при восстановлении журнал будет повторно применён к новому снимку.
+//   Это безопасно: итоговое состояние ключа определяется последней операцией над ним.
+// - Вызывается автоматически, когда журнал достигает DB_WAL_CHECKPOINT_SIZE записей.
+//==================================================================================================
+void db_wal_checkpoint(struct Database* db)
+{
+    struct DbWal* wal = db->wal;
+    verify_contract(wal != NULL,
+        "db_wal_checkpoint: database has no write-ahead log\n");
+
+    // Снимок должен содержать все записанные в журнал изменения.
+    db_wal_write_group(wal);
+    db_lsm_flush(db);
+
+    // Имя временного файла и имя каталога, содержащего снимок.
+    size_t length = strlen(wal->snapshot_filename);
+    char* tmp_filename = calloc(length + sizeof(".tmp"), 1U);
+    char* dir_filename = calloc(length + sizeof("."), 1U);
+    verify_contract(tmp_filename != NULL && dir_filename != NULL,
+        "db_wal_checkpoint: Unable to allocate memory\n");
+
+    memcpy(tmp_filename, wal->snapshot_filename, length);
+    memcpy(tmp_filename + length, ".tmp", sizeof(".tmp"));
+
+    const char* slash = strrchr(wal->snapshot_filename, '/');
+    if (slash != NULL)
     {
-        // Сдвигаем элементы на один вправо.
-        memmove(&db->entries[pos + 1], &db->entries[pos], (db->size - pos)  * sizeof(Entry_t));
+        memcpy(dir_filename, wal->snapshot_filename, slash - wal->snapshot_filename + 1U);
+    }
+    else
+    {
+        memcpy(dir_filename, ".", sizeof("."));
     }
 
-    // Производим вставку элемента.
-    db->entries[pos].key = key;
-    memcpy(db->entries[pos].value, value, VALUE_SIZE);
-    db->size++;
-    return true;
+    // Записываем снимок во временный файл и дожидаемся его попадания на диск.
+    db_dump_to_file_native(db, tmp_filename);
+    db_wal_sync_file(tmp_filename);
+
+    // Атомарно заменяем старый снимок новым и фиксируем переименование в каталоге.
+    int ret = rename(tmp_filename, wal->snapshot_filename);
+    verify_contract(ret != -1,
+        "db_wal_checkpoint: Unable to rename \'%s\'\n", tmp_filename);
+
+    db_wal_sync_file(dir_filename);
+
+    // Все записи журнала отражены в снимке. Заголовок журнала сохраняется.
+    ret = ftruncate(wal->fd, sizeof(WalHeader_t));
+    verify_contract(ret != -1,
+        "db_wal_checkpoint: Unable to truncate file \'%s\'\n", wal->wal_filename);
+
+    ret = fdatasync(wal->fd);
+    verify_contract(ret != -1,
+        "db_wal_checkpoint: Unable to sync file \'%s\'\n", wal->wal_filename);
+
+    wal->num_records = 0U;
+
+    free(tmp_filename);
+    free(dir_filename);
+}
+
+//==================================================================================================
+// Функция: db_wal_sync
+// Назначение: Сбрасывает на диск все операции, записанные в журнал предзаписи.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in) - указатель на базу данных с журналом предзаписи.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Операция переживает сбой только после сброса её группы на диск. Группа сбрасывается
+//   автоматически при накоплении DB_WAL_GROUP_SIZE записей, при вызове db_wal_sync
+//   и при закрытии базы данных.
+//==================================================================================================
+void db_wal_sync(struct Database* db)
+{
+    struct DbWal* wal = db->wal;
+    verify_contract(wal != NULL,
+        "db_wal_sync: database has no write-ahead log\n");
+
+    db_wal_write_group(wal);
+
+    if (wal->num_records >= DB_WAL_CHECKPOINT_SIZE)
+    {   // Журнал слишком длинный: восстановление по нему заняло бы много времени.
+        db_wal_checkpoint(db);
+    }
+}
+
+//==================================================================================================
+// Функция: db_wal_push
+// Назначение: Добавляет запись в группу записей журнала предзаписи.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// wal   (in) - указатель на журнал предзаписи.
+// op    (in) - вид операции.
+// key   (in) - ключ.
+// value (in) - значение (NULL для удаления).
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void db_wal_push(struct DbWal* wal, DbWalOp op, DbKey_t key, const char value[VALUE_SIZE])
+{
+    WalRecord_t* record = &wal->group[wal->group_size++];
+
+    record->op  = op;
+    record->key = key;
+
+    if (value != NULL)
+    {
+        memcpy(record->value, value, VALUE_SIZE);
+    }
+    else
+    {
+        memset(record->value, 0, VALUE_SIZE);
+    }
+
+    record->checksum = db_wal_checksum(record);
+
+    if (wal->group_size == DB_WAL_GROUP_SIZE)
+    {
+        db_wal_write_group(wal);
+    }
+}
+
+//==================================================================================================
+// Функция: db_wal_append
+// Назначение: Записывает операцию в журнал предзаписи.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db    (in) - указатель на базу данных.
+// op    (in) - вид операции.
+// key   (in) - ключ.
+// value (in) - значение (NULL для удаления).
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Для базы данных без журнала предзаписи функция ничего не делает.
+// - Вызывается до применения операции к базе данных, поэтому снимок, созданный
+//   здесь при переполнении журнала, содержит все предыдущие операции и только их.
+//==================================================================================================
+void db_wal_append(struct Database* db, DbWalOp op, DbKey_t key, const char value[VALUE_SIZE])
+{
+    if (db->wal == NULL)
+    {
+        return;
+    }
+
+    if (db->wal->num_records >= DB_WAL_CHECKPOINT_SIZE)
+    {
+        db_wal_checkpoint(db);
+    }
+
+    db_wal_push(db->wal, op, key, value);
+}
+
+//==================================================================================================
+// Функция: db_wal_append_batch
+// Назначение: Записывает в журнал предзаписи вставку набора пар ключ-значение.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db     (in) - указатель на базу данных.
+// keys   (in) - массив ключей.
+// values (in) - массив значений.
+// n      (in) - количество пар ключ-значение.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Каждая пара записывается как отдельная вставка: при восстановлении набор
+//   применяется вызовами db_insert по порядку, что совпадает с db_insert_batch.
+// - Снимок может быть создан только до записи первой пары набора.
+//==================================================================================================
+void db_wal_append_batch(struct Database* db, const DbKey_t keys[],
+                         const char values[][VALUE_SIZE], uint32_t n)
+{
+    if (db->wal == NULL)
+    {
+        return;
+    }
+
+    if (db->wal->num_records >= DB_WAL_CHECKPOINT_SIZE)
+    {
+        db_wal_checkpoint(db);
+    }
+
+    for (uint32_t i = 0U; i < n; ++i)
+    {
+        db_wal_push(db->wal, DB_WAL_INSERT, keys[i], values[i]);
+    }
+}
+
+//==================================================================================================
+// Функция: db_wal_open
+// Назначение: Восстанавливает базу данных по снимку и журналу предзаписи
+//             и открывает журнал для записи последующих изменений.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db                (out) - указатель на базу данных.
+// snapshot_filename (in)  - имя файла снимка базы данных.
+// wal_filename      (in)  - имя файла журнала предзаписи.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Отсутствующие файлы соответствуют пустой базе данных.
+// - Журнал начинается с заголовка WalHeader_t. Журнал с чужим магическим числом,
+//   другой разрядностью ключа или другим размером значения не открывается (ошибка
+//   verify_contract), а не принимается за повреждённый и не обрезается.
+// - Операции журнала применяются к снимку по порядку. Чтение журнала прекращается
+//   на первой повреждённой записи (запись, не дописанная из-за сбоя); журнал
+//   обрезается до последней целой записи.
+// - Последующие вызовы db_insert, db_insert_batch и db_remove записываются в журнал.
+//   Стоимость сохранения изменения пропорциональна размеру изменения, а не базы данных.
+//==================================================================================================
+void db_wal_open(struct Database* db, const char* snapshot_filename, const char* wal_filename)
+{
+    // Загружаем последний снимок.
+    if (access(snapshot_filename, F_OK) == 0)
+    {
+        db_scan_from_file(db, snapshot_filename);
+    }
+    else
+    {
+        db_alloc(db);
+    }
+
+    // Открываем журнал на чтение и дозапись.
+    int fd = open(wal_filename, O_RDWR | O_CREAT | O_APPEND, 0644);
+    verify_contract(fd != -1,
+        "db_wal_open: Unable to open file \'%s\'\n", wal_filename);
+
+    struct stat file_stat;
+    int ret = fstat(fd, &file_stat);
+    verify_contract(ret != -1,
+        "db_wal_open: Unable to measure size for file \'%s\'\n", wal_filename);
+
+    // Заголовок журнала, соответствующий текущим параметрам базы данных.
+    const WalHeader_t expected = {
+        .magic      = DB_WAL_MAGIC,
+        .key_bits   = DB_KEY_BITS,
+        .value_size = VALUE_SIZE
+    };
+
+    size_t file_size = file_stat.st_size;
+    if (file_size < sizeof(WalHeader_t))
+    {   // Журнал только что создан или сбой произошёл при записи его заголовка.
+        char prefix[sizeof(WalHeader_t)];
+        db_pread_all(fd, prefix, file_size, 0U, wal_filename);
+        verify_contract(memcmp(prefix, &expected, file_size) == 0,
+            "db_wal_open: File \'%s\' is not a write-ahead log\n", wal_filename);
+
+        ret = ftruncate(fd, 0);
+        verify_contract(ret != -1,
+            "db_wal_open: Unable to truncate file \'%s\'\n", wal_filename);
+
+        db_write_all(fd, &expected, sizeof(WalHeader_t), wal_filename);
+
+        ret = fdatasync(fd);
+        verify_contract(ret != -1,
+            "db_wal_open: Unable to sync file \'%s\'\n", wal_filename);
+
+        file_size = sizeof(WalHeader_t);
+    }
+
+    // Проверяем заголовок: журнал другой базы данных не применяется и не обрезается.
+    WalHeader_t header;
+    db_pread_all(fd, &header, sizeof(WalHeader_t), 0U, wal_filename);
+    verify_contract(header.magic == DB_WAL_MAGIC,
+        "db_wal_open: File \'%s\' is not a write-ahead log\n", wal_filename);
+    verify_contract(header.key_bits == DB_KEY_BITS && header.value_size == VALUE_SIZE,
+        "db_wal_open: Write-ahead log \'%s\' has %u-bit keys and %u-byte values, "
+        "expected %u-bit keys and %u-byte values\n", wal_filename,
+        header.key_bits, header.value_size, DB_KEY_BITS, VALUE_SIZE);
+
+    // Считываем записи журнала целиком.
+    size_t records_size = file_size - sizeof(WalHeader_t);
+    WalRecord_t* records = malloc(records_size + 1U);
+    verify_contract(records != NULL,
+        "db_wal_open: Unable to allocate memory\n");
+
+    db_pread_all(fd, records, records_size, sizeof(WalHeader_t), wal_filename);
+
+    // Применяем целые записи журнала к снимку. Подряд идущие вставки применяются
+    // одним вызовом db_insert_batch, поэтому восстановление занимает O(size) на каждую
+    // серию вставок, а не на каждую вставку.
+    size_t max_records = records_size / sizeof(WalRecord_t);
+    DbKey_t* keys = calloc(max_records + 1U, sizeof(DbKey_t));
+    char (*values)[VALUE_SIZE] = calloc(max_records + 1U, VALUE_SIZE);
+    verify_contract(keys != NULL && values != NULL,
+        "db_wal_open: Unable to allocate memory\n");
+
+    uint32_t num_records = 0U;
+    uint32_t num_inserts = 0U;
+    for (; num_records < max_records; ++num_records)
+    {
+        const WalRecord_t* record = &records[num_records];
+
+        if (record->checksum != db_wal_checksum(record) ||
+            (record->op != DB_WAL_INSERT && record->op != DB_WAL_REMOVE))
+        {
+            break;
+        }
+
+        if (record->op == DB_WAL_INSERT)
+        {
+            keys[num_inserts] = record->key;
+            memcpy(values[num_inserts], record->value, VALUE_SIZE);
+            num_inserts++;
+        }
+        else
+        {
+            db_insert_batch(db, keys, (const char (*)[VALUE_SIZE]) values, num_inserts);
+            num_inserts = 0U;
+
+            char value[VALUE_SIZE];
+            db_remove(db, record->key, value);
+        }
+    }
+
+    db_insert_batch(db, keys, (const char (*)[VALUE_SIZE]) values, num_inserts);
+
+    free(keys);
+    free(values);
+    free(records);
+
+    // Отбрасываем повреждённый хвост журнала.
+    if (num_records * sizeof(WalRecord_t) != records_size)
+    {
+        ret = ftruncate(fd, sizeof(WalHeader_t) + num_records * sizeof(WalRecord_t));
+        verify_contract(ret != -1,
+            "db_wal_open: Unable to truncate file \'%s\'\n", wal_filename);
+
+        ret = fdatasync(fd);
+        verify_contract(ret != -1,
+            "db_wal_open: Unable to sync file \'%s\'\n", wal_filename);
+    }
+
+    // Подключаем журнал к базе данных.
+    struct DbWal* wal = calloc(1U, sizeof(struct DbWal));
+    verify_contract(wal != NULL,
+        "db_wal_open: Unable to allocate memory\n");
+
+    wal->fd                = fd;
+    wal->num_records       = num_records;
+    wal->snapshot_filename = strdup(snapshot_filename);
+    wal->wal_filename      = strdup(wal_filename);
+    wal->group_size        = 0U;
+    verify_contract(wal->snapshot_filename != NULL && wal->wal_filename != NULL,
+        "db_wal_open: Unable to allocate memory\n");
+
+    db->wal = wal;
+}
+
+//==================================================================================================
+// Функция: db_wal_close
+// Назначение: Сбрасывает на диск и закрывает журнал предзаписи.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db (in) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Вызывается из db_free. После вызова изменения базы данных не сохраняются на диск.
+//==================================================================================================
+void db_wal_close(struct Database* db)
+{
+    struct DbWal* wal = db->wal;
+    if (wal == NULL)
+    {
+        return;
+    }
+
+    db_wal_write_group(wal);
+
+    int ret = close(wal->fd);
+    verify_contract(ret != -1,
+        "db_wal_close: Detected error on file close operation \'%s\'\n", wal->wal_filename);
+
+    free(wal->snapshot_filename);
+    free(wal->wal_filename);
+    free(wal);
+
+    db->wal = NULL;
+}
+
+//==============================//
+// Сегментированная база данных //
+//==============================//
+
+// Задание, выполняемое отдельным потоком над одним сегментом.
+typedef struct {
+    // Сегмент и его блокировка.
+    struct Database* shard;
+    pthread_rwlock_t* lock;
+
+    // Имя файла сегмента (для сохранения и чтения).
+    char* filename;
+
+    // Пары ключ-значение сегмента (для пакетной вставки).
+    DbKey_t* keys;
+    char (*values)[VALUE_SIZE];
+    uint32_t n;
+
+    // Результат выполнения задания.
+    uint32_t result;
+} ShardTask;
+
+//==================================================================================================
+// Функция: sdb_alloc
+// Назначение: Инициализирует сегментированную базу данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// sdb        (out) - указатель на сегментированную базу данных.
+// shard_bits (in)  - количество старших бит ключа, задающих номер сегмента
+//                    (от 0 до DB_MAX_SHARD_BITS).
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Сегмент с номером i содержит ключи, старшие shard_bits бит которых равны i, поэтому
+//   каждый сегмент хранит непрерывный диапазон ключей, а сегменты упорядочены по ключам.
+// - Каждый сегмент - независимая база данных со своей блокировкой: вставка сдвигает
+//   только массив своего сегмента, а вставки в разные сегменты выполняются параллельно.
+//==================================================================================================
+void sdb_alloc(struct ShardedDatabase* sdb, uint32_t shard_bits)
+{
+    verify_contract(shard_bits <= DB_MAX_SHARD_BITS,
+        "sdb_alloc: too many shard bits %u\n", shard_bits);
+
+    sdb->shard_bits = shard_bits;
+    sdb->num_shards = 1U << shard_bits;
+
+    sdb->shards = calloc(sdb->num_shards, sizeof(struct Database));
+    sdb->locks  = calloc(sdb->num_shards, sizeof(pthread_rwlock_t));
+    verify_contract(sdb->shards != NULL && sdb->locks != NULL,
+        "sdb_alloc: unable to allocate memory\n");
+
+    for (uint32_t shard_i = 0U; shard_i < sdb->num_shards; ++shard_i)
+    {
+        db_alloc(&sdb->shards[shard_i]);
+
+        int ret = pthread_rwlock_init(&sdb->locks[shard_i], NULL);
+        verify_contract(ret == 0,
+            "sdb_alloc: unable to initialize lock\n");
+    }
+}
+
+//==================================================================================================
+// Функция: sdb_free
+// Назначение: Освобождает ресурсы сегментированной базы данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// sdb (in) - указатель на сегментированную базу данных.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void sdb_free(struct ShardedDatabase* sdb)
+{
+    for (uint32_t shard_i = 0U; shard_i < sdb->num_shards; ++shard_i)
+    {
+        db_free(&sdb->shards[shard_i]);
+
+        int ret = pthread_rwlock_destroy(&sdb->locks[shard_i]);
+        verify_contract(ret == 0,
+            "sdb_free: unable to destroy lock\n");
+    }
+
+    free(sdb->shards);
+    free(sdb->locks);
+
+    sdb->shards     = NULL;
+    sdb->locks      = NULL;
+    sdb->num_shards = 0U;
+    sdb->shard_bits = 0U;
+}
+
+//==================================================================================================
+// Функция: sdb_shard
+// Назначение: Вычисляет номер сегмента, содержащего ключ.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// sdb (in) - указатель на сегментированную базу данных.
+// key (in) - ключ.
+//
+// Возвращаемое значение:
+// Номер сегмента.
+//==================================================================================================
+uint32_t sdb_shard(const struct ShardedDatabase* sdb, DbKey_t key)
+{
+    // Сдвиг на DB_KEY_BITS бит не определён, поэтому единственный сегмент обрабатывается отдельно.
+    return (sdb->shard_bits == 0U)? 0U : (uint32_t) (key >> (DB_KEY_BITS - sdb->shard_bits));
+}
+
+//==================================================================================================
+// Функция: sdb_insert
+// Назначение: Вставляет в сегментированную базу данных значение по заданному ключу.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// sdb   (in) - указатель на сегментированную базу данных.
+// key   (in) - ключ для вставки в базу данных.
+// value (in) - значение для вставки в базу данных.
+//
+// Возвращаемое значение:
+// FALSE - элемент уже присутствовал в базе данных, значение обновлено.
+// TRUE  - элемент успешно добавлен в базу данных.
+//
+// Примечания:
+// - Функцию можно вызывать из нескольких потоков одновременно.
+//==================================================================================================
+bool sdb_insert(struct ShardedDatabase* sdb, DbKey_t key, const char value[VALUE_SIZE])
+{
+    uint32_t shard_i = sdb_shard(sdb, key);
+
+    pthread_rwlock_wrlock(&sdb->locks[shard_i]);
+    bool inserted = db_insert(&sdb->shards[shard_i], key, value);
+    pthread_rwlock_unlock(&sdb->locks[shard_i]);
+
+    return inserted;
 }
 
 //==================================================================================================
-// Функция: db_remove
-// Назначение: Удаляет из базы данных значение по заданному ключу.
+// Функция: sdb_remove
+// Назначение: Удаляет из сегментированной базы данных значение по заданному ключу.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// db    (in)  - указатель на базу данных.
+// sdb   (in)  - указатель на сегментированную базу данных.
 // key   (in)  - ключ для поиска в базе данных.
 // value (out) - значение, которое удалено из базы данных.
 //
 // Возвращаемое значение:
 // FALSE - элемент уже отсутствует в базе данных.
 // TRUE  - элемент успешно удалён из базы данных.
+//
+// Примечания:
+// - Функцию можно вызывать из нескольких потоков одновременно.
 //==================================================================================================
-bool db_remove(struct Database* db, uint32_t key, char value[VALUE_SIZE])
+bool sdb_remove(struct ShardedDatabase* sdb, DbKey_t key, char value[VALUE_SIZE])
 {
-    // Индекс элемента для удаления.
-    uint32_t removeIndex;
+    uint32_t shard_i = sdb_shard(sdb, key);
 
-    // Производим поиск элемента в массиве.
-    bool found = db_search(db, key, value, &removeIndex);
-    if (!found)
+    pthread_rwlock_wrlock(&sdb->locks[shard_i]);
+    bool removed = db_remove(&sdb->shards[shard_i], key, value);
+    pthread_rwlock_unlock(&sdb->locks[shard_i]);
+
+    return removed;
+}
+
+//==================================================================================================
+// Функция: sdb_search
+// Назначение: Ищет в сегментированной базе данных значение по заданному ключу.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// sdb   (in)  - указатель на сегментированную базу данных.
+// key   (in)  - искомый ключ.
+// value (out) - указатель на записываемое функцией значение.
+//
+// Возвращаемое значение:
+// TRUE  - значение по ключу найдено.
+// FALSE - значение по ключу отсутствует.
+//
+// Примечания:
+// - Функцию можно вызывать из нескольких потоков одновременно; поиски в одном
+//   сегменте не блокируют друг друга.
+//==================================================================================================
+bool sdb_search(struct ShardedDatabase* sdb, DbKey_t key, char value[VALUE_SIZE])
+{
+    uint32_t shard_i = sdb_shard(sdb, key);
+
+    pthread_rwlock_rdlock(&sdb->locks[shard_i]);
+    uint32_t index;
+    bool found = db_search(&sdb->shards[shard_i], key, value, &index);
+    pthread_rwlock_unlock(&sdb->locks[shard_i]);
+
+    return found;
+}
+
+//==================================================================================================
+// Функция: sdb_size
+// Назначение: Возвращает количество элементов в сегментированной базе данных.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// sdb (in) - указатель на сегментированную базу данных.
+//
+// Возвращаемое значение:
+// Количество элементов.
+//==================================================================================================
+uint32_t sdb_size(struct ShardedDatabase* sdb)
+{
+    uint32_t size = 0U;
+
+    for (uint32_t shard_i = 0U; shard_i < sdb->num_shards; ++shard_i)
     {
-        return false;
+        pthread_rwlock_rdlock(&sdb->locks[shard_i]);
+        size += db_size(&sdb->shards[shard_i]);
+        pthread_rwlock_unlock(&sdb->locks[shard_i]);
     }
 
-    // Сдвигаем элементы на один влево.
-    if (removeIndex != db->size - 1)
+    return size;
+}
+
+//==================================================================================================
+// Функция: sdb_run_tasks
+// Назначение: Выполняет задания над сегментами параллельно, по потоку на сегмент.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tasks     (in/out) - массив заданий.
+// num_tasks (in)     - количество заданий.
+// routine   (in)     - функция потока, принимающая указатель на задание.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Единственное задание выполняется в вызывающем потоке без создания нового.
+//==================================================================================================
+void sdb_run_tasks(ShardTask* tasks, uint32_t num_tasks, void* (*routine)(void*))
+{
+    if (num_tasks <= 1U)
     {
-        memmove(
-            &db->entries[removeIndex],
-            &db->entries[removeIndex + 1],
-            (db->size - (removeIndex + 1))  * sizeof(Entry_t));
+        if (num_tasks == 1U)
+        {
+            routine(&tasks[0]);
+        }
+
+        return;
     }
 
-    db->size--;
+    pthread_t* threads = calloc(num_tasks, sizeof(pthread_t));
+    verify_contract(threads != NULL,
+        "sdb_run_tasks: unable to allocate memory\n");
 
-    // Освобождаем память, если это необходимо.
-    if (4 <= db->capacity && db->size <= db->capacity/4)
+    for (uint32_t task_i = 0U; task_i < num_tasks; ++task_i)
     {
-        db->capacity /= 2;
+        int ret = pthread_create(&threads[task_i], NULL, routine, &tasks[task_i]);
+        verify_contract(ret == 0,
+            "sdb_run_tasks: unable to create thread\n");
+    }
 
-        db->entries = realloc(db->entries, db->capacity * sizeof(Entry_t));
-        verify_contract(db->entries != NULL,
-            "db_remove: unable to reallocate memory\n");
+    for (uint32_t task_i = 0U; task_i < num_tasks; ++task_i)
+    {
+        int ret = pthread_join(threads[task_i], NULL);
+        verify_contract(ret == 0,
+            "sdb_run_tasks: unable to join thread\n");
     }
 
-    return true;
+    free(threads);
 }
 
-//=================================//
-// Чтение из файла и запись в файл //
-//=================================//
+//==================================================================================================
+// Функция: sdb_insert_batch_task
+// Назначение: Поток пакетной вставки в один сегмент.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// arg (in/out) - указатель на ShardTask.
+//
+// Возвращаемое значение:
+// NULL.
+//==================================================================================================
+void* sdb_insert_batch_task(void* arg)
+{
+    ShardTask* task = arg;
 
-// Магические числа.
-// Используются для идентификации формата базы даных
-const uint32_t MAGIC0 = 0xDEADBEEF;
-const uint32_t MAGIC1 = 0xB01DFACE;
+    pthread_rwlock_wrlock(task->lock);
+    task->result = db_insert_batch(task->shard, task->keys,
+                                   (const char (*)[VALUE_SIZE]) task->values, task->n);
+    pthread_rwlock_unlock(task->lock);
+
+    return NULL;
+}
 
 //==================================================================================================
-// Функция: db_dump_to_file
-// Назначение: Сохраняет базу данных в файл.
+// Функция: sdb_insert_batch
+// Назначение: Вставляет в сегментированную базу данных набор значений по заданным ключам.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// db       (in) - указатель на базу данных.
-// filename (in) - имя файла для сохранения данных.
+// sdb    (in) - указатель на сегментированную базу данных.
+// keys   (in) - массив ключей для вставки в базу данных.
+// values (in) - массив значений для вставки в базу данных.
+// n      (in) - количество вставляемых пар ключ-значение.
 //
 // Возвращаемое значение:
-// Отсутствует.
+// Количество добавленных в базу данных элементов (без учёта обновлённых).
+//
+// Примечания:
+// - Набор распределяется по сегментам с сохранением порядка пар, после чего
+//   каждый сегмент сливается со своей частью набора в отдельном потоке. Сегменты,
+//   на которые не пришлось ни одной пары, пропускаются.
 //==================================================================================================
-void db_dump_to_file(const struct Database* db, const char* filename)
+uint32_t sdb_insert_batch(struct ShardedDatabase* sdb, const DbKey_t keys[],
+                          const char values[][VALUE_SIZE], uint32_t n)
 {
-    // Открываем файл на запись в бинарном виде
-    FILE* file = fopen(filename, "wb+");
-    verify_contract(file != NULL,
-        "db_dump_to_file: Unable to open file \'%s\'\n", filename);
+    // Подсчитываем размеры частей набора.
+    uint32_t* starts = calloc(sdb->num_shards + 1U, sizeof(uint32_t));
+    verify_contract(starts != NULL,
+        "sdb_insert_batch: unable to allocate memory\n");
 
-    // Записываем два магических числа в формате Big Endian.
-    uint32_t magics[2] = {
-        my_htobe32(MAGIC0),
-        my_htobe32(MAGIC1)
-    };
+    for (uint32_t i = 0U; i < n; ++i)
+    {
+        starts[sdb_shard(sdb, keys[i]) + 1U]++;
+    }
 
-    size_t ret = fwrite(magics, sizeof(MAGIC0), 2, file);
-    verify_contract(ret == 2,
-        "db_dump_to_file: Unable to dump magic number to file \'%s\'\n", filename);
+    for (uint32_t shard_i = 0U; shard_i < sdb->num_shards; ++shard_i)
+    {
+        starts[shard_i + 1U] += starts[shard_i];
+    }
 
-    // Записываем остальные данные.
-    for (uint32_t i = 0U; i < db->size; ++i)
+    // Раскладываем пары по частям (устойчиво: при повторении ключа сохраняется последнее значение).
+    DbKey_t* part_keys = calloc(n + 1U, sizeof(DbKey_t));
+    char (*part_values)[VALUE_SIZE] = calloc(n + 1U, VALUE_SIZE);
+    ShardTask* tasks = calloc(sdb->num_shards, sizeof(ShardTask));
+    verify_contract(part_keys != NULL && part_values != NULL && tasks != NULL,
+        "sdb_insert_batch: unable to allocate memory\n");
+
+    for (uint32_t shard_i = 0U; shard_i < sdb->num_shards; ++shard_i)
     {
-        uint32_t key = my_htobe32(db->entries[i].key);
+        tasks[shard_i].shard  = &sdb->shards[shard_i];
+        tasks[shard_i].lock   = &sdb->locks[shard_i];
+        tasks[shard_i].keys   = &part_keys[starts[shard_i]];
+        tasks[shard_i].values = &part_values[starts[shard_i]];
+        tasks[shard_i].n      = 0U;
+    }
 
-        ret = fwrite(&key, sizeof(uint32_t), 1U, file);
-        verify_contract(ret == 1,
-            "db_dump_to_file: Unable to dump data to file \'%s\'\n", filename);
+    for (uint32_t i = 0U; i < n; ++i)
+    {
+        ShardTask* task = &tasks[sdb_shard(sdb, keys[i])];
 
-        ret = fwrite(db->entries[i].value, 1U, VALUE_SIZE, file);
-        verify_contract(ret == VALUE_SIZE,
-            "db_dump_to_file: Unable to dump data to file \'%s\'\n", filename);
+        task->keys[task->n] = keys[i];
+        memcpy(task->values[task->n], values[i], VALUE_SIZE);
+        task->n++;
     }
 
-    // Закрываем файл.
-    ret = fclose(file);
-    verify_contract(ret != EOF,
-        "db_dump_to_file: Detected error on file close operation \'%s\'\n", filename);
+    // Оставляем только непустые задания.
+    uint32_t num_tasks = 0U;
+    for (uint32_t shard_i = 0U; shard_i < sdb->num_shards; ++shard_i)
+    {
+        if (tasks[shard_i].n != 0U)
+        {
+            tasks[num_tasks++] = tasks[shard_i];
+        }
+    }
+
+    sdb_run_tasks(tasks, num_tasks, sdb_insert_batch_task);
+
+    uint32_t inserted = 0U;
+    for (uint32_t task_i = 0U; task_i < num_tasks; ++task_i)
+    {
+        inserted += tasks[task_i].result;
+    }
+
+    free(starts);
+    free(part_keys);
+    free(part_values);
+    free(tasks);
+
+    return inserted;
 }
 
 //==================================================================================================
-// Функция: db_scan_from_file
-// Назначение: Считывает базу данных из файла.
+// Функция: sdb_shard_tasks
+// Назначение: Создаёт задания над всеми сегментами с именами файлов сегментов.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// db       (in) - указатель на базу данных.
-// filename (in) - имя файла для чтения данных.
+// sdb    (in) - указатель на сегментированную базу данных.
+// prefix (in) - префикс имён файлов: сегмент i хранится в файле "<prefix>.<i>".
+//
+// Возвращаемое значение:
+// Массив заданий (освобождается функцией sdb_free_tasks).
+//==================================================================================================
+ShardTask* sdb_shard_tasks(struct ShardedDatabase* sdb, const char* prefix)
+{
+    ShardTask* tasks = calloc(sdb->num_shards, sizeof(ShardTask));
+    verify_contract(tasks != NULL,
+        "sdb_shard_tasks: unable to allocate memory\n");
+
+    for (uint32_t shard_i = 0U; shard_i < sdb->num_shards; ++shard_i)
+    {
+        size_t length = strlen(prefix) + sizeof(".000");
+
+        tasks[shard_i].shard    = &sdb->shards[shard_i];
+        tasks[shard_i].lock     = &sdb->locks[shard_i];
+        tasks[shard_i].filename = malloc(length);
+        verify_contract(tasks[shard_i].filename != NULL,
+            "sdb_shard_tasks: unable to allocate memory\n");
+
+        snprintf(tasks[shard_i].filename, length, "%s.%03u", prefix, shard_i);
+    }
+
+    return tasks;
+}
+
+//==================================================================================================
+// Функция: sdb_free_tasks
+// Назначение: Освобождает массив заданий, созданный функцией sdb_shard_tasks.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tasks     (in) - массив заданий.
+// num_tasks (in) - количество заданий.
 //
 // Возвращаемое значение:
 // Отсутствует.
 //==================================================================================================
-void db_scan_from_file(struct Database* db, const char* filename)
+void sdb_free_tasks(ShardTask* tasks, uint32_t num_tasks)
 {
-    // Открываем файл на чтение в бинарном виде
-    FILE* file = fopen(filename, "rb+");
-    verify_contract(file != NULL,
-        "Unable to open file \'%s\'\n", filename);
+    for (uint32_t task_i = 0U; task_i < num_tasks; ++task_i)
+    {
+        free(tasks[task_i].filename);
+    }
 
-    // Измеряем размер файла.
-    int ret = fseek(file, 0L, SEEK_END);
-    verify_contract(
-        ret != -1,
-        "Unable to find end of file: %s\n", filename
-    );
+    free(tasks);
+}
 
-    long fileSize = ftell(file);
-    verify_contract(
-        fileSize != -1,
-        "Unable to measure size for file: %s\n", filename
-    );
+//==================================================================================================
+// Функция: sdb_dump_task
+// Назначение: Поток сохранения одного сегмента в файл.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// arg (in) - указатель на ShardTask.
+//
+// Возвращаемое значение:
+// NULL.
+//==================================================================================================
+void* sdb_dump_task(void* arg)
+{
+    ShardTask* task = arg;
 
-    // Возвращаем каретку на исходную точку.
-    ret = fseek(file, 0L, SEEK_SET);
-    verify_contract(
-        ret != -1,
-        "Unable to rewind to start of file: %s\n", filename
-    );
+    pthread_rwlock_rdlock(task->lock);
+    db_dump_to_file(task->shard, task->filename);
+    pthread_rwlock_unlock(task->lock);
 
-    // Считываем и проверяем магические числа.
-    uint32_t magics[2];
+    return NULL;
+}
 
-    size_t retf = fread(magics, sizeof(MAGIC0), 2, file);
-    verify_contract(retf == 2,
-        "Unable to read magic number from file \'%s\'\n",
-        filename);
-    verify_contract(
-        my_be32toh(magics[0]) == MAGIC0 && my_be32toh(magics[1]) == MAGIC1,
-        "Invalid magic numbers\n");
+//==================================================================================================
+// Функция: sdb_scan_task
+// Назначение: Поток чтения одного сегмента из файла.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// arg (in/out) - указатель на ShardTask.
+//
+// Возвращаемое значение:
+// NULL.
+//==================================================================================================
+void* sdb_scan_task(void* arg)
+{
+    ShardTask* task = arg;
 
-    // Вычисляем количество элементов в базе данных.
-    db->size = (fileSize - sizeof(MAGIC0) - sizeof(MAGIC1)) / sizeof(Entry_t);
-    db->capacity = db->size;
+    db_scan_from_file(task->shard, task->filename);
 
-    // Выделяем массив для хранения элементов базы данных.
-    db->entries = calloc(db->size, sizeof(Entry_t));
-    verify_contract(db->entries != NULL,
-        "Unable to allocate memory\n");
+    return NULL;
+}
 
-    // Считываем элементы базы данных
-    retf = fread(db->entries, sizeof(Entry_t), db->size, file);
-    verify_contract(retf == db->size,
-        "Unable to read data from file \'%s\'\n", filename);
+//==================================================================================================
+// Функция: sdb_dump_to_files
+// Назначение: Сохраняет сегментированную базу данных в файлы, по файлу на сегмент.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// sdb    (in) - указатель на сегментированную базу данных.
+// prefix (in) - префикс имён файлов: сегмент i сохраняется в файл "<prefix>.<i>".
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Сегменты сохраняются параллельно, каждый в отдельном потоке, в формате db_dump_to_file.
+//==================================================================================================
+void sdb_dump_to_files(struct ShardedDatabase* sdb, const char* prefix)
+{
+    ShardTask* tasks = sdb_shard_tasks(sdb, prefix);
 
-    // Меняем эндианность ключей.
-    for (uint32_t i = 0; i < db->size; ++i)
+    sdb_run_tasks(tasks, sdb->num_shards, sdb_dump_task);
+
+    sdb_free_tasks(tasks, sdb->num_shards);
+}
+
+//==================================================================================================
+// Функция: sdb_scan_from_files
+// Назначение: Считывает сегментированную базу данных из файлов сегментов.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// sdb        (out) - указатель на сегментированную базу данных.
+// prefix     (in)  - префикс имён файлов сегментов.
+// shard_bits (in)  - количество бит номера сегмента, с которым база данных была сохранена.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Сегменты считываются параллельно, каждый в отдельном потоке.
+//==================================================================================================
+void sdb_scan_from_files(struct ShardedDatabase* sdb, const char* prefix, uint32_t shard_bits)
+{
+    sdb_alloc(sdb, shard_bits);
+
+    // Пустые сегменты заменяются считанными из файлов.
+    for (uint32_t shard_i = 0U; shard_i < sdb->num_shards; ++shard_i)
     {
-        db->entries[i].key = my_be32toh(db->entries[i].key);
+        db_free(&sdb->shards[shard_i]);
     }
 
-    // Закрываем файл.
-    ret = fclose(file);
-    verify_contract(ret != EOF,
-        "Detected error on file close operation \'%s\'\n", filename);
-}
\ No newline at end of file
+    ShardTask* tasks = sdb_shard_tasks(sdb, prefix);
+
+    sdb_run_tasks(tasks, sdb->num_shards, sdb_scan_task);
+
+    sdb_free_tasks(tasks, sdb->num_shards);
+
+    // Проверяем, что каждый файл содержит ключи своего сегмента.
+    for (uint32_t shard_i = 0U; shard_i < sdb->num_shards; ++shard_i)
+    {
+        const struct Database* shard = &sdb->shards[shard_i];
+
+        verify_contract(shard->size == 0U ||
+                        (sdb_shard(sdb, db_entry(shard, 0U)->key) == shard_i &&
+                         sdb_shard(sdb, db_entry(shard, shard->size - 1U)->key) == shard_i),
+            "sdb_scan_from_files: shard file %u contains keys of another shard\n", shard_i);
+    }
+}
+
+//==================================================================================================
+// Функция: sdb_range
+// Назначение: Устанавливает курсор на записи с ключами из полуинтервала [lo, hi).
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// sdb    (in)  - указатель на сегментированную базу данных.
+// lo     (in)  - наименьший ключ диапазона.
+// hi     (in)  - ключ, следующий за наибольшим ключом диапазона.
+// cursor (out) - курсор.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Сегменты хранят непересекающиеся упорядоченные диапазоны ключей, поэтому слияние
+//   курсоров сегментов сводится к их последовательному обходу: затрагиваются только
+//   сегменты, пересекающиеся с диапазоном.
+// - Курсор не захватывает блокировки: изменения базы данных во время обхода недопустимы.
+//==================================================================================================
+void sdb_range(const struct ShardedDatabase* sdb, DbKey_t lo, DbKey_t hi, SdbCursor* cursor)
+{
+    cursor->sdb = sdb;
+    cursor->lo  = lo;
+    cursor->hi  = hi;
+
+    cursor->shard      = sdb_shard(sdb, lo);
+    cursor->last_shard = (lo < hi)? sdb_shard(sdb, hi - 1U) : cursor->shard;
+
+    db_range(&sdb->shards[cursor->shard], lo, hi, &cursor->cursor);
+}
+
+//==================================================================================================
+// Функция: sdb_cursor_next
+// Назначение: Возвращает очередную запись диапазона в порядке возрастания ключа.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// cursor (in/out) - курсор.
+//
+// Возвращаемое значение:
+// Указатель на запись (без копирования) или NULL, если диапазон исчерпан.
+//==================================================================================================
+const Entry_t* sdb_cursor_next(SdbCursor* cursor)
+{
+    while (true)
+    {
+        const Entry_t* entry = db_cursor_next(&cursor->cursor);
+        if (entry != NULL)
+        {
+            return entry;
+        }
+
+        if (cursor->shard == cursor->last_shard)
+        {
+            return NULL;
+        }
+
+        // Переходим к следующему сегменту.
+        cursor->shard++;
+        db_range(&cursor->sdb->shards[cursor->shard], cursor->lo, cursor->hi, &cursor->cursor);
+    }
+}
@@ -8,6 +8,54 @@
 #define NUM_INSERTED 10U
 #define NUM_FULL_SEARCHES 10U
 
+// Параметры теста пакетной вставки.
+#define NUM_BATCH_INSERTED 1000U
+#define BATCH_SIZE 100U
+
+// Параметры теста log-structured режима.
+#define NUM_LSM_OPERATIONS 50000U
+#define LSM_KEY_RANGE 20000U
+#define LSM_CHECK_PERIOD 5000U
+
+// Параметры теста журнала предзаписи.
+#define NUM_WAL_OPERATIONS 4000U
+#define WAL_KEY_RANGE 1000U
+
+// Параметры теста режима одновременного доступа.
+#define NUM_CONCURRENT_READERS 3U
+#define NUM_CONCURRENT_WRITES 20000U
+#define CONCURRENT_KEY_RANGE 4000U
+
+// Параметры теста обхода диапазона ключей.
+#define NUM_RANGE_KEYS 5000U
+#define NUM_RANGE_QUERIES 200U
+#define RANGE_RUN_SIZE 7U
+
+// Параметры теста значений переменной длины.
+#define NUM_VALUE_OPERATIONS 20000U
+#define VALUE_KEY_RANGE 500U
+#define MAX_VALUE_LENGTH 40U
+#define VALUE_CHECK_PERIOD 1000U
+
+// Параметры теста хеш-индекса.
+#define NUM_HASH_OPERATIONS 20000U
+#define HASH_KEY_RANGE 3000U
+#define HASH_CHECK_PERIOD 2000U
+
+// Параметры теста блочного формата файла.
+#define NUM_BLOCK_ENTRIES 5000U
+
+// Параметры теста сегментированной базы данных.
+#define SHARD_BITS 3U
+#define NUM_SHARDED_OPERATIONS 20000U
+#define NUM_SHARDED_BATCH 5000U
+#define NUM_SHARDED_RANGES 100U
+
+// Параметры теста управления ёмкостью.
+#define CAPACITY_BASE_SIZE 4096U
+#define NUM_CAPACITY_CYCLES 200U
+#define CAPACITY_SWING 64U
+
 // Бинарное представление IP-адреса
 #define IP_ADDRESS(byte3, byte2, byte1, byte0)                  \
     ((((byte3) & 0xFFU) << 24U) | (((byte2) & 0xFFU) << 16U) |  \
@@ -15,6 +63,17 @@
 
 // Имя файла с базой данных.
 const char* DB_FILENAME = "res/database.db";
+// Имя файла с базой данных в формате с естественным порядком байт.
+const char* DB_NATIVE_FILENAME = "res/database-native.db";
+// Имя файла с базой данных в блочном формате.
+const char* DB_BLOCKS_FILENAME = "res/database-blocks.db";
+// Имена файлов снимка базы данных и журнала предзаписи.
+const char* DB_SNAPSHOT_FILENAME = "res/database-snapshot.db";
+const char* DB_WAL_FILENAME = "res/database.wal";
+// Префикс имён файлов сегментов базы данных.
+const char* DB_SHARDS_PREFIX = "res/database-shard";
+// Имя файла со счётчиками операций в формате JSON.
+const char* DB_STATS_FILENAME = "res/database-stats.json";
 
 #define NUM_HOSTANAMES 10
 const char* hostnames[NUM_HOSTANAMES] =
@@ -31,6 +90,49 @@ const char* hostnames[NUM_HOSTANAMES] =
     "cherry"
 };
 
+// Флаг завершения потоков-читателей.
+bool concurrent_stop = false;
+
+//==================================================================================================
+// Функция: concurrent_reader
+// Назначение: Поток-читатель теста режима одновременного доступа.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// arg (in) - указатель на базу данных.
+//
+// Возвращаемое значение:
+// NULL.
+//
+// Примечания:
+// - Нечётные ключи присутствуют в базе данных всё время теста, чётные вставляются
+//   и удаляются писателем. Значение по ключу - десятичная запись ключа.
+//==================================================================================================
+void* concurrent_reader(void* arg)
+{
+    const struct Database* db = arg;
+
+    unsigned seed = (unsigned) (uintptr_t) &seed;
+
+    while (!__atomic_load_n(&concurrent_stop, __ATOMIC_RELAXED))
+    {
+        uint32_t key = rand_r(&seed) % CONCURRENT_KEY_RANGE;
+
+        char value[VALUE_SIZE];
+        char expected[VALUE_SIZE] = {};
+        snprintf(expected, VALUE_SIZE, "%u", key);
+
+        uint32_t index;
+        bool found = db_search_concurrent(db, key, value, &index);
+
+        verify_contract(found || key % 2U == 0U,
+            "[DB CONCURRENT] Key %u not found\n", key);
+        verify_contract(!found || memcmp(value, expected, VALUE_SIZE) == 0,
+            "[DB CONCURRENT] Unexpected value for key %u\n", key);
+    }
+
+    return NULL;
+}
+
 int main(void)
 {
     //============================================//
@@ -82,6 +184,74 @@ int main(void)
         }
     }
 
+    // Пакетный поиск: сохранённые ключи вперемешку с отсутствующими в БД.
+    DbKey_t batch_keys[2U * NUM_INSERTED];
+    for (size_t saved_i = 0U; saved_i < NUM_INSERTED; ++saved_i)
+    {
+        batch_keys[2U * saved_i + 0U] = saved[saved_i];
+        batch_keys[2U * saved_i + 1U] = saved[saved_i] + 1U;
+    }
+
+    char batch_values[2U * NUM_INSERTED][VALUE_SIZE];
+    bool batch_found[2U * NUM_INSERTED];
+    uint32_t batch_num_found =
+        db_search_batch(&db, batch_keys, 2U * NUM_INSERTED, batch_values, batch_found);
+
+    for (size_t batch_i = 0U; batch_i < 2U * NUM_INSERTED; ++batch_i)
+    {
+        // Результат пакетного поиска должен совпадать с результатом одиночного поиска.
+        char value_expected[VALUE_SIZE];
+        uint32_t index;
+        bool found = db_search(&db, batch_keys[batch_i], value_expected, &index);
+
+        verify_contract(found == batch_found[batch_i],
+            "[DB BATCH SEARCH] Unexpected search result\n");
+        verify_contract(!found || strcmp(value_expected, batch_values[batch_i]) == 0,
+            "[DB BATCH SEARCH] Found unexpected value\n");
+    }
+
+    verify_contract(batch_num_found == NUM_INSERTED,
+        "[DB BATCH SEARCH] Unexpected number of found elements\n");
+
+    // Сохраняем содержимое БД в порядке возрастания ключей.
+    DbKey_t sorted_keys[NUM_INSERTED];
+    char sorted_values[NUM_INSERTED][VALUE_SIZE];
+    for (uint32_t i = 0U; i < db_size(&db); ++i)
+    {
+        db_at_index(&db, i, &sorted_keys[i], sorted_values[i]);
+    }
+
+    // Переупорядочиваем БД в размещение Эйтцингера.
+    db_layout_eytzinger(&db);
+
+    for (uint32_t i = 0U; i < db_size(&db); ++i)
+    {
+        // Доступ по индексу не зависит от размещения.
+        DbKey_t key;
+        char value[VALUE_SIZE];
+        db_at_index(&db, i, &key, value);
+
+        verify_contract(key == sorted_keys[i] && strcmp(value, sorted_values[i]) == 0,
+            "[DB EYTZINGER] Unexpected element at index %u\n", i);
+
+        // Поиск возвращает тот же индекс, что и в упорядоченном размещении.
+        uint32_t index;
+        bool found = db_search(&db, sorted_keys[i], value, &index);
+
+        verify_contract(found && index == i && strcmp(value, sorted_values[i]) == 0,
+            "[DB EYTZINGER] Unable to find an element\n");
+    }
+
+    for (size_t batch_i = 0U; batch_i < 2U * NUM_INSERTED; ++batch_i)
+    {
+        char value_found[VALUE_SIZE];
+        uint32_t index;
+        bool found = db_search(&db, batch_keys[batch_i], value_found, &index);
+
+        verify_contract(found == batch_found[batch_i],
+            "[DB EYTZINGER] Unexpected search result\n");
+    }
+
     for (size_t saved_i = 0U; saved_i < NUM_INSERTED; ++saved_i)
     {
         // Ключ для поиска в БД.
@@ -162,7 +332,7 @@ int main(void)
 
     for (uint32_t i = 0; i < db_size(&db_read); ++i)
     {
-        uint32_t key;
+        DbKey_t key;
         char value[VALUE_SIZE];
 
         db_at_index(&db_read, i, &key, value);
@@ -177,5 +347,968 @@ int main(void)
         printf("%-10s %hhu.%hhu.%hhu.%hhu\n", value, byte3, byte2, byte1, byte0);
     }
 
+    //=============================================//
+    // Тест отображения файла базы данных в память //
+    //=============================================//
+
+    // Сохраняем базу данных в формате с естественным порядком байт.
+    db_dump_to_file_native(&db_read, DB_NATIVE_FILENAME);
+
+    // База данных, отображённая в память.
+    struct Database db_mapped;
+    db_open_mmap(&db_mapped, DB_NATIVE_FILENAME);
+
+    verify_contract(db_size(&db_mapped) == db_size(&db_read),
+        "[DB MMAP] Unexpected database size\n");
+
+    for (uint32_t i = 0; i < db_size(&db_read); ++i)
+    {
+        DbKey_t key_expected;
+        char value_expected[VALUE_SIZE];
+        db_at_index(&db_read, i, &key_expected, value_expected);
+
+        // Проверяем доступ по индексу.
+        DbKey_t key;
+        char value[VALUE_SIZE];
+        db_at_index(&db_mapped, i, &key, value);
+
+        verify_contract(key == key_expected && strcmp(value, value_expected) == 0,
+            "[DB MMAP] Unexpected element at index %u\n", i);
+
+        // Проверяем доступ по ключу.
+        uint32_t index;
+        bool found = db_search(&db_mapped, key_expected, value, &index);
+
+        verify_contract(found && index == i && strcmp(value, value_expected) == 0,
+            "[DB MMAP] Unable to find an element\n");
+    }
+
+    db_free(&db_mapped);
+
+    // Файл с естественным порядком байт также считывается в динамическую память.
+    struct Database db_native;
+    db_scan_from_file(&db_native, DB_NATIVE_FILENAME);
+
+    verify_contract(db_size(&db_native) == db_size(&db_read) &&
+        memcmp(db_native.entries, db_read.entries, db_size(&db_read) * sizeof(Entry_t)) == 0,
+        "[DB NATIVE] Unexpected database contents\n");
+
+    db_free(&db_native);
+    db_free(&db_read);
+
+    //============================//
+    // Тест пакетной вставки в БД //
+    //============================//
+
+    // Ключи выбираются из узкого диапазона, чтобы среди них были повторяющиеся.
+    DbKey_t batch_insert_keys[NUM_BATCH_INSERTED];
+    char batch_insert_values[NUM_BATCH_INSERTED][VALUE_SIZE];
+    for (size_t insert_i = 0U; insert_i < NUM_BATCH_INSERTED; ++insert_i)
+    {
+        batch_insert_keys[insert_i] = rand() % (2U * NUM_BATCH_INSERTED);
+        snprintf(batch_insert_values[insert_i], VALUE_SIZE, "%zu", insert_i);
+    }
+
+    // Эталонная база данных заполняется поэлементной вставкой.
+    struct Database db_single;
+    db_alloc(&db_single);
+
+    // База данных заполняется пакетами по BATCH_SIZE элементов.
+    struct Database db_batch;
+    db_alloc(&db_batch);
+
+    for (size_t insert_i = 0U; insert_i < NUM_BATCH_INSERTED; insert_i += BATCH_SIZE)
+    {
+        uint32_t num_added = 0U;
+        for (size_t batch_i = insert_i; batch_i < insert_i + BATCH_SIZE; ++batch_i)
+        {
+            num_added += db_insert(&db_single, batch_insert_keys[batch_i], batch_insert_values[batch_i]);
+        }
+
+        uint32_t num_batch_added = db_insert_batch(&db_batch,
+            &batch_insert_keys[insert_i], &batch_insert_values[insert_i], BATCH_SIZE);
+
+        verify_contract(num_added == num_batch_added,
+            "[DB BATCH INSERT] Unexpected number of inserted elements\n");
+    }
+
+    // База данных строится из всего набора сразу.
+    struct Database db_built;
+    db_build_from_unsorted(&db_built, batch_insert_keys, batch_insert_values, NUM_BATCH_INSERTED);
+
+    verify_contract(
+        db_size(&db_batch) == db_size(&db_single) && db_size(&db_built) == db_size(&db_single),
+        "[DB BATCH INSERT] Unexpected database size\n");
+
+    for (uint32_t i = 0U; i < db_size(&db_single); ++i)
+    {
+        DbKey_t key_expected, key_batch, key_built;
+        char value_expected[VALUE_SIZE], value_batch[VALUE_SIZE], value_built[VALUE_SIZE];
+
+        db_at_index(&db_single, i, &key_expected, value_expected);
+        db_at_index(&db_batch,  i, &key_batch,    value_batch);
+        db_at_index(&db_built,  i, &key_built,    value_built);
+
+        verify_contract(key_batch == key_expected && strcmp(value_batch, value_expected) == 0,
+            "[DB BATCH INSERT] Unexpected element at index %u\n", i);
+        verify_contract(key_built == key_expected && strcmp(value_built, value_expected) == 0,
+            "[DB BUILD] Unexpected element at index %u\n", i);
+    }
+
+    db_free(&db_single);
+    db_free(&db_batch);
+    db_free(&db_built);
+
+    //======================================//
+    // Тест log-structured режима работы БД //
+    //======================================//
+
+    // Эталонная база данных изменяется напрямую.
+    struct Database db_direct;
+    db_alloc(&db_direct);
+
+    // База данных в log-structured режиме.
+    struct Database db_lsm;
+    db_alloc(&db_lsm);
+    db_lsm_enable(&db_lsm);
+
+    for (size_t op_i = 0U; op_i < NUM_LSM_OPERATIONS; ++op_i)
+    {
+        uint32_t key = rand() % LSM_KEY_RANGE;
+
+        char value_direct[VALUE_SIZE] = {};
+        char value_lsm[VALUE_SIZE]    = {};
+
+        if (rand() % 3 == 0)
+        {   // Каждая третья операция - удаление.
+            bool removed_direct = db_remove(&db_direct, key, value_direct);
+            bool removed_lsm    = db_remove(&db_lsm,    key, value_lsm);
+
+            verify_contract(removed_direct == removed_lsm,
+                "[DB LSM] Unexpected deletion result\n");
+            verify_contract(!removed_direct || strcmp(value_direct, value_lsm) == 0,
+                "[DB LSM] Removed unexpected value\n");
+        }
+        else
+        {
+            snprintf(value_direct, VALUE_SIZE, "%zu", op_i);
+
+            bool inserted_direct = db_insert(&db_direct, key, value_direct);
+            bool inserted_lsm    = db_insert(&db_lsm,    key, value_direct);
+
+            verify_contract(inserted_direct == inserted_lsm,
+                "[DB LSM] Unexpected insertion result\n");
+        }
+
+        verify_contract(db_size(&db_direct) == db_size(&db_lsm),
+            "[DB LSM] Unexpected database size\n");
+
+        if (op_i % LSM_CHECK_PERIOD == 0U)
+        {   // Периодически сверяем результаты поиска по всему диапазону ключей.
+            for (uint32_t search_key = 0U; search_key < LSM_KEY_RANGE; ++search_key)
+            {
+                uint32_t index;
+                bool found_direct = db_search(&db_direct, search_key, value_direct, &index);
+                bool found_lsm    = db_search(&db_lsm,    search_key, value_lsm,    &index);
+
+                verify_contract(found_direct == found_lsm,
+                    "[DB LSM] Unexpected search result\n");
+                verify_contract(!found_direct || strcmp(value_direct, value_lsm) == 0,
+                    "[DB LSM] Found unexpected value\n");
+            }
+        }
+    }
+
+    // После слияния журнала содержимое баз данных совпадает поэлементно.
+    db_lsm_flush(&db_lsm);
+
+    verify_contract(db_size(&db_lsm) == db_size(&db_direct),
+        "[DB LSM] Unexpected database size after flush\n");
+
+    for (uint32_t i = 0U; i < db_size(&db_direct); ++i)
+    {
+        DbKey_t key_direct, key_lsm;
+        char value_direct[VALUE_SIZE], value_lsm[VALUE_SIZE];
+
+        db_at_index(&db_direct, i, &key_direct, value_direct);
+        db_at_index(&db_lsm,    i, &key_lsm,    value_lsm);
+
+        verify_contract(key_direct == key_lsm && strcmp(value_direct, value_lsm) == 0,
+            "[DB LSM] Unexpected element at index %u\n", i);
+    }
+
+    db_free(&db_direct);
+    db_free(&db_lsm);
+
+    //===============================//
+    // Тест журнала предзаписи (WAL) //
+    //===============================//
+
+    // Начинаем с пустой базы данных.
+    unlink(DB_SNAPSHOT_FILENAME);
+    unlink(DB_WAL_FILENAME);
+
+    // Эталонная база данных не сохраняется на диск.
+    struct Database db_reference;
+    db_alloc(&db_reference);
+
+    struct Database db_durable;
+    db_wal_open(&db_durable, DB_SNAPSHOT_FILENAME, DB_WAL_FILENAME);
+
+    for (size_t op_i = 0U; op_i < NUM_WAL_OPERATIONS; ++op_i)
+    {
+        uint32_t key = rand() % WAL_KEY_RANGE;
+
+        char value[VALUE_SIZE] = {};
+        snprintf(value, VALUE_SIZE, "%zu", op_i);
+
+        if (rand() % 3 == 0)
+        {   // Каждая третья операция - удаление.
+            db_remove(&db_reference, key, value);
+            db_remove(&db_durable,   key, value);
+        }
+        else if (rand() % 10 == 0)
+        {   // Изредка вставляем пару ключей пакетом.
+            DbKey_t keys[2] = {key, rand() % WAL_KEY_RANGE};
+            char values[2][VALUE_SIZE] = {};
+            memcpy(values[0], value, VALUE_SIZE);
+
+            db_insert_batch(&db_reference, keys, values, 2U);
+            db_insert_batch(&db_durable,   keys, values, 2U);
+        }
+        else
+        {
+            db_insert(&db_reference, key, value);
+            db_insert(&db_durable,   key, value);
+        }
+
+        if (op_i == NUM_WAL_OPERATIONS / 2U)
+        {   // Середина операций сохраняется в снимке, остальные - в журнале.
+            db_wal_checkpoint(&db_durable);
+        }
+    }
+
+    db_free(&db_durable);
+
+    // Имитируем сбой во время дозаписи в журнал: недописанная запись в конце файла.
+    FILE* wal_file = fopen(DB_WAL_FILENAME, "ab");
+    verify_contract(wal_file != NULL,
+        "[DB WAL] Unable to open write-ahead log\n");
+    fwrite("torn record", 1U, 11U, wal_file);
+    fclose(wal_file);
+
+    // Восстанавливаем базу данных по снимку и журналу.
+    db_wal_open(&db_durable, DB_SNAPSHOT_FILENAME, DB_WAL_FILENAME);
+
+    verify_contract(db_size(&db_durable) == db_size(&db_reference),
+        "[DB WAL] Unexpected database size after recovery\n");
+
+    for (uint32_t i = 0U; i < db_size(&db_reference); ++i)
+    {
+        DbKey_t key_reference, key_durable;
+        char value_reference[VALUE_SIZE], value_durable[VALUE_SIZE];
+
+        db_at_index(&db_reference, i, &key_reference, value_reference);
+        db_at_index(&db_durable,   i, &key_durable,   value_durable);
+
+        verify_contract(key_reference == key_durable &&
+                        memcmp(value_reference, value_durable, VALUE_SIZE) == 0,
+            "[DB WAL] Unexpected element at index %u after recovery\n", i);
+    }
+
+    db_free(&db_reference);
+    db_free(&db_durable);
+
+    //=======================================//
+    // Тест режима одновременного доступа БД //
+    //=======================================//
+
+    struct Database db_shared;
+    db_alloc(&db_shared);
+    db_concurrent_enable(&db_shared);
+
+    // Нечётные ключи вставляются до запуска читателей.
+    for (uint32_t key = 1U; key < CONCURRENT_KEY_RANGE; key += 2U)
+    {
+        char value[VALUE_SIZE] = {};
+        snprintf(value, VALUE_SIZE, "%u", key);
+
+        db_insert_concurrent(&db_shared, key, value);
+    }
+
+    pthread_t readers[NUM_CONCURRENT_READERS];
+    for (uint32_t reader_i = 0U; reader_i < NUM_CONCURRENT_READERS; ++reader_i)
+    {
+        int ret = pthread_create(&readers[reader_i], NULL, concurrent_reader, &db_shared);
+        verify_contract(ret == 0,
+            "[DB CONCURRENT] Unable to create reader thread\n");
+    }
+
+    // Писатель вставляет и удаляет чётные ключи, многократно меняя ёмкость массива.
+    for (uint32_t write_i = 0U; write_i < NUM_CONCURRENT_WRITES; ++write_i)
+    {
+        uint32_t key = 2U * (rand() % (CONCURRENT_KEY_RANGE / 2U));
+
+        char value[VALUE_SIZE] = {};
+        snprintf(value, VALUE_SIZE, "%u", key);
+
+        if (rand() % 2 == 0)
+        {
+            db_insert_concurrent(&db_shared, key, value);
+        }
+        else
+        {
+            db_remove_concurrent(&db_shared, key, value);
+        }
+
+        if (write_i % 1000U == 0U)
+        {   // Пакетная вставка всех чётных ключей.
+            DbKey_t keys[CONCURRENT_KEY_RANGE / 2U];
+            char values[CONCURRENT_KEY_RANGE / 2U][VALUE_SIZE];
+            memset(values, 0, sizeof(values));
+
+            for (uint32_t i = 0U; i < CONCURRENT_KEY_RANGE / 2U; ++i)
+            {
+                keys[i] = 2U * i;
+                snprintf(values[i], VALUE_SIZE, "%u", 2U * i);
+            }
+
+            db_insert_batch_concurrent(&db_shared, keys, values, CONCURRENT_KEY_RANGE / 2U);
+        }
+    }
+
+    __atomic_store_n(&concurrent_stop, true, __ATOMIC_RELAXED);
+
+    for (uint32_t reader_i = 0U; reader_i < NUM_CONCURRENT_READERS; ++reader_i)
+    {
+        int ret = pthread_join(readers[reader_i], NULL);
+        verify_contract(ret == 0,
+            "[DB CONCURRENT] Unable to join reader thread\n");
+    }
+
+    // Без читателей двух записей достаточно, чтобы освободить все заменённые массивы.
+    for (uint32_t write_i = 0U; write_i < 2U; ++write_i)
+    {
+        char value[VALUE_SIZE] = {};
+        db_insert_concurrent(&db_shared, 1U, value);
+    }
+
+    verify_contract(db_shared.sync->num_retired == 0U,
+        "[DB CONCURRENT] Replaced entry arrays are expected to be reclaimed\n");
+
+    db_free(&db_shared);
+
+    //=================================//
+    // Тест обхода диапазона ключей БД //
+    //=================================//
+
+    // Адреса хостов из нескольких подсетей 10.x.y.z.
+    struct Database db_hosts;
+    db_alloc(&db_hosts);
+
+    for (uint32_t i = 0U; i < NUM_RANGE_KEYS; ++i)
+    {
+        char value[VALUE_SIZE] = {};
+        uint32_t key = IP_ADDRESS(10, rand() % 4, rand() % 16, rand() % 256);
+        memcpy(value, &key, sizeof(key));
+
+        db_insert(&db_hosts, key, value);
+    }
+
+    for (uint32_t layout_i = 0U; layout_i < 2U; ++layout_i)
+    {
+        if (layout_i == 1U)
+        {
+            db_layout_eytzinger(&db_hosts);
+        }
+
+        for (uint32_t query_i = 0U; query_i < NUM_RANGE_QUERIES; ++query_i)
+        {
+            DbCursor cursor;
+            uint32_t lo, hi;
+
+            if (query_i % 2U == 0U)
+            {   // Произвольный полуинтервал.
+                lo = IP_ADDRESS(10, rand() % 4, rand() % 16, rand() % 256);
+                hi = lo + rand() % 4096;
+                db_range(&db_hosts, lo, hi, &cursor);
+            }
+            else
+            {   // Подсеть 10.a.b.0/24 или 10.a.0.0/16.
+                uint32_t prefix_bits = (rand() % 2 == 0)? 24U : 16U;
+                lo = IP_ADDRESS(10, rand() % 4, rand() % 16, 0);
+                lo &= ~((1U << (32U - prefix_bits)) - 1U);
+                hi = lo + (1U << (32U - prefix_bits));
+
+                // Адрес занимает младшие 32 бита ключа.
+                db_prefix(&db_hosts, lo, prefix_bits + (DB_KEY_BITS - 32U), &cursor);
+            }
+
+            // Сверяем обход участками с перебором всех записей по индексу.
+            uint32_t index = 0U;
+            const Entry_t* run;
+            uint32_t run_size;
+
+            while ((run_size = db_cursor_next_n(&cursor, &run, RANGE_RUN_SIZE)) != 0U)
+            {
+                for (uint32_t i = 0U; i < run_size; ++i)
+                {
+                    for (; index < db_size(&db_hosts); ++index)
+                    {
+                        DbKey_t key;
+                        char value[VALUE_SIZE];
+                        db_at_index(&db_hosts, index, &key, value);
+
+                        if (lo <= key && key < hi)
+                        {
+                            verify_contract(key == run[i].key &&
+                                            memcmp(value, run[i].value, VALUE_SIZE) == 0,
+                                "[DB RANGE] Unexpected entry in range\n");
+                            break;
+                        }
+                    }
+
+                    verify_contract(index < db_size(&db_hosts),
+                        "[DB RANGE] Entry out of range\n");
+                    index++;
+                }
+            }
+
+            // После исчерпания курсора в диапазоне не осталось записей.
+            verify_contract(db_cursor_next(&cursor) == NULL,
+                "[DB RANGE] Cursor is not exhausted\n");
+
+            for (; index < db_size(&db_hosts); ++index)
+            {
+                DbKey_t key;
+                char value[VALUE_SIZE];
+                db_at_index(&db_hosts, index, &key, value);
+
+                verify_contract(key < lo || hi <= key,
+                    "[DB RANGE] Entry %u missing from range\n", (unsigned) key);
+            }
+        }
+    }
+
+    db_free(&db_hosts);
+
+#ifdef DB_ARENA_SUPPORTED
+    //=====================================//
+    // Тест значений переменной длины в БД //
+    //=====================================//
+
+    struct Database db_values;
+    db_alloc(&db_values);
+    db_arena_enable(&db_values);
+
+    // Эталонные значения по ключам.
+    static char expected_values[VALUE_KEY_RANGE][MAX_VALUE_LENGTH];
+    static uint32_t expected_lengths[VALUE_KEY_RANGE];
+    static bool expected_present[VALUE_KEY_RANGE];
+
+    for (uint32_t op_i = 0U; op_i < NUM_VALUE_OPERATIONS; ++op_i)
+    {
+        uint32_t key = rand() % VALUE_KEY_RANGE;
+
+        if (rand() % 3 == 0)
+        {
+            bool removed = db_remove_value(&db_values, key);
+
+            verify_contract(removed == expected_present[key],
+                "[DB VALUES] Unexpected deletion result\n");
+
+            expected_present[key] = false;
+        }
+        else
+        {
+            // Короткие и длинные значения вперемешку.
+            uint32_t length = rand() % MAX_VALUE_LENGTH;
+            for (uint32_t i = 0U; i < length; ++i)
+            {
+                expected_values[key][i] = 'a' + rand() % 26;
+            }
+
+            bool inserted = db_insert_value(&db_values, key, expected_values[key], length);
+
+            verify_contract(inserted == !expected_present[key],
+                "[DB VALUES] Unexpected insertion result\n");
+
+            expected_lengths[key] = length;
+            expected_present[key] = true;
+        }
+
+        if (op_i % VALUE_CHECK_PERIOD == 0U)
+        {
+            for (uint32_t search_key = 0U; search_key < VALUE_KEY_RANGE; ++search_key)
+            {
+                const char* value;
+                uint32_t length;
+                bool found = db_search_value(&db_values, search_key, &value, &length);
+
+                verify_contract(found == expected_present[search_key],
+                    "[DB VALUES] Unexpected search result\n");
+                verify_contract(!found ||
+                                (length == expected_lengths[search_key] &&
+                                 memcmp(value, expected_values[search_key], length) == 0),
+                    "[DB VALUES] Found unexpected value\n");
+            }
+        }
+    }
+
+    // Уплотнение не позволяет области значений расти неограниченно.
+    verify_contract(db_values.arena->size <= 4U * VALUE_KEY_RANGE * MAX_VALUE_LENGTH,
+        "[DB VALUES] Value arena is not compacted\n");
+
+    // Курсор выдаёт записи, значения которых читаются без копирования.
+    DbCursor values_cursor;
+    db_range(&db_values, 0U, VALUE_KEY_RANGE, &values_cursor);
+
+    for (const Entry_t* entry; (entry = db_cursor_next(&values_cursor)) != NULL;)
+    {
+        uint32_t length;
+        const char* value = db_value(&db_values, entry, &length);
+
+        verify_contract(expected_present[entry->key] &&
+                        length == expected_lengths[entry->key] &&
+                        memcmp(value, expected_values[entry->key], length) == 0,
+            "[DB VALUES] Unexpected value in range\n");
+    }
+
+    db_free(&db_values);
+#endif // DB_ARENA_SUPPORTED
+
+    //=========================//
+    // Тест хеш-индекса для БД //
+    //=========================//
+
+    // Эталонная база данных использует бинарный поиск.
+    struct Database db_binary;
+    db_alloc(&db_binary);
+
+    struct Database db_hashed;
+    db_alloc(&db_hashed);
+    db_hash_enable(&db_hashed);
+
+    for (uint32_t op_i = 0U; op_i < NUM_HASH_OPERATIONS; ++op_i)
+    {
+        // Ключи в верхней половине диапазона значений проверяют сравнение с DB_NO_INDEX.
+        uint32_t key = (rand() % HASH_KEY_RANGE) * 0x100001U;
+
+        char value_binary[VALUE_SIZE] = {};
+        char value_hashed[VALUE_SIZE] = {};
+        snprintf(value_binary, VALUE_SIZE, "%u", op_i);
+
+        int action = rand() % 100;
+        if (action < 40)
+        {
+            bool removed_binary = db_remove(&db_binary, key, value_binary);
+            bool removed_hashed = db_remove(&db_hashed, key, value_hashed);
+
+            verify_contract(removed_binary == removed_hashed,
+                "[DB HASH] Unexpected deletion result\n");
+        }
+        else if (action < 41)
+        {   // Пакетная вставка перестраивает индекс.
+            DbKey_t keys[2] = {key, (rand() % HASH_KEY_RANGE) * 0x100001U};
+            char values[2][VALUE_SIZE] = {};
+
+            db_insert_batch(&db_binary, keys, values, 2U);
+            db_insert_batch(&db_hashed, keys, values, 2U);
+        }
+        else
+        {
+            db_insert(&db_binary, key, value_binary);
+            db_insert(&db_hashed, key, value_binary);
+        }
+
+        if (op_i % HASH_CHECK_PERIOD == 0U)
+        {
+            for (uint32_t key_i = 0U; key_i < HASH_KEY_RANGE; ++key_i)
+            {
+                uint32_t search_key = key_i * 0x100001U;
+                uint32_t index_binary = 0U, index_hashed = 0U;
+
+                bool found_binary = db_search(&db_binary, search_key, value_binary, &index_binary);
+                bool found_hashed = db_search(&db_hashed, search_key, value_hashed, &index_hashed);
+
+                verify_contract(found_binary == found_hashed,
+                    "[DB HASH] Unexpected search result\n");
+                verify_contract(!found_binary ||
+                                (index_binary == index_hashed &&
+                                 memcmp(value_binary, value_hashed, VALUE_SIZE) == 0),
+                    "[DB HASH] Found unexpected element\n");
+            }
+        }
+    }
+
+    db_free(&db_binary);
+    db_free(&db_hashed);
+
+    //====================================//
+    // Тест блочного формата файла для БД //
+    //====================================//
+
+    // Адреса хостов с повторяющимися именами.
+    struct Database db_plain;
+    db_alloc(&db_plain);
+
+    for (uint32_t i = 0U; i < NUM_BLOCK_ENTRIES; ++i)
+    {
+        char value[VALUE_SIZE] = {};
+        strncpy(value, hostnames[rand() % NUM_HOSTANAMES], VALUE_SIZE - 1U);
+
+        db_insert(&db_plain, IP_ADDRESS(10, rand() % 256, rand() % 256, rand() % 256), value);
+    }
+
+    // Граничные ключи проверяют разности максимальной ширины.
+    char edge_value[VALUE_SIZE] = "edge";
+    db_insert(&db_plain, 0U, edge_value);
+    db_insert(&db_plain, DB_KEY_MAX, edge_value);
+
+    db_dump_to_file_blocks(&db_plain, DB_BLOCKS_FILENAME);
+
+    // Файл считывается целиком.
+    struct Database db_unpacked;
+    db_scan_from_file(&db_unpacked, DB_BLOCKS_FILENAME);
+
+    verify_contract(db_size(&db_unpacked) == db_size(&db_plain),
+        "[DB BLOCKS] Unexpected database size\n");
+
+    for (uint32_t i = 0U; i < db_size(&db_plain); ++i)
+    {
+        DbKey_t key_plain, key_unpacked;
+        char value_plain[VALUE_SIZE], value_unpacked[VALUE_SIZE];
+
+        db_at_index(&db_plain,    i, &key_plain,    value_plain);
+        db_at_index(&db_unpacked, i, &key_unpacked, value_unpacked);
+
+        verify_contract(key_plain == key_unpacked &&
+                        memcmp(value_plain, value_unpacked, VALUE_SIZE) == 0,
+            "[DB BLOCKS] Unexpected element at index %u\n", i);
+    }
+
+    // Поиск по файлу декодирует только блоки, содержащие искомые ключи.
+    struct DbBlockFile block_file;
+    db_block_file_open(&block_file, DB_BLOCKS_FILENAME);
+
+    for (uint32_t i = 0U; i < db_size(&db_plain); ++i)
+    {
+        DbKey_t key;
+        char value_plain[VALUE_SIZE], value_file[VALUE_SIZE];
+        db_at_index(&db_plain, i, &key, value_plain);
+
+        verify_contract(db_block_file_search(&block_file, key, value_file) &&
+                        memcmp(value_plain, value_file, VALUE_SIZE) == 0,
+            "[DB BLOCKS] Key %u not found in file\n", (unsigned) key);
+
+        // Соседний ключ отсутствует в базе данных.
+        uint32_t index;
+        if (key != DB_KEY_MAX && !db_search(&db_plain, key + 1U, value_plain, &index))
+        {
+            verify_contract(!db_block_file_search(&block_file, key + 1U, value_file),
+                "[DB BLOCKS] Unexpected key %u found in file\n", (unsigned) key + 1U);
+        }
+    }
+
+    verify_contract(block_file.num_decoded == block_file.num_blocks,
+        "[DB BLOCKS] Each block is expected to be decoded once\n");
+
+    db_block_file_close(&block_file);
+
+    db_free(&db_plain);
+    db_free(&db_unpacked);
+
+    //========================================//
+    // Тест сегментированной базы данных (БД) //
+    //========================================//
+
+    struct Database db_unsharded;
+    db_alloc(&db_unsharded);
+
+    struct ShardedDatabase sdb;
+    sdb_alloc(&sdb, SHARD_BITS);
+
+    // Ключи перемешиваются умножением, чтобы попадать во все сегменты.
+    for (uint32_t op_i = 0U; op_i < NUM_SHARDED_OPERATIONS; ++op_i)
+    {
+        DbKey_t key = (DbKey_t) (rand() % 4096) * DB_KEY_HASH_MULTIPLIER;
+        char value_reference[VALUE_SIZE] = {};
+        char value_sharded[VALUE_SIZE]   = {};
+        snprintf(value_reference, VALUE_SIZE, "%u", op_i);
+
+        if (rand() % 3 != 0)
+        {
+            verify_contract(db_insert(&db_unsharded, key, value_reference) ==
+                            sdb_insert(&sdb, key, value_reference),
+                "[DB SHARDS] Unexpected insert result\n");
+        }
+        else
+        {
+            bool removed = db_remove(&db_unsharded, key, value_reference);
+            verify_contract(removed == sdb_remove(&sdb, key, value_sharded),
+                "[DB SHARDS] Unexpected remove result\n");
+            verify_contract(!removed || memcmp(value_reference, value_sharded, VALUE_SIZE) == 0,
+                "[DB SHARDS] Unexpected removed value\n");
+        }
+    }
+
+    // Пакетная вставка распределяет набор по сегментам.
+    DbKey_t sharded_keys[NUM_SHARDED_BATCH];
+    char sharded_values[NUM_SHARDED_BATCH][VALUE_SIZE] = {};
+    for (uint32_t i = 0U; i < NUM_SHARDED_BATCH; ++i)
+    {
+        sharded_keys[i] = (DbKey_t) rand() * DB_KEY_HASH_MULTIPLIER;
+        snprintf(sharded_values[i], VALUE_SIZE, "b%u", i);
+    }
+
+    verify_contract(db_insert_batch(&db_unsharded, sharded_keys, sharded_values, NUM_SHARDED_BATCH) ==
+                    sdb_insert_batch(&sdb, sharded_keys, sharded_values, NUM_SHARDED_BATCH),
+        "[DB SHARDS] Unexpected batch insert result\n");
+
+    // Сохранение и чтение сегментов.
+    sdb_dump_to_files(&sdb, DB_SHARDS_PREFIX);
+    sdb_free(&sdb);
+    sdb_scan_from_files(&sdb, DB_SHARDS_PREFIX, SHARD_BITS);
+
+    verify_contract(sdb_size(&sdb) == db_size(&db_unsharded),
+        "[DB SHARDS] Unexpected database size\n");
+
+    for (uint32_t i = 0U; i < db_size(&db_unsharded); ++i)
+    {
+        DbKey_t key;
+        char value_reference[VALUE_SIZE], value_sharded[VALUE_SIZE];
+        db_at_index(&db_unsharded, i, &key, value_reference);
+
+        verify_contract(sdb_search(&sdb, key, value_sharded) &&
+                        memcmp(value_reference, value_sharded, VALUE_SIZE) == 0,
+            "[DB SHARDS] Key %u not found\n", (unsigned) key);
+    }
+
+    // Обход диапазонов, в том числе пересекающих границы сегментов, упорядочен по ключам.
+    for (uint32_t range_i = 0U; range_i <= NUM_SHARDED_RANGES; ++range_i)
+    {
+        DbKey_t lo = (DbKey_t) rand() * DB_KEY_HASH_MULTIPLIER;
+        DbKey_t hi = (DbKey_t) rand() * DB_KEY_HASH_MULTIPLIER;
+        if (range_i == NUM_SHARDED_RANGES)
+        {
+            lo = 0U;
+            hi = DB_KEY_MAX;
+        }
+        else if (lo > hi)
+        {
+            DbKey_t tmp = lo;
+            lo = hi;
+            hi = tmp;
+        }
+
+        DbCursor cursor_reference;
+        SdbCursor cursor_sharded;
+        db_range(&db_unsharded, lo, hi, &cursor_reference);
+        sdb_range(&sdb, lo, hi, &cursor_sharded);
+
+        const Entry_t* entry_reference;
+        const Entry_t* entry_sharded;
+        do
+        {
+            entry_reference = db_cursor_next(&cursor_reference);
+            entry_sharded   = sdb_cursor_next(&cursor_sharded);
+
+            verify_contract((entry_reference == NULL) == (entry_sharded == NULL),
+                "[DB SHARDS] Unexpected range length\n");
+            verify_contract(entry_reference == NULL ||
+                            memcmp(entry_reference, entry_sharded, sizeof(Entry_t)) == 0,
+                "[DB SHARDS] Unexpected range element\n");
+        }
+        while (entry_reference != NULL);
+    }
+
+    sdb_free(&sdb);
+    db_free(&db_unsharded);
+
+    //=============================//
+    // Тест управления ёмкостью БД //
+    //=============================//
+
+    // Зарезервированная ёмкость не изменяется при вставках.
+    struct Database db_reserved;
+    db_alloc(&db_reserved);
+    db_reserve(&db_reserved, CAPACITY_BASE_SIZE);
+
+    DbCapacityStats stats;
+    db_capacity_stats(&db_reserved, &stats);
+
+    for (uint32_t key = 0U; key < CAPACITY_BASE_SIZE; ++key)
+    {
+        char value[VALUE_SIZE] = {};
+        db_insert(&db_reserved, key, value);
+    }
+
+    DbCapacityStats stats_after;
+    db_capacity_stats(&db_reserved, &stats_after);
+    verify_contract(stats_after.num_grows == stats.num_grows && stats_after.num_shrinks == 0U,
+        "[DB CAPACITY] Reserved capacity is expected to be kept\n");
+
+    // Удаление до четверти ёмкости и вставка обратно при уменьшении вдвое
+    // приводят к изменению ёмкости в каждом цикле. Уменьшение с запасом
+    // (трёхкратное увеличение, порог в одну восьмую) такого не допускает.
+    DbCapacityPolicy policy = DB_CAPACITY_POLICY_DEFAULT;
+    policy.growth_percent = 300U;
+    policy.shrink_divisor = 8U;
+    db_set_capacity_policy(&db_reserved, &policy);
+
+    for (uint32_t key = CAPACITY_BASE_SIZE / 8U; key < CAPACITY_BASE_SIZE; ++key)
+    {
+        char value[VALUE_SIZE];
+        db_remove(&db_reserved, key, value);
+    }
+
+    db_capacity_stats(&db_reserved, &stats);
+    verify_contract(stats.num_shrinks == 1U,
+        "[DB CAPACITY] Expected a single shrink\n");
+
+    for (uint32_t cycle = 0U; cycle < NUM_CAPACITY_CYCLES; ++cycle)
+    {
+        for (uint32_t i = 0U; i < CAPACITY_SWING; ++i)
+        {
+            char value[VALUE_SIZE] = {};
+            db_insert(&db_reserved, CAPACITY_BASE_SIZE + i, value);
+        }
+
+        for (uint32_t i = 0U; i < CAPACITY_SWING; ++i)
+        {
+            char value[VALUE_SIZE];
+            db_remove(&db_reserved, CAPACITY_BASE_SIZE + i, value);
+        }
+    }
+
+    db_capacity_stats(&db_reserved, &stats_after);
+    verify_contract(stats_after.num_grows == stats.num_grows &&
+                    stats_after.num_shrinks == stats.num_shrinks,
+        "[DB CAPACITY] Capacity is expected to stay stable under churn\n");
+
+    // Отложенное уменьшение: удаления не изменяют ёмкость до явного вызова db_shrink.
+    policy.shrink_period = 0U;
+    db_set_capacity_policy(&db_reserved, &policy);
+
+    for (uint32_t key = 0U; key < CAPACITY_BASE_SIZE / 8U - 1U; ++key)
+    {
+        char value[VALUE_SIZE];
+        db_remove(&db_reserved, key, value);
+    }
+
+    db_capacity_stats(&db_reserved, &stats);
+    verify_contract(stats.num_shrinks == stats_after.num_shrinks,
+        "[DB CAPACITY] Lazy policy is expected to postpone shrinking\n");
+
+    db_shrink(&db_reserved);
+    verify_contract(db_reserved.capacity == 3U && db_size(&db_reserved) == 1U,
+        "[DB CAPACITY] Unexpected capacity after explicit shrink\n");
+
+    db_free(&db_reserved);
+    verify_contract(db_reserved.policy.growth_percent == 300U &&
+                    db_reserved.policy.shrink_period == 0U,
+        "[DB CAPACITY] Capacity policy is expected to survive db_free\n");
+
+    // Массивы в больших страницах сохраняют содержимое при изменении ёмкости.
+    struct Database db_huge;
+    db_alloc(&db_huge);
+
+    policy = DB_CAPACITY_POLICY_DEFAULT;
+    policy.huge_page_bytes = 1U;
+    db_set_capacity_policy(&db_huge, &policy);
+
+    for (uint32_t key = 0U; key < CAPACITY_BASE_SIZE; ++key)
+    {
+        char value[VALUE_SIZE] = {};
+        snprintf(value, VALUE_SIZE, "%u", key);
+        db_insert(&db_huge, CAPACITY_BASE_SIZE - key, value);
+    }
+
+    for (uint32_t key = 0U; key < CAPACITY_BASE_SIZE; ++key)
+    {
+        char expected[VALUE_SIZE] = {};
+        char value[VALUE_SIZE];
+        uint32_t index;
+        snprintf(expected, VALUE_SIZE, "%u", key);
+
+        verify_contract(db_search(&db_huge, CAPACITY_BASE_SIZE - key, value, &index) &&
+                        memcmp(value, expected, VALUE_SIZE) == 0,
+            "[DB CAPACITY] Unexpected value in huge page backed database\n");
+    }
+
+    db_capacity_stats(&db_huge, &stats);
+    verify_contract(stats.num_huge_allocs == stats.num_grows,
+        "[DB CAPACITY] Every array is expected to be huge page backed\n");
+
+    db_free(&db_huge);
+
+    // Пакетная вставка в пустую базу данных выделяет массив по политике с запасом ёмкости.
+    struct Database db_bulk;
+    db_alloc(&db_bulk);
+
+    DbKey_t bulk_keys[CAPACITY_BASE_SIZE / 8U];
+    char bulk_values[CAPACITY_BASE_SIZE / 8U][VALUE_SIZE];
+    memset(bulk_values, 0, sizeof(bulk_values));
+
+    for (uint32_t i = 0U; i < CAPACITY_BASE_SIZE / 8U; ++i)
+    {
+        bulk_keys[i] = CAPACITY_BASE_SIZE / 8U - i;
+    }
+
+    db_insert_batch(&db_bulk, bulk_keys, bulk_values, CAPACITY_BASE_SIZE / 8U);
+
+    db_capacity_stats(&db_bulk, &stats);
+    verify_contract(stats.num_grows == 1U && db_bulk.capacity > db_size(&db_bulk),
+        "[DB CAPACITY] Bulk load is expected to follow the capacity policy\n");
+
+    char bulk_value[VALUE_SIZE] = {};
+    db_insert(&db_bulk, 0U, bulk_value);
+
+    db_capacity_stats(&db_bulk, &stats_after);
+    verify_contract(stats_after.num_grows == stats.num_grows,
+        "[DB CAPACITY] Insert after bulk load is expected to fit in reserved capacity\n");
+
+    db_free(&db_bulk);
+
+    //============================//
+    // Тест инструментирования БД //
+    //============================//
+
+    // Количество операций совпадает с суммой гистограммы задержки.
+    struct DbStats stats_total;
+    db_stats_collect(&stats_total);
+
+    for (uint32_t op = 0U; op < DB_NUM_OPS; ++op)
+    {
+        uint64_t histogram_total = 0U;
+        for (uint32_t bucket = 0U; bucket < DB_STATS_NUM_BUCKETS; ++bucket)
+        {
+            histogram_total += stats_total.latency[op][bucket];
+        }
+
+        verify_contract(histogram_total == stats_total.num_ops[op],
+            "[DB STATS] Histogram does not match operation count\n");
+    }
+
+#ifdef DB_STATS
+    verify_contract(stats_total.num_ops[DB_OP_SEARCH] != 0U && stats_total.num_ops[DB_OP_INSERT] != 0U &&
+                    stats_total.num_ops[DB_OP_REMOVE] != 0U && stats_total.num_probes != 0U &&
+                    stats_total.bytes_moved != 0U && stats_total.num_reallocs != 0U,
+        "[DB STATS] Expected non-zero counters\n");
+
+    // Счётчики выводятся после прогона тестов.
+    db_stats_dump(stdout, DB_STATS_TEXT);
+
+    FILE* stats_file = fopen(DB_STATS_FILENAME, "w");
+    verify_contract(stats_file != NULL,
+        "[DB STATS] Unable to open file \'%s\'\n", DB_STATS_FILENAME);
+
+    db_stats_dump(stats_file, DB_STATS_JSON);
+    fclose(stats_file);
+#else
+    verify_contract(stats_total.num_probes == 0U,
+        "[DB STATS] Counters are expected to be disabled\n");
+#endif // DB_STATS
+
     return EXIT_SUCCESS;
 }
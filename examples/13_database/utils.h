@@ -179,6 +179,41 @@ uint32_t my_be32toh(uint32_t val)
     return htobe32(val);
 }
 
+//==================================================================================================
+// Функция: my_htobe64
+// Назначение: Меняет порядок байт в 64-битном беззнаковом числе на Big Endian.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// val (in) - число (с естественным порядком байт).
+//
+// Возвращаемое значение:
+// Число с порядком байт Big Endian.
+//==================================================================================================
+uint64_t my_htobe64(uint64_t val)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // Используем встроенную функцию компилятора.
+    return __builtin_bswap64(val);
+#else
+    return val;
+#endif
+}
+
+//==================================================================================================
+// Функция: my_be64toh
+// Назначение: Меняет порядок байт в 64-битном беззнаковом числе с Big Endian.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// val (in) - число (с порядком байт Big Endian).
+//
+// Возвращаемое значение:
+// Число с естественным порядком байт.
+//==================================================================================================
+uint64_t my_be64toh(uint64_t val)
+{
+    return my_htobe64(val);
+}
+
 //==================================================================================================
 // Функция: byteswap32_slow
 // Назначение: Неэффективно меняет порядок байт в 32-битном беззнаковом числе.
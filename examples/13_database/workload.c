@@ -0,0 +1,487 @@
+// Copyright 2025 Vladislav Aleinik
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+#include "database.h"
+#include "utils.h"
+
+// Размеры баз данных для измерений.
+#define NUM_SIZES 6U
+const uint32_t DB_SIZES[NUM_SIZES] = {1000U, 10000U, 100000U, 1000000U, 10000000U, 100000000U};
+
+// Наибольший размер базы данных по умолчанию: 100 млн записей требуют нескольких гигабайт памяти.
+#define DEFAULT_MAX_SIZE 10000000U
+
+// Количество потоков.
+#define NUM_THREAD_COUNTS 4U
+const uint32_t THREAD_COUNTS[NUM_THREAD_COUNTS] = {1U, 2U, 4U, 8U};
+
+// Доля операций записи, в процентах.
+#define NUM_WRITE_MIXES 3U
+const uint32_t WRITE_PERCENTS[NUM_WRITE_MIXES] = {0U, 5U, 50U};
+
+// Распределения ключей запросов.
+typedef enum {
+    // Все ключи базы данных равновероятны.
+    DIST_UNIFORM    = 0,
+    // Вероятность ключа убывает по закону Ципфа от его ранга (популярные ключи).
+    DIST_ZIPF       = 1,
+    // Ключи запрашиваются в порядке возрастания.
+    DIST_SEQUENTIAL = 2,
+    NUM_DISTS       = 3
+} Distribution;
+
+const char* DIST_NAMES[NUM_DISTS] = {"uniform", "zipf", "sequential"};
+
+// Показатель распределения Ципфа (как в YCSB).
+#define ZIPF_THETA 0.99
+
+// Общее количество операций в одном измерении (делится между потоками).
+#define NUM_OPS 2000000U
+// Задержка измеряется для каждой SAMPLE_PERIOD-й операции.
+#define SAMPLE_PERIOD 8U
+
+// Размер пакета при заполнении базы данных.
+#define FILL_BATCH_SIZE 65536U
+
+// Имя файла с результатами.
+const char* CSV_FILENAME = "res/workload.csv";
+
+// Параметры распределения Ципфа для заданного количества ключей.
+typedef struct {
+    uint32_t n;
+    double zeta_n;
+    double alpha;
+    double eta;
+    double half_pow_theta;
+} ZipfParams;
+
+// Аргументы рабочего потока.
+struct WorkerArgs
+{
+    // База данных в режиме одновременного доступа.
+    struct Database* db;
+    // Размер базы данных.
+    uint32_t size;
+    // Распределение ключей и параметры распределения Ципфа.
+    Distribution dist;
+    const ZipfParams* zipf;
+    // Доля операций записи, в процентах.
+    uint32_t write_percent;
+    // Количество операций потока и номер потока.
+    uint32_t num_ops;
+    uint32_t thread_i;
+
+    // Измеренные задержки (массив из num_ops / SAMPLE_PERIOD элементов).
+    uint32_t* samples;
+    uint32_t num_samples;
+};
+
+//==================================================================================================
+// Функция: time_now_ns
+// Назначение: Возвращает текущее время в наносекундах.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// отсутствуют.
+//
+// Возвращаемое значение:
+// Время по монотонным часам.
+//==================================================================================================
+uint64_t time_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return 1000000000ULL * ts.tv_sec + ts.tv_nsec;
+}
+
+//==================================================================================================
+// Функция: xorshift64
+// Назначение: Генерирует псевдослучайное число (генератор без общего состояния между потоками).
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// state (in/out) - состояние генератора (не равно нулю).
+//
+// Возвращаемое значение:
+// Псевдослучайное 64-битное число.
+//==================================================================================================
+uint64_t xorshift64(uint64_t* state)
+{
+    uint64_t x = *state;
+    x ^= x << 13U;
+    x ^= x >> 7U;
+    x ^= x << 17U;
+
+    return *state = x;
+}
+
+//==================================================================================================
+// Функция: zipf_init
+// Назначение: Вычисляет параметры распределения Ципфа.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// zipf (out) - параметры распределения.
+// n    (in)  - количество ключей.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//
+// Примечания:
+// - Используется метод Грэя и др. ("Quickly generating billion-record synthetic databases"):
+//   дзета-функция вычисляется один раз за O(n), генерация ранга выполняется за O(1).
+//==================================================================================================
+void zipf_init(ZipfParams* zipf, uint32_t n)
+{
+    double zeta_n = 0.0;
+    for (uint32_t i = 1U; i <= n; ++i)
+    {
+        zeta_n += 1.0 / pow(i, ZIPF_THETA);
+    }
+
+    double zeta_2 = 1.0 + 1.0 / pow(2.0, ZIPF_THETA);
+
+    zipf->n              = n;
+    zipf->zeta_n         = zeta_n;
+    zipf->alpha          = 1.0 / (1.0 - ZIPF_THETA);
+    zipf->eta            = (1.0 - pow(2.0 / n, 1.0 - ZIPF_THETA)) / (1.0 - zeta_2 / zeta_n);
+    zipf->half_pow_theta = 1.0 + pow(0.5, ZIPF_THETA);
+}
+
+//==================================================================================================
+// Функция: zipf_next
+// Назначение: Генерирует ранг по распределению Ципфа.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// zipf  (in)     - параметры распределения.
+// state (in/out) - состояние генератора случайных чисел.
+//
+// Возвращаемое значение:
+// Ранг от 0 (самый популярный) до n - 1.
+//==================================================================================================
+uint32_t zipf_next(const ZipfParams* zipf, uint64_t* state)
+{
+    double u  = (xorshift64(state) >> 11U) * (1.0 / 9007199254740992.0);
+    double uz = u * zipf->zeta_n;
+
+    if (uz < 1.0)
+    {
+        return 0U;
+    }
+
+    if (uz < zipf->half_pow_theta)
+    {
+        return 1U;
+    }
+
+    uint32_t rank = (uint32_t) (zipf->n * pow(zipf->eta * u - zipf->eta + 1.0, zipf->alpha));
+    return (rank < zipf->n)? rank : zipf->n - 1U;
+}
+
+//==================================================================================================
+// Функция: worker_thread
+// Назначение: Поток, выполняющий поиск и обновление записей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// arg (in/out) - указатель на struct WorkerArgs.
+//
+// Возвращаемое значение:
+// NULL.
+//
+// Примечания:
+// - База данных содержит ключи 0, 2, ..., 2 * (size - 1). Ранги распределения Ципфа
+//   перемешиваются умножением, чтобы популярные ключи не были соседними.
+// - Запись обновляет значение существующего ключа: размер базы данных не меняется,
+//   и измерение не зависит от стоимости сдвига массива (см. benchmark.c).
+//==================================================================================================
+void* worker_thread(void* arg)
+{
+    struct WorkerArgs* args = arg;
+
+    uint64_t state = 0x9E3779B97F4A7C15ULL * (args->thread_i + 1U);
+    uint32_t next  = (uint32_t) ((uint64_t) args->size * args->thread_i / THREAD_COUNTS[NUM_THREAD_COUNTS - 1U]);
+
+    // Контрольная сумма - защита от удаления цикла компилятором.
+    uint32_t checksum = 0U;
+
+    for (uint32_t op_i = 0U; op_i < args->num_ops; ++op_i)
+    {
+        uint32_t i;
+        switch (args->dist)
+        {
+            case DIST_UNIFORM:
+                i = xorshift64(&state) % args->size;
+                break;
+            case DIST_ZIPF:
+                i = (uint32_t) (zipf_next(args->zipf, &state) * 2654435761ULL % args->size);
+                break;
+            case DIST_SEQUENTIAL:
+            default:
+                i = next;
+                next = (next + 1U == args->size)? 0U : next + 1U;
+                break;
+        }
+
+        bool write = (xorshift64(&state) % 100U) < args->write_percent;
+        bool sample = (op_i % SAMPLE_PERIOD == 0U);
+
+        uint64_t start = sample? time_now_ns() : 0U;
+
+        char value[VALUE_SIZE] = {};
+        if (write)
+        {
+            memcpy(value, &op_i, sizeof(op_i));
+            checksum += db_insert_concurrent(args->db, 2U * i, value);
+        }
+        else
+        {
+            uint32_t index;
+            checksum += db_search_concurrent(args->db, 2U * i, value, &index);
+        }
+
+        if (sample)
+        {
+            uint64_t elapsed = time_now_ns() - start;
+            args->samples[args->num_samples++] = (elapsed < 0xFFFFFFFFU)? elapsed : 0xFFFFFFFFU;
+        }
+    }
+
+    verify_contract(args->write_percent == 100U || checksum != 0U,
+        "Unexpected search results\n");
+
+    return NULL;
+}
+
+//==================================================================================================
+// Функция: compare_u32
+// Назначение: Сравнивает два 32-битных числа (для qsort).
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// lhs (in) - указатель на первое число.
+// rhs (in) - указатель на второе число.
+//
+// Возвращаемое значение:
+// Отрицательное число, ноль или положительное число.
+//==================================================================================================
+int compare_u32(const void* lhs, const void* rhs)
+{
+    uint32_t a = *(const uint32_t*) lhs;
+    uint32_t b = *(const uint32_t*) rhs;
+
+    return (a > b) - (a < b);
+}
+
+//==================================================================================================
+// Функция: perf_open_cache_misses
+// Назначение: Открывает счётчик промахов кеша последнего уровня для процесса и его потоков.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// отсутствуют.
+//
+// Возвращаемое значение:
+// Файловый дескриптор счётчика или -1, если счётчики недоступны
+// (нет поддержки в ядре, виртуальная машина, ограничение perf_event_paranoid).
+//
+// Примечания:
+// - Флаг inherit распространяет счётчик на потоки, созданные после его открытия.
+//==================================================================================================
+int perf_open_cache_misses(void)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.size           = sizeof(attr);
+    attr.config         = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled       = 1;
+    attr.inherit        = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+//==================================================================================================
+// Функция: run_workload
+// Назначение: Выполняет одно измерение и записывает результат в CSV-файл.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// db            (in) - база данных в режиме одновременного доступа.
+// size          (in) - размер базы данных.
+// dist          (in) - распределение ключей.
+// zipf          (in) - параметры распределения Ципфа.
+// num_threads   (in) - количество потоков.
+// write_percent (in) - доля операций записи, в процентах.
+// csv           (in) - CSV-файл с результатами.
+//
+// Возвращаемое значение:
+// Отсутствует.
+//==================================================================================================
+void run_workload(struct Database* db, uint32_t size, Distribution dist, const ZipfParams* zipf,
+                  uint32_t num_threads, uint32_t write_percent, FILE* csv)
+{
+    pthread_t threads[num_threads];
+    struct WorkerArgs args[num_threads];
+
+    uint32_t ops_per_thread = NUM_OPS / num_threads;
+    uint32_t samples_per_thread = ops_per_thread / SAMPLE_PERIOD + 1U;
+
+    uint32_t* samples = calloc((size_t) num_threads * samples_per_thread, sizeof(uint32_t));
+    verify_contract(samples != NULL, "Unable to allocate memory\n");
+
+    int perf_fd = perf_open_cache_misses();
+    if (perf_fd != -1)
+    {
+        ioctl(perf_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    // Начало измеряемого отрезка времени.
+    uint64_t start = time_now_ns();
+
+    for (uint32_t thread_i = 0U; thread_i < num_threads; ++thread_i)
+    {
+        args[thread_i] = (struct WorkerArgs) {
+            .db            = db,
+            .size          = size,
+            .dist          = dist,
+            .zipf          = zipf,
+            .write_percent = write_percent,
+            .num_ops       = ops_per_thread,
+            .thread_i      = thread_i,
+            .samples       = &samples[(size_t) thread_i * samples_per_thread],
+            .num_samples   = 0U
+        };
+
+        int ret = pthread_create(&threads[thread_i], NULL, worker_thread, &args[thread_i]);
+        verify_contract(ret == 0, "Unable to create thread\n");
+    }
+
+    for (uint32_t thread_i = 0U; thread_i < num_threads; ++thread_i)
+    {
+        pthread_join(threads[thread_i], NULL);
+    }
+
+    // Конец измеряемого отрезка времени.
+    uint64_t end = time_now_ns();
+
+    // Промахи кеша на операцию (отрицательное значение - счётчик недоступен).
+    double misses_per_op = -1.0;
+    if (perf_fd != -1)
+    {
+        ioctl(perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+
+        uint64_t misses = 0U;
+        if (read(perf_fd, &misses, sizeof(misses)) == sizeof(misses))
+        {
+            misses_per_op = (double) misses / ((uint64_t) ops_per_thread * num_threads);
+        }
+
+        close(perf_fd);
+    }
+
+    // Собираем измеренные задержки всех потоков в начало массива.
+    uint32_t num_samples = 0U;
+    for (uint32_t thread_i = 0U; thread_i < num_threads; ++thread_i)
+    {
+        memmove(&samples[num_samples], args[thread_i].samples,
+                args[thread_i].num_samples * sizeof(uint32_t));
+        num_samples += args[thread_i].num_samples;
+    }
+
+    qsort(samples, num_samples, sizeof(uint32_t), compare_u32);
+
+    double ops_per_sec = 1e9 * ops_per_thread * num_threads / (end - start);
+    uint32_t p50 = samples[num_samples / 2U];
+    uint32_t p99 = samples[(uint64_t) num_samples * 99U / 100U];
+
+    fprintf(csv, "%u,%s,%u,%u,%.0lf,%u,%u,", size, DIST_NAMES[dist], num_threads, write_percent,
+            ops_per_sec, p50, p99);
+    if (misses_per_op < 0.0)
+    {
+        fprintf(csv, "\n");
+    }
+    else
+    {
+        fprintf(csv, "%.3lf\n", misses_per_op);
+    }
+
+    printf("%12u %13s %8u %8u%% %12.2lf %8u %8u %12.3lf\n", size, DIST_NAMES[dist], num_threads,
+           write_percent, 1e-6 * ops_per_sec, p50, p99, misses_per_op);
+
+    free(samples);
+}
+
+int main(int argc, char** argv)
+{
+    // Максимальный размер базы данных задаётся аргументом командной строки
+    // (make workload MAX_SIZE=100000000 для измерений на 100 млн записей).
+    uint32_t max_size = (argc > 1)? strtoul(argv[1], NULL, 10) : DEFAULT_MAX_SIZE;
+
+    FILE* csv = fopen(CSV_FILENAME, "w");
+    verify_contract(csv != NULL, "Unable to open file \'%s\'\n", CSV_FILENAME);
+
+    fprintf(csv, "size,distribution,threads,write_percent,ops_per_sec,p50_ns,p99_ns,"
+                 "cache_misses_per_op\n");
+
+    printf("Пропускная способность (млн операций/с), задержка (нс) и промахи кеша на операцию\n");
+    printf("(промахи равны -1, если счётчики perf_event_open недоступны):\n");
+    printf("      Размер Распределение   Потоки    Запись     Операции      p50      p99      Промахи\n");
+
+    // Ключи и значения для заполнения базы данных пакетами.
+    DbKey_t* fill_keys = calloc(FILL_BATCH_SIZE, sizeof(DbKey_t));
+    char (*fill_values)[VALUE_SIZE] = calloc(FILL_BATCH_SIZE, VALUE_SIZE);
+    verify_contract(fill_keys != NULL && fill_values != NULL, "Unable to allocate memory\n");
+
+    for (uint32_t size_i = 0U; size_i < NUM_SIZES && DB_SIZES[size_i] <= max_size; ++size_i)
+    {
+        uint32_t size = DB_SIZES[size_i];
+
+        // Заполняем базу данных чётными ключами в порядке возрастания.
+        struct Database db;
+        db_alloc(&db);
+
+        for (uint32_t start = 0U; start < size; start += FILL_BATCH_SIZE)
+        {
+            uint32_t n = (size - start < FILL_BATCH_SIZE)? size - start : FILL_BATCH_SIZE;
+
+            for (uint32_t i = 0U; i < n; ++i)
+            {
+                fill_keys[i] = 2U * (start + i);
+            }
+
+            db_insert_batch(&db, fill_keys, (const char (*)[VALUE_SIZE]) fill_values, n);
+        }
+
+        db_concurrent_enable(&db);
+
+        ZipfParams zipf;
+        zipf_init(&zipf, size);
+
+        for (uint32_t dist = 0U; dist < NUM_DISTS; ++dist)
+        {
+            for (uint32_t count_i = 0U; count_i < NUM_THREAD_COUNTS; ++count_i)
+            {
+                for (uint32_t mix_i = 0U; mix_i < NUM_WRITE_MIXES; ++mix_i)
+                {
+                    run_workload(&db, size, dist, &zipf, THREAD_COUNTS[count_i],
+                                 WRITE_PERCENTS[mix_i], csv);
+                }
+            }
+        }
+
+        db_free(&db);
+    }
+
+    free(fill_keys);
+    free(fill_values);
+
+    fclose(csv);
+
+    printf("Результаты записаны в файл %s\n", CSV_FILENAME);
+
+    return EXIT_SUCCESS;
+}
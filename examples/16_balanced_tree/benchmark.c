@@ -0,0 +1,151 @@
+// Copyright 2024 Vladislav Aleinik
+#include <stdint.h>
+#include <time.h>
+
+typedef uint32_t Key_t;
+typedef uint32_t Value_t;
+
+#ifdef TREE_AVL
+#include "tree-avl.h"
+#define TREE_NAME "АВЛ-дерево"
+#endif // TREE_AVL
+
+#ifdef TREE_RB
+#include "tree-rb.h"
+#define TREE_NAME "Красно-чёрное дерево"
+#endif // TREE_RB
+
+#ifdef TREE_BPLUS
+#include "tree-bplus.h"
+#define TREE_NAME "B+-дерево"
+#endif // TREE_BPLUS
+
+#if defined(TREE_BPLUS)
+#define LAYOUT_NAME "широкие узлы с векторным сравнением ключей"
+#elif defined(TREE_SOA)
+#define LAYOUT_NAME "раздельное хранение узлов"
+#else
+#define LAYOUT_NAME "совместное хранение узлов"
+#endif // TREE_BPLUS
+
+// Количество запросов на поиск для каждого размера дерева.
+#define NUM_SEARCHES 2000000U
+
+// Размеры деревьев для измерений.
+#define NUM_SIZES 4U
+const uint32_t TREE_SIZES[NUM_SIZES] = {1000U, 10000U, 100000U, 1000000U};
+
+//==================================================================================================
+// Функция: time_now
+// Назначение: Возвращает текущее время в секундах.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// отсутствуют.
+//
+// Возвращаемое значение:
+// Время по монотонным часам.
+//==================================================================================================
+double time_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+//==================================================================================================
+// Функция: measure_search
+// Назначение: Измеряет среднее время поиска одного ключа в дереве.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in) - дерево поиска.
+// keys (in) - массив из NUM_SEARCHES ключей для поиска.
+//
+// Возвращаемое значение:
+// Среднее время поиска в наносекундах.
+//==================================================================================================
+double measure_search(Tree* tree, const Key_t* keys)
+{
+    // Контрольная сумма - защита от удаления цикла компилятором.
+    Value_t checksum = 0U;
+
+    double start = time_now();
+
+    for (uint32_t i = 0U; i < NUM_SEARCHES; ++i)
+    {
+        Value_t value = 0U;
+        bool found;
+
+        tree_search(tree, keys[i], &value, &found);
+        checksum += value;
+    }
+
+    double end = time_now();
+
+    verify_contract(checksum != 0U, "Unexpected search results\n");
+
+    return 1e9 * (end - start) / NUM_SEARCHES;
+}
+
+int main(int argc, char** argv)
+{
+    // Максимальный размер дерева можно ограничить аргументом командной строки.
+    uint32_t max_size = (argc > 1)? strtoul(argv[1], NULL, 10) : TREE_SIZES[NUM_SIZES - 1U];
+
+    // Ключи, добавленные в дерево, и ключи для поиска.
+    Key_t* inserted = calloc(max_size, sizeof(Key_t));
+    Key_t* keys     = calloc(NUM_SEARCHES, sizeof(Key_t));
+    verify_contract(inserted != NULL && keys != NULL, "Unable to allocate memory\n");
+
+    // Задаём семя для генератора случайных чисел.
+    srand(100500);
+
+#ifdef TREE_SOA
+    printf("%s, %s (%zu + %zu Б на узел):\n", TREE_NAME, LAYOUT_NAME,
+           sizeof(TreeNode), sizeof(TreeNodeCold));
+#else
+    printf("%s, %s (%zu Б на узел):\n", TREE_NAME, LAYOUT_NAME, sizeof(TreeNode));
+#endif // TREE_SOA
+    printf("      Размер    Поиск, нс    После перенумерации (vEB), нс\n");
+
+    for (uint32_t size_i = 0U; size_i < NUM_SIZES && TREE_SIZES[size_i] <= max_size; ++size_i)
+    {
+        uint32_t size = TREE_SIZES[size_i];
+
+        // Заполняем дерево случайными ключами: порядок узлов в памяти не связан с порядком ключей.
+        Tree tree;
+        RetCode ret = tree_alloc(&tree);
+        verify_contract(ret == RET_OK, "Unable to allocate tree\n");
+
+        while (tree.size < size)
+        {
+            Key_t key = rand();
+
+            inserted[tree.size] = key;
+            ret = tree_set(&tree, key, key | 1U);
+            verify_contract(ret == RET_OK, "Unable to insert tree element\n");
+        }
+
+        // Все ключи для поиска присутствуют в дереве.
+        for (uint32_t i = 0U; i < NUM_SEARCHES; ++i)
+        {
+            keys[i] = inserted[rand() % size];
+        }
+
+        double random_ns = measure_search(&tree, keys);
+
+        ret = tree_relayout(&tree, TREE_LAYOUT_VEB);
+        verify_contract(ret == RET_OK, "Unable to relayout tree\n");
+
+        double veb_ns = measure_search(&tree, keys);
+
+        printf("%12u %12.1lf %32.1lf\n", size, random_ns, veb_ns);
+
+        tree_free(&tree);
+    }
+
+    free(inserted);
+    free(keys);
+
+    return EXIT_SUCCESS;
+}
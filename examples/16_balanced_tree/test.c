@@ -12,9 +12,182 @@ typedef uint32_t Value_t;
 #include "tree-rb.h"
 #endif // TREE_RB
 
+#ifdef TREE_BPLUS
+#include "tree-bplus.h"
+#endif // TREE_BPLUS
+
 #define NUM_INSERTED      20U
 #define NUM_FULL_SEARCHES 10U
 
+// Максимальный размер дерева, построенного из отсортированных ключей.
+#define NUM_BUILT           1000U
+// Размеры деревьев до NUM_BUILT_EXHAUSTIVE проверяются все подряд.
+#define NUM_BUILT_EXHAUSTIVE 64U
+
+// Количество случайных изменений дерева перед перенумерацией узлов.
+#define NUM_CHURNED 4000U
+
+// Шаг нижней границы отрезков при проверке обхода отрезков ключей.
+#define RANGE_STEP 37U
+
+// Тип RangeState - состояние проверки обхода отрезка ключей дерева из чётных ключей.
+typedef struct {
+    // Ожидаемый следующий ключ.
+    Key_t next_key;
+    // Количество полученных пар ключ-значение.
+    size_t count;
+    // Количество вызовов функции обратного вызова.
+    size_t num_calls;
+    // Флаг прерывания обхода после первой пачки.
+    bool stop;
+} RangeState;
+
+//==================================================================================================
+// Функция: range_check_batch
+// Назначение: Проверяет пачку пар ключ-значение, полученную при обходе отрезка ключей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// keys   (in)     - массив ключей пачки.
+// values (in)     - массив значений пачки.
+// count  (in)     - количество пар в пачке.
+// arg    (in/out) - состояние проверки (RangeState).
+//
+// Возвращаемое значение:
+// Флаг продолжения обхода.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Дерево содержит чётные ключи key со значениями 3 * key / 2.
+//==================================================================================================
+bool range_check_batch(const Key_t keys[], const Value_t values[], size_t count, void* arg)
+{
+    RangeState* state = arg;
+
+    verify_contract(count != 0U, "[TREE RANGE] Empty batch\n");
+
+    for (size_t i = 0U; i < count; ++i)
+    {
+        verify_contract(keys[i] == state->next_key && values[i] == 3U * (keys[i] / 2U),
+            "[TREE RANGE] Unexpected element\n");
+
+        state->next_key += 2U;
+    }
+
+    state->count     += count;
+    state->num_calls += 1U;
+
+    return !state->stop;
+}
+
+#ifdef TREE_CONCURRENT
+
+// Количество потоков при проверке режима одновременного доступа.
+#define NUM_THREADS 4U
+// Количество операций каждого потока.
+#define NUM_THREAD_OPS 100000U
+// Каждая WRITE_PERIOD-я операция потока изменяет дерево, остальные - поиск.
+#define WRITE_PERIOD 20U
+// Количество ключей при проверке режима одновременного доступа.
+#define NUM_SHARED 4096U
+
+// Тип WorkerState - состояние потока, обращающегося к дереву в режиме одновременного доступа.
+// Поток изменяет только ключи key, для которых key % NUM_THREADS == thread_i: чётные ключи
+// не удаляются, нечётные ключи вставляются и удаляются.
+typedef struct {
+    // Общее дерево.
+    Tree* tree;
+    // Номер потока.
+    uint32_t thread_i;
+    // Семя генератора случайных чисел потока.
+    unsigned seed;
+    // Ожидаемые значения ключей (0 - ключ отсутствует). Для ключей других потоков не используются.
+    Value_t expected[NUM_SHARED];
+} WorkerState;
+
+//==================================================================================================
+// Функция: worker_run
+// Назначение: Выполняет поиск и изменение общего дерева в режиме одновременного доступа.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// arg (in/out) - состояние потока (WorkerState).
+//
+// Возвращаемое значение:
+// NULL.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Значение ключа key всегда равно key + 1 или key + 2. Ключи текущего потока проверяются
+//   точно, чётные ключи других потоков должны находиться всегда.
+//==================================================================================================
+void* worker_run(void* arg)
+{
+    WorkerState* state = arg;
+
+    for (size_t op_i = 0U; op_i < NUM_THREAD_OPS; ++op_i)
+    {
+        RetCode ret;
+
+        if (op_i % WRITE_PERIOD == 0U)
+        {   // Изменяем случайный ключ текущего потока.
+            Key_t key = (rand_r(&state->seed) % (NUM_SHARED / NUM_THREADS)) * NUM_THREADS +
+                        state->thread_i;
+
+            if (key % 2U == 0U || rand_r(&state->seed) % 2U == 0U)
+            {
+                Value_t value = key + 1U + rand_r(&state->seed) % 2U;
+
+                ret = tree_set_concurrent(state->tree, key, value);
+                verify_contract(ret == RET_OK, "Unable to insert tree element\n");
+
+                state->expected[key] = value;
+            }
+            else
+            {
+                Value_t removed_value = 0U;
+                bool removed;
+
+                ret = tree_remove_concurrent(state->tree, key, &removed_value, &removed);
+                verify_contract(ret == RET_OK, "Unable to remove tree element\n");
+                verify_contract(removed == (state->expected[key] != 0U) &&
+                                (!removed || removed_value == state->expected[key]),
+                    "[TREE CONCURRENT] Unexpected removed element\n");
+
+                state->expected[key] = 0U;
+            }
+
+            continue;
+        }
+
+        Key_t key = rand_r(&state->seed) % NUM_SHARED;
+        Value_t found_value = 0U;
+        bool found;
+
+        ret = tree_search_concurrent(state->tree, key, &found_value, &found);
+        verify_contract(ret == RET_OK, "Unable to search for tree element\n");
+
+        if (key % NUM_THREADS == state->thread_i)
+        {
+            verify_contract(found == (state->expected[key] != 0U) &&
+                            (!found || found_value == state->expected[key]),
+                "[TREE CONCURRENT] Unexpected element of the current thread\n");
+        }
+        else
+        {
+            verify_contract((found || key % 2U != 0U) &&
+                            (!found || found_value == key + 1U || found_value == key + 2U),
+                "[TREE CONCURRENT] Unexpected element of another thread\n");
+        }
+    }
+
+    return NULL;
+}
+
+#endif // TREE_CONCURRENT
+
 int main(void)
 {
     // Код возврата операции.
@@ -102,5 +275,455 @@ int main(void)
     // Освобождаем ресурсы дерева.
     tree_free(&search_db);
 
+    // Отсортированные ключи (чётные числа) и значения для построения дерева.
+    Key_t built_keys[NUM_BUILT];
+    Value_t built_values[NUM_BUILT];
+    for (size_t i = 0U; i < NUM_BUILT; ++i)
+    {
+        built_keys[i]   = 2U * i;
+        built_values[i] = 3U * i;
+    }
+
+    // Строим деревья всех малых размеров и нескольких больших размеров.
+    for (size_t n = 0U; n <= NUM_BUILT; n += (n < NUM_BUILT_EXHAUSTIVE)? 1U : 97U)
+    {
+        Tree built;
+
+        ret = tree_alloc(&built);
+        verify_contract(ret == RET_OK, "Unable to allocate tree\n");
+
+        ret = tree_build_sorted(&built, built_keys, built_values, n);
+        verify_contract(ret == RET_OK, "Unable to build tree\n");
+#ifdef TREE_BPLUS
+        // Массив узлов B+-дерева выделяется по количеству узлов, а не ключей.
+        verify_contract(built.size == n && built.capacity == ((n == 0U)? 1U : built.num_nodes),
+            "[TREE BUILD] Unexpected tree size\n");
+#elif defined(TREE_CHUNKED)
+        // Массив узлов выделяется целыми блоками.
+        verify_contract(built.size == n && built.capacity ==
+                        ((n == 0U)? 1U : (n + TREE_CHUNK_NODES - 1U) / TREE_CHUNK_NODES) *
+                        TREE_CHUNK_NODES,
+            "[TREE BUILD] Unexpected tree size\n");
+#else
+        verify_contract(built.size == n && built.capacity == ((n == 0U)? 1U : n),
+            "[TREE BUILD] Unexpected tree size\n");
+#endif // TREE_BPLUS
+        verify_contract(tree_check(&built),
+            "[TREE BUILD] Tree invariants are violated\n");
+
+        for (size_t i = 0U; i < n; ++i)
+        {
+            Value_t found_value = 0U;
+            bool found;
+
+            ret = tree_search(&built, built_keys[i], &found_value, &found);
+            verify_contract(ret == RET_OK, "Unable to search for tree element\n");
+            verify_contract(found && found_value == built_values[i],
+                "[TREE BUILD] Unable to find an element\n");
+
+            ret = tree_search(&built, built_keys[i] + 1U, &found_value, &found);
+            verify_contract(ret == RET_OK, "Unable to search for tree element\n");
+            verify_contract(!found,
+                "[TREE BUILD] Found spurious element\n");
+        }
+
+        tree_free(&built);
+    }
+
+    // Построенное дерево должно оставаться корректным при последующих изменениях.
+    Tree built;
+
+    ret = tree_alloc(&built);
+    verify_contract(ret == RET_OK, "Unable to allocate tree\n");
+
+    ret = tree_build_sorted(&built, built_keys, built_values, NUM_BUILT);
+    verify_contract(ret == RET_OK, "Unable to build tree\n");
+
+    for (size_t i = 0U; i < NUM_BUILT; ++i)
+    {
+        ret = tree_set(&built, 2U * i + 1U, 0U);
+        verify_contract(ret == RET_OK, "Unable to insert tree element\n");
+    }
+
+    for (size_t i = 0U; i < NUM_BUILT; i += 2U)
+    {
+        Value_t removed_value;
+        bool removed;
+
+        ret = tree_remove(&built, built_keys[i], &removed_value, &removed);
+        verify_contract(ret == RET_OK, "Unable to remove tree element\n");
+        verify_contract(removed && removed_value == built_values[i],
+            "[TREE BUILD] Unable to remove an element\n");
+    }
+
+    verify_contract(built.size == NUM_BUILT + NUM_BUILT / 2U && tree_check(&built),
+        "[TREE BUILD] Tree invariants are violated after modification\n");
+
+    // Неупорядоченные ключи не принимаются, дерево при этом не изменяется.
+    Key_t unsorted_keys[3U] = {1U, 3U, 3U};
+    ret = tree_build_sorted(&built, unsorted_keys, built_values, 3U);
+    verify_contract(ret == RET_INVAL && built.size == NUM_BUILT + NUM_BUILT / 2U,
+        "[TREE BUILD] Accepted unsorted keys\n");
+
+    tree_free(&built);
+
+    // Объединяем дерево чётных ключей и дерево ключей, кратных трём.
+    Tree evens;
+    Tree triples;
+
+    ret = tree_alloc(&evens);
+    verify_contract(ret == RET_OK, "Unable to allocate tree\n");
+    ret = tree_alloc(&triples);
+    verify_contract(ret == RET_OK, "Unable to allocate tree\n");
+
+    ret = tree_build_sorted(&evens, built_keys, built_values, NUM_BUILT);
+    verify_contract(ret == RET_OK, "Unable to build tree\n");
+
+    for (size_t i = 0U; i < NUM_BUILT; ++i)
+    {
+        ret = tree_set(&triples, 3U * i, 3U * i + 1U);
+        verify_contract(ret == RET_OK, "Unable to insert tree element\n");
+    }
+
+    ret = tree_merge(&evens, &triples);
+    verify_contract(ret == RET_OK, "Unable to merge trees\n");
+    verify_contract(tree_check(&evens) && triples.size == NUM_BUILT,
+        "[TREE MERGE] Tree invariants are violated\n");
+
+    // Количество элементов объединения.
+    size_t num_merged = 0U;
+    for (Key_t key = 0U; key < 3U * NUM_BUILT; ++key)
+    {
+        Value_t found_value = 0U;
+        bool found;
+
+        ret = tree_search(&evens, key, &found_value, &found);
+        verify_contract(ret == RET_OK, "Unable to search for tree element\n");
+
+        // Для совпадающих ключей сохраняется значение из второго дерева.
+        bool expected = (key % 3U == 0U) || (key % 2U == 0U && key < 2U * NUM_BUILT);
+        Value_t expected_value = (key % 3U == 0U)? key + 1U : 3U * (key / 2U);
+
+        verify_contract(found == expected && (!found || found_value == expected_value),
+            "[TREE MERGE] Unexpected element\n");
+
+        num_merged += found;
+    }
+
+    verify_contract(evens.size == num_merged,
+        "[TREE MERGE] Unexpected tree size\n");
+
+    tree_free(&evens);
+    tree_free(&triples);
+
+    // Обходим отрезки ключей дерева из чётных ключей.
+    Tree ranged;
+
+    ret = tree_alloc(&ranged);
+    verify_contract(ret == RET_OK, "Unable to allocate tree\n");
+
+    ret = tree_build_sorted(&ranged, built_keys, built_values, NUM_BUILT);
+    verify_contract(ret == RET_OK, "Unable to build tree\n");
+
+    Key_t spans[4U] = {0U, 1U, 150U, 3U * NUM_BUILT};
+    for (Key_t lo = 0U; lo < 2U * NUM_BUILT + RANGE_STEP; lo += RANGE_STEP)
+    {
+        for (size_t span_i = 0U; span_i < 4U; ++span_i)
+        {
+            Key_t hi = lo + spans[span_i];
+
+            // Чётные ключи отрезка [lo, hi], присутствующие в дереве.
+            Key_t first = (lo + 1U) / 2U * 2U;
+            Key_t last  = (hi < 2U * NUM_BUILT - 2U)? hi : 2U * NUM_BUILT - 2U;
+            size_t expected = (first > last)? 0U : (last - first) / 2U + 1U;
+
+            RangeState state = {first, 0U, 0U, false};
+
+            ret = tree_range_for_each(&ranged, lo, hi, range_check_batch, &state);
+            verify_contract(ret == RET_OK, "Unable to iterate over tree range\n");
+            verify_contract(state.count == expected,
+                "[TREE RANGE] Unexpected number of elements\n");
+
+            // Прерывание обхода функцией обратного вызова.
+            state = (RangeState) {first, 0U, 0U, true};
+
+            ret = tree_range_for_each(&ranged, lo, hi, range_check_batch, &state);
+            verify_contract(ret == RET_OK, "Unable to iterate over tree range\n");
+            verify_contract(state.num_calls == ((expected == 0U)? 0U : 1U),
+                "[TREE RANGE] Iteration has not stopped\n");
+        }
+    }
+
+    // Пустой отрезок с нижней границей больше верхней.
+    RangeState empty_state = {0U, 0U, 0U, false};
+
+    ret = tree_range_for_each(&ranged, 10U, 5U, range_check_batch, &empty_state);
+    verify_contract(ret == RET_OK && empty_state.count == 0U,
+        "[TREE RANGE] Unexpected elements in empty range\n");
+
+#ifndef TREE_BPLUS
+    // Проверяем курсоры: нижняя граница для существующих и отсутствующих ключей.
+    for (size_t i = 0U; i < NUM_BUILT; ++i)
+    {
+        Node_t exact_id = tree_lower_bound(&ranged, 2U * i);
+        Node_t above_id = tree_lower_bound(&ranged, 2U * i + 1U);
+
+        verify_contract(exact_id != NULL_NODE && tree_get(&ranged, exact_id)->key == 2U * i,
+            "[TREE CURSOR] Unexpected lower bound\n");
+        verify_contract((i + 1U == NUM_BUILT)? (above_id == NULL_NODE) :
+                        (above_id != NULL_NODE && tree_get(&ranged, above_id)->key == 2U * i + 2U),
+            "[TREE CURSOR] Unexpected lower bound\n");
+    }
+
+    // Обход в порядке возрастания ключей.
+    size_t num_visited = 0U;
+    for (Node_t cur_id = tree_next(&ranged, NULL_NODE); cur_id != NULL_NODE;
+         cur_id = tree_next(&ranged, cur_id))
+    {
+        verify_contract(tree_get(&ranged, cur_id)->key == built_keys[num_visited] &&
+                        tree_cold(&ranged, cur_id)->value == built_values[num_visited],
+            "[TREE CURSOR] Unexpected element\n");
+
+        num_visited += 1U;
+    }
+
+    verify_contract(num_visited == NUM_BUILT, "[TREE CURSOR] Unexpected number of elements\n");
+
+    // Обход в порядке убывания ключей.
+    for (Node_t cur_id = tree_prev(&ranged, NULL_NODE); cur_id != NULL_NODE;
+         cur_id = tree_prev(&ranged, cur_id))
+    {
+        num_visited -= 1U;
+
+        verify_contract(tree_get(&ranged, cur_id)->key == built_keys[num_visited],
+            "[TREE CURSOR] Unexpected element\n");
+    }
+
+    verify_contract(num_visited == 0U, "[TREE CURSOR] Unexpected number of elements\n");
+#endif // TREE_BPLUS
+
+    tree_free(&ranged);
+
+    // Перемешиваем узлы в памяти случайными вставками и удалениями.
+    Tree churned;
+
+    ret = tree_alloc(&churned);
+    verify_contract(ret == RET_OK, "Unable to allocate tree\n");
+
+    for (size_t i = 0U; i < NUM_CHURNED; ++i)
+    {
+        Value_t removed_value;
+        bool removed;
+
+        ret = tree_set(&churned, rand() % NUM_CHURNED, i);
+        verify_contract(ret == RET_OK, "Unable to insert tree element\n");
+
+        ret = tree_remove(&churned, rand() % NUM_CHURNED, &removed_value, &removed);
+        verify_contract(ret == RET_OK, "Unable to remove tree element\n");
+    }
+
+    // Содержимое дерева до перенумерации.
+    Key_t churned_keys[NUM_CHURNED];
+    Value_t churned_values[NUM_CHURNED];
+    size_t num_churned = churned.size;
+
+    ret = tree_flatten(&churned, churned_keys, churned_values);
+    verify_contract(ret == RET_OK, "Unable to flatten tree\n");
+
+    double churned_fragmentation = tree_fragmentation(&churned);
+
+    TreeLayout layouts[2U] = {TREE_LAYOUT_BFS, TREE_LAYOUT_VEB};
+    for (size_t layout_i = 0U; layout_i < 2U; ++layout_i)
+    {
+        ret = tree_relayout(&churned, layouts[layout_i]);
+        verify_contract(ret == RET_OK, "Unable to relayout tree\n");
+        verify_contract(tree_check(&churned) && churned.size == num_churned,
+            "[TREE RELAYOUT] Tree invariants are violated\n");
+
+        // Корень дерева размещается в начале массива при любом порядке.
+        verify_contract(churned.root_id == 0U,
+            "[TREE RELAYOUT] Root node is not the first node\n");
+
+        for (size_t i = 0U; i < num_churned; ++i)
+        {
+            Value_t found_value = 0U;
+            bool found;
+
+            ret = tree_search(&churned, churned_keys[i], &found_value, &found);
+            verify_contract(ret == RET_OK, "Unable to search for tree element\n");
+            verify_contract(found && found_value == churned_values[i],
+                "[TREE RELAYOUT] Unable to find an element\n");
+        }
+    }
+
+    verify_contract(tree_fragmentation(&churned) < churned_fragmentation,
+        "[TREE RELAYOUT] Fragmentation has not decreased\n");
+
+#ifdef TREE_ORDER_STATISTICS
+    // Проверяем порядковые статистики по содержимому дерева после перенумерации.
+    for (size_t i = 0U; i < num_churned; ++i)
+    {
+        Node_t selected_id = tree_select(&churned, i);
+
+        verify_contract(selected_id != NULL_NODE &&
+                        tree_get(&churned, selected_id)->key == churned_keys[i],
+            "[TREE SELECT] Unexpected element\n");
+        verify_contract(tree_rank(&churned, churned_keys[i]) == i,
+            "[TREE RANK] Unexpected rank\n");
+    }
+
+    verify_contract(tree_select(&churned, num_churned) == NULL_NODE,
+        "[TREE SELECT] Found spurious element\n");
+
+    // Ранг отсутствующего ключа равен количеству меньших ключей.
+    size_t num_less = 0U;
+    for (Key_t key = 0U; key <= NUM_CHURNED; ++key)
+    {
+        verify_contract(tree_rank(&churned, key) == num_less,
+            "[TREE RANK] Unexpected rank\n");
+
+        num_less += (num_less < num_churned && churned_keys[num_less] == key);
+    }
+#endif // TREE_ORDER_STATISTICS
+
+#ifndef TREE_BPLUS
+    // Удаление и вставка не изменяют идентификаторы остальных узлов.
+    Node_t churned_ids[NUM_CHURNED];
+    for (size_t i = 0U; i < num_churned; ++i)
+    {
+        churned_ids[i] = tree_lower_bound(&churned, churned_keys[i]);
+    }
+
+    size_t num_slots = churned.num_slots;
+    for (size_t round = 0U; round < 2U; ++round)
+    {
+        for (size_t i = 0U; i < num_churned; i += 2U)
+        {
+            Value_t removed_value;
+            bool removed;
+
+            ret = tree_remove(&churned, churned_keys[i], &removed_value, &removed);
+            verify_contract(ret == RET_OK, "Unable to remove tree element\n");
+            verify_contract(removed && removed_value == churned_values[i],
+                "[TREE STABLE IDS] Unable to remove an element\n");
+        }
+
+        for (size_t i = 1U; i < num_churned; i += 2U)
+        {
+            verify_contract(tree_lower_bound(&churned, churned_keys[i]) == churned_ids[i],
+                "[TREE STABLE IDS] Node identifier has changed\n");
+        }
+
+        if (round == 1U)
+        {
+            break;
+        }
+
+        // Вставленные узлы занимают места удалённых.
+        for (size_t i = 0U; i < num_churned; i += 2U)
+        {
+            ret = tree_set(&churned, churned_keys[i], churned_values[i]);
+            verify_contract(ret == RET_OK, "Unable to insert tree element\n");
+        }
+
+        verify_contract(tree_check(&churned) && churned.num_slots == num_slots,
+            "[TREE STABLE IDS] Freed nodes are not reused\n");
+    }
+
+    // Восстанавливаем плотную нумерацию узлов.
+    ret = tree_compact(&churned);
+    verify_contract(ret == RET_OK, "Unable to compact tree\n");
+    verify_contract(tree_check(&churned) && churned.num_slots == num_churned / 2U,
+        "[TREE COMPACT] Tree invariants are violated\n");
+
+    for (size_t i = 1U; i < num_churned; i += 2U)
+    {
+        Node_t found_id = tree_lower_bound(&churned, churned_keys[i]);
+
+        verify_contract(found_id < churned.size &&
+                        tree_cold(&churned, found_id)->value == churned_values[i],
+            "[TREE COMPACT] Unexpected element\n");
+    }
+#endif // TREE_BPLUS
+
+    tree_free(&churned);
+
+#ifdef TREE_CONCURRENT
+    // Потоки одновременно ищут и изменяют общее дерево из чётных ключей.
+    Tree shared;
+
+    ret = tree_alloc(&shared);
+    verify_contract(ret == RET_OK, "Unable to allocate tree\n");
+
+    for (Key_t key = 0U; key < NUM_SHARED; key += 2U)
+    {
+        ret = tree_set(&shared, key, key + 1U);
+        verify_contract(ret == RET_OK, "Unable to insert tree element\n");
+    }
+
+    ret = tree_concurrent_enable(&shared);
+    verify_contract(ret == RET_OK, "Unable to enable concurrent access mode\n");
+
+    static WorkerState workers[NUM_THREADS];
+    pthread_t threads[NUM_THREADS];
+
+    for (uint32_t thread_i = 0U; thread_i < NUM_THREADS; ++thread_i)
+    {
+        WorkerState* state = &workers[thread_i];
+
+        state->tree     = &shared;
+        state->thread_i = thread_i;
+        state->seed     = 100500U + thread_i;
+
+        for (Key_t key = 0U; key < NUM_SHARED; ++key)
+        {
+            state->expected[key] = (key % 2U == 0U)? key + 1U : 0U;
+        }
+
+        int err = pthread_create(&threads[thread_i], NULL, worker_run, state);
+        verify_contract(err == 0, "Unable to create thread\n");
+    }
+
+    for (uint32_t thread_i = 0U; thread_i < NUM_THREADS; ++thread_i)
+    {
+        int err = pthread_join(threads[thread_i], NULL);
+        verify_contract(err == 0, "Unable to join thread\n");
+    }
+
+    ret = tree_concurrent_disable(&shared);
+    verify_contract(ret == RET_OK, "Unable to disable concurrent access mode\n");
+
+    ret = tree_compact(&shared);
+    verify_contract(ret == RET_OK, "Unable to compact tree\n");
+
+    // После уплотнения узлы нумеруются плотно, дерево содержит ожидаемые элементы.
+    size_t num_shared = 0U;
+    for (Key_t key = 0U; key < NUM_SHARED; ++key)
+    {
+        Value_t expected = workers[key % NUM_THREADS].expected[key];
+        Value_t found_value = 0U;
+        bool found;
+
+        ret = tree_search(&shared, key, &found_value, &found);
+        verify_contract(ret == RET_OK, "Unable to search for tree element\n");
+        verify_contract(found == (expected != 0U) && (!found || found_value == expected),
+            "[TREE CONCURRENT] Unexpected element\n");
+
+        num_shared += found;
+    }
+
+    verify_contract(shared.size == num_shared && tree_check(&shared),
+        "[TREE CONCURRENT] Tree invariants are violated\n");
+
+    for (Node_t cur_id = tree_next(&shared, NULL_NODE); cur_id != NULL_NODE;
+         cur_id = tree_next(&shared, cur_id))
+    {
+        verify_contract(cur_id < shared.size,
+            "[TREE CONCURRENT] Node numbering is not dense\n");
+    }
+
+    tree_free(&shared);
+#endif // TREE_CONCURRENT
+
     return EXIT_SUCCESS;
 }
@@ -9,6 +9,36 @@
 
 #include "utils.h"
 
+// Макроопределение TREE_VISUALIZE включает пошаговую печать дерева при балансировке
+// (с задержкой в одну секунду после каждого шага).
+
+// Макроопределение TREE_CONCURRENT добавляет режим одновременного доступа
+// (см. tree_concurrent_enable): читатели спускаются по дереву без блокировок, проверяя версии
+// пройденных узлов, а писатели изменяют версии только перевязываемых узлов.
+
+#ifdef TREE_CONCURRENT
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#ifdef TREE_SOA
+#error "TREE_CONCURRENT is incompatible with TREE_SOA"
+#endif // TREE_SOA
+
+#ifdef TREE_CHUNKED
+#error "TREE_CONCURRENT is incompatible with TREE_CHUNKED"
+#endif // TREE_CHUNKED
+#endif // TREE_CONCURRENT
+
+// Макроопределение TREE_STORE - запись поля, читаемого поиском без блокировок (ключа,
+// значения и дочерних узлов узла, идентификатора корня). В режиме одновременного доступа
+// запись атомарна без упорядочивания: порядок записей задаётся версиями узлов.
+#ifdef TREE_CONCURRENT
+#define TREE_STORE(FIELD, VALUE) __atomic_store_n(&(FIELD), (VALUE), __ATOMIC_RELAXED)
+#else
+#define TREE_STORE(FIELD, VALUE) ((FIELD) = (VALUE))
+#endif // TREE_CONCURRENT
+
 //==================//
 // Структура данных //
 //==================//
@@ -19,6 +49,22 @@ typedef uint32_t Node_t;
 // Макроопределение NULL_NODE - идентификатор узла-пустышки
 #define NULL_NODE ((Node_t) 0xFFFFFFFFU)
 
+// Макроопределение FREE_NODE - правый дочерний узел свободного узла массива
+// (см. tree_slot_release)
+#define FREE_NODE ((Node_t) 0xFFFFFFFEU)
+
+// Макроопределение TREE_SOA включает раздельное хранение узлов (structure of arrays):
+// поля, используемые при спуске по дереву (ключ и дочерние узлы), хранятся в массиве nodes,
+// а остальные поля (родительский узел, значение и высота) - в массиве cold.
+
+// Макроопределение TREE_CHUNKED включает хранение узлов блоками по TREE_CHUNK_NODES узлов:
+// при росте дерева выделяется новый блок, а ранее выделенные узлы не копируются.
+
+// Макроопределение TREE_ORDER_STATISTICS добавляет в узел размер поддерева: k-й по возрастанию
+// ключ (tree_select) и количество меньших ключей (tree_rank) находятся за O(log n).
+
+#ifndef TREE_SOA
+
 // Тип TreeNode - узел дерева
 typedef struct {
     // Идентификатор родительского узла.
@@ -38,22 +84,186 @@ typedef struct {
 
     // Высота поддерева, имеющего данный узел как корневой.
     int32_t height;
+
+#ifdef TREE_ORDER_STATISTICS
+    // Количество узлов поддерева, имеющего данный узел как корневой.
+    uint32_t subtree_size;
+#endif // TREE_ORDER_STATISTICS
+
+#ifdef TREE_CONCURRENT
+    // Версия узла: нечётна, пока писатель изменяет дочерние узлы или значение узла.
+    uint32_t version;
+#endif // TREE_CONCURRENT
+} TreeNode;
+
+// Тип TreeNodeCold - поля узла, не используемые при спуске по дереву.
+// При совместном хранении совпадает с узлом дерева.
+typedef TreeNode TreeNodeCold;
+
+#else // TREE_SOA
+
+// Тип TreeNode - поля узла дерева, используемые при спуске по дереву.
+typedef struct {
+    // Ключ узла дерева.
+    Key_t key;
+
+    // Идентификатор левого дочернего узла.
+    // В случае отсутствия левого дочернего узла равен NULL_NODE.
+    Node_t left_id;
+    // Идентификатор правого дочернего узла.
+    // В случае отсутствия правого дочернего узла равен NULL_NODE.
+    Node_t right_id;
+
+#ifdef TREE_ORDER_STATISTICS
+    // Количество узлов поддерева, имеющего данный узел как корневой.
+    uint32_t subtree_size;
+#endif // TREE_ORDER_STATISTICS
 } TreeNode;
 
+// Тип TreeNodeCold - поля узла, не используемые при спуске по дереву.
+typedef struct {
+    // Идентификатор родительского узла.
+    // Для корневой вершины равен NULL_NODE.
+    Node_t parent_id;
+
+    // Значение узла дерева.
+    Value_t value;
+
+    // Высота поддерева, имеющего данный узел как корневой.
+    int32_t height;
+} TreeNodeCold;
+
+#endif // TREE_SOA
+
+#ifdef TREE_CHUNKED
+
+// Количество узлов в блоке массива узлов.
+#define TREE_CHUNK_NODES 1024U
+
+// Тип TreeChunk - блок узлов дерева.
+typedef struct {
+    // Узлы дерева с идентификаторами от i * TREE_CHUNK_NODES до (i + 1) * TREE_CHUNK_NODES - 1,
+    // где i - номер блока.
+    TreeNode nodes[TREE_CHUNK_NODES];
+#ifdef TREE_SOA
+    // Холодные поля узлов блока.
+    TreeNodeCold cold[TREE_CHUNK_NODES];
+#endif // TREE_SOA
+} TreeChunk;
+
+#endif // TREE_CHUNKED
+
+#ifdef TREE_CONCURRENT
+
+// Количество счётчиков активных читателей. Потоки-читатели распределяются по счётчикам,
+// чтобы поиск в разных потоках не изменял одну и ту же кеш-линию.
+#define TREE_READER_STRIPES 16U
+
+// Тип TreeReaderStripe - счётчики активных читателей, начавших поиск в эпоху чётной
+// и нечётной версии.
+typedef struct {
+    uint64_t active[2U];
+} __attribute__((aligned(64U))) TreeReaderStripe;
+
+// Тип TreeRetired - узел или массив узлов, исключённый писателем из дерева.
+typedef struct {
+    // Эпоха, в которую объект исключён из дерева.
+    uint64_t epoch;
+    // Идентификатор исключённого узла (NULL_NODE для массива узлов).
+    Node_t node_id;
+    // Заменённый массив узлов (NULL для узла).
+    TreeNode* nodes;
+} TreeRetired;
+
+// Тип TreeSync - состояние режима одновременного доступа.
+typedef struct {
+    // Счётчики активных читателей.
+    TreeReaderStripe readers[TREE_READER_STRIPES];
+    // Текущая эпоха. Активные читатели начали поиск в эпоху epoch или epoch - 1.
+    uint64_t epoch;
+
+    // Версия корня дерева: нечётна, пока писатель изменяет идентификатор корневого узла.
+    uint32_t root_version;
+    // Счётчик перемещений узлов: нечётен, пока узел с минимальным ключом правого поддерева
+    // переносится на место удаляемого узла (см. tree_remove).
+    uint32_t move_seq;
+
+    // Блокировка, упорядочивающая писателей.
+    pthread_mutex_t write_lock;
+    // Флаг выполнения операции писателем.
+    bool writing;
+
+    // Исключённые из дерева объекты в порядке возрастания эпох.
+    TreeRetired* retired;
+    size_t num_retired;
+    size_t retired_capacity;
+} TreeSync;
+
+// Номер счётчика активных читателей текущего потока (TREE_READER_STRIPES до первого поиска).
+__thread uint32_t tree_reader_stripe = TREE_READER_STRIPES;
+// Количество потоков, выполнявших поиск в режиме одновременного доступа.
+uint32_t tree_num_reader_threads = 0U;
+
+#endif // TREE_CONCURRENT
+
 // Тип Tree - двоичное дерево поиска.
 typedef struct {
+#ifdef TREE_CHUNKED
+    // Динамический массив указателей на блоки узлов дерева.
+    // Узел дерева с идентификатором id находится в блоке id / TREE_CHUNK_NODES.
+    TreeChunk** chunks;
+#else
     // Динамический массив узлов дерева.
     // Идентификатор узла дерева равен индексу этого узла в массиве nodes.
     TreeNode* nodes;
+#ifdef TREE_SOA
+    // Динамический массив холодных полей узлов дерева (того же размера, что и nodes).
+    TreeNodeCold* cold;
+#endif // TREE_SOA
+#endif // TREE_CHUNKED
     // Счётчик узлов двоичного дерева.
     size_t size;
     // Размер массива nodes.
     size_t capacity;
 
+    // Количество использованных элементов массива nodes, включая свободные узлы.
+    size_t num_slots;
+    // Первый узел списка свободных узлов или NULL_NODE.
+    // Следующий свободный узел хранится в поле left_id.
+    Node_t free_id;
+
     // Корневой узел двоичного дерева.
     Node_t root_id;
+
+#ifdef TREE_CONCURRENT
+    // Состояние режима одновременного доступа или NULL вне этого режима.
+    TreeSync* sync;
+#endif // TREE_CONCURRENT
 } Tree;
 
+// Тип TreeLayout - порядок размещения узлов в массиве nodes (см. tree_relayout).
+typedef enum
+{
+    // Порядок обхода в ширину: узлы верхних уровней дерева размещаются в начале массива.
+    TREE_LAYOUT_BFS = 0,
+    // Порядок ван Эмде Боаса: верхняя половина уровней поддерева и каждое из нижних поддеревьев
+    // рекурсивно размещаются в смежных участках массива.
+    TREE_LAYOUT_VEB = 1
+} TreeLayout;
+
+// Размер кеш-линии, по которому оценивается фрагментация дерева.
+#define TREE_CACHE_LINE_SIZE 64U
+
+// Количество пар ключ-значение, передаваемых за один вызов функции обратного вызова
+// (см. tree_range_for_each).
+#define TREE_RANGE_BATCH 64U
+
+// Тип TreeRangeCallback - функция обратного вызова для пачки пар ключ-значение.
+// Получает массивы из count ключей и значений в порядке возрастания ключей и пользовательский
+// аргумент arg. Возвращает false, чтобы прекратить обход.
+typedef bool (*TreeRangeCallback)(const Key_t keys[], const Value_t values[], size_t count,
+                                  void* arg);
+
 //======================//
 // Управление ресурсами //
 //======================//
@@ -87,6 +297,31 @@ RetCode tree_alloc(Tree* tree)
     tree->capacity = 1U;
     tree->root_id  = NULL_NODE;
 
+    tree->num_slots = 0U;
+    tree->free_id   = NULL_NODE;
+#ifdef TREE_CONCURRENT
+    tree->sync      = NULL;
+#endif // TREE_CONCURRENT
+
+#ifdef TREE_CHUNKED
+    // Выделяем память для одного блока узлов дерева.
+    tree->capacity = TREE_CHUNK_NODES;
+
+    tree->chunks = calloc(1U, sizeof(TreeChunk*));
+    if (tree->chunks == NULL)
+    {
+        return RET_NOMEM;
+    }
+
+    tree->chunks[0U] = calloc(1U, sizeof(TreeChunk));
+    if (tree->chunks[0U] == NULL)
+    {
+        free(tree->chunks);
+        tree->chunks = NULL;
+
+        return RET_NOMEM;
+    }
+#else
     // Выделяем память для массива узлов дерева
     tree->nodes = calloc(tree->capacity, sizeof(TreeNode));
     if (tree->nodes == NULL)
@@ -94,9 +329,96 @@ RetCode tree_alloc(Tree* tree)
         return RET_NOMEM;
     }
 
+#ifdef TREE_SOA
+    // Выделяем память для массива холодных полей узлов.
+    tree->cold = calloc(tree->capacity, sizeof(TreeNodeCold));
+    if (tree->cold == NULL)
+    {
+        free(tree->nodes);
+        tree->nodes = NULL;
+
+        return RET_NOMEM;
+    }
+#endif // TREE_SOA
+#endif // TREE_CHUNKED
+
     return RET_OK;
 }
 
+#ifdef TREE_CONCURRENT
+
+//==================================================================================================
+// Функция: tree_sync_release
+// Назначение: Освобождает состояние режима одновременного доступа.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in/out) - бинарное дерево поиска.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Вызывается, когда ни один поток не обращается к дереву. Заменённые массивы узлов
+//   освобождаются, исключённые узлы остаются в массиве nodes (см. tree_concurrent_disable).
+//==================================================================================================
+void tree_sync_release(Tree* tree)
+{
+    TreeSync* sync = tree->sync;
+    if (sync == NULL)
+    {
+        return;
+    }
+
+    for (size_t i = 0U; i < sync->num_retired; ++i)
+    {
+        free(sync->retired[i].nodes);
+    }
+
+    free(sync->retired);
+
+    int ret = pthread_mutex_destroy(&sync->write_lock);
+    verify_contract(ret == 0,
+        "tree_sync_release: unable to destroy mutex\n");
+
+    free(sync);
+    tree->sync = NULL;
+}
+
+//==================================================================================================
+// Функция: tree_retire
+// Назначение: Откладывает освобождение узла или массива узлов до завершения читателей,
+// которые могли застать его в дереве.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in/out) - бинарное дерево поиска в режиме одновременного доступа.
+// node_id (in)     - идентификатор исключённого узла или NULL_NODE.
+// nodes   (in)     - заменённый массив узлов или NULL.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Место в списке исключённых объектов резервируется функцией tree_write_begin.
+//==================================================================================================
+void tree_retire(Tree* tree, Node_t node_id, TreeNode* nodes)
+{
+    TreeSync* sync = tree->sync;
+
+    verify_contract(sync->num_retired < sync->retired_capacity,
+        "tree_retire: retired list is full\n");
+
+    sync->retired[sync->num_retired] = (TreeRetired) {sync->epoch, node_id, nodes};
+    sync->num_retired += 1U;
+}
+
+#endif // TREE_CONCURRENT
+
 //==================================================================================================
 // Функция: tree_free
 // Назначение: Освобождает ресурсы дерева
@@ -116,16 +438,163 @@ RetCode tree_alloc(Tree* tree)
 //==================================================================================================
 RetCode tree_free(Tree* tree)
 {
+#ifdef TREE_CHUNKED
+    if (tree == NULL || tree->chunks == NULL)
+#else
     if (tree == NULL || tree->nodes == NULL)
+#endif // TREE_CHUNKED
     {
         return RET_INVAL;
     }
 
+#ifdef TREE_CONCURRENT
+    // Освобождаем состояние режима одновременного доступа.
+    tree_sync_release(tree);
+#endif // TREE_CONCURRENT
+
     // Освобождаем ранее выделенную динамическую память.
+#ifdef TREE_CHUNKED
+    for (size_t chunk_i = 0U; chunk_i < tree->capacity / TREE_CHUNK_NODES; ++chunk_i)
+    {
+        free(tree->chunks[chunk_i]);
+    }
+
+    free(tree->chunks);
+#else
     free(tree->nodes);
+#ifdef TREE_SOA
+    free(tree->cold);
+#endif // TREE_SOA
+#endif // TREE_CHUNKED
 
     // Производим защиту от повторного освобождения памяти.
+#ifdef TREE_CHUNKED
+    tree->chunks = NULL;
+#else
     tree->nodes = NULL;
+#endif // TREE_CHUNKED
+
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_resize_nodes
+// Назначение: Изменяет размер массива узлов дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree         (in/out) - бинарное дерево поиска.
+// new_capacity (in)     - новый размер массива узлов (не меньше tree->size и не равен нулю).
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - При раздельном хранении узлов (TREE_SOA) перевыделяются оба массива.
+// - При хранении узлов блоками (TREE_CHUNKED) размер массива округляется вверх до целого числа
+//   блоков. Выделяются или освобождаются только блоки в конце массива, остальные узлы
+//   не копируются.
+// - В режиме одновременного доступа узлы копируются в новый массив, а прежний массив
+//   освобождается после завершения читателей, которые могут к нему обращаться.
+// - В случае нехватки памяти возвращается RET_NOMEM, узлы дерева не изменяются.
+//==================================================================================================
+RetCode tree_resize_nodes(Tree* tree, size_t new_capacity)
+{
+#ifdef TREE_CONCURRENT
+    if (tree->sync != NULL)
+    {
+        TreeNode* copied_nodes = calloc(new_capacity, sizeof(TreeNode));
+        if (copied_nodes == NULL)
+        {
+            return RET_NOMEM;
+        }
+
+        memcpy(copied_nodes, tree->nodes, tree->num_slots * sizeof(TreeNode));
+
+        // Публикуем новый массив после копирования узлов.
+        tree_retire(tree, NULL_NODE, tree->nodes);
+        __atomic_store_n(&tree->nodes, copied_nodes, __ATOMIC_RELEASE);
+
+        tree->capacity = new_capacity;
+
+        return RET_OK;
+    }
+#endif // TREE_CONCURRENT
+
+#ifdef TREE_CHUNKED
+    // Количество блоков до и после изменения размера.
+    size_t num_chunks     = tree->capacity / TREE_CHUNK_NODES;
+    size_t new_num_chunks = (new_capacity + TREE_CHUNK_NODES - 1U) / TREE_CHUNK_NODES;
+
+    if (new_num_chunks > num_chunks)
+    {   // Перевыделяем массив указателей на блоки: узлы остаются на своих местах.
+        TreeChunk** new_chunks = realloc(tree->chunks, new_num_chunks * sizeof(TreeChunk*));
+        if (new_chunks == NULL)
+        {
+            return RET_NOMEM;
+        }
+
+        tree->chunks = new_chunks;
+
+        for (size_t chunk_i = num_chunks; chunk_i < new_num_chunks; ++chunk_i)
+        {
+            tree->chunks[chunk_i] = calloc(1U, sizeof(TreeChunk));
+            if (tree->chunks[chunk_i] == NULL)
+            {   // Размер массива ограничивается уже выделенными блоками.
+                tree->capacity = chunk_i * TREE_CHUNK_NODES;
+
+                return RET_NOMEM;
+            }
+        }
+    }
+    else
+    {   // Освобождаем блоки в конце массива.
+        for (size_t chunk_i = new_num_chunks; chunk_i < num_chunks; ++chunk_i)
+        {
+            free(tree->chunks[chunk_i]);
+        }
+
+        // При неудаче остаётся массив указателей большего размера.
+        TreeChunk** new_chunks = realloc(tree->chunks, new_num_chunks * sizeof(TreeChunk*));
+        if (new_chunks != NULL)
+        {
+            tree->chunks = new_chunks;
+        }
+    }
+
+    // Обновляем размер массива узлов.
+    tree->capacity = new_num_chunks * TREE_CHUNK_NODES;
+#else
+    // Перевыделяем массив узлов дерева.
+    TreeNode* new_nodes = realloc(tree->nodes, new_capacity * sizeof(TreeNode));
+    if (new_nodes == NULL)
+    {
+        return RET_NOMEM;
+    }
+
+    tree->nodes = new_nodes;
+
+#ifdef TREE_SOA
+    // Перевыделяем массив холодных полей узлов.
+    TreeNodeCold* new_cold = realloc(tree->cold, new_capacity * sizeof(TreeNodeCold));
+    if (new_cold == NULL)
+    {   // Массив nodes уже перевыделен: ёмкость ограничивается меньшим из двух массивов.
+        if (new_capacity < tree->capacity)
+        {
+            tree->capacity = new_capacity;
+        }
+
+        return RET_NOMEM;
+    }
+
+    tree->cold = new_cold;
+#endif // TREE_SOA
+
+    // Обновляем размер массива узлов.
+    tree->capacity = new_capacity;
+#endif // TREE_CHUNKED
 
     return RET_OK;
 }
@@ -150,11 +619,46 @@ RetCode tree_free(Tree* tree)
 //
 // Примечания:
 // - Идентификатор node_id - индекс, не выходящий за границы массива tree->nodes.
+// - При хранении узлов блоками (TREE_CHUNKED) узел находится по номеру блока и индексу
+//   в блоке.
 //==================================================================================================
 TreeNode* tree_get(Tree* tree, Node_t node_id)
 {
+#ifdef TREE_CHUNKED
+    return &tree->chunks[node_id / TREE_CHUNK_NODES]->nodes[node_id % TREE_CHUNK_NODES];
+#else
     // Возвращаем узел в массиве по индексу, равному идентификатору узла.
     return &tree->nodes[node_id];
+#endif // TREE_CHUNKED
+}
+
+//==================================================================================================
+// Функция: tree_cold
+// Назначение: Возвращает холодные поля узла дерева (родительский узел, значение и высоту)
+// по идентификатору узла дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in) - бинарное дерево поиска.
+// node_id (in) - валидный идентификатор узла дерева.
+//
+// Возвращаемое значение:
+// Указатель на холодные поля узла дерева.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - При совместном хранении узлов совпадает с tree_get.
+//==================================================================================================
+TreeNodeCold* tree_cold(Tree* tree, Node_t node_id)
+{
+#if defined(TREE_SOA) && defined(TREE_CHUNKED)
+    return &tree->chunks[node_id / TREE_CHUNK_NODES]->cold[node_id % TREE_CHUNK_NODES];
+#elif defined(TREE_SOA)
+    return &tree->cold[node_id];
+#else
+    return tree_get(tree, node_id);
+#endif // TREE_SOA
 }
 
 //==================================================================================================
@@ -181,7 +685,7 @@ int32_t tree_height(Tree* tree, Node_t node_id)
         return 0;
     }
 
-    return tree->nodes[node_id].height;
+    return tree_cold(tree, node_id)->height;
 }
 
 //==================================================================================================
@@ -215,128 +719,88 @@ int32_t tree_balance_factor(Tree* tree, Node_t node_id)
     return tree_height(tree, node->left_id) - tree_height(tree, node->right_id);
 }
 
+#ifdef TREE_ORDER_STATISTICS
+
 //==================================================================================================
-// Функция: tree_transplant
-// Назначение: Производит замену одного поддерева на другое поддерева.
+// Функция: tree_subtree_size
+// Назначение: Возвращает количество узлов поддерева.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// tree            (in) - бинарное дерево поиска.
-// transplanted_id (in) - идентификатор корневого узла заменяемого поддерева.
-// new_id          (in) - идентификатор коренового узла поддерева, .
+// tree    (in) - бинарное дерево поиска.
+// node_id (in) - идентификатор корневого узла поддерева или NULL_NODE.
 //
 // Возвращаемое значение:
-// отсутствует
+// Количество узлов поддерева (ноль для узла-пустышки).
 //
 // Используемые внешние переменные:
 // отсутствуют
 //
 // Примечания:
-// - Описание алгоритма можно найти в книге Introduction to Algorithms (Cormen, Leiserson, Rivest,
-//   Stein), в части 12.3 третьего издания.
-// - Балансировка дерева производится на более высоком уровне реализации.
+// отсутствуют
 //==================================================================================================
-void tree_transplant(Tree* tree, Node_t transplanted_id, Node_t new_id)
+uint32_t tree_subtree_size(Tree* tree, Node_t node_id)
 {
-    // Указатель на заменяемый узел дерева.
-    TreeNode* transplanted = tree_get(tree, transplanted_id);
-
-    if (transplanted->parent_id == NULL_NODE)
-    {   // Заменяемый узел является корневым.
-        // Заменяем идентификатор корневого узла дерева.
-        tree->root_id = new_id;
-    }
-    else
-    {   // Заменяемый узел не является корневым.
-        // Указатель на родительский узел для заменяемого дерева.
-        TreeNode* parent = tree_get(tree, transplanted->parent_id);
-        if (transplanted_id == parent->left_id)
-        {   // Заменяемый узел находится в левом поддереве своего родительского узла.
-            parent->left_id = new_id;
-        }
-        else
-        {   // Заменяемый узел находится в правом поддереве своего родительского узла.
-            parent->right_id = new_id;
-        }
-    }
-
-    if (new_id != NULL_NODE)
-    {   // Новый узел не является узлом-пустышкой.
-        // Указатель на новый узел.
-        TreeNode* new = tree_get(tree, new_id);
-
-        // Обновляем идентификатор родительского узла для нового узла.
-        new->parent_id = transplanted->parent_id;
-    }
+    return (node_id == NULL_NODE)? 0U : tree_get(tree, node_id)->subtree_size;
 }
 
 //==================================================================================================
-// Функция: tree_node_allocate
-// Назначение: Выделяет новый узел дерева.
+// Функция: tree_update_size
+// Назначение: Пересчитывает размер поддерева узла по размерам его дочерних поддеревьев.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// tree     (in)  - бинарное дерево поиска.
-// new_node (out) - идентификатора нового узла (выходной аргумент).
+// tree    (in) - бинарное дерево поиска.
+// node_id (in) - валидный идентификатор узла дерева.
 //
 // Возвращаемое значение:
-// Новый узел дерева.
+// отсутствует.
 //
 // Используемые внешние переменные:
 // отсутствуют
 //
 // Примечания:
-// отсутствуют
+// - Размеры поддеревьев дочерних узлов должны быть актуальны.
 //==================================================================================================
-RetCode tree_node_allocate(Tree* tree, Node_t* new_node)
+void tree_update_size(Tree* tree, Node_t node_id)
 {
-    // Проверяем наличие невыделенных узлов дерева.
-    if (tree->size == tree->capacity)
-    {   // Невыделенные узлы отсутствуют.
-
-        // Новый размер массива узлов.
-        size_t new_capacity =
-            (tree->size == 0U)? 1U : (2U * tree->capacity);
-
-        // Перевыделяем массив узлов дерева.
-        tree->nodes = realloc(tree->nodes, new_capacity * sizeof(TreeNode));
-        if (tree->nodes == NULL)
-        {
-            return RET_NOMEM;
-        }
-
-        // Обновляем размер массива узлов.
-        tree->capacity = new_capacity;
-    }
+    TreeNode* node = tree_get(tree, node_id);
 
-    // Выделяем новый узел на первом свободном месте в массиве
-    Node_t allocated_id = tree->size;
+    node->subtree_size =
+        1U + tree_subtree_size(tree, node->left_id) + tree_subtree_size(tree, node->right_id);
+}
 
-    // Увеличиваем счётчик выделенных узлов.
-    tree->size += 1U;
+#endif // TREE_ORDER_STATISTICS
 
-    // Указатель на новый узел.
-    TreeNode* allocated = tree_get(tree, allocated_id);
+#ifdef TREE_CONCURRENT
 
-    // Инициализируем узел как отвязанный от дерева.
-    allocated->parent_id = NULL_NODE;
-    allocated->left_id   = NULL_NODE;
-    allocated->right_id  = NULL_NODE;
-
-    // Высота нового узла равна 1.
-    allocated->height = 1;
-
-    // Возвращаем узел.
-    *new_node = allocated_id;
-
-    return RET_OK;
+//==================================================================================================
+// Функция: tree_version
+// Назначение: Возвращает версию, защищающую связь с заданным узлом.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in) - бинарное дерево поиска в режиме одновременного доступа.
+// node_id (in) - валидный идентификатор узла или NULL_NODE.
+//
+// Возвращаемое значение:
+// Указатель на версию узла или на версию корня дерева для узла-пустышки.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Узел-пустышка выступает родителем корневого узла: изменение идентификатора корня
+//   защищается версией корня дерева.
+//==================================================================================================
+uint32_t* tree_version(Tree* tree, Node_t node_id)
+{
+    return (node_id == NULL_NODE)? &tree->sync->root_version : &tree_get(tree, node_id)->version;
 }
 
 //==================================================================================================
-// Функция: tree_node_free
-// Назначение: Освбождает узел дерева.
+// Функция: tree_version_lock
+// Назначение: Делает версию нечётной перед изменением защищаемых ею данных.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// tree     (in) - бинарное дерево поиска.
-// freed_id (in) - идентификатора узла для освобождения.
+// version (in/out) - чётная версия.
 //
 // Возвращаемое значение:
 // отсутствует.
@@ -345,54 +809,27 @@ RetCode tree_node_allocate(Tree* tree, Node_t* new_node)
 // отсутствуют
 //
 // Примечания:
-// - Балансировка дерева производится на более высоком уровне реализации.
+// - Изменять версии может только писатель, захвативший блокировку дерева.
 //==================================================================================================
-void tree_node_free(Tree* tree, Node_t freed_id)
+void tree_version_lock(uint32_t* version)
 {
-    // Удаляемый из дерева узел.
-    TreeNode* freed = tree_get(tree, freed_id);
-
-    // Идентификатор последнего узла в массиве узлов
-    Node_t last_id = tree->size - 1U;
-
-    if (freed_id != last_id)
-    {   // Удаляемый узел не последний в массиве узлов.
-
-        // Последний узел.
-        TreeNode* last = tree_get(tree, last_id);
-
-        // Переносим последний узел в массиве узлов в освободившееся пространство.
-        *freed = *last;
-        tree_transplant(tree, last_id, freed_id);
-
-        // Обновляем родителя правого и левого дочерних узлов.
-        if (freed->left_id != NULL_NODE)
-        {
-            TreeNode* left = tree_get(tree, freed->left_id);
-            left->parent_id = freed_id;
-        }
-        if (freed->right_id != NULL_NODE)
-        {
-            TreeNode* right = tree_get(tree, freed->right_id);
-            right->parent_id = freed_id;
-        }
-    }
+    verify_contract((*version & 1U) == 0U,
+        "tree_version_lock: version is already locked\n");
 
-    // Уменьшаем счётчик выделенных узлов
-    tree->size -= 1U;
+    // Читатели, заставшие изменение, повторят поиск.
+    __atomic_store_n(version, *version + 1U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
 }
 
 //==================================================================================================
-// Функция: tree_search_node
-// Назначение: Производит поиск узла в дереве.
+// Функция: tree_version_unlock
+// Назначение: Публикует новую чётную версию после изменения защищаемых ею данных.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// tree       (in)  - бинарное дерево поиска.
-// search_key (in)  - ключ, по которому производится поиск.
-// parent_id  (out) - указатель на идентификатор родительского узла.
+// version (in/out) - нечётная версия.
 //
 // Возвращаемое значение:
-// Узел по ключу или NULL_NODE в случае отсутствия узла.
+// отсутствует.
 //
 // Используемые внешние переменные:
 // отсутствуют
@@ -400,255 +837,151 @@ void tree_node_free(Tree* tree, Node_t freed_id)
 // Примечания:
 // отсутствуют
 //==================================================================================================
-Node_t tree_search_node(Tree* tree, Key_t search_key, Node_t* parent_id)
+void tree_version_unlock(uint32_t* version)
 {
-    // Родительский узел корневого узла - это узел-пустышка.
-    *parent_id = NULL_NODE;
-
-    // Тукущий рассматриваемый идентификатор.
-    Node_t cur_id = tree->root_id;
-    // Обходим дерево от корня к листьям.
-    while (cur_id != NULL_NODE)
-    {
-        // Текущий рассматриваемый узел.
-        TreeNode* node = tree_get(tree, cur_id);
-
-        if (search_key == node->key)
-        {   // Текущий рассматриаемый узел имеет подходящий ключ.
-            return cur_id;
-        }
-
-        // Обновляем идентификатор рассматриваемого узла.
-        *parent_id = cur_id;
-
-        if (search_key < node->key)
-        {   // Если искомый ключ меньше текущего, то рассматриваем левое поддерево.
-            cur_id = node->left_id;
-        }
-        else
-        {   // Если искомый ключ больше текущего, то рассматриваем правое поддерево.
-            cur_id = node->right_id;
-        }
-    }
-
-    // В случае неуспеха возвращаем идентификатор узла-пустышки.
-    return NULL_NODE;
+    __atomic_store_n(version, *version + 1U, __ATOMIC_RELEASE);
 }
 
 //==================================================================================================
-// Функция: tree_minimum
-// Назначение: Ищет узел с минимальным ключом в в заданном поддереве.
+// Функция: tree_write_lock
+// Назначение: Блокирует узел перед изменением его дочерних узлов или значения.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// tree       (in) - бинарное дерево поиска.
-// subtree_id (in) - идентификатора поддерева для поиска минимума.
+// tree    (in) - бинарное дерево поиска.
+// node_id (in) - валидный идентификатор узла или NULL_NODE для идентификатора корня.
 //
 // Возвращаемое значение:
-// Идентификатор узла с минимальным ключом.
+// отсутствует.
 //
 // Используемые внешние переменные:
 // отсутствуют
 //
 // Примечания:
-// - Описание алгоритма можно найти в книге Introduction to Algorithms (Cormen, Leiserson, Rivest,
-//   Stein), в части 12.3 третьего издания.
+// - Вне режима одновременного доступа ничего не делает.
+// - Узел блокируется только на время одного преобразования (поворота или перевязки),
+//   между преобразованиями дерево остаётся корректным деревом поиска.
 //==================================================================================================
-Node_t tree_minimum(Tree* tree, Node_t subtree_id)
+void tree_write_lock(Tree* tree, Node_t node_id)
 {
-    // Текущий рассматривамый узел.
-    TreeNode* subtree = tree_get(tree, subtree_id);
-
-    // В цикле итеративно переходим к левому дочернему узлу.
-    while (subtree->left_id != NULL_NODE)
+    if (tree->sync != NULL)
     {
-        subtree_id = subtree->left_id;
-        subtree = tree_get(tree, subtree_id);
+        tree_version_lock(tree_version(tree, node_id));
     }
-
-    return subtree_id;
 }
 
 //==================================================================================================
-// Функция: tree_rotate_left
-// Назначение: производит левый поворот над заданной вершиной дерева.
+// Функция: tree_write_unlock
+// Назначение: Снимает блокировку узла после изменения его дочерних узлов или значения.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
 // tree    (in) - бинарное дерево поиска.
-// node_id (in) - валидный идентификатор корневого узла поддерева.
+// node_id (in) - идентификатор узла, заблокированного функцией tree_write_lock.
 //
 // Возвращаемое значение:
-// Идентификатор нового корневого узла поддерева.
+// отсутствует.
 //
 // Используемые внешние переменные:
 // отсутствуют
 //
 // Примечания:
-// - Визуализация преобразования, заданного данной функцией.
-//   Здесь узел node задан идентификатором node_id, а узел ret - ret_id.
-//    node                     ret
-//    / \                      / \    *
-//   T1 ret     ------->     node T3
-//      / \                  / \      *
-//     T2  T3               T1  T2
-//
-// - Узел node должен иметь правый дочерний узел.
-// - Операция не производит перерассчёта высот для родительских узлов.
+// - Вне режима одновременного доступа ничего не делает.
 //==================================================================================================
-Node_t tree_rotate_left(Tree* tree, Node_t node_id)
+void tree_write_unlock(Tree* tree, Node_t node_id)
 {
-    // Текущий корневой узел поддерева.
-    TreeNode* node = tree_get(tree, node_id);
-
-    // Идентификатор нового корневого узла поддерева.
-    Node_t ret_id = node->right_id;
-    // Новый корневой узел поддерева.
-    TreeNode* ret = tree_get(tree, ret_id);
-
-    // Идентификатор текущего левого дочернего узла для узла ret.
-    Node_t t2_id = ret->left_id;
-
-    // Идентификатор родительского узла для узла node.
-    Node_t parent_id = node->parent_id;
-
-    // Обновляем связи узла node.
-    node->parent_id = ret_id;
-    node->right_id  = t2_id;
-
-
-    // Обновляем связи узла ret.
-    ret->left_id    = node_id;
-    ret->parent_id  = parent_id;
-
-    // Обновляем высоты обоих узлов.
-    node->height = max(tree_height(tree, node->left_id), tree_height(tree, node->right_id)) + 1;
-    ret->height  = max(node->height, tree_height(tree, ret->right_id)) + 1;
-
-    // Обновляем идентификатор родителя для узла T2.
-    if (t2_id != NULL_NODE)
-    {
-        TreeNode* t2 = tree_get(tree, t2_id);
-
-        t2->parent_id = node_id;
-    }
-
-    // Обновляем идентификатор дочернего узла для родителя узла node.
-    if (parent_id == NULL_NODE)
+    if (tree->sync != NULL)
     {
-        tree->root_id = ret_id;
-    }
-    else
-    {
-        TreeNode* parent = tree_get(tree, parent_id);
-
-        if (parent->left_id == node_id)
-        {
-            parent->left_id = ret_id;
-        }
-        else
-        {
-            parent->right_id = ret_id;
-        }
+        tree_version_unlock(tree_version(tree, node_id));
     }
-
-    return ret_id;
 }
 
 //==================================================================================================
-// Функция: tree_rotate_right
-// Назначение: производит правый поворот над заданной вершиной дерева.
+// Функция: tree_read_validate
+// Назначение: Проверяет, что версия не изменилась с момента её чтения читателем.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// tree    (in) - бинарное дерево поиска.
-// node_id (in) - валидный идентификатор корневого узла поддерева.
+// version (in) - указатель на версию.
+// seen    (in) - чётная версия, прочитанная ранее.
 //
 // Возвращаемое значение:
-// Идентификатор нового корневого узла поддерева.
+// TRUE, если данные, прочитанные после версии seen, согласованы.
 //
 // Используемые внешние переменные:
 // отсутствуют
 //
 // Примечания:
-// - Визуализация преобразования, заданного данной функцией.
-//   Здесь узел node задан идентификатором node_id, а узел ret - ret_id.
-//      node                ret
-//      / \                 / \      *
-//    ret  T3   ------->   T1 node
-//    / \                     / \    *
-//   T1  T2                  T2  T3
-//
-// - Узел node должен иметь левый дочерний узел.
-// - Операция не производит перерассчёта высот для родительских узлов.
+// отсутствуют
 //==================================================================================================
-Node_t tree_rotate_right(Tree* tree, Node_t node_id)
+bool tree_read_validate(const uint32_t* version, uint32_t seen)
 {
-    // Текущий корневой узел поддерева.
-    TreeNode* node = tree_get(tree, node_id);
-
-    // Идентификатор нового корневого узла поддерева.
-    Node_t ret_id = node->left_id;
-    // Новый корневой узел поддерева.
-    TreeNode* ret = tree_get(tree, ret_id);
-
-    // Идентификатор текущего правого дочернего узла для узла ret.
-    Node_t t2_id = ret->right_id;
-
-    // Идентификатор родительского узла для узла node.
-    Node_t parent_id = node->parent_id;
-
-    // Обновляем связи узла node.
-    node->parent_id = ret_id;
-    node->left_id = t2_id;
+    // Все чтения данных завершаются до повторного чтения версии.
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
 
-    // Обновляем связи узла ret.
-    ret->parent_id = parent_id;
-    ret->right_id  = node_id;
+    return __atomic_load_n(version, __ATOMIC_RELAXED) == seen;
+}
 
-    // Обновляем высоты обоих узлов.
-    node->height = max(tree_height(tree, node->left_id), tree_height(tree, node->right_id)) + 1;
-    ret->height  = max(node->height, tree_height(tree, ret->left_id)) + 1;
+#endif // TREE_CONCURRENT
 
-    // Обновляем идентификатор родителя для узла T2.
-    if (t2_id != NULL_NODE)
-    {
-        TreeNode* t2 = tree_get(tree, t2_id);
+//==================================================================================================
+// Функция: tree_slot_allocate
+// Назначение: Выделяет место в массиве узлов.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in/out) - бинарное дерево поиска.
+// slot_id (out)    - идентификатор выделенного узла.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Сначала используются свободные узлы (см. tree_slot_release), затем - элементы массива
+//   после всех использованных. Заполненный массив узлов увеличивается вдвое, а при хранении
+//   узлов блоками (TREE_CHUNKED) - на один блок.
+//==================================================================================================
+RetCode tree_slot_allocate(Tree* tree, Node_t* slot_id)
+{
+    if (tree->free_id != NULL_NODE)
+    {   // Извлекаем первый узел из списка свободных узлов.
+        *slot_id      = tree->free_id;
+        tree->free_id = tree_get(tree, *slot_id)->left_id;
 
-        t2->parent_id = node_id;
+        return RET_OK;
     }
 
-    // Обновляем идентификатор дочернего узла для родителя узла node.
-    if (parent_id == NULL_NODE)
-    {
-        tree->root_id = ret_id;
-    }
-    else
-    {
-        TreeNode* parent = tree_get(tree, parent_id);
+    // Проверяем наличие невыделенных узлов дерева.
+    if (tree->num_slots == tree->capacity)
+    {   // Невыделенные узлы отсутствуют.
 
-        if (parent->left_id == node_id)
-        {
-            parent->left_id = ret_id;
-        }
-        else
+        // Новый размер массива узлов.
+#ifdef TREE_CHUNKED
+        size_t new_capacity = tree->capacity + TREE_CHUNK_NODES;
+#else
+        size_t new_capacity =
+            (tree->num_slots == 0U)? 1U : (2U * tree->capacity);
+#endif // TREE_CHUNKED
+
+        // Перевыделяем массив узлов дерева.
+        if (tree_resize_nodes(tree, new_capacity) != RET_OK)
         {
-            parent->right_id = ret_id;
+            return RET_NOMEM;
         }
     }
 
-    return ret_id;
-}
+    *slot_id = tree->num_slots;
+    tree->num_slots += 1U;
 
-// Максимальная глубина печати дерева
-#define MAX_PRINT_DEPTH 40U
+    return RET_OK;
+}
 
 //==================================================================================================
-// Функция: tree_print_recursive
-// Назначение: Рекурсивно производит печать поддерева.
+// Функция: tree_slot_release
+// Назначение: Добавляет узел, исключённый из дерева, в список свободных узлов.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// tree   (in) - бинарное дерево поиска.
-// node_i (in) - идентификатор поддерева для печати.
-// level  (in) - обрабатываемый уровень дерева.
-// state  (in) - состояние печати дерева.
+// tree    (in/out) - бинарное дерево поиска.
+// slot_id (in)     - идентификатор исключённого узла.
 //
 // Возвращаемое значение:
 // отсутствует.
@@ -657,32 +990,928 @@ Node_t tree_rotate_right(Tree* tree, Node_t node_id)
 // отсутствуют
 //
 // Примечания:
-// отсутствуют
+// - Свободный узел помечается значением FREE_NODE в поле right_id.
 //==================================================================================================
-void tree_print_recursive(Tree* tree, Node_t node_i, size_t level, int state[MAX_PRINT_DEPTH])
+void tree_slot_release(Tree* tree, Node_t slot_id)
 {
-    if (level == MAX_PRINT_DEPTH)
-    {
-        // Печать уровня с номером более чем MAX_PRINT_DEPTH не производится.
-        return;
-    }
+    TreeNode* slot = tree_get(tree, slot_id);
 
-    // Текущий узел.
-    TreeNode* node = (node_i == NULL_NODE)? NULL : tree_get(tree, node_i);
+    slot->left_id  = tree->free_id;
+    slot->right_id = FREE_NODE;
 
-    // Рекурсивно печатаем левое поддерево.
-    state[level] = 0;
-    if (node != NULL)
-    {
-        tree_print_recursive(tree, node->right_id, level + 1U, state);
-    }
-    state[level] = 1;
+    tree->free_id = slot_id;
+}
 
-    // Печатаем строку текущего узла.
-    for (size_t lvl = 0U; lvl + 1U < level; lvl++)
-    {
-        switch (state[lvl])
-        {
+//==================================================================================================
+// Функция: tree_slot_is_free
+// Назначение: Проверяет, является ли элемент массива узлов свободным узлом.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in) - бинарное дерево поиска.
+// slot_id (in) - идентификатор, меньший tree->num_slots.
+//
+// Возвращаемое значение:
+// Флаг свободного узла.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+bool tree_slot_is_free(Tree* tree, Node_t slot_id)
+{
+    return tree_get(tree, slot_id)->right_id == FREE_NODE;
+}
+
+//==================================================================================================
+// Функция: tree_transplant
+// Назначение: Производит замену одного поддерева на другое поддерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree            (in) - бинарное дерево поиска.
+// transplanted_id (in) - идентификатор корневого узла заменяемого поддерева.
+// new_id          (in) - идентификатор коренового узла поддерева, .
+//
+// Возвращаемое значение:
+// отсутствует
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Описание алгоритма можно найти в книге Introduction to Algorithms (Cormen, Leiserson, Rivest,
+//   Stein), в части 12.3 третьего издания.
+// - Балансировка дерева производится на более высоком уровне реализации.
+//==================================================================================================
+void tree_transplant(Tree* tree, Node_t transplanted_id, Node_t new_id)
+{
+    // Указатель на заменяемый узел дерева.
+    TreeNodeCold* transplanted = tree_cold(tree, transplanted_id);
+
+#ifdef TREE_CONCURRENT
+    // Блокируем узел, связь которого с поддеревом изменяется.
+    tree_write_lock(tree, transplanted->parent_id);
+#endif // TREE_CONCURRENT
+
+    if (transplanted->parent_id == NULL_NODE)
+    {   // Заменяемый узел является корневым.
+        // Заменяем идентификатор корневого узла дерева.
+        TREE_STORE(tree->root_id, new_id);
+    }
+    else
+    {   // Заменяемый узел не является корневым.
+        // Указатель на родительский узел для заменяемого дерева.
+        TreeNode* parent = tree_get(tree, transplanted->parent_id);
+        if (transplanted_id == parent->left_id)
+        {   // Заменяемый узел находится в левом поддереве своего родительского узла.
+            TREE_STORE(parent->left_id, new_id);
+        }
+        else
+        {   // Заменяемый узел находится в правом поддереве своего родительского узла.
+            TREE_STORE(parent->right_id, new_id);
+        }
+    }
+
+#ifdef TREE_CONCURRENT
+    tree_write_unlock(tree, transplanted->parent_id);
+#endif // TREE_CONCURRENT
+
+    if (new_id != NULL_NODE)
+    {   // Новый узел не является узлом-пустышкой.
+        // Обновляем идентификатор родительского узла для нового узла.
+        tree_cold(tree, new_id)->parent_id = transplanted->parent_id;
+    }
+}
+
+//==================================================================================================
+// Функция: tree_node_allocate
+// Назначение: Выделяет новый узел дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree     (in)  - бинарное дерево поиска.
+// new_node (out) - идентификатора нового узла (выходной аргумент).
+//
+// Возвращаемое значение:
+// Новый узел дерева.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+RetCode tree_node_allocate(Tree* tree, Node_t* new_node)
+{
+    // Выделяем новый узел на месте свободного узла или после всех использованных узлов.
+    Node_t allocated_id;
+    if (tree_slot_allocate(tree, &allocated_id) != RET_OK)
+    {
+        return RET_NOMEM;
+    }
+
+    // Увеличиваем счётчик выделенных узлов.
+    tree->size += 1U;
+
+    // Указатель на новый узел.
+    TreeNode* allocated = tree_get(tree, allocated_id);
+
+    // Инициализируем узел как отвязанный от дерева.
+    tree_cold(tree, allocated_id)->parent_id = NULL_NODE;
+    TREE_STORE(allocated->left_id,  NULL_NODE);
+    TREE_STORE(allocated->right_id, NULL_NODE);
+
+    // Высота нового узла равна 1.
+    tree_cold(tree, allocated_id)->height = 1;
+
+#ifdef TREE_ORDER_STATISTICS
+    // Поддерево нового узла состоит из него самого.
+    allocated->subtree_size = 1U;
+#endif // TREE_ORDER_STATISTICS
+
+#ifdef TREE_CONCURRENT
+    // Узел недоступен читателям до связывания с родительским узлом.
+    __atomic_store_n(&allocated->version, 0U, __ATOMIC_RELAXED);
+#endif // TREE_CONCURRENT
+
+    // Возвращаем узел.
+    *new_node = allocated_id;
+
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_node_move
+// Назначение: Переносит узел дерева на место неиспользуемого узла массива.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree     (in) - бинарное дерево поиска.
+// moved_id (in) - идентификатор переносимого узла.
+// new_id   (in) - идентификатор неиспользуемого узла, занимаемого переносимым узлом.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Связи родительского и дочерних узлов перенаправляются на новый идентификатор.
+//==================================================================================================
+void tree_node_move(Tree* tree, Node_t moved_id, Node_t new_id)
+{
+    // Узел на новом месте.
+    TreeNode* moved = tree_get(tree, new_id);
+
+    // Переносим узел в освободившееся пространство.
+    *moved = *tree_get(tree, moved_id);
+#ifdef TREE_SOA
+    *tree_cold(tree, new_id) = *tree_cold(tree, moved_id);
+#endif // TREE_SOA
+    tree_transplant(tree, moved_id, new_id);
+
+    // Обновляем родителя правого и левого дочерних узлов.
+    if (moved->left_id != NULL_NODE)
+    {
+        tree_cold(tree, moved->left_id)->parent_id = new_id;
+    }
+    if (moved->right_id != NULL_NODE)
+    {
+        tree_cold(tree, moved->right_id)->parent_id = new_id;
+    }
+}
+
+//==================================================================================================
+// Функция: tree_node_free
+// Назначение: Освбождает узел дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree     (in) - бинарное дерево поиска.
+// freed_id (in) - идентификатора узла для освобождения.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Балансировка дерева производится на более высоком уровне реализации.
+// - Узел добавляется в список свободных узлов, идентификаторы остальных узлов не изменяются.
+// - В режиме одновременного доступа узел не переиспользуется, пока его могут читать
+//   другие потоки (см. tree_retire).
+//==================================================================================================
+void tree_node_free(Tree* tree, Node_t freed_id)
+{
+#ifdef TREE_CONCURRENT
+    if (tree->sync != NULL)
+    {
+        tree_retire(tree, freed_id, NULL);
+
+        tree->size -= 1U;
+        return;
+    }
+#endif // TREE_CONCURRENT
+
+    // Место узла переиспользуется при следующей вставке.
+    tree_slot_release(tree, freed_id);
+
+    // Уменьшаем счётчик выделенных узлов
+    tree->size -= 1U;
+}
+
+//==================================================================================================
+// Функция: tree_search_node
+// Назначение: Производит поиск узла в дереве.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree       (in)  - бинарное дерево поиска.
+// search_key (in)  - ключ, по которому производится поиск.
+// parent_id  (out) - указатель на идентификатор родительского узла.
+//
+// Возвращаемое значение:
+// Узел по ключу или NULL_NODE в случае отсутствия узла.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+Node_t tree_search_node(Tree* tree, Key_t search_key, Node_t* parent_id)
+{
+    // Родительский узел корневого узла - это узел-пустышка.
+    *parent_id = NULL_NODE;
+
+    // Тукущий рассматриваемый идентификатор.
+    Node_t cur_id = tree->root_id;
+    // Обходим дерево от корня к листьям.
+    while (cur_id != NULL_NODE)
+    {
+        // Текущий рассматриваемый узел.
+        TreeNode* node = tree_get(tree, cur_id);
+
+        if (search_key == node->key)
+        {   // Текущий рассматриаемый узел имеет подходящий ключ.
+            return cur_id;
+        }
+
+        // Обновляем идентификатор рассматриваемого узла.
+        *parent_id = cur_id;
+
+        if (search_key < node->key)
+        {   // Если искомый ключ меньше текущего, то рассматриваем левое поддерево.
+            cur_id = node->left_id;
+        }
+        else
+        {   // Если искомый ключ больше текущего, то рассматриваем правое поддерево.
+            cur_id = node->right_id;
+        }
+    }
+
+    // В случае неуспеха возвращаем идентификатор узла-пустышки.
+    return NULL_NODE;
+}
+
+//==================================================================================================
+// Функция: tree_minimum
+// Назначение: Ищет узел с минимальным ключом в в заданном поддереве.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree       (in) - бинарное дерево поиска.
+// subtree_id (in) - идентификатора поддерева для поиска минимума.
+//
+// Возвращаемое значение:
+// Идентификатор узла с минимальным ключом.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Описание алгоритма можно найти в книге Introduction to Algorithms (Cormen, Leiserson, Rivest,
+//   Stein), в части 12.3 третьего издания.
+//==================================================================================================
+Node_t tree_minimum(Tree* tree, Node_t subtree_id)
+{
+    // Текущий рассматривамый узел.
+    TreeNode* subtree = tree_get(tree, subtree_id);
+
+    // В цикле итеративно переходим к левому дочернему узлу.
+    while (subtree->left_id != NULL_NODE)
+    {
+        subtree_id = subtree->left_id;
+        subtree = tree_get(tree, subtree_id);
+    }
+
+    return subtree_id;
+}
+
+//==================================================================================================
+// Функция: tree_successor
+// Назначение: Ищет узел, следующий за заданным узлом в порядке возрастания ключей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in) - бинарное дерево поиска.
+// node_id (in) - валидный идентификатор узла дерева.
+//
+// Возвращаемое значение:
+// Идентификатор следующего узла или NULL_NODE, если ключ узла максимален.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Описание алгоритма можно найти в книге Introduction to Algorithms (Cormen, Leiserson, Rivest,
+//   Stein), в части 12.2 третьего издания.
+//==================================================================================================
+Node_t tree_successor(Tree* tree, Node_t node_id)
+{
+    // Текущий рассматриваемый узел.
+    TreeNode* node = tree_get(tree, node_id);
+
+    if (node->right_id != NULL_NODE)
+    {   // Следующий узел - минимум правого поддерева.
+        return tree_minimum(tree, node->right_id);
+    }
+
+    // Поднимаемся к первому предку, для которого узел находится в левом поддереве.
+    Node_t parent_id = tree_cold(tree, node_id)->parent_id;
+    while (parent_id != NULL_NODE && node_id == tree_get(tree, parent_id)->right_id)
+    {
+        node_id   = parent_id;
+        parent_id = tree_cold(tree, parent_id)->parent_id;
+    }
+
+    return parent_id;
+}
+
+//==================================================================================================
+// Функция: tree_maximum
+// Назначение: Ищет узел с максимальным ключом в заданном поддереве.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree       (in) - бинарное дерево поиска.
+// subtree_id (in) - идентификатора поддерева для поиска максимума.
+//
+// Возвращаемое значение:
+// Идентификатор узла с максимальным ключом.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Описание алгоритма можно найти в книге Introduction to Algorithms (Cormen, Leiserson, Rivest,
+//   Stein), в части 12.2 третьего издания.
+//==================================================================================================
+Node_t tree_maximum(Tree* tree, Node_t subtree_id)
+{
+    // Текущий рассматривамый узел.
+    TreeNode* subtree = tree_get(tree, subtree_id);
+
+    // В цикле итеративно переходим к правому дочернему узлу.
+    while (subtree->right_id != NULL_NODE)
+    {
+        subtree_id = subtree->right_id;
+        subtree = tree_get(tree, subtree_id);
+    }
+
+    return subtree_id;
+}
+
+//==================================================================================================
+// Функция: tree_predecessor
+// Назначение: Ищет узел, предшествующий заданному узлу в порядке возрастания ключей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in) - бинарное дерево поиска.
+// node_id (in) - валидный идентификатор узла дерева.
+//
+// Возвращаемое значение:
+// Идентификатор предыдущего узла или NULL_NODE, если ключ узла минимален.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Симметрична функции tree_successor.
+//==================================================================================================
+Node_t tree_predecessor(Tree* tree, Node_t node_id)
+{
+    // Текущий рассматриваемый узел.
+    TreeNode* node = tree_get(tree, node_id);
+
+    if (node->left_id != NULL_NODE)
+    {   // Предыдущий узел - максимум левого поддерева.
+        return tree_maximum(tree, node->left_id);
+    }
+
+    // Поднимаемся к первому предку, для которого узел находится в правом поддереве.
+    Node_t parent_id = tree_cold(tree, node_id)->parent_id;
+    while (parent_id != NULL_NODE && node_id == tree_get(tree, parent_id)->left_id)
+    {
+        node_id   = parent_id;
+        parent_id = tree_cold(tree, parent_id)->parent_id;
+    }
+
+    return parent_id;
+}
+
+//==================================================================================================
+// Функция: tree_rotate_left
+// Назначение: производит левый поворот над заданной вершиной дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in) - бинарное дерево поиска.
+// node_id (in) - валидный идентификатор корневого узла поддерева.
+//
+// Возвращаемое значение:
+// Идентификатор нового корневого узла поддерева.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Визуализация преобразования, заданного данной функцией.
+//   Здесь узел node задан идентификатором node_id, а узел ret - ret_id.
+//    node                     ret
+//    / \                      / \    *
+//   T1 ret     ------->     node T3
+//      / \                  / \      *
+//     T2  T3               T1  T2
+//
+// - Узел node должен иметь правый дочерний узел.
+// - Операция не производит перерассчёта высот для родительских узлов.
+//==================================================================================================
+Node_t tree_rotate_left(Tree* tree, Node_t node_id)
+{
+    // Текущий корневой узел поддерева.
+    TreeNode* node = tree_get(tree, node_id);
+
+    // Идентификатор нового корневого узла поддерева.
+    Node_t ret_id = node->right_id;
+    // Новый корневой узел поддерева.
+    TreeNode* ret = tree_get(tree, ret_id);
+
+    // Идентификатор текущего левого дочернего узла для узла ret.
+    Node_t t2_id = ret->left_id;
+
+    // Идентификатор родительского узла для узла node.
+    Node_t parent_id = tree_cold(tree, node_id)->parent_id;
+
+#ifdef TREE_CONCURRENT
+    // Блокируем узлы, дочерние узлы которых изменяются поворотом.
+    tree_write_lock(tree, parent_id);
+    tree_write_lock(tree, node_id);
+    tree_write_lock(tree, ret_id);
+#endif // TREE_CONCURRENT
+
+    // Обновляем связи узла node.
+    tree_cold(tree, node_id)->parent_id = ret_id;
+    TREE_STORE(node->right_id, t2_id);
+
+    // Обновляем связи узла ret.
+    TREE_STORE(ret->left_id, node_id);
+    tree_cold(tree, ret_id)->parent_id = parent_id;
+
+    // Обновляем высоты обоих узлов.
+    tree_cold(tree, node_id)->height =
+        max(tree_height(tree, node->left_id), tree_height(tree, node->right_id)) + 1;
+    tree_cold(tree, ret_id)->height =
+        max(tree_height(tree, node_id), tree_height(tree, ret->right_id)) + 1;
+
+#ifdef TREE_ORDER_STATISTICS
+    // Обновляем размеры поддеревьев: сначала опустившегося узла, затем нового корня.
+    tree_update_size(tree, node_id);
+    tree_update_size(tree, ret_id);
+#endif // TREE_ORDER_STATISTICS
+
+    // Обновляем идентификатор родителя для узла T2.
+    if (t2_id != NULL_NODE)
+    {
+        tree_cold(tree, t2_id)->parent_id = node_id;
+    }
+
+    // Обновляем идентификатор дочернего узла для родителя узла node.
+    if (parent_id == NULL_NODE)
+    {
+        TREE_STORE(tree->root_id, ret_id);
+    }
+    else
+    {
+        TreeNode* parent = tree_get(tree, parent_id);
+
+        if (parent->left_id == node_id)
+        {
+            TREE_STORE(parent->left_id, ret_id);
+        }
+        else
+        {
+            TREE_STORE(parent->right_id, ret_id);
+        }
+    }
+
+#ifdef TREE_CONCURRENT
+    tree_write_unlock(tree, ret_id);
+    tree_write_unlock(tree, node_id);
+    tree_write_unlock(tree, parent_id);
+#endif // TREE_CONCURRENT
+
+    return ret_id;
+}
+
+//==================================================================================================
+// Функция: tree_rotate_right
+// Назначение: производит правый поворот над заданной вершиной дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in) - бинарное дерево поиска.
+// node_id (in) - валидный идентификатор корневого узла поддерева.
+//
+// Возвращаемое значение:
+// Идентификатор нового корневого узла поддерева.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Визуализация преобразования, заданного данной функцией.
+//   Здесь узел node задан идентификатором node_id, а узел ret - ret_id.
+//      node                ret
+//      / \                 / \      *
+//    ret  T3   ------->   T1 node
+//    / \                     / \    *
+//   T1  T2                  T2  T3
+//
+// - Узел node должен иметь левый дочерний узел.
+// - Операция не производит перерассчёта высот для родительских узлов.
+//==================================================================================================
+Node_t tree_rotate_right(Tree* tree, Node_t node_id)
+{
+    // Текущий корневой узел поддерева.
+    TreeNode* node = tree_get(tree, node_id);
+
+    // Идентификатор нового корневого узла поддерева.
+    Node_t ret_id = node->left_id;
+    // Новый корневой узел поддерева.
+    TreeNode* ret = tree_get(tree, ret_id);
+
+    // Идентификатор текущего правого дочернего узла для узла ret.
+    Node_t t2_id = ret->right_id;
+
+    // Идентификатор родительского узла для узла node.
+    Node_t parent_id = tree_cold(tree, node_id)->parent_id;
+
+#ifdef TREE_CONCURRENT
+    // Блокируем узлы, дочерние узлы которых изменяются поворотом.
+    tree_write_lock(tree, parent_id);
+    tree_write_lock(tree, node_id);
+    tree_write_lock(tree, ret_id);
+#endif // TREE_CONCURRENT
+
+    // Обновляем связи узла node.
+    tree_cold(tree, node_id)->parent_id = ret_id;
+    TREE_STORE(node->left_id, t2_id);
+
+    // Обновляем связи узла ret.
+    tree_cold(tree, ret_id)->parent_id = parent_id;
+    TREE_STORE(ret->right_id, node_id);
+
+    // Обновляем высоты обоих узлов.
+    tree_cold(tree, node_id)->height =
+        max(tree_height(tree, node->left_id), tree_height(tree, node->right_id)) + 1;
+    tree_cold(tree, ret_id)->height =
+        max(tree_height(tree, node_id), tree_height(tree, ret->left_id)) + 1;
+
+#ifdef TREE_ORDER_STATISTICS
+    // Обновляем размеры поддеревьев: сначала опустившегося узла, затем нового корня.
+    tree_update_size(tree, node_id);
+    tree_update_size(tree, ret_id);
+#endif // TREE_ORDER_STATISTICS
+
+    // Обновляем идентификатор родителя для узла T2.
+    if (t2_id != NULL_NODE)
+    {
+        tree_cold(tree, t2_id)->parent_id = node_id;
+    }
+
+    // Обновляем идентификатор дочернего узла для родителя узла node.
+    if (parent_id == NULL_NODE)
+    {
+        TREE_STORE(tree->root_id, ret_id);
+    }
+    else
+    {
+        TreeNode* parent = tree_get(tree, parent_id);
+
+        if (parent->left_id == node_id)
+        {
+            TREE_STORE(parent->left_id, ret_id);
+        }
+        else
+        {
+            TREE_STORE(parent->right_id, ret_id);
+        }
+    }
+
+#ifdef TREE_CONCURRENT
+    tree_write_unlock(tree, ret_id);
+    tree_write_unlock(tree, node_id);
+    tree_write_unlock(tree, parent_id);
+#endif // TREE_CONCURRENT
+
+    return ret_id;
+}
+
+//==================================================================================================
+// Функция: tree_build_recursive
+// Назначение: Рекурсивно связывает узлы отсортированного диапазона в идеально сбалансированное
+// поддерево.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree      (in) - бинарное дерево поиска.
+// first_id  (in) - идентификатор первого узла диапазона.
+// last_id   (in) - идентификатор узла, следующего за последним узлом диапазона.
+// parent_id (in) - идентификатор родительского узла для корня поддерева.
+//
+// Возвращаемое значение:
+// Идентификатор корневого узла поддерева или NULL_NODE для пустого диапазона.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Узлы диапазона уже содержат ключи и значения в порядке возрастания ключей,
+//   функция выставляет только связи узлов и высоты поддеревьев.
+// - Размеры левого и правого поддеревьев отличаются не более чем на единицу,
+//   поэтому глубина рекурсии не превышает log2(n) + 1.
+//==================================================================================================
+Node_t tree_build_recursive(Tree* tree, Node_t first_id, Node_t last_id, Node_t parent_id)
+{
+    if (first_id == last_id)
+    {   // Пустой диапазон задаёт узел-пустышку.
+        return NULL_NODE;
+    }
+
+    // Корнем поддерева становится средний узел диапазона.
+    Node_t middle_id = first_id + (last_id - first_id) / 2U;
+    TreeNode* middle = tree_get(tree, middle_id);
+
+    // Связываем корень поддерева с родителем и с поддеревьями из левой и правой частей диапазона.
+    tree_cold(tree, middle_id)->parent_id = parent_id;
+    middle->left_id   = tree_build_recursive(tree, first_id, middle_id, middle_id);
+    middle->right_id  = tree_build_recursive(tree, middle_id + 1U, last_id, middle_id);
+
+    // Вычисляем высоту поддерева.
+    tree_cold(tree, middle_id)->height =
+        max(tree_height(tree, middle->left_id), tree_height(tree, middle->right_id)) + 1;
+
+#ifdef TREE_ORDER_STATISTICS
+    // Поддерево состоит из всех узлов диапазона.
+    middle->subtree_size = last_id - first_id;
+#endif // TREE_ORDER_STATISTICS
+
+    return middle_id;
+}
+
+//==================================================================================================
+// Функция: tree_check_recursive
+// Назначение: Рекурсивно проверяет связи узлов и балансировку поддерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree      (in) - бинарное дерево поиска.
+// node_id   (in) - идентификатор корневого узла поддерева.
+// parent_id (in) - ожидаемый идентификатор родительского узла.
+//
+// Возвращаемое значение:
+// Высота поддерева или -1 в случае нарушения инвариантов.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+int32_t tree_check_recursive(Tree* tree, Node_t node_id, Node_t parent_id)
+{
+    if (node_id == NULL_NODE)
+    {
+        return 0;
+    }
+
+    if (node_id >= tree->num_slots || tree_slot_is_free(tree, node_id))
+    {   // Идентификатор узла выходит за границы массива узлов или указывает на свободный узел.
+        return -1;
+    }
+
+    // Проверяемый узел.
+    TreeNode* node = tree_get(tree, node_id);
+    if (tree_cold(tree, node_id)->parent_id != parent_id)
+    {
+        return -1;
+    }
+
+    int32_t left_height  = tree_check_recursive(tree, node->left_id,  node_id);
+    int32_t right_height = tree_check_recursive(tree, node->right_id, node_id);
+    if (left_height < 0 || right_height < 0)
+    {
+        return -1;
+    }
+
+    // Проверяем сохранённую высоту и баланс поддеревьев.
+    int32_t height = max(left_height, right_height) + 1;
+    if (tree_cold(tree, node_id)->height != height || abs(left_height - right_height) > 1)
+    {
+        return -1;
+    }
+
+#ifdef TREE_ORDER_STATISTICS
+    // Проверяем сохранённый размер поддерева.
+    if (node->subtree_size !=
+        1U + tree_subtree_size(tree, node->left_id) + tree_subtree_size(tree, node->right_id))
+    {
+        return -1;
+    }
+#endif // TREE_ORDER_STATISTICS
+
+    return height;
+}
+
+//==================================================================================================
+// Функция: tree_layout_bfs
+// Назначение: Вычисляет порядок узлов при обходе дерева в ширину.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree  (in)  - бинарное дерево поиска.
+// order (out) - массив из tree->size идентификаторов узлов в порядке обхода.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Выходной массив одновременно служит очередью обхода.
+//==================================================================================================
+void tree_layout_bfs(Tree* tree, Node_t order[])
+{
+    // Количество узлов, добавленных в очередь.
+    size_t count = 0U;
+
+    if (tree->root_id != NULL_NODE)
+    {
+        order[count++] = tree->root_id;
+    }
+
+    for (size_t i = 0U; i < count; ++i)
+    {
+        TreeNode* node = tree_get(tree, order[i]);
+
+        if (node->left_id != NULL_NODE)
+        {
+            order[count++] = node->left_id;
+        }
+        if (node->right_id != NULL_NODE)
+        {
+            order[count++] = node->right_id;
+        }
+    }
+}
+
+// Предварительная декларация функции для взаимной рекурсии.
+void tree_layout_veb(Tree* tree, Node_t root_id, uint32_t height, Node_t order[], size_t* count);
+
+//==================================================================================================
+// Функция: tree_layout_veb_bottom
+// Назначение: Размещает в порядке ван Эмде Боаса нижние поддеревья, корни которых находятся
+// на заданной глубине относительно заданного узла.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in)     - бинарное дерево поиска.
+// node_id (in)     - идентификатор узла, от которого отсчитывается глубина.
+// depth   (in)     - глубина корней нижних поддеревьев.
+// height  (in)     - количество уровней нижних поддеревьев.
+// order   (in/out) - массив идентификаторов узлов в новом порядке.
+// count   (in/out) - количество уже размещённых узлов.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Нижние поддеревья размещаются слева направо.
+//==================================================================================================
+void tree_layout_veb_bottom(Tree* tree, Node_t node_id, uint32_t depth, uint32_t height,
+                            Node_t order[], size_t* count)
+{
+    if (node_id == NULL_NODE)
+    {
+        return;
+    }
+
+    if (depth == 0U)
+    {   // Узел является корнем нижнего поддерева.
+        tree_layout_veb(tree, node_id, height, order, count);
+        return;
+    }
+
+    TreeNode* node = tree_get(tree, node_id);
+
+    tree_layout_veb_bottom(tree, node->left_id,  depth - 1U, height, order, count);
+    tree_layout_veb_bottom(tree, node->right_id, depth - 1U, height, order, count);
+}
+
+//==================================================================================================
+// Функция: tree_layout_veb
+// Назначение: Вычисляет порядок ван Эмде Боаса для узлов поддерева, ограниченного по высоте.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in)     - бинарное дерево поиска.
+// root_id (in)     - идентификатор корневого узла поддерева.
+// height  (in)     - количество уровней поддерева, которые требуется разместить.
+// order   (in/out) - массив идентификаторов узлов в новом порядке.
+// count   (in/out) - количество уже размещённых узлов.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Поддерево разрезается по середине высоты: сначала рекурсивно размещается верхнее поддерево
+//   из height / 2 уровней, затем - каждое из нижних поддеревьев.
+// - Путь от корня к листу пересекает O(log(n) / log(B)) блоков размера B при любом B, поэтому
+//   порядок эффективен одновременно для кеш-линий, страниц и TLB.
+//==================================================================================================
+void tree_layout_veb(Tree* tree, Node_t root_id, uint32_t height, Node_t order[], size_t* count)
+{
+    if (root_id == NULL_NODE || height == 0U)
+    {
+        return;
+    }
+
+    if (height == 1U)
+    {   // Поддерево из одного уровня состоит из корневого узла.
+        order[(*count)++] = root_id;
+        return;
+    }
+
+    // Количество уровней верхнего поддерева.
+    uint32_t top_height = height / 2U;
+
+    tree_layout_veb(tree, root_id, top_height, order, count);
+    tree_layout_veb_bottom(tree, root_id, top_height, height - top_height, order, count);
+}
+
+// Максимальная глубина печати дерева
+#define MAX_PRINT_DEPTH 40U
+
+//==================================================================================================
+// Функция: tree_print_recursive
+// Назначение: Рекурсивно производит печать поддерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree   (in) - бинарное дерево поиска.
+// node_i (in) - идентификатор поддерева для печати.
+// level  (in) - обрабатываемый уровень дерева.
+// state  (in) - состояние печати дерева.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+void tree_print_recursive(Tree* tree, Node_t node_i, size_t level, int state[MAX_PRINT_DEPTH])
+{
+    if (level == MAX_PRINT_DEPTH)
+    {
+        // Печать уровня с номером более чем MAX_PRINT_DEPTH не производится.
+        return;
+    }
+
+    // Текущий узел.
+    TreeNode* node = (node_i == NULL_NODE)? NULL : tree_get(tree, node_i);
+
+    // Рекурсивно печатаем левое поддерево.
+    state[level] = 0;
+    if (node != NULL)
+    {
+        tree_print_recursive(tree, node->right_id, level + 1U, state);
+    }
+    state[level] = 1;
+
+    // Печатаем строку текущего узла.
+    for (size_t lvl = 0U; lvl + 1U < level; lvl++)
+    {
+        switch (state[lvl])
+        {
             case 0:
                 printf("      ");
                 break;
@@ -699,434 +1928,1759 @@ void tree_print_recursive(Tree* tree, Node_t node_i, size_t level, int state[MAX
         }
     }
 
-    if (level != 0U)
+    if (level != 0U)
+    {
+        if (state[level - 1U] == 0)
+        {
+            state[level - 1U] = 1;
+        }
+
+        switch (state[level - 1U])
+        {
+            case 1:
+                printf(" ┌────");
+                break;
+            case 2:
+                printf(" └────");
+                break;
+            case 3:
+                printf("      ");
+                break;
+            default: break;
+        }
+
+        if (state[level - 1U] == 2)
+        {
+            state[level - 1U] = 3;
+        }
+    }
+
+    // Печатаем текущий узел.
+    if (node == NULL)
+    {
+        printf("0\n");
+    }
+    else
+    {
+        printf("[%d](%d)\n", node->key, tree_cold(tree, node_i)->height);
+    }
+
+    // Рекурсивно печатаем правое поддерево.
+    state[level] = 2;
+    if (node != NULL)
+    {
+        tree_print_recursive(tree, node->left_id, level + 1U, state);
+    }
+    state[level] = 3;
+}
+
+// Предварительная декларация функции для печати.
+void tree_print(Tree* tree);
+
+//==================================================================================================
+// Функция: tree_balance
+// Назначение: Производит перебалансировку дерева от нижнего узла к верхнему.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree        (in) - бинарное дерево поиска.
+// unbalanced_id (in) - идентификатор узла, с которого требуется начинать перебалансировку.
+//
+// Возвращаемое значение:
+// код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+void tree_balance(Tree* tree, Node_t unbalanced_id)
+{
+    if (unbalanced_id == NULL_NODE)
+    {
+        // Для узла-пустышки балансировка уже выполнена.
+        return;
+    }
+
+    // Производим итеративную балансировку дерева.
+    do
+    {
+        // Узел, являющийся текущим кандидатом на перебалансировку.
+        TreeNode* unbalanced = tree_get(tree, unbalanced_id);
+
+        // Родительский узел для итогового поддерева.
+        Node_t parent_id = tree_cold(tree, unbalanced_id)->parent_id;
+
+        // Вычисляем разность высот левого и правого поддеревьев.
+        int32_t balance_factor = tree_balance_factor(tree, unbalanced_id);
+
+        // Проверяем необходимость балансировки.
+        if (balance_factor > 1)
+        {   // Левое поддерево значительно выше правого.
+            // Идентификатор корня левого поддерева.
+            Node_t left_id = unbalanced->left_id;
+
+            // Проверяем баланс левого поддерева.
+            if (tree_balance_factor(tree, left_id) < 0)
+            {
+                // u = unbalanced_id
+                // l = left_id
+                /*     u     >       u
+                 *    / \    >      / \
+                 *   l   T4  >     x   T4
+                 *  / \      >    / \
+                 * T1  x     >   l  T3
+                 *    / \    >  / \
+                 *   T2 T3   > T1 T2
+                 */
+
+                // Производим дополнительный обратный поворот.
+                tree_rotate_left(tree, left_id);
+            }
+
+            // u = unbalanced_id
+            // l = left_id
+            /*       u    >      l
+             *      / \   >     / \
+             *     l   T4 >    /   \
+             *    / \     >   x     u
+             *   x  T3    >  / \   / \
+             *  / \       > T1 T2 T3 T4
+             * T1 T2      >
+             */
+
+            // Производим прямой поворот.
+            tree_rotate_right(tree, unbalanced_id);
+        }
+        else if (balance_factor < -1)
+        {   // Правое поддерево значительно выше левого.
+            // Идентификатор корня правого поддерева.
+            Node_t right_id = unbalanced->right_id;
+
+            // Проверяем баланс правого поддерева.
+            if (tree_balance_factor(tree, right_id) > 0)
+            {
+                // u = unbalanced_id
+                // r = right_id
+                /*    u     >   u
+                 *   / \    >  / \
+                 *  T1  r   > T1  r
+                 *     / \  >    / \
+                 *    x  T4 >   T2  x
+                 *   / \    >      / \
+                 *  T2 T3   >     T3 T4
+                 */
+
+                // Производим дополнительный обратный поворот.
+                tree_rotate_right(tree, right_id);
+            }
+
+            // u = unbalanced_id
+            // r = right_id
+            /*   u       >      r
+             *  / \      >     / \
+             * T1  r     >    /   \
+             *    / \    >   u     x
+             *   T2  x   >  / \   / \
+             *      / \  > T1 T2 T3 T4
+             *     T3 T4 >
+             */
+
+            // Производим прямой поворот.
+            tree_rotate_left(tree, unbalanced_id);
+        }
+        else
+        {
+            // Вычисляем высоту текущего кандидата на перебалансировку.
+            tree_cold(tree, unbalanced_id)->height = max(tree_height(tree, unbalanced->left_id), tree_height(tree, unbalanced->right_id)) + 1;
+
+#ifdef TREE_ORDER_STATISTICS
+            // Пересчитываем размер поддерева: балансировка проходит весь путь до корня.
+            tree_update_size(tree, unbalanced_id);
+#endif // TREE_ORDER_STATISTICS
+        }
+
+#ifdef TREE_VISUALIZE
+        tree_print(tree);
+        printf("\n");
+        sleep(1);
+#endif // TREE_VISUALIZE
+
+        // Переходим к рассмотрению родительского узла.
+        unbalanced_id = parent_id;
+    }
+    while (unbalanced_id != NULL_NODE);
+}
+
+
+//============================//
+// Пользовательский интерфейс //
+//============================//
+
+//==================================================================================================
+// Функция: tree_search
+// Назначение: Находит значение в дереве по ключу.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree  (in)  - бинарное дерево поиска.
+// key   (in)  - ключ, по которому производится поиск.
+// res   (out) - значение по ключу (выходной аргумент).
+// found (out) - флаг успешности поиска в дереве (выходной аргумент).
+//
+// Возвращаемое значение:
+// код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+RetCode tree_search(Tree* tree, Key_t key, Value_t* res, bool* found)
+{
+    if (tree == NULL || res == NULL || found == NULL)
+    {
+        return RET_INVAL;
+    }
+
+    Node_t parent_id = NULL_NODE;
+    Node_t found_id = tree_search_node(tree, key, &parent_id);
+    if (found_id == NULL_NODE)
+    {
+        *found = false;
+        return RET_OK;
+    }
+
+    *res = tree_cold(tree, found_id)->value;
+
+    *found = true;
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_set
+// Назначение: Выставляет значение в дереве по ключу.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree  (in) - бинарное дерево поиска.
+// key   (in) - ключ, по которому производится поиск значения.
+// value (in) - новое значение для заданного ключа.
+//
+// Возвращаемое значение:
+// код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+RetCode tree_set(Tree* tree, Key_t key, Value_t value)
+{
+    if (tree == NULL)
+    {
+        return RET_INVAL;
+    }
+
+#ifdef TREE_CONCURRENT
+    verify_contract(tree->sync == NULL || tree->sync->writing,
+        "tree_set: use tree_set_concurrent in concurrent access mode\n");
+#endif // TREE_CONCURRENT
+
+    // Производим поиск значения по ключу.
+    Node_t parent_id = NULL_NODE;
+    Node_t found_i = tree_search_node(tree, key, &parent_id);
+
+    // Обновляем значение уже существующего узла.
+    if (found_i != NULL_NODE)
+    {
+#ifdef TREE_CONCURRENT
+        tree_write_lock(tree, found_i);
+#endif // TREE_CONCURRENT
+
+        TREE_STORE(tree_cold(tree, found_i)->value, value);
+
+#ifdef TREE_CONCURRENT
+        tree_write_unlock(tree, found_i);
+#endif // TREE_CONCURRENT
+
+        // Структура дерева не изменилась, перебалансировка не требуется.
+        return RET_OK;
+    }
+
+    // Выделяем новый узел для несуществующего ключа.
+    Node_t allocated_id;
+    RetCode ret = tree_node_allocate(tree, &allocated_id);
+    if (ret != RET_OK)
+    {
+        // Структура дерева не изменилась, перебалансировка не требуется.
+        return ret;
+    }
+
+    // Инициализируем выделенный узел до его связывания с деревом.
+    TreeNode*     allocated      = tree_get(tree, allocated_id);
+    TreeNodeCold* allocated_cold = tree_cold(tree, allocated_id);
+
+    allocated_cold->parent_id = parent_id;
+    TREE_STORE(allocated->key,        key);
+    TREE_STORE(allocated_cold->value, value);
+
+#ifdef TREE_CONCURRENT
+    tree_write_lock(tree, parent_id);
+#endif // TREE_CONCURRENT
+
+    // Выставляем родителя для нового узла.
+    if (tree->root_id == NULL_NODE)
+    {   // Новый узел является корневым.
+        TREE_STORE(tree->root_id, allocated_id);
+    }
+    else
+    {   // Новый узел является внутренним или листовым.
+        TreeNode* parent = tree_get(tree, parent_id);
+        if (key < parent->key)
+        {
+            TREE_STORE(parent->left_id, allocated_id);
+        }
+        else
+        {
+            TREE_STORE(parent->right_id, allocated_id);
+        }
+    }
+
+#ifdef TREE_CONCURRENT
+    tree_write_unlock(tree, parent_id);
+#endif // TREE_CONCURRENT
+
+    // Производим балансировку дерева, начиная с добавленного узла.
+    tree_balance(tree, allocated_id);
+
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_remove
+// Назначение: Удаляет ключ из дерева с возвратом значения.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree  (in)  - бинарное дерево поиска.
+// key   (in)  - ключ, по которому производится удаление значения.
+// ret   (out) - значение для ключа.
+// found (out) - флаг успешности поиска ключа в дереве.
+//
+// Возвращаемое значение:
+// код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+RetCode tree_remove(Tree* tree, Key_t key, Value_t* ret, bool* found)
+{
+    if (tree == NULL || ret == NULL || found == NULL)
+    {
+        return RET_INVAL;
+    }
+
+#ifdef TREE_CONCURRENT
+    verify_contract(tree->sync == NULL || tree->sync->writing,
+        "tree_remove: use tree_remove_concurrent in concurrent access mode\n");
+#endif // TREE_CONCURRENT
+
+    // Производим поиск по ключу.
+    Node_t selected_parent_id = NULL_NODE;
+    Node_t selected_id = tree_search_node(tree, key, &selected_parent_id);
+
+    if (selected_id == NULL_NODE)
+    {   // В случае отсутствия ключа в дереве возвращаемся из функции.
+        *found = false;
+        return RET_OK;
+    }
+
+    // Узел, найденный по ключу.
+    TreeNode* selected = tree_get(tree, selected_id);
+
+    if (selected->left_id == NULL_NODE)
+    {   // У найденного узла отсутствует левый дочерный узел.
+        tree_transplant(tree, selected_id, selected->right_id);
+
+        // Выполняем балансировку, начиная с изменённого поддерева.
+        tree_balance(tree, selected_parent_id);
+    }
+    else if (selected->right_id == NULL_NODE)
+    {   // У найденного узла отсутствует правый дочерный узел.
+        tree_transplant(tree, selected_id, selected->left_id);
+
+        // Выполняем балансировку, начиная с изменённого поддерева.
+        tree_balance(tree, selected_parent_id);
+    }
+    else
+    {   // У найденного узла два дочерних узла.
+        // Идентификатор узла с минимальным ключом в правом поддереве.
+        Node_t minimum_id = tree_minimum(tree, selected->right_id);
+
+        // Узел с минимальным ключом в правом поддереве.
+        TreeNode* minimum = tree_get(tree, minimum_id);
+
+        // Родительский узел для узла с минимальным ключом.
+        Node_t minimum_parent_id = tree_cold(tree, minimum_id)->parent_id;
+
+        // Правый дочерний узел для узла с минимальным ключом.
+        Node_t t2_id = minimum->right_id;
+
+        // s = selected_id
+        // m = minimum_id
+        /*   s     >
+         *  / \    >   m
+         * T1 ...  >  / \
+         *    /    > T1 ...
+         *   m     >    /
+         *    \    >   T2
+         *     T2  >
+         */
+
+#ifdef TREE_CONCURRENT
+        if (tree->sync != NULL)
+        {   // Узел minimum переносится вверх по дереву: читатели, не нашедшие ключ
+            // во время переноса, повторят поиск.
+            tree_version_lock(&tree->sync->move_seq);
+        }
+
+        tree_write_lock(tree, minimum_id);
+#endif // TREE_CONCURRENT
+
+        if (minimum_parent_id != selected_id)
+        {   // Узел minimum не является правым дочерним узлом для узла selected.
+            // Перевязываем поддерево T2 на место узла с минимальным ключом.
+            tree_transplant(tree, minimum_id, t2_id);
+
+            // Связываем узел minimum с правым дочерним узлом узла selected.
+            TREE_STORE(minimum->right_id, selected->right_id);
+            tree_cold(tree, minimum->right_id)->parent_id = minimum_id;
+        }
+
+        // Перевязываем узел minimum на место узла selected.
+        tree_transplant(tree, selected_id, minimum_id);
+
+        // Связываем узел minimum с левым дочерним узлом узла selected.
+        TREE_STORE(minimum->left_id, selected->left_id);
+        tree_cold(tree, minimum->left_id)->parent_id = minimum_id;
+
+#ifdef TREE_CONCURRENT
+        tree_write_unlock(tree, minimum_id);
+
+        if (tree->sync != NULL)
+        {
+            tree_version_unlock(&tree->sync->move_seq);
+        }
+#endif // TREE_CONCURRENT
+
+        // Производим перебалансировку с низшего затронутого узла.
+        if (minimum_parent_id != selected_id)
+        {   // Низшим затронутым узлом является узел с идентификатором minimum_parent_id.
+            tree_balance(tree, minimum_parent_id);
+        }
+        else
+        {   // Низшим затронутым узлом является узел minimum.
+            tree_balance(tree, minimum_id);
+        }
+    }
+
+    // Возвращаем значение из удаляемого узла.
+    *ret = tree_cold(tree, selected_id)->value;
+
+    tree_node_free(tree, selected_id);
+
+    *found = true;
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_build_sorted
+// Назначение: Строит дерево из массива ключей, отсортированного по возрастанию.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree   (in/out) - бинарное дерево поиска, инициализированное функцией tree_alloc.
+// keys   (in)     - массив ключей, строго возрастающих.
+// values (in)     - массив значений для ключей.
+// n      (in)     - количество пар ключ-значение.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Предыдущее содержимое дерева заменяется.
+// - Массив узлов выделяется ровно на n узлов, узлы размещаются в нём в порядке возрастания
+//   ключей. Построение выполняется за O(n) без поворотов, в отличие от O(n log n) для
+//   последовательности вызовов tree_set.
+// - Построенное дерево идеально сбалансировано: высоты поддеревьев отличаются
+//   не более чем на единицу.
+// - В случае неупорядоченных ключей возвращается RET_INVAL, а в случае нехватки памяти -
+//   RET_NOMEM. В обоих случаях дерево не изменяется.
+//==================================================================================================
+RetCode tree_build_sorted(Tree* tree, const Key_t keys[], const Value_t values[], size_t n)
+{
+    if (tree == NULL || (n != 0U && (keys == NULL || values == NULL)) || n >= NULL_NODE)
+    {
+        return RET_INVAL;
+    }
+
+#ifdef TREE_CONCURRENT
+    verify_contract(tree->sync == NULL,
+        "tree_build_sorted: concurrent access mode is enabled\n");
+#endif // TREE_CONCURRENT
+
+    // Проверяем упорядоченность ключей до изменения дерева.
+    for (size_t i = 1U; i < n; ++i)
+    {
+        if (keys[i - 1U] >= keys[i])
+        {
+            return RET_INVAL;
+        }
+    }
+
+    // Перевыделяем массив узлов под точное количество узлов.
+    size_t new_capacity = (n == 0U)? 1U : n;
+    if (new_capacity > tree->capacity && tree_resize_nodes(tree, new_capacity) != RET_OK)
+    {
+        return RET_NOMEM;
+    }
+
+    tree->size      = n;
+    tree->num_slots = n;
+    tree->free_id   = NULL_NODE;
+
+    // Идентификатор узла равен индексу ключа в отсортированном массиве.
+    for (size_t i = 0U; i < n; ++i)
+    {
+        tree_get(tree, i)->key    = keys[i];
+        tree_cold(tree, i)->value = values[i];
+    }
+
+    // Освобождаем лишнюю память (при неудаче остаётся массив большего размера).
+    if (new_capacity < tree->capacity)
+    {
+        tree_resize_nodes(tree, new_capacity);
+    }
+
+    // Связываем узлы в сбалансированное дерево.
+    tree->root_id = tree_build_recursive(tree, 0U, n, NULL_NODE);
+
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_flatten
+// Назначение: Выгружает пары ключ-значение дерева в порядке возрастания ключей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree   (in)  - бинарное дерево поиска.
+// keys   (out) - массив ключей размера не менее tree->size.
+// values (out) - массив значений размера не менее tree->size.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Обход выполняется без рекурсии по ссылкам на родительские узлы за O(n).
+//==================================================================================================
+RetCode tree_flatten(Tree* tree, Key_t keys[], Value_t values[])
+{
+    if (tree == NULL || (tree->size != 0U && (keys == NULL || values == NULL)))
+    {
+        return RET_INVAL;
+    }
+
+    // Начинаем обход с узла с минимальным ключом.
+    Node_t cur_id = (tree->root_id == NULL_NODE)? NULL_NODE : tree_minimum(tree, tree->root_id);
+
+    for (size_t i = 0U; cur_id != NULL_NODE; ++i)
+    {
+        keys[i]   = tree_get(tree, cur_id)->key;
+        values[i] = tree_cold(tree, cur_id)->value;
+
+        cur_id = tree_successor(tree, cur_id);
+    }
+
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_lower_bound
+// Назначение: Находит узел с минимальным ключом, не меньшим заданного.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in) - бинарное дерево поиска.
+// key  (in) - ключ, по которому производится поиск.
+//
+// Возвращаемое значение:
+// Идентификатор найденного узла или NULL_NODE, если все ключи дерева меньше key.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Идентификатор узла служит курсором для tree_next и tree_prev. Ключ и значение узла
+//   доступны через tree_get(tree, node_id)->key и tree_cold(tree, node_id)->value.
+// - Курсор становится недействительным после изменения дерева.
+//==================================================================================================
+Node_t tree_lower_bound(Tree* tree, Key_t key)
+{
+    // Последний пройденный узел с ключом, не меньшим искомого.
+    Node_t found_id = NULL_NODE;
+
+    Node_t cur_id = tree->root_id;
+    while (cur_id != NULL_NODE)
+    {
+        TreeNode* node = tree_get(tree, cur_id);
+
+        if (key == node->key)
+        {   // Узел с искомым ключом - ответ.
+            return cur_id;
+        }
+
+        if (key < node->key)
+        {   // Узел подходит, но в левом поддереве может найтись меньший подходящий ключ.
+            found_id = cur_id;
+            cur_id   = node->left_id;
+        }
+        else
+        {
+            cur_id = node->right_id;
+        }
+    }
+
+    return found_id;
+}
+
+//==================================================================================================
+// Функция: tree_next
+// Назначение: Перемещает курсор к следующему узлу в порядке возрастания ключей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in) - бинарное дерево поиска.
+// node_id (in) - идентификатор узла дерева или NULL_NODE.
+//
+// Возвращаемое значение:
+// Идентификатор следующего узла или NULL_NODE после узла с максимальным ключом.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - NULL_NODE обозначает позицию за краями дерева: следующим за ним считается узел
+//   с минимальным ключом.
+// - Переход выполняется по ссылкам на родительские узлы без рекурсии и выделения памяти,
+//   обход всего дерева занимает O(n).
+//==================================================================================================
+Node_t tree_next(Tree* tree, Node_t node_id)
+{
+    if (node_id == NULL_NODE)
+    {
+        return (tree->root_id == NULL_NODE)? NULL_NODE : tree_minimum(tree, tree->root_id);
+    }
+
+    return tree_successor(tree, node_id);
+}
+
+//==================================================================================================
+// Функция: tree_prev
+// Назначение: Перемещает курсор к предыдущему узлу в порядке возрастания ключей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in) - бинарное дерево поиска.
+// node_id (in) - идентификатор узла дерева или NULL_NODE.
+//
+// Возвращаемое значение:
+// Идентификатор предыдущего узла или NULL_NODE перед узлом с минимальным ключом.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - NULL_NODE обозначает позицию за краями дерева: предыдущим для него считается узел
+//   с максимальным ключом.
+//==================================================================================================
+Node_t tree_prev(Tree* tree, Node_t node_id)
+{
+    if (node_id == NULL_NODE)
+    {
+        return (tree->root_id == NULL_NODE)? NULL_NODE : tree_maximum(tree, tree->root_id);
+    }
+
+    return tree_predecessor(tree, node_id);
+}
+
+//==================================================================================================
+// Функция: tree_range_for_each
+// Назначение: Передаёт функции обратного вызова все пары ключ-значение с ключами из отрезка
+// [lo, hi] в порядке возрастания ключей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree     (in) - бинарное дерево поиска.
+// lo       (in) - нижняя граница ключей (включительно).
+// hi       (in) - верхняя граница ключей (включительно).
+// callback (in) - функция обратного вызова.
+// arg      (in) - пользовательский аргумент функции обратного вызова.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Пары копируются в буфер на стеке и передаются пачками до TREE_RANGE_BATCH пар, поэтому
+//   вызов функции обратного вызова и проверка её результата приходятся на пачку, а не на ключ.
+// - Спуск по дереву выполняется один раз, затем обход идёт по курсору за O(log n + k).
+// - Функция обратного вызова не должна изменять дерево.
+//==================================================================================================
+RetCode tree_range_for_each(Tree* tree, Key_t lo, Key_t hi, TreeRangeCallback callback, void* arg)
+{
+    if (tree == NULL || callback == NULL)
+    {
+        return RET_INVAL;
+    }
+
+    // Буфер пачки пар ключ-значение.
+    Key_t   batch_keys[TREE_RANGE_BATCH];
+    Value_t batch_values[TREE_RANGE_BATCH];
+    size_t  batch_size = 0U;
+
+    for (Node_t cur_id = tree_lower_bound(tree, lo); cur_id != NULL_NODE;
+         cur_id = tree_successor(tree, cur_id))
+    {
+        TreeNode* node = tree_get(tree, cur_id);
+        if (node->key > hi)
+        {
+            break;
+        }
+
+        batch_keys[batch_size]   = node->key;
+        batch_values[batch_size] = tree_cold(tree, cur_id)->value;
+        batch_size += 1U;
+
+        if (batch_size == TREE_RANGE_BATCH)
+        {
+            if (!callback(batch_keys, batch_values, batch_size, arg))
+            {   // Обход прерван функцией обратного вызова.
+                return RET_OK;
+            }
+
+            batch_size = 0U;
+        }
+    }
+
+    // Передаём неполную последнюю пачку.
+    if (batch_size != 0U)
+    {
+        callback(batch_keys, batch_values, batch_size, arg);
+    }
+
+    return RET_OK;
+}
+
+#ifdef TREE_ORDER_STATISTICS
+
+//==================================================================================================
+// Функция: tree_select
+// Назначение: Находит узел с k-м по возрастанию ключом.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in) - бинарное дерево поиска.
+// k    (in) - порядковый номер ключа, начиная с нуля.
+//
+// Возвращаемое значение:
+// Идентификатор найденного узла или NULL_NODE, если k не меньше количества узлов.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Спуск по дереву сравнивает k с размером левого поддерева и выполняется за O(log n).
+// - Найденный узел может служить курсором для tree_next и tree_prev.
+//==================================================================================================
+Node_t tree_select(Tree* tree, size_t k)
+{
+    Node_t cur_id = tree->root_id;
+    while (cur_id != NULL_NODE)
+    {
+        TreeNode* node = tree_get(tree, cur_id);
+
+        // Количество ключей, меньших ключа текущего узла, в его поддереве.
+        size_t left_size = tree_subtree_size(tree, node->left_id);
+
+        if (k == left_size)
+        {
+            return cur_id;
+        }
+
+        if (k < left_size)
+        {
+            cur_id = node->left_id;
+        }
+        else
+        {   // Пропускаем левое поддерево и текущий узел.
+            k -= left_size + 1U;
+            cur_id = node->right_id;
+        }
+    }
+
+    return NULL_NODE;
+}
+
+//==================================================================================================
+// Функция: tree_rank
+// Назначение: Вычисляет количество ключей дерева, меньших заданного.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in) - бинарное дерево поиска.
+// key  (in) - ключ, который может отсутствовать в дереве.
+//
+// Возвращаемое значение:
+// Количество ключей, меньших key (для присутствующего ключа - его порядковый номер).
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Вычисляется за O(log n): при переходе в правое поддерево учитываются левое поддерево
+//   и текущий узел.
+//==================================================================================================
+size_t tree_rank(Tree* tree, Key_t key)
+{
+    size_t rank = 0U;
+
+    Node_t cur_id = tree->root_id;
+    while (cur_id != NULL_NODE)
+    {
+        TreeNode* node = tree_get(tree, cur_id);
+
+        if (key == node->key)
+        {
+            return rank + tree_subtree_size(tree, node->left_id);
+        }
+
+        if (key < node->key)
+        {
+            cur_id = node->left_id;
+        }
+        else
+        {
+            rank += tree_subtree_size(tree, node->left_id) + 1U;
+            cur_id = node->right_id;
+        }
+    }
+
+    return rank;
+}
+
+#endif // TREE_ORDER_STATISTICS
+
+//==================================================================================================
+// Функция: tree_merge
+// Назначение: Добавляет в дерево все пары ключ-значение другого дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree  (in/out) - бинарное дерево поиска, в которое добавляются элементы.
+// other (in)     - бинарное дерево поиска, элементы которого добавляются.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Оба дерева выгружаются в отсортированные массивы, массивы сливаются, после чего дерево
+//   tree перестраивается функцией tree_build_sorted. Слияние выполняется за O(n + m)
+//   вместо O(m log(n + m)) для вставки элементов по одному.
+// - Для совпадающих ключей сохраняется значение из дерева other (как при вызове tree_set).
+// - Дерево other не изменяется.
+//==================================================================================================
+RetCode tree_merge(Tree* tree, Tree* other)
+{
+    if (tree == NULL || other == NULL || tree == other)
+    {
+        return RET_INVAL;
+    }
+
+    size_t tree_size  = tree->size;
+    size_t other_size = other->size;
+    if (other_size == 0U)
+    {   // Добавлять нечего.
+        return RET_OK;
+    }
+
+    // Элементы дерева tree выгружаются в конец общего массива, а элементы дерева other -
+    // в отдельный массив. Слияние пишет в начало общего массива и не обгоняет чтение.
+    Key_t*   merged_keys   = calloc(tree_size + other_size, sizeof(Key_t));
+    Value_t* merged_values = calloc(tree_size + other_size, sizeof(Value_t));
+    Key_t*   other_keys    = calloc(other_size, sizeof(Key_t));
+    Value_t* other_values  = calloc(other_size, sizeof(Value_t));
+
+    RetCode ret = RET_NOMEM;
+    if (merged_keys != NULL && merged_values != NULL && other_keys != NULL && other_values != NULL)
+    {
+        tree_flatten(tree,  merged_keys + other_size, merged_values + other_size);
+        tree_flatten(other, other_keys, other_values);
+
+        // Индексы чтения из двух отсортированных последовательностей и индекс записи.
+        size_t tree_i  = other_size;
+        size_t other_i = 0U;
+        size_t merged_i = 0U;
+
+        while (tree_i < tree_size + other_size || other_i < other_size)
+        {
+            if (other_i == other_size ||
+                (tree_i < tree_size + other_size && merged_keys[tree_i] < other_keys[other_i]))
+            {   // Следующий ключ берётся из дерева tree.
+                merged_keys[merged_i]   = merged_keys[tree_i];
+                merged_values[merged_i] = merged_values[tree_i];
+                tree_i += 1U;
+            }
+            else
+            {   // Следующий ключ берётся из дерева other, совпадающий ключ дерева tree пропускается.
+                if (tree_i < tree_size + other_size && merged_keys[tree_i] == other_keys[other_i])
+                {
+                    tree_i += 1U;
+                }
+
+                merged_keys[merged_i]   = other_keys[other_i];
+                merged_values[merged_i] = other_values[other_i];
+                other_i += 1U;
+            }
+
+            merged_i += 1U;
+        }
+
+        ret = tree_build_sorted(tree, merged_keys, merged_values, merged_i);
+    }
+
+    free(merged_keys);
+    free(merged_values);
+    free(other_keys);
+    free(other_values);
+
+    return ret;
+}
+
+//==================================================================================================
+// Функция: tree_relayout
+// Назначение: Перенумеровывает узлы дерева так, чтобы порядок узлов в памяти соответствовал
+// структуре дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree   (in/out) - бинарное дерево поиска.
+// layout (in)     - порядок размещения узлов.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Вставка занимает места удалённых узлов (см. tree_slot_allocate), поэтому после серии
+//   изменений соседние в дереве узлы оказываются в произвольных местах массива и поиск
+//   обращается к новой кеш-линии почти на каждом уровне. После перенумерации узлы верхних
+//   уровней (TREE_LAYOUT_BFS) или близкие поддеревья (TREE_LAYOUT_VEB) лежат рядом.
+// - Перенумерация выполняется за O(n) (O(n log log n) для TREE_LAYOUT_VEB) с временным
+//   выделением памяти под копию узлов дерева. Её имеет смысл вызывать периодически или
+//   при превышении порога, вычисленного функцией tree_fragmentation.
+// - Все ранее полученные идентификаторы узлов становятся недействительными, узлы занимают
+//   первые tree->size мест массива (как после tree_compact).
+// - В случае нехватки памяти возвращается RET_NOMEM, дерево не изменяется.
+//==================================================================================================
+RetCode tree_relayout(Tree* tree, TreeLayout layout)
+{
+    if (tree == NULL || (layout != TREE_LAYOUT_BFS && layout != TREE_LAYOUT_VEB))
+    {
+        return RET_INVAL;
+    }
+
+#ifdef TREE_CONCURRENT
+    verify_contract(tree->sync == NULL,
+        "tree_relayout: concurrent access mode is enabled\n");
+#endif // TREE_CONCURRENT
+
+    if (tree->size == 0U)
+    {   // Пустое дерево не требует перенумерации.
+        return RET_OK;
+    }
+
+    // Идентификаторы узлов в новом порядке: order[новый идентификатор] = старый идентификатор.
+    Node_t* order = calloc(tree->size, sizeof(Node_t));
+    // Отображение старых идентификаторов в новые.
+    Node_t* new_ids = calloc(tree->num_slots, sizeof(Node_t));
+    // Копия узлов в новом порядке.
+    TreeNode* new_nodes = calloc(tree->size, sizeof(TreeNode));
+#ifdef TREE_SOA
+    // Копия холодных полей узлов в новом порядке.
+    TreeNodeCold* new_cold = calloc(tree->size, sizeof(TreeNodeCold));
+#else
+    // При совместном хранении холодные поля находятся в массиве узлов.
+    TreeNodeCold* new_cold = new_nodes;
+#endif // TREE_SOA
+
+    if (order == NULL || new_ids == NULL || new_nodes == NULL || new_cold == NULL)
+    {
+        free(order);
+        free(new_ids);
+        free(new_nodes);
+#ifdef TREE_SOA
+        free(new_cold);
+#endif // TREE_SOA
+
+        return RET_NOMEM;
+    }
+
+    // Вычисляем новый порядок узлов.
+    if (layout == TREE_LAYOUT_BFS)
+    {
+        tree_layout_bfs(tree, order);
+    }
+    else
+    {
+        size_t count = 0U;
+        tree_layout_veb(tree, tree->root_id, tree_height(tree, tree->root_id), order, &count);
+    }
+
+    for (size_t new_id = 0U; new_id < tree->size; ++new_id)
+    {
+        new_ids[order[new_id]] = new_id;
+    }
+
+    // Копируем узлы в новом порядке с перенумерацией связей.
+    for (size_t new_id = 0U; new_id < tree->size; ++new_id)
+    {
+        TreeNode*     node      = &new_nodes[new_id];
+        TreeNodeCold* node_cold = &new_cold[new_id];
+
+        *node = *tree_get(tree, order[new_id]);
+#ifdef TREE_SOA
+        *node_cold = *tree_cold(tree, order[new_id]);
+#endif // TREE_SOA
+
+        node_cold->parent_id = (node_cold->parent_id == NULL_NODE)?
+                               NULL_NODE : new_ids[node_cold->parent_id];
+        node->left_id  = (node->left_id  == NULL_NODE)? NULL_NODE : new_ids[node->left_id];
+        node->right_id = (node->right_id == NULL_NODE)? NULL_NODE : new_ids[node->right_id];
+    }
+
+    tree->root_id = new_ids[tree->root_id];
+
+    // Записываем узлы на места с новыми идентификаторами.
+    for (size_t new_id = 0U; new_id < tree->size; ++new_id)
+    {
+        *tree_get(tree, new_id) = new_nodes[new_id];
+#ifdef TREE_SOA
+        *tree_cold(tree, new_id) = new_cold[new_id];
+#endif // TREE_SOA
+    }
+
+    // Свободные узлы остаются за последним занятым узлом.
+    tree->num_slots = tree->size;
+    tree->free_id   = NULL_NODE;
+
+    free(order);
+    free(new_ids);
+    free(new_nodes);
+#ifdef TREE_SOA
+    free(new_cold);
+#endif // TREE_SOA
+
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_compact
+// Назначение: Восстанавливает плотную нумерацию узлов дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in/out) - бинарное дерево поиска.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Удаление узла не изменяет идентификаторы остальных узлов, а его место занимает следующая
+//   вставка. Функция переносит последние занятые узлы массива на места свободных узлов, после
+//   чего идентификаторы узлов принимают значения от 0 до tree->size - 1, а лишняя память
+//   освобождается.
+// - Идентификаторы перенесённых узлов становятся недействительными.
+// - Выполняется за O(tree->num_slots) без выделения памяти.
+//==================================================================================================
+RetCode tree_compact(Tree* tree)
+{
+    if (tree == NULL)
+    {
+        return RET_INVAL;
+    }
+
+#ifdef TREE_CONCURRENT
+    verify_contract(tree->sync == NULL,
+        "tree_compact: concurrent access mode is enabled\n");
+#endif // TREE_CONCURRENT
+
+    // Переносим последние занятые узлы массива на места свободных узлов.
+    Node_t last_id = tree->num_slots;
+    for (Node_t hole_id = 0U; hole_id < tree->size; ++hole_id)
     {
-        if (state[level - 1U] == 0)
+        if (!tree_slot_is_free(tree, hole_id))
         {
-            state[level - 1U] = 1;
+            continue;
         }
 
-        switch (state[level - 1U])
+        do
         {
-            case 1:
-                printf(" ┌────");
-                break;
-            case 2:
-                printf(" └────");
-                break;
-            case 3:
-                printf("      ");
-                break;
-            default: break;
+            last_id -= 1U;
         }
+        while (tree_slot_is_free(tree, last_id));
 
-        if (state[level - 1U] == 2)
-        {
-            state[level - 1U] = 3;
-        }
+        tree_node_move(tree, last_id, hole_id);
     }
 
-    // Печатаем текущий узел.
-    if (node == NULL)
-    {
-        printf("0\n");
-    }
-    else
+    tree->num_slots = tree->size;
+    tree->free_id   = NULL_NODE;
+
+    // Освобождаем лишнюю память (при неудаче остаётся массив большего размера).
+    size_t new_capacity = (tree->size == 0U)? 1U : tree->size;
+    if (new_capacity < tree->capacity)
     {
-        printf("[%d](%d)\n", node->key, node->height);
+        tree_resize_nodes(tree, new_capacity);
     }
 
-    // Рекурсивно печатаем правое поддерево.
-    state[level] = 2;
-    if (node != NULL)
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_fragmentation
+// Назначение: Оценивает рассогласованность порядка узлов в памяти и структуры дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in) - бинарное дерево поиска.
+//
+// Возвращаемое значение:
+// Доля связей от узла к дочернему узлу, ведущих в другую кеш-линию (от 0 до 1).
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Номер кеш-линии узла оценивается по смещению узла от начала массива nodes
+//   (см. TREE_CACHE_LINE_SIZE).
+// - Свободные узлы не учитываются.
+// - Вычисляется за O(n) и может использоваться для решения о вызове tree_relayout.
+//==================================================================================================
+double tree_fragmentation(Tree* tree)
+{
+    // Количество связей от узла к дочернему узлу.
+    size_t num_links = 0U;
+    // Количество связей, ведущих в другую кеш-линию.
+    size_t num_crossing = 0U;
+
+    for (size_t node_id = 0U; node_id < tree->num_slots; ++node_id)
     {
-        tree_print_recursive(tree, node->left_id, level + 1U, state);
+        if (tree_slot_is_free(tree, node_id))
+        {
+            continue;
+        }
+
+        TreeNode* node = tree_get(tree, node_id);
+
+        // Кеш-линия узла.
+        size_t line = node_id * sizeof(TreeNode) / TREE_CACHE_LINE_SIZE;
+
+        Node_t child_ids[2U] = {node->left_id, node->right_id};
+        for (size_t child_i = 0U; child_i < 2U; ++child_i)
+        {
+            if (child_ids[child_i] == NULL_NODE)
+            {
+                continue;
+            }
+
+            num_links += 1U;
+            if (child_ids[child_i] * sizeof(TreeNode) / TREE_CACHE_LINE_SIZE != line)
+            {
+                num_crossing += 1U;
+            }
+        }
     }
-    state[level] = 3;
-}
 
-// Предварительная декларация функции для печати.
-void tree_print(Tree* tree);
+    return (num_links == 0U)? 0.0 : (double) num_crossing / num_links;
+}
 
 //==================================================================================================
-// Функция: tree_balance
-// Назначение: Производит перебалансировку дерева от нижнего узла к верхнему.
+// Функция: tree_check
+// Назначение: Проверяет инварианты АВЛ-дерева.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// tree        (in) - бинарное дерево поиска.
-// unbalanced_id (in) - идентификатор узла, с которого требуется начинать перебалансировку.
+// tree (in) - бинарное дерево поиска.
 //
 // Возвращаемое значение:
-// код возврата.
+// Флаг корректности дерева.
 //
 // Используемые внешние переменные:
 // отсутствуют
 //
 // Примечания:
-// отсутствуют
+// - Проверяются связи узлов с родителями, строгое возрастание ключей при обходе,
+//   соответствие количества узлов полю size, сохранённые высоты и баланс поддеревьев.
 //==================================================================================================
-void tree_balance(Tree* tree, Node_t unbalanced_id)
+bool tree_check(Tree* tree)
 {
-    if (unbalanced_id == NULL_NODE)
+    if (tree_check_recursive(tree, tree->root_id, NULL_NODE) < 0)
     {
-        // Для узла-пустышки балансировка уже выполнена.
-        return;
+        return false;
     }
 
-    // Производим итеративную балансировку дерева.
-    do
+    // Количество узлов, пройденных при обходе.
+    size_t count = 0U;
+
+    Node_t cur_id = (tree->root_id == NULL_NODE)? NULL_NODE : tree_minimum(tree, tree->root_id);
+    while (cur_id != NULL_NODE)
     {
-        // Узел, являющийся текущим кандидатом на перебалансировку.
-        TreeNode* unbalanced = tree_get(tree, unbalanced_id);
+        Node_t next_id = tree_successor(tree, cur_id);
+        if (next_id != NULL_NODE && tree_get(tree, cur_id)->key >= tree_get(tree, next_id)->key)
+        {
+            return false;
+        }
 
-        // Родительский узел для итогового поддерева.
-        Node_t parent_id = unbalanced->parent_id;
+        count += 1U;
+        cur_id = next_id;
+    }
 
-        // Вычисляем разность высот левого и правого поддеревьев.
-        int32_t balance_factor = tree_balance_factor(tree, unbalanced_id);
+    return count == tree->size;
+}
 
-        // Проверяем необходимость балансировки.
-        if (balance_factor > 1)
-        {   // Левое поддерево значительно выше правого.
-            // Идентификатор корня левого поддерева.
-            Node_t left_id = unbalanced->left_id;
+//==================================================================================================
+// Функция: tree_print
+// Назначение: Производит печать дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in) - бинарное дерево поиска.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+void tree_print(Tree* tree)
+{
+    int state[MAX_PRINT_DEPTH + 1U] = {};
 
-            // Проверяем баланс левого поддерева.
-            if (tree_balance_factor(tree, left_id) < 0)
-            {
-                // u = unbalanced_id
-                // l = left_id
-                /*     u     >       u
-                 *    / \    >      / \
-                 *   l   T4  >     x   T4
-                 *  / \      >    / \
-                 * T1  x     >   l  T3
-                 *    / \    >  / \
-                 *   T2 T3   > T1 T2
-                 */
+    Node_t root_id = tree->root_id;
+    tree_print_recursive(tree, root_id, 0U, state);
+}
 
-                // Производим дополнительный обратный поворот.
-                tree_rotate_left(tree, left_id);
-            }
+#ifdef TREE_CONCURRENT
 
-            // u = unbalanced_id
-            // l = left_id
-            /*       u    >      l
-             *      / \   >     / \
-             *     l   T4 >    /   \
-             *    / \     >   x     u
-             *   x  T3    >  / \   / \
-             *  / \       > T1 T2 T3 T4
-             * T1 T2      >
-             */
+//===============================//
+// Одновременный доступ к дереву //
+//===============================//
 
-            // Производим прямой поворот.
-            tree_rotate_right(tree, unbalanced_id);
+//==================================================================================================
+// Функция: tree_epoch_enter
+// Назначение: Регистрирует читателя в текущей эпохе.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// sync (in/out) - состояние режима одновременного доступа.
+//
+// Возвращаемое значение:
+// Указатель на счётчик активных читателей, увеличенный для текущего потока.
+//
+// Используемые внешние переменные:
+// tree_reader_stripe      - номер счётчика активных читателей текущего потока.
+// tree_num_reader_threads - количество потоков-читателей.
+//
+// Примечания:
+// - Если писатель сменил эпоху между чтением эпохи и увеличением счётчика, регистрация
+//   повторяется: зарегистрированный читатель всегда относится к эпохе epoch или epoch - 1.
+//==================================================================================================
+uint64_t* tree_epoch_enter(TreeSync* sync)
+{
+    if (tree_reader_stripe == TREE_READER_STRIPES)
+    {   // Первый поиск в текущем потоке.
+        tree_reader_stripe =
+            __atomic_fetch_add(&tree_num_reader_threads, 1U, __ATOMIC_RELAXED) % TREE_READER_STRIPES;
+    }
+
+    TreeReaderStripe* stripe = &sync->readers[tree_reader_stripe];
+
+    while (true)
+    {
+        uint64_t epoch = __atomic_load_n(&sync->epoch, __ATOMIC_SEQ_CST);
+        uint64_t* active = &stripe->active[epoch & 1U];
+
+        __atomic_fetch_add(active, 1U, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&sync->epoch, __ATOMIC_SEQ_CST) == epoch)
+        {
+            return active;
         }
-        else if (balance_factor < -1)
-        {   // Правое поддерево значительно выше левого.
-            // Идентификатор корня правого поддерева.
-            Node_t right_id = unbalanced->right_id;
 
-            // Проверяем баланс правого поддерева.
-            if (tree_balance_factor(tree, right_id) > 0)
-            {
-                // u = unbalanced_id
-                // r = right_id
-                /*    u     >   u
-                 *   / \    >  / \
-                 *  T1  r   > T1  r
-                 *     / \  >    / \
-                 *    x  T4 >   T2  x
-                 *   / \    >      / \
-                 *  T2 T3   >     T3 T4
-                 */
+        __atomic_fetch_sub(active, 1U, __ATOMIC_RELEASE);
+    }
+}
 
-                // Производим дополнительный обратный поворот.
-                tree_rotate_right(tree, right_id);
-            }
+//==================================================================================================
+// Функция: tree_epoch_exit
+// Назначение: Снимает регистрацию читателя после завершения поиска.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// active (in/out) - счётчик, возвращённый функцией tree_epoch_enter.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+void tree_epoch_exit(uint64_t* active)
+{
+    __atomic_fetch_sub(active, 1U, __ATOMIC_RELEASE);
+}
 
-            // u = unbalanced_id
-            // r = right_id
-            /*   u       >      r
-             *  / \      >     / \
-             * T1  r     >    /   \
-             *    / \    >   u     x
-             *   T2  x   >  / \   / \
-             *      / \  > T1 T2 T3 T4
-             *     T3 T4 >
-             */
+//==================================================================================================
+// Функция: tree_epoch_reclaim
+// Назначение: Переходит к следующей эпохе и освобождает объекты, недоступные читателям.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in/out) - бинарное дерево поиска в режиме одновременного доступа.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Вызывается писателем, захватившим блокировку дерева.
+// - Эпоха увеличивается, когда завершились все читатели предыдущей эпохи. Объект, исключённый
+//   из дерева в эпоху e, мог застать только читатель эпохи не позже e, поэтому в эпоху e + 2
+//   объект освобождается: узел добавляется в список свободных узлов, массив узлов - в free.
+//==================================================================================================
+void tree_epoch_reclaim(Tree* tree)
+{
+    TreeSync* sync = tree->sync;
 
-            // Производим прямой поворот.
-            tree_rotate_left(tree, unbalanced_id);
+    // Счётчики читателей предыдущей эпохи.
+    uint64_t previous = (sync->epoch - 1U) & 1U;
+
+    bool drained = true;
+    for (size_t stripe_i = 0U; stripe_i < TREE_READER_STRIPES && drained; ++stripe_i)
+    {
+        drained = __atomic_load_n(&sync->readers[stripe_i].active[previous], __ATOMIC_SEQ_CST) == 0U;
+    }
+
+    if (drained)
+    {
+        __atomic_store_n(&sync->epoch, sync->epoch + 1U, __ATOMIC_SEQ_CST);
+    }
+
+    // Количество освобождённых объектов.
+    size_t num_reclaimed = 0U;
+    while (num_reclaimed < sync->num_retired && sync->retired[num_reclaimed].epoch + 2U <= sync->epoch)
+    {
+        TreeRetired* retired = &sync->retired[num_reclaimed];
+
+        if (retired->nodes != NULL)
+        {
+            free(retired->nodes);
         }
         else
+        {   // Добавляем узел в начало списка свободных узлов.
+            tree_slot_release(tree, retired->node_id);
+        }
+
+        num_reclaimed += 1U;
+    }
+
+    sync->num_retired -= num_reclaimed;
+    memmove(sync->retired, sync->retired + num_reclaimed, sync->num_retired * sizeof(TreeRetired));
+}
+
+//==================================================================================================
+// Функция: tree_write_begin
+// Назначение: Начинает изменение дерева в режиме одновременного доступа.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in/out) - бинарное дерево поиска в режиме одновременного доступа.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Резервирует место для исключения из дерева одного узла и одного массива узлов,
+//   чтобы изменение дерева не прерывалось нехваткой памяти.
+// - В случае нехватки памяти возвращается RET_NOMEM, блокировка дерева не удерживается.
+//==================================================================================================
+RetCode tree_write_begin(Tree* tree)
+{
+    TreeSync* sync = tree->sync;
+    verify_contract(sync != NULL,
+        "tree_write_begin: concurrent access mode is not enabled\n");
+
+    int ret = pthread_mutex_lock(&sync->write_lock);
+    verify_contract(ret == 0,
+        "tree_write_begin: unable to lock mutex\n");
+
+    if (sync->num_retired + 2U > sync->retired_capacity)
+    {
+        size_t new_capacity = 2U * sync->retired_capacity + 2U;
+
+        TreeRetired* new_retired = realloc(sync->retired, new_capacity * sizeof(TreeRetired));
+        if (new_retired == NULL)
         {
-            // Вычисляем высоту текущего кандидата на перебалансировку.
-            unbalanced->height = max(tree_height(tree, unbalanced->left_id), tree_height(tree, unbalanced->right_id)) + 1;
+            pthread_mutex_unlock(&sync->write_lock);
+            return RET_NOMEM;
         }
 
-        tree_print(tree);
-        printf("\n");
-        sleep(1);
-
-        // Переходим к рассмотрению родительского узла.
-        unbalanced_id = parent_id;
+        sync->retired          = new_retired;
+        sync->retired_capacity = new_capacity;
     }
-    while (unbalanced_id != NULL_NODE);
+
+    sync->writing = true;
+
+    return RET_OK;
 }
 
+//==================================================================================================
+// Функция: tree_write_end
+// Назначение: Завершает изменение дерева в режиме одновременного доступа.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in/out) - бинарное дерево поиска в режиме одновременного доступа.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+void tree_write_end(Tree* tree)
+{
+    TreeSync* sync = tree->sync;
+
+    sync->writing = false;
 
-//============================//
-// Пользовательский интерфейс //
-//============================//
+    tree_epoch_reclaim(tree);
+
+    int ret = pthread_mutex_unlock(&sync->write_lock);
+    verify_contract(ret == 0,
+        "tree_write_end: unable to unlock mutex\n");
+}
 
 //==================================================================================================
-// Функция: tree_search
-// Назначение: Находит значение в дереве по ключу.
+// Функция: tree_search_optimistic
+// Назначение: Однократно производит поиск ключа без блокировок.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// tree  (in)  - бинарное дерево поиска.
+// tree  (in)  - бинарное дерево поиска в режиме одновременного доступа.
 // key   (in)  - ключ, по которому производится поиск.
 // res   (out) - значение по ключу (выходной аргумент).
 // found (out) - флаг успешности поиска в дереве (выходной аргумент).
 //
 // Возвращаемое значение:
-// код возврата.
+// FALSE, если поиск пересёкся с изменением дерева и его нужно повторить.
 //
 // Используемые внешние переменные:
 // отсутствуют
 //
 // Примечания:
-// отсутствуют
+// - Переход к дочернему узлу подтверждается повторным чтением версии родительского узла
+//   после чтения версии дочернего узла (optimistic lock coupling): если родитель
+//   не изменялся, дочерний узел был связан с ним в момент чтения его версии.
+// - Повороты изменяют версии опускающихся узлов, поэтому ключ не может покинуть поддерево
+//   пройденного узла незамеченным. Исключение - перенос узла вверх при удалении
+//   (см. tree_remove), который отслеживается счётчиком перемещений: отсутствие ключа
+//   подтверждается, только если перемещений не было.
+// - Массив узлов считывается один раз: заменённый массив не изменяется писателями
+//   и не освобождается до выхода читателя из эпохи.
 //==================================================================================================
-RetCode tree_search(Tree* tree, Key_t key, Value_t* res, bool* found)
+bool tree_search_optimistic(Tree* tree, Key_t key, Value_t* res, bool* found)
 {
-    if (tree == NULL || res == NULL || found == NULL)
+    TreeSync* sync = tree->sync;
+
+    // Счётчик перемещений и версия корня на момент начала поиска.
+    uint32_t move_seq = __atomic_load_n(&sync->move_seq,     __ATOMIC_ACQUIRE);
+    uint32_t root_seq = __atomic_load_n(&sync->root_version, __ATOMIC_ACQUIRE);
+    if (((move_seq | root_seq) & 1U) != 0U)
     {
-        return RET_INVAL;
+        return false;
     }
 
-    Node_t parent_id = NULL_NODE;
-    Node_t found_id = tree_search_node(tree, key, &parent_id);
-    if (found_id == NULL_NODE)
+    TreeNode* nodes = __atomic_load_n(&tree->nodes,   __ATOMIC_ACQUIRE);
+    Node_t   cur_id = __atomic_load_n(&tree->root_id, __ATOMIC_RELAXED);
+
+    // Корневой узел должен принадлежать прочитанному массиву узлов.
+    if (!tree_read_validate(&sync->root_version, root_seq))
     {
-        *found = false;
-        return RET_OK;
+        return false;
     }
 
-    TreeNode* found_node = tree_get(tree, found_id);
-    *res = found_node->value;
+    // Версия, защищающая связь с текущим узлом, и её прочитанное значение.
+    const uint32_t* parent_version = &sync->root_version;
+    uint32_t        parent_seen    = root_seq;
 
-    *found = true;
-    return RET_OK;
+    while (cur_id != NULL_NODE)
+    {
+        TreeNode* node = &nodes[cur_id];
+
+        uint32_t version = __atomic_load_n(&node->version, __ATOMIC_ACQUIRE);
+        if ((version & 1U) != 0U || !tree_read_validate(parent_version, parent_seen))
+        {
+            return false;
+        }
+
+        Key_t node_key = __atomic_load_n(&node->key, __ATOMIC_RELAXED);
+        if (key == node_key)
+        {
+            Value_t value = __atomic_load_n(&node->value, __ATOMIC_RELAXED);
+            if (!tree_read_validate(&node->version, version))
+            {
+                return false;
+            }
+
+            *res   = value;
+            *found = true;
+            return true;
+        }
+
+        cur_id = __atomic_load_n((key < node_key)? &node->left_id : &node->right_id,
+                                 __ATOMIC_RELAXED);
+
+        parent_version = &node->version;
+        parent_seen    = version;
+    }
+
+    if (!tree_read_validate(parent_version, parent_seen) ||
+        !tree_read_validate(&sync->move_seq, move_seq))
+    {
+        return false;
+    }
+
+    *found = false;
+    return true;
 }
 
 //==================================================================================================
-// Функция: tree_set
-// Назначение: Выставляет значение в дереве по ключу.
+// Функция: tree_concurrent_enable
+// Назначение: Включает режим одновременного доступа к дереву из нескольких потоков.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// tree  (in) - бинарное дерево поиска.
-// key   (in) - ключ, по которому производится поиск значения.
-// value (in) - новое значение для заданного ключа.
+// tree (in/out) - бинарное дерево поиска.
 //
 // Возвращаемое значение:
-// код возврата.
+// Код возврата.
 //
 // Используемые внешние переменные:
 // отсутствуют
 //
 // Примечания:
-// отсутствуют
+// - Вызывается, когда ни один другой поток не обращается к дереву.
+// - В этом режиме читатели вызывают tree_search_concurrent и не блокируют ни друг друга,
+//   ни писателей. Писатели вызывают tree_set_concurrent и tree_remove_concurrent
+//   и упорядочиваются блокировкой дерева.
+// - Места удалённых узлов переиспользуются только после завершения читателей,
+//   которые могли их застать. Остальные функции изменения дерева (tree_build_sorted,
+//   tree_merge, tree_relayout) в этом режиме недоступны.
 //==================================================================================================
-RetCode tree_set(Tree* tree, Key_t key, Value_t value)
+RetCode tree_concurrent_enable(Tree* tree)
 {
     if (tree == NULL)
     {
         return RET_INVAL;
     }
 
-    // Производим поиск значения по ключу.
-    Node_t parent_id = NULL_NODE;
-    Node_t found_i = tree_search_node(tree, key, &parent_id);
-
-    // Обновляем значение уже существующего узла.
-    if (found_i != NULL_NODE)
+    if (tree->sync != NULL)
     {
-        TreeNode* found = tree_get(tree, found_i);
-        found->value = value;
-
-        // Структура дерева не изменилась, перебалансировка не требуется.
         return RET_OK;
     }
 
-    // Выделяем новый узел для несуществующего ключа.
-    Node_t allocated_id;
-    RetCode ret = tree_node_allocate(tree, &allocated_id);
-    if (ret != RET_OK)
+    TreeSync* sync = NULL;
+    if (posix_memalign((void**) &sync, sizeof(TreeReaderStripe), sizeof(TreeSync)) != 0)
     {
-        // Структура дерева не изменилась, перебалансировка не требуется.
-        return ret;
+        return RET_NOMEM;
     }
 
-    // Выставляем родителя для нового узла.
-    if (tree->root_id == NULL_NODE)
-    {   // Новый узел является корневым.
-        tree->root_id = allocated_id;
-    }
-    else
-    {   // Новый узел является внутренним или листовым.
-        TreeNode* parent = tree_get(tree, parent_id);
-        if (key < parent->key)
-        {
-            parent->left_id = allocated_id;
-        }
-        else
-        {
-            parent->right_id = allocated_id;
-        }
-    }
+    memset(sync, 0, sizeof(TreeSync));
 
-    // Инициализируем выделенный узел.
-    TreeNode* allocated = tree_get(tree, allocated_id);
+    int ret = pthread_mutex_init(&sync->write_lock, NULL);
+    verify_contract(ret == 0,
+        "tree_concurrent_enable: unable to initialize mutex\n");
 
-    allocated->parent_id = parent_id;
-    allocated->key       = key;
-    allocated->value     = value;
+    // Версии узлов не поддерживаются вне режима одновременного доступа.
+    for (Node_t node_id = 0U; node_id < tree->num_slots; ++node_id)
+    {
+        tree_get(tree, node_id)->version = 0U;
+    }
 
-    // Производим балансировку дерева, начиная с добавленного узла.
-    tree_balance(tree, allocated_id);
+    tree->sync = sync;
 
     return RET_OK;
 }
 
 //==================================================================================================
-// Функция: tree_remove
-// Назначение: Удаляет ключ из дерева с возвратом значения.
+// Функция: tree_concurrent_disable
+// Назначение: Выключает режим одновременного доступа к дереву.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// tree  (in)  - бинарное дерево поиска.
-// key   (in)  - ключ, по которому производится удаление значения.
-// ret   (out) - значение для ключа.
-// found (out) - флаг успешности поиска ключа в дереве.
+// tree (in/out) - бинарное дерево поиска.
 //
 // Возвращаемое значение:
-// код возврата.
+// Код возврата.
 //
 // Используемые внешние переменные:
 // отсутствуют
 //
 // Примечания:
-// отсутствуют
+// - Вызывается, когда ни один другой поток не обращается к дереву.
+// - Исключённые из дерева узлы сразу добавляются в список свободных узлов, идентификаторы
+//   узлов дерева не изменяются. Плотную нумерацию узлов восстанавливает tree_compact.
 //==================================================================================================
-RetCode tree_remove(Tree* tree, Key_t key, Value_t* ret, bool* found)
+RetCode tree_concurrent_disable(Tree* tree)
 {
-    if (tree == NULL || ret == NULL || found == NULL)
+    if (tree == NULL)
     {
         return RET_INVAL;
     }
 
-    // Производим поиск по ключу.
-    Node_t selected_parent_id = NULL_NODE;
-    Node_t selected_id = tree_search_node(tree, key, &selected_parent_id);
-
-    if (selected_id == NULL_NODE)
-    {   // В случае отсутствия ключа в дереве возвращаемся из функции.
-        *found = false;
+    TreeSync* sync = tree->sync;
+    if (sync == NULL)
+    {
         return RET_OK;
     }
 
-    // Узел, найденный по ключу.
-    TreeNode* selected = tree_get(tree, selected_id);
-
-    if (selected->left_id == NULL_NODE)
-    {   // У найденного узла отсутствует левый дочерный узел.
-        tree_transplant(tree, selected_id, selected->right_id);
-
-        // Выполняем балансировку, начиная с изменённого поддерева.
-        tree_balance(tree, selected_parent_id);
-    }
-    else if (selected->right_id == NULL_NODE)
-    {   // У найденного узла отсутствует правый дочерный узел.
-        tree_transplant(tree, selected_id, selected->left_id);
-
-        // Выполняем балансировку, начиная с изменённого поддерева.
-        tree_balance(tree, selected_parent_id);
+    // Читатели завершились: исключённые узлы больше недоступны.
+    for (size_t i = 0U; i < sync->num_retired; ++i)
+    {
+        if (sync->retired[i].nodes == NULL)
+        {
+            tree_slot_release(tree, sync->retired[i].node_id);
+        }
     }
-    else
-    {   // У найденного узла два дочерних узла.
-        // Идентификатор узла с минимальным ключом в правом поддереве.
-        Node_t minimum_id = tree_minimum(tree, selected->right_id);
 
-        // Узел с минимальным ключом в правом поддереве.
-        TreeNode* minimum = tree_get(tree, minimum_id);
+    tree_sync_release(tree);
 
-        // Родительский узел для узла с минимальным ключом.
-        Node_t minimum_parent_id = minimum->parent_id;
+    return RET_OK;
+}
 
-        // Правый дочерний узел для узла с минимальным ключом.
-        Node_t t2_id = minimum->right_id;
+//==================================================================================================
+// Функция: tree_search_concurrent
+// Назначение: Находит значение в дереве по ключу параллельно с другими потоками.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree  (in)  - бинарное дерево поиска в режиме одновременного доступа.
+// key   (in)  - ключ, по которому производится поиск.
+// res   (out) - значение по ключу (выходной аргумент).
+// found (out) - флаг успешности поиска в дереве (выходной аргумент).
+//
+// Возвращаемое значение:
+// код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Поиск не захватывает блокировок и не изменяет узлы дерева. Если писатель изменил
+//   пройденный узел, поиск повторяется от корня.
+//==================================================================================================
+RetCode tree_search_concurrent(Tree* tree, Key_t key, Value_t* res, bool* found)
+{
+    if (tree == NULL || res == NULL || found == NULL)
+    {
+        return RET_INVAL;
+    }
 
-        // s = selected_id
-        // m = minimum_id
-        /*   s     >
-         *  / \    >   m
-         * T1 ...  >  / \
-         *    /    > T1 ...
-         *   m     >    /
-         *    \    >   T2
-         *     T2  >
-         */
+    TreeSync* sync = tree->sync;
+    verify_contract(sync != NULL,
+        "tree_search_concurrent: concurrent access mode is not enabled\n");
 
-        if (minimum_parent_id != selected_id)
-        {   // Узел minimum не является правым дочерним узлом для узла selected.
-            // Перевязываем поддерево T2 на место узла с минимальным ключом.
-            tree_transplant(tree, minimum_id, t2_id);
+    uint64_t* active = tree_epoch_enter(sync);
 
-            // Связываем узел minimum с правым дочерним узлом узла selected.
-            minimum->right_id = selected->right_id;
-            TreeNode* right = tree_get(tree, minimum->right_id);
-            right->parent_id = minimum_id;
-        }
+    while (!tree_search_optimistic(tree, key, res, found))
+    {   // Уступаем процессор писателю.
+        sched_yield();
+    }
 
-        // Перевязываем узел minimum на место узла selected.
-        tree_transplant(tree, selected_id, minimum_id);
+    tree_epoch_exit(active);
 
-        // Связываем узел minimum с левым дочерним узлом узла selected.
-        minimum->left_id = selected->left_id;
-        TreeNode* left = tree_get(tree, minimum->left_id);
-        left->parent_id = minimum_id;
+    return RET_OK;
+}
 
-        // Производим перебалансировку с низшего затронутого узла.
-        if (minimum_parent_id != selected_id)
-        {   // Низшим затронутым узлом является узел с идентификатором minimum_parent_id.
-            tree_balance(tree, minimum_parent_id);
-        }
-        else
-        {   // Низшим затронутым узлом является узел minimum.
-            tree_balance(tree, minimum_id);
-        }
+//==================================================================================================
+// Функция: tree_set_concurrent
+// Назначение: Выставляет значение в дереве по ключу параллельно с читателями.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree  (in) - бинарное дерево поиска в режиме одновременного доступа.
+// key   (in) - ключ, по которому производится поиск значения.
+// value (in) - новое значение для заданного ключа.
+//
+// Возвращаемое значение:
+// Совпадает с возвращаемым значением tree_set.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+RetCode tree_set_concurrent(Tree* tree, Key_t key, Value_t value)
+{
+    if (tree == NULL)
+    {
+        return RET_INVAL;
     }
 
-    // Возвращаем значение из удаляемого узла.
-    *ret = selected->value;
+    RetCode ret = tree_write_begin(tree);
+    if (ret != RET_OK)
+    {
+        return ret;
+    }
 
-    tree_node_free(tree, selected_id);
+    ret = tree_set(tree, key, value);
+    tree_write_end(tree);
 
-    *found = true;
-    return RET_OK;
+    return ret;
 }
 
 //==================================================================================================
-// Функция: tree_print
-// Назначение: Производит печать дерева.
+// Функция: tree_remove_concurrent
+// Назначение: Удаляет ключ из дерева с возвратом значения параллельно с читателями.
 //--------------------------------------------------------------------------------------------------
 // Параметры:
-// tree (in) - бинарное дерево поиска.
+// tree  (in)  - бинарное дерево поиска в режиме одновременного доступа.
+// key   (in)  - ключ, по которому производится удаление значения.
+// ret   (out) - значение для ключа.
+// found (out) - флаг успешности поиска ключа в дереве.
 //
 // Возвращаемое значение:
-// отсутствует.
+// Совпадает с возвращаемым значением tree_remove.
 //
 // Используемые внешние переменные:
 // отсутствуют
@@ -1134,12 +3688,25 @@ RetCode tree_remove(Tree* tree, Key_t key, Value_t* ret, bool* found)
 // Примечания:
 // отсутствуют
 //==================================================================================================
-void tree_print(Tree* tree)
+RetCode tree_remove_concurrent(Tree* tree, Key_t key, Value_t* ret, bool* found)
 {
-    int state[MAX_PRINT_DEPTH + 1U] = {};
+    if (tree == NULL)
+    {
+        return RET_INVAL;
+    }
 
-    Node_t root_id = tree->root_id;
-    tree_print_recursive(tree, root_id, 0U, state);
+    RetCode code = tree_write_begin(tree);
+    if (code != RET_OK)
+    {
+        return code;
+    }
+
+    code = tree_remove(tree, key, ret, found);
+    tree_write_end(tree);
+
+    return code;
 }
 
+#endif // TREE_CONCURRENT
+
 #endif // HEADER_GUARD_TREE_AVL_H_INCLUDED
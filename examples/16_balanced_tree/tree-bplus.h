@@ -0,0 +1,2000 @@
+// Copyright 2024 Vladislav Aleinik
+#ifndef HEADER_GUARD_TREE_BPLUS_H_INCLUDED
+#define HEADER_GUARD_TREE_BPLUS_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+
+//==================//
+// Структура данных //
+//==================//
+
+// Тип Node_t - идентификатор узла дерева
+typedef uint32_t Node_t;
+
+// Макроопределение NULL_NODE - идентификатор узла-пустышки
+#define NULL_NODE ((Node_t) 0xFFFFFFFFU)
+
+// Размер кеш-линии.
+#define TREE_CACHE_LINE_SIZE 64U
+
+// Размер узла B+-дерева: по умолчанию четыре кеш-линии. Спуск по дереву из n ключей обращается
+// к O(log(n) / log(TREE_MAX_KEYS)) узлам вместо O(log(n)) узлов двоичного дерева.
+#ifndef TREE_NODE_SIZE
+#define TREE_NODE_SIZE (4U * TREE_CACHE_LINE_SIZE)
+#endif // TREE_NODE_SIZE
+
+// Размер вектора для сравнения ключей внутри узла (SSE2 на x86-64, NEON на AArch64).
+#define TREE_VECTOR_SIZE 16U
+
+// Количество ключей в одном векторе.
+#define TREE_KEYS_PER_VECTOR (TREE_VECTOR_SIZE / sizeof(Key_t))
+
+// Размер элемента, хранимого в узле вместе с ключом (значение листа или дочерний узел).
+#define TREE_SLOT_SIZE ((sizeof(Value_t) > sizeof(Node_t))? sizeof(Value_t) : sizeof(Node_t))
+
+// Максимальное количество ключей в узле: помещается в TREE_NODE_SIZE вместе с заголовком
+// и кратно количеству ключей в векторе.
+#define TREE_MAX_KEYS \
+    ((TREE_NODE_SIZE - TREE_VECTOR_SIZE - 2U * sizeof(Node_t)) / (sizeof(Key_t) + TREE_SLOT_SIZE) \
+        / TREE_KEYS_PER_VECTOR * TREE_KEYS_PER_VECTOR)
+
+// Минимальное количество ключей в узле, отличном от корневого.
+#define TREE_MIN_KEYS (TREE_MAX_KEYS / 2U)
+
+// Тип TreeKeyVector - вектор ключей для одновременного сравнения (расширение GCC).
+// Векторное сравнение требует целочисленного типа Key_t.
+typedef Key_t TreeKeyVector __attribute__((vector_size(TREE_VECTOR_SIZE)));
+
+// Тип TreeNode - узел B+-дерева.
+// Пары ключ-значение хранятся только в листьях, внутренние узлы хранят разделяющие ключи.
+struct TreeNode {
+    // Идентификатор родительского узла.
+    // Для корневой вершины равен NULL_NODE.
+    Node_t parent_id;
+
+    // Количество ключей в узле.
+    uint16_t num_keys;
+    // Флаг листового узла.
+    uint16_t is_leaf;
+
+    // Ключи узла в порядке возрастания.
+    // Ключи с индексами от num_keys до TREE_MAX_KEYS не используются.
+    Key_t keys[TREE_MAX_KEYS] __attribute__((aligned(TREE_VECTOR_SIZE)));
+
+    union {
+        // Идентификаторы дочерних узлов внутреннего узла.
+        // Ключи поддерева children[i] не меньше keys[i - 1] и меньше keys[i].
+        Node_t children[TREE_MAX_KEYS + 1U];
+
+        struct {
+            // Значения листа для ключей с теми же индексами.
+            Value_t values[TREE_MAX_KEYS];
+
+            // Идентификаторы соседних листьев в порядке возрастания ключей.
+            // Для крайних листьев равны NULL_NODE.
+            Node_t prev_id;
+            Node_t next_id;
+        };
+    };
+} __attribute__((aligned(TREE_CACHE_LINE_SIZE)));
+
+typedef struct TreeNode TreeNode;
+
+_Static_assert(sizeof(TreeNode) == TREE_NODE_SIZE, "B+ tree node must fill TREE_NODE_SIZE bytes");
+_Static_assert(TREE_MAX_KEYS >= 4U, "B+ tree node must hold at least four keys");
+
+// Тип Tree - B+-дерево поиска.
+typedef struct {
+    // Динамический массив узлов дерева, выровненный по границе кеш-линии.
+    // Идентификатор узла дерева равен индексу этого узла в массиве nodes.
+    TreeNode* nodes;
+    // Счётчик узлов дерева.
+    size_t num_nodes;
+    // Размер массива nodes.
+    size_t capacity;
+
+    // Счётчик пар ключ-значение в дереве.
+    size_t size;
+
+    // Корневой узел дерева.
+    Node_t root_id;
+} Tree;
+
+// Предварительная декларация функции для печати.
+void tree_print(Tree* tree);
+
+// Тип TreeLayout - порядок размещения узлов в массиве nodes (см. tree_relayout).
+typedef enum
+{
+    // Порядок обхода в ширину: узлы верхних уровней дерева размещаются в начале массива.
+    TREE_LAYOUT_BFS = 0,
+    // Порядок ван Эмде Боаса: верхняя половина уровней поддерева и каждое из нижних поддеревьев
+    // рекурсивно размещаются в смежных участках массива.
+    TREE_LAYOUT_VEB = 1
+} TreeLayout;
+
+// Размер страницы памяти, по которому оценивается фрагментация дерева.
+#define TREE_PAGE_SIZE 4096U
+
+// Тип TreeRangeCallback - функция обратного вызова для пачки пар ключ-значение.
+// Получает массивы из count ключей и значений в порядке возрастания ключей и пользовательский
+// аргумент arg. Возвращает false, чтобы прекратить обход.
+typedef bool (*TreeRangeCallback)(const Key_t keys[], const Value_t values[], size_t count,
+                                  void* arg);
+
+//======================//
+// Управление ресурсами //
+//======================//
+
+//==================================================================================================
+// Функция: tree_alloc
+// Назначение: Инициализирует B+-дерево
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in/out) - дерево, которое требуется инициализировать.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Для каждого дерева, инициализируемого с помощью tree_alloc,
+//   должна быть вызвана функция tree_free.
+//==================================================================================================
+RetCode tree_alloc(Tree* tree)
+{
+    if (tree == NULL)
+    {
+        return RET_INVAL;
+    }
+
+    // Инициализируем поля структуры.
+    tree->num_nodes = 0U;
+    tree->capacity  = 1U;
+    tree->size      = 0U;
+    tree->root_id   = NULL_NODE;
+
+    // Выделяем выровненную память для массива узлов дерева.
+    void* nodes = NULL;
+    if (posix_memalign(&nodes, TREE_CACHE_LINE_SIZE, tree->capacity * sizeof(TreeNode)) != 0)
+    {
+        tree->nodes = NULL;
+
+        return RET_NOMEM;
+    }
+
+    tree->nodes = nodes;
+
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_free
+// Назначение: Освобождает ресурсы B+-дерева
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in/out) - дерево, ресурсы которого требуется освободить.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Для каждого дерева, освобождаемого с помощью tree_free,
+//   должна ранее быть вызвана функция tree_alloc.
+//==================================================================================================
+RetCode tree_free(Tree* tree)
+{
+    if (tree == NULL || tree->nodes == NULL)
+    {
+        return RET_INVAL;
+    }
+
+    // Освобождаем ранее выделенную динамическую память.
+    free(tree->nodes);
+
+    // Производим защиту от повторного освобождения памяти.
+    tree->nodes = NULL;
+
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_resize_nodes
+// Назначение: Изменяет размер массива узлов B+-дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree         (in/out) - B+-дерево поиска.
+// new_capacity (in)     - новый размер массива узлов (не равен нулю).
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Функция realloc не сохраняет выравнивание, поэтому массив выделяется заново
+//   и первые min(tree->num_nodes, new_capacity) узлов копируются.
+// - В случае нехватки памяти возвращается RET_NOMEM, узлы дерева не изменяются.
+//==================================================================================================
+RetCode tree_resize_nodes(Tree* tree, size_t new_capacity)
+{
+    // Выделяем новый массив узлов дерева.
+    void* new_nodes = NULL;
+    if (posix_memalign(&new_nodes, TREE_CACHE_LINE_SIZE, new_capacity * sizeof(TreeNode)) != 0)
+    {
+        return RET_NOMEM;
+    }
+
+    // Копируем выделенные узлы.
+    size_t num_copied = (tree->num_nodes < new_capacity)? tree->num_nodes : new_capacity;
+    memcpy(new_nodes, tree->nodes, num_copied * sizeof(TreeNode));
+
+    free(tree->nodes);
+    tree->nodes = new_nodes;
+
+    // Обновляем размер массива узлов.
+    tree->capacity = new_capacity;
+
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_reserve_nodes
+// Назначение: Гарантирует наличие заданного количества невыделенных узлов в массиве.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree      (in/out) - B+-дерево поиска.
+// num_extra (in)     - требуемое количество невыделенных узлов.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Размер массива как минимум удваивается, что даёт амортизированное O(1) на выделение.
+// - После успешного вызова num_extra вызовов tree_node_allocate не перевыделяют массив,
+//   поэтому указатели на узлы остаются действительными.
+//==================================================================================================
+RetCode tree_reserve_nodes(Tree* tree, size_t num_extra)
+{
+    if (tree->num_nodes + num_extra <= tree->capacity)
+    {
+        return RET_OK;
+    }
+
+    // Новый размер массива узлов.
+    size_t new_capacity = 2U * tree->capacity;
+    if (new_capacity < tree->num_nodes + num_extra)
+    {
+        new_capacity = tree->num_nodes + num_extra;
+    }
+
+    return tree_resize_nodes(tree, new_capacity);
+}
+
+//=========================//
+// Вспомогательные функции //
+//=========================//
+
+//==================================================================================================
+// Функция: tree_get
+// Назначение: Возвращает узел дерева по идентификатору узла дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in) - B+-дерево поиска.
+// node_id (in) - идентификатор узла дерева.
+//
+// Возвращаемое значение:
+// Указатель на узел дерева.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Идентификатор node_id - индекс, не выходящий за границы массива tree->nodes.
+//==================================================================================================
+TreeNode* tree_get(Tree* tree, Node_t node_id)
+{
+    // Возвращаем узел в массиве по индексу, равному идентификатору узла.
+    return &tree->nodes[node_id];
+}
+
+//==================================================================================================
+// Функция: tree_node_allocate
+// Назначение: Выделяет новый пустой узел дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in) - B+-дерево поиска.
+// is_leaf (in) - флаг листового узла.
+//
+// Возвращаемое значение:
+// Идентификатор нового узла.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - В случае нехватки памяти возвращается NULL_NODE.
+//==================================================================================================
+Node_t tree_node_allocate(Tree* tree, bool is_leaf)
+{
+    // Проверяем наличие невыделенных узлов дерева.
+    if (tree_reserve_nodes(tree, 1U) != RET_OK)
+    {
+        return NULL_NODE;
+    }
+
+    // Выделяем новый узел на первом свободном месте в массиве
+    Node_t allocated_id = tree->num_nodes;
+
+    // Увеличиваем счётчик выделенных узлов.
+    tree->num_nodes += 1U;
+
+    // Инициализируем узел как пустой и отвязанный от дерева.
+    TreeNode* allocated = tree_get(tree, allocated_id);
+    memset(allocated, 0, sizeof(TreeNode));
+
+    allocated->parent_id = NULL_NODE;
+    allocated->is_leaf   = is_leaf;
+
+    if (is_leaf)
+    {
+        allocated->prev_id = NULL_NODE;
+        allocated->next_id = NULL_NODE;
+    }
+
+    return allocated_id;
+}
+
+//==================================================================================================
+// Функция: tree_child_index
+// Назначение: Находит индекс дочернего узла в массиве children родительского узла.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// parent   (in) - внутренний узел дерева.
+// child_id (in) - идентификатор дочернего узла.
+//
+// Возвращаемое значение:
+// Индекс дочернего узла.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Используется только при изменении структуры дерева, поиск не обращается к этой функции.
+//==================================================================================================
+uint32_t tree_child_index(TreeNode* parent, Node_t child_id)
+{
+    uint32_t child_i = 0U;
+    while (parent->children[child_i] != child_id)
+    {
+        child_i += 1U;
+    }
+
+    return child_i;
+}
+
+//==================================================================================================
+// Функция: tree_node_free
+// Назначение: Освбождает узел дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree     (in) - B+-дерево поиска.
+// freed_id (in) - идентификатор узла для освобождения.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Освобождаемый узел не должен быть связан с другими узлами дерева.
+// - На место освобождаемого узла переносится последний узел массива, поэтому идентификатор
+//   tree->num_nodes - 1 после вызова становится равным freed_id.
+//==================================================================================================
+void tree_node_free(Tree* tree, Node_t freed_id)
+{
+    // Идентификатор переносимого узла.
+    Node_t last_id = tree->num_nodes - 1U;
+
+    if (freed_id != last_id)
+    {
+        TreeNode* moved = tree_get(tree, freed_id);
+        *moved = *tree_get(tree, last_id);
+
+        // Обновляем ссылку родителя на переносимый узел.
+        if (moved->parent_id == NULL_NODE)
+        {
+            tree->root_id = freed_id;
+        }
+        else
+        {
+            TreeNode* parent = tree_get(tree, moved->parent_id);
+            parent->children[tree_child_index(parent, last_id)] = freed_id;
+        }
+
+        // Обновляем ссылки соседних листьев или дочерних узлов.
+        if (moved->is_leaf)
+        {
+            if (moved->prev_id != NULL_NODE)
+            {
+                tree_get(tree, moved->prev_id)->next_id = freed_id;
+            }
+            if (moved->next_id != NULL_NODE)
+            {
+                tree_get(tree, moved->next_id)->prev_id = freed_id;
+            }
+        }
+        else
+        {
+            for (uint32_t child_i = 0U; child_i <= moved->num_keys; ++child_i)
+            {
+                tree_get(tree, moved->children[child_i])->parent_id = freed_id;
+            }
+        }
+    }
+
+    // Уменьшаем счётчик выделенных узлов.
+    tree->num_nodes -= 1U;
+}
+
+//==================================================================================================
+// Функция: tree_node_rank
+// Назначение: Вычисляет количество ключей узла, меньших заданного (или не больших его).
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// node      (in) - узел дерева.
+// key       (in) - ключ для сравнения.
+// inclusive (in) - флаг подсчёта ключей, равных заданному.
+//
+// Возвращаемое значение:
+// Количество ключей узла, меньших key (при inclusive - не больших key).
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Ключи сравниваются векторами по TREE_KEYS_PER_VECTOR без условных переходов: результат
+//   сравнения - маска из -1 и 0, маски накапливаются в векторе-счётчике. Цикл по всем
+//   TREE_MAX_KEYS ключам имеет постоянную длину и полностью разворачивается компилятором,
+//   в отличие от log2(TREE_MAX_KEYS) трудно предсказуемых переходов двоичного поиска.
+// - Неиспользуемые ключи с индексами от num_keys исключаются маской индексов.
+//==================================================================================================
+uint32_t tree_node_rank(const TreeNode* node, Key_t key, bool inclusive)
+{
+    // Векторы из копий ключа, индексов элементов и количества ключей в узле.
+    TreeKeyVector key_vector;
+    TreeKeyVector index_vector;
+    TreeKeyVector limit_vector;
+    for (uint32_t lane = 0U; lane < TREE_KEYS_PER_VECTOR; ++lane)
+    {
+        key_vector[lane]   = key;
+        index_vector[lane] = lane;
+        limit_vector[lane] = node->num_keys;
+    }
+
+    // Счётчики истинных сравнений по элементам вектора.
+    TreeKeyVector counter = key_vector - key_vector;
+
+    for (uint32_t key_i = 0U; key_i < TREE_MAX_KEYS; key_i += TREE_KEYS_PER_VECTOR)
+    {
+        TreeKeyVector keys;
+        memcpy(&keys, &node->keys[key_i], sizeof(keys));
+
+        // Ключ не больше key равносилен тому, что key не меньше ключа.
+        __typeof__(keys < key_vector) mask = inclusive? ~(key_vector < keys) : (keys < key_vector);
+
+        // Маска из -1 приводится к типу ключа без изменения битов и вычитается из счётчика.
+        counter -= (TreeKeyVector) (mask & (index_vector < limit_vector));
+        index_vector += TREE_KEYS_PER_VECTOR;
+    }
+
+    uint32_t rank = 0U;
+    for (uint32_t lane = 0U; lane < TREE_KEYS_PER_VECTOR; ++lane)
+    {
+        rank += counter[lane];
+    }
+
+    return rank;
+}
+
+//==================================================================================================
+// Функция: tree_search_leaf
+// Назначение: Находит лист, в котором находится или должен находиться ключ.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree  (in)  - непустое B+-дерево поиска.
+// key   (in)  - ключ, по которому производится поиск.
+// depth (out) - количество узлов на пути от корня до листа (выходной аргумент).
+//
+// Возвращаемое значение:
+// Идентификатор листа.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+Node_t tree_search_leaf(Tree* tree, Key_t key, uint32_t* depth)
+{
+    Node_t cur_id = tree->root_id;
+    TreeNode* cur = tree_get(tree, cur_id);
+
+    *depth = 1U;
+    while (!cur->is_leaf)
+    {
+        // Ключи, равные разделяющему ключу, находятся в правом поддереве.
+        cur_id = cur->children[tree_node_rank(cur, key, true)];
+        cur    = tree_get(tree, cur_id);
+
+        *depth += 1U;
+    }
+
+    return cur_id;
+}
+
+//==================================================================================================
+// Функция: tree_leftmost_leaf
+// Назначение: Находит лист с минимальными ключами поддерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree       (in) - B+-дерево поиска.
+// subtree_id (in) - корневой узел поддерева.
+//
+// Возвращаемое значение:
+// Идентификатор листа.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+Node_t tree_leftmost_leaf(Tree* tree, Node_t subtree_id)
+{
+    Node_t cur_id = subtree_id;
+    while (!tree_get(tree, cur_id)->is_leaf)
+    {
+        cur_id = tree_get(tree, cur_id)->children[0U];
+    }
+
+    return cur_id;
+}
+
+//==================================================================================================
+// Функция: tree_insert_into_parent
+// Назначение: Добавляет в родительский узел разделяющий ключ и новый узел, полученный
+// разделением дочернего узла.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree     (in) - B+-дерево поиска.
+// left_id  (in) - идентификатор разделённого узла.
+// key      (in) - минимальный ключ поддерева right_id.
+// right_id (in) - идентификатор нового узла, следующего за left_id.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Переполненный родительский узел разделяется пополам, средний ключ поднимается выше.
+//   При разделении корня дерево вырастает на один уровень.
+// - Невыделенные узлы для всех разделений должны быть зарезервированы заранее.
+//==================================================================================================
+void tree_insert_into_parent(Tree* tree, Node_t left_id, Key_t key, Node_t right_id)
+{
+    while (true)
+    {
+        Node_t parent_id = tree_get(tree, left_id)->parent_id;
+
+        if (parent_id == NULL_NODE)
+        {   // Разделён корневой узел: создаём новый корень.
+            Node_t root_id = tree_node_allocate(tree, false);
+            TreeNode* root = tree_get(tree, root_id);
+
+            root->num_keys    = 1U;
+            root->keys[0U]    = key;
+            root->children[0U] = left_id;
+            root->children[1U] = right_id;
+
+            tree_get(tree, left_id)->parent_id  = root_id;
+            tree_get(tree, right_id)->parent_id = root_id;
+
+            tree->root_id = root_id;
+            return;
+        }
+
+        TreeNode* parent = tree_get(tree, parent_id);
+        tree_get(tree, right_id)->parent_id = parent_id;
+
+        // Позиция нового ключа в родительском узле.
+        uint32_t key_i = tree_child_index(parent, left_id);
+
+        if (parent->num_keys < TREE_MAX_KEYS)
+        {   // В родительском узле есть место.
+            memmove(&parent->keys[key_i + 1U], &parent->keys[key_i],
+                    (parent->num_keys - key_i) * sizeof(Key_t));
+            memmove(&parent->children[key_i + 2U], &parent->children[key_i + 1U],
+                    (parent->num_keys - key_i) * sizeof(Node_t));
+
+            parent->keys[key_i]          = key;
+            parent->children[key_i + 1U] = right_id;
+            parent->num_keys += 1U;
+            return;
+        }
+
+        // Собираем TREE_MAX_KEYS + 1 ключей переполненного узла.
+        Key_t  split_keys[TREE_MAX_KEYS + 1U];
+        Node_t split_children[TREE_MAX_KEYS + 2U];
+
+        memcpy(split_keys, parent->keys, key_i * sizeof(Key_t));
+        split_keys[key_i] = key;
+        memcpy(&split_keys[key_i + 1U], &parent->keys[key_i],
+               (TREE_MAX_KEYS - key_i) * sizeof(Key_t));
+
+        memcpy(split_children, parent->children, (key_i + 1U) * sizeof(Node_t));
+        split_children[key_i + 1U] = right_id;
+        memcpy(&split_children[key_i + 2U], &parent->children[key_i + 1U],
+               (TREE_MAX_KEYS - key_i) * sizeof(Node_t));
+
+        // Левая половина остаётся в узле, средний ключ поднимается, правая половина переносится.
+        uint32_t left_count  = (TREE_MAX_KEYS + 1U) / 2U;
+        uint32_t right_count = TREE_MAX_KEYS - left_count;
+
+        Node_t new_id = tree_node_allocate(tree, false);
+        TreeNode* new = tree_get(tree, new_id);
+
+        parent->num_keys = left_count;
+        memcpy(parent->keys, split_keys, left_count * sizeof(Key_t));
+        memcpy(parent->children, split_children, (left_count + 1U) * sizeof(Node_t));
+
+        new->num_keys = right_count;
+        memcpy(new->keys, &split_keys[left_count + 1U], right_count * sizeof(Key_t));
+        memcpy(new->children, &split_children[left_count + 1U], (right_count + 1U) * sizeof(Node_t));
+
+        for (uint32_t child_i = 0U; child_i <= right_count; ++child_i)
+        {
+            tree_get(tree, new->children[child_i])->parent_id = new_id;
+        }
+
+        // Продолжаем вставку уровнем выше.
+        left_id  = parent_id;
+        key      = split_keys[left_count];
+        right_id = new_id;
+    }
+}
+
+//==================================================================================================
+// Функция: tree_join_siblings
+// Назначение: Объединяет два соседних дочерних узла в один.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree      (in) - B+-дерево поиска.
+// parent_id (in) - идентификатор родительского узла.
+// key_i     (in) - индекс разделяющего ключа между объединяемыми узлами children[key_i]
+//                  и children[key_i + 1].
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Правый узел освобождается, разделяющий ключ удаляется из родительского узла
+//   (для внутренних узлов он опускается в объединённый узел).
+// - Освобождение узла переносит последний узел массива (см. tree_node_free).
+//==================================================================================================
+void tree_join_siblings(Tree* tree, Node_t parent_id, uint32_t key_i)
+{
+    TreeNode* parent = tree_get(tree, parent_id);
+
+    Node_t left_id  = parent->children[key_i];
+    Node_t right_id = parent->children[key_i + 1U];
+
+    TreeNode* left  = tree_get(tree, left_id);
+    TreeNode* right = tree_get(tree, right_id);
+
+    if (left->is_leaf)
+    {   // Переносим пары ключ-значение и исключаем правый лист из списка листьев.
+        memcpy(&left->keys[left->num_keys], right->keys, right->num_keys * sizeof(Key_t));
+        memcpy(&left->values[left->num_keys], right->values, right->num_keys * sizeof(Value_t));
+        left->num_keys += right->num_keys;
+
+        left->next_id = right->next_id;
+        if (right->next_id != NULL_NODE)
+        {
+            tree_get(tree, right->next_id)->prev_id = left_id;
+        }
+    }
+    else
+    {   // Опускаем разделяющий ключ и переносим ключи и дочерние узлы.
+        left->keys[left->num_keys] = parent->keys[key_i];
+        memcpy(&left->keys[left->num_keys + 1U], right->keys, right->num_keys * sizeof(Key_t));
+        memcpy(&left->children[left->num_keys + 1U], right->children,
+               (right->num_keys + 1U) * sizeof(Node_t));
+
+        for (uint32_t child_i = 0U; child_i <= right->num_keys; ++child_i)
+        {
+            tree_get(tree, right->children[child_i])->parent_id = left_id;
+        }
+
+        left->num_keys += right->num_keys + 1U;
+    }
+
+    // Удаляем разделяющий ключ и правый узел из родительского узла.
+    memmove(&parent->keys[key_i], &parent->keys[key_i + 1U],
+            (parent->num_keys - key_i - 1U) * sizeof(Key_t));
+    memmove(&parent->children[key_i + 1U], &parent->children[key_i + 2U],
+            (parent->num_keys - key_i - 1U) * sizeof(Node_t));
+    parent->num_keys -= 1U;
+
+    tree_node_free(tree, right_id);
+}
+
+//==================================================================================================
+// Функция: tree_remove_fixup
+// Назначение: Восстанавливает заполненность узлов после удаления ключа из листа.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in) - B+-дерево поиска.
+// node_id (in) - идентификатор узла, из которого удалён ключ.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Узел с менее чем TREE_MIN_KEYS ключами забирает ключ у соседнего узла, а если оба
+//   соседа заполнены минимально - объединяется с одним из них, что может опустошить
+//   родительский узел. Пустой внутренний корень заменяется единственным дочерним узлом.
+//==================================================================================================
+void tree_remove_fixup(Tree* tree, Node_t node_id)
+{
+    while (true)
+    {
+        TreeNode* node = tree_get(tree, node_id);
+
+        if (node_id == tree->root_id)
+        {
+            if (node->num_keys != 0U)
+            {
+                return;
+            }
+
+            if (node->is_leaf)
+            {   // Дерево опустело.
+                tree->root_id = NULL_NODE;
+            }
+            else
+            {   // Дерево уменьшается на один уровень.
+                tree->root_id = node->children[0U];
+                tree_get(tree, tree->root_id)->parent_id = NULL_NODE;
+            }
+
+            tree_node_free(tree, node_id);
+            return;
+        }
+
+        if (node->num_keys >= TREE_MIN_KEYS)
+        {
+            return;
+        }
+
+        Node_t parent_id = node->parent_id;
+        TreeNode* parent = tree_get(tree, parent_id);
+
+        // Индекс узла среди дочерних узлов родителя и соседние узлы.
+        uint32_t child_i = tree_child_index(parent, node_id);
+
+        TreeNode* left  = (child_i == 0U)?
+                          NULL : tree_get(tree, parent->children[child_i - 1U]);
+        TreeNode* right = (child_i == parent->num_keys)?
+                          NULL : tree_get(tree, parent->children[child_i + 1U]);
+
+        if (left != NULL && left->num_keys > TREE_MIN_KEYS)
+        {   // Забираем последний ключ левого соседа.
+            memmove(&node->keys[1U], &node->keys[0U], node->num_keys * sizeof(Key_t));
+
+            if (node->is_leaf)
+            {
+                memmove(&node->values[1U], &node->values[0U], node->num_keys * sizeof(Value_t));
+
+                node->keys[0U]   = left->keys[left->num_keys - 1U];
+                node->values[0U] = left->values[left->num_keys - 1U];
+
+                parent->keys[child_i - 1U] = node->keys[0U];
+            }
+            else
+            {
+                memmove(&node->children[1U], &node->children[0U],
+                        (node->num_keys + 1U) * sizeof(Node_t));
+
+                node->keys[0U]     = parent->keys[child_i - 1U];
+                node->children[0U] = left->children[left->num_keys];
+                tree_get(tree, node->children[0U])->parent_id = node_id;
+
+                parent->keys[child_i - 1U] = left->keys[left->num_keys - 1U];
+            }
+
+            node->num_keys += 1U;
+            left->num_keys -= 1U;
+            return;
+        }
+
+        if (right != NULL && right->num_keys > TREE_MIN_KEYS)
+        {   // Забираем первый ключ правого соседа.
+            if (node->is_leaf)
+            {
+                node->keys[node->num_keys]   = right->keys[0U];
+                node->values[node->num_keys] = right->values[0U];
+
+                memmove(&right->values[0U], &right->values[1U],
+                        (right->num_keys - 1U) * sizeof(Value_t));
+                memmove(&right->keys[0U], &right->keys[1U],
+                        (right->num_keys - 1U) * sizeof(Key_t));
+
+                parent->keys[child_i] = right->keys[0U];
+            }
+            else
+            {
+                node->keys[node->num_keys]           = parent->keys[child_i];
+                node->children[node->num_keys + 1U] = right->children[0U];
+                tree_get(tree, right->children[0U])->parent_id = node_id;
+
+                parent->keys[child_i] = right->keys[0U];
+
+                memmove(&right->keys[0U], &right->keys[1U],
+                        (right->num_keys - 1U) * sizeof(Key_t));
+                memmove(&right->children[0U], &right->children[1U],
+                        right->num_keys * sizeof(Node_t));
+            }
+
+            node->num_keys  += 1U;
+            right->num_keys -= 1U;
+            return;
+        }
+
+        // Оба соседа заполнены минимально: объединяем узел с одним из них.
+        Node_t last_id = tree->num_nodes - 1U;
+        Node_t freed_id = (left != NULL)? node_id : parent->children[child_i + 1U];
+
+        tree_join_siblings(tree, parent_id, (left != NULL)? (child_i - 1U) : child_i);
+
+        // Родительский узел мог быть перенесён на место освобождённого узла.
+        if (parent_id == last_id)
+        {
+            parent_id = freed_id;
+        }
+
+        node_id = parent_id;
+    }
+}
+
+//==================================================================================================
+// Функция: tree_check_recursive
+// Назначение: Проверяет инварианты B+-дерева для поддерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree      (in)     - B+-дерево поиска.
+// node_id   (in)     - корневой узел поддерева.
+// parent_id (in)     - ожидаемый родительский узел.
+// lower     (in)     - нижняя граница ключей поддерева (включительно) или NULL.
+// upper     (in)     - верхняя граница ключей поддерева (исключительно) или NULL.
+// count     (in/out) - счётчик пройденных узлов.
+//
+// Возвращаемое значение:
+// Количество уровней поддерева или -1 при нарушении инвариантов.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+int32_t tree_check_recursive(Tree* tree, Node_t node_id, Node_t parent_id,
+                             const Key_t* lower, const Key_t* upper, size_t* count)
+{
+    if (node_id >= tree->num_nodes)
+    {
+        return -1;
+    }
+
+    TreeNode* node = tree_get(tree, node_id);
+    *count += 1U;
+
+    // Проверяем связь с родителем и заполненность узла.
+    if (node->parent_id != parent_id || node->num_keys > TREE_MAX_KEYS || node->num_keys == 0U)
+    {
+        return -1;
+    }
+    if (parent_id != NULL_NODE && node->num_keys < TREE_MIN_KEYS)
+    {
+        return -1;
+    }
+
+    // Проверяем упорядоченность ключей и их принадлежность границам поддерева.
+    for (uint32_t key_i = 0U; key_i < node->num_keys; ++key_i)
+    {
+        if ((key_i != 0U && node->keys[key_i - 1U] >= node->keys[key_i]) ||
+            (lower != NULL && node->keys[key_i] < *lower) ||
+            (upper != NULL && node->keys[key_i] >= *upper))
+        {
+            return -1;
+        }
+    }
+
+    if (node->is_leaf)
+    {
+        return 1;
+    }
+
+    // Все листья должны находиться на одной глубине.
+    int32_t height = -1;
+    for (uint32_t child_i = 0U; child_i <= node->num_keys; ++child_i)
+    {
+        int32_t child_height = tree_check_recursive(tree, node->children[child_i], node_id,
+            (child_i == 0U)? lower : &node->keys[child_i - 1U],
+            (child_i == node->num_keys)? upper : &node->keys[child_i], count);
+
+        if (child_height < 0 || (height >= 0 && child_height != height))
+        {
+            return -1;
+        }
+
+        height = child_height;
+    }
+
+    return height + 1;
+}
+
+//==================================================================================================
+// Функция: tree_depth
+// Назначение: Вычисляет количество уровней дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in) - B+-дерево поиска.
+// node_id (in) - корневой узел поддерева.
+//
+// Возвращаемое значение:
+// Количество уровней поддерева.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Все листья B+-дерева находятся на одной глубине, поэтому достаточно спуска по первым
+//   дочерним узлам.
+//==================================================================================================
+uint32_t tree_depth(Tree* tree, Node_t node_id)
+{
+    if (node_id == NULL_NODE)
+    {
+        return 0U;
+    }
+
+    uint32_t depth = 1U;
+    while (!tree_get(tree, node_id)->is_leaf)
+    {
+        node_id = tree_get(tree, node_id)->children[0U];
+        depth += 1U;
+    }
+
+    return depth;
+}
+
+//==================================================================================================
+// Функция: tree_layout_bfs
+// Назначение: Вычисляет порядок узлов при обходе дерева в ширину.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree  (in)  - B+-дерево поиска.
+// order (out) - массив из tree->num_nodes идентификаторов узлов в порядке обхода.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Выходной массив одновременно служит очередью обхода.
+// - Листья оказываются в конце массива в порядке возрастания ключей.
+//==================================================================================================
+void tree_layout_bfs(Tree* tree, Node_t order[])
+{
+    // Количество узлов, добавленных в очередь.
+    size_t count = 0U;
+
+    if (tree->root_id != NULL_NODE)
+    {
+        order[count++] = tree->root_id;
+    }
+
+    for (size_t i = 0U; i < count; ++i)
+    {
+        TreeNode* node = tree_get(tree, order[i]);
+        if (node->is_leaf)
+        {
+            continue;
+        }
+
+        for (uint32_t child_i = 0U; child_i <= node->num_keys; ++child_i)
+        {
+            order[count++] = node->children[child_i];
+        }
+    }
+}
+
+// Предварительная декларация функции для взаимной рекурсии.
+void tree_layout_veb(Tree* tree, Node_t root_id, uint32_t height, Node_t order[], size_t* count);
+
+//==================================================================================================
+// Функция: tree_layout_veb_bottom
+// Назначение: Размещает в порядке ван Эмде Боаса нижние поддеревья, корни которых находятся
+// на заданной глубине относительно заданного узла.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in)     - B+-дерево поиска.
+// node_id (in)     - идентификатор узла, от которого отсчитывается глубина.
+// depth   (in)     - глубина корней нижних поддеревьев.
+// height  (in)     - количество уровней нижних поддеревьев.
+// order   (in/out) - массив идентификаторов узлов в новом порядке.
+// count   (in/out) - количество уже размещённых узлов.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Нижние поддеревья размещаются слева направо.
+//==================================================================================================
+void tree_layout_veb_bottom(Tree* tree, Node_t node_id, uint32_t depth, uint32_t height,
+                            Node_t order[], size_t* count)
+{
+    if (depth == 0U)
+    {   // Узел является корнем нижнего поддерева.
+        tree_layout_veb(tree, node_id, height, order, count);
+        return;
+    }
+
+    TreeNode* node = tree_get(tree, node_id);
+
+    for (uint32_t child_i = 0U; child_i <= node->num_keys; ++child_i)
+    {
+        tree_layout_veb_bottom(tree, node->children[child_i], depth - 1U, height, order, count);
+    }
+}
+
+//==================================================================================================
+// Функция: tree_layout_veb
+// Назначение: Вычисляет порядок ван Эмде Боаса для узлов поддерева, ограниченного по высоте.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in)     - B+-дерево поиска.
+// root_id (in)     - идентификатор корневого узла поддерева.
+// height  (in)     - количество уровней поддерева, которые требуется разместить.
+// order   (in/out) - массив идентификаторов узлов в новом порядке.
+// count   (in/out) - количество уже размещённых узлов.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Поддерево разрезается по середине высоты: сначала рекурсивно размещается верхнее поддерево
+//   из height / 2 уровней, затем - каждое из нижних поддеревьев.
+// - Высота B+-дерева мала (4-6 уровней для миллиардов ключей), поэтому порядок отличается
+//   от обхода в ширину в основном группировкой поддеревьев нижних уровней по страницам.
+//==================================================================================================
+void tree_layout_veb(Tree* tree, Node_t root_id, uint32_t height, Node_t order[], size_t* count)
+{
+    if (root_id == NULL_NODE || height == 0U)
+    {
+        return;
+    }
+
+    if (height == 1U)
+    {   // Поддерево из одного уровня состоит из корневого узла.
+        order[(*count)++] = root_id;
+        return;
+    }
+
+    // Количество уровней верхнего поддерева.
+    uint32_t top_height = height / 2U;
+
+    tree_layout_veb(tree, root_id, top_height, order, count);
+    tree_layout_veb_bottom(tree, root_id, top_height, height - top_height, order, count);
+}
+
+//==================================================================================================
+// Функция: tree_print_recursive
+// Назначение: Производит печать поддерева с отступами по уровням.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree    (in) - B+-дерево поиска.
+// node_id (in) - корневой узел поддерева.
+// level   (in) - глубина корневого узла поддерева.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Узел печатается одной строкой со всеми ключами, затем печатаются его дочерние узлы.
+//==================================================================================================
+void tree_print_recursive(Tree* tree, Node_t node_id, size_t level)
+{
+    TreeNode* node = tree_get(tree, node_id);
+
+    for (size_t lvl = 0U; lvl < level; ++lvl)
+    {
+        printf("    ");
+    }
+
+    printf("[");
+    for (uint32_t key_i = 0U; key_i < node->num_keys; ++key_i)
+    {
+        printf((key_i == 0U)? "%d" : " %d", node->keys[key_i]);
+    }
+    printf("]\n");
+
+    if (!node->is_leaf)
+    {
+        for (uint32_t child_i = 0U; child_i <= node->num_keys; ++child_i)
+        {
+            tree_print_recursive(tree, node->children[child_i], level + 1U);
+        }
+    }
+}
+
+//============================//
+// Пользовательский интерфейс //
+//============================//
+
+//==================================================================================================
+// Функция: tree_search
+// Назначение: Находит значение в дереве по ключу.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree  (in)  - B+-дерево поиска.
+// key   (in)  - ключ, по которому производится поиск.
+// res   (out) - значение по ключу (выходной аргумент).
+// found (out) - флаг успешности поиска в дереве (выходной аргумент).
+//
+// Возвращаемое значение:
+// код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+RetCode tree_search(Tree* tree, Key_t key, Value_t* res, bool* found)
+{
+    if (tree == NULL || res == NULL || found == NULL)
+    {
+        return RET_INVAL;
+    }
+
+    if (tree->root_id == NULL_NODE)
+    {
+        *found = false;
+        return RET_OK;
+    }
+
+    uint32_t depth;
+    TreeNode* leaf = tree_get(tree, tree_search_leaf(tree, key, &depth));
+
+    uint32_t key_i = tree_node_rank(leaf, key, false);
+    if (key_i == leaf->num_keys || leaf->keys[key_i] != key)
+    {
+        *found = false;
+        return RET_OK;
+    }
+
+    *res = leaf->values[key_i];
+
+    *found = true;
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_set
+// Назначение: Выставляет значение в дереве по ключу.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree  (in) - B+-дерево.
+// key   (in) - ключ, по которому производится поиск значения.
+// value (in) - новое значение для заданного ключа.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Узлы для разделения всех узлов на пути от корня резервируются до изменения дерева,
+//   поэтому в случае нехватки памяти возвращается RET_NOMEM, а дерево не изменяется.
+//==================================================================================================
+RetCode tree_set(Tree* tree, Key_t key, Value_t value)
+{
+    if (tree == NULL)
+    {
+        return RET_INVAL;
+    }
+
+    if (tree->root_id == NULL_NODE)
+    {   // Новый ключ помещается в корневой лист.
+        Node_t root_id = tree_node_allocate(tree, true);
+        if (root_id == NULL_NODE)
+        {
+            return RET_NOMEM;
+        }
+
+        TreeNode* root = tree_get(tree, root_id);
+        root->num_keys   = 1U;
+        root->keys[0U]   = key;
+        root->values[0U] = value;
+
+        tree->root_id = root_id;
+        tree->size    = 1U;
+
+        return RET_OK;
+    }
+
+    // Производим поиск листа по ключу.
+    uint32_t depth;
+    Node_t leaf_id = tree_search_leaf(tree, key, &depth);
+    TreeNode* leaf = tree_get(tree, leaf_id);
+
+    uint32_t key_i = tree_node_rank(leaf, key, false);
+
+    // Обновляем значение уже существующего ключа.
+    if (key_i < leaf->num_keys && leaf->keys[key_i] == key)
+    {
+        leaf->values[key_i] = value;
+
+        // Структура дерева не изменилась.
+        return RET_OK;
+    }
+
+    // Резервируем узлы для разделения каждого узла на пути и для нового корня.
+    if (tree_reserve_nodes(tree, depth + 1U) != RET_OK)
+    {
+        return RET_NOMEM;
+    }
+
+    leaf = tree_get(tree, leaf_id);
+    tree->size += 1U;
+
+    if (leaf->num_keys < TREE_MAX_KEYS)
+    {   // В листе есть место.
+        memmove(&leaf->keys[key_i + 1U], &leaf->keys[key_i],
+                (leaf->num_keys - key_i) * sizeof(Key_t));
+        memmove(&leaf->values[key_i + 1U], &leaf->values[key_i],
+                (leaf->num_keys - key_i) * sizeof(Value_t));
+
+        leaf->keys[key_i]   = key;
+        leaf->values[key_i] = value;
+        leaf->num_keys += 1U;
+
+        return RET_OK;
+    }
+
+    // Собираем TREE_MAX_KEYS + 1 пар ключ-значение переполненного листа.
+    Key_t   split_keys[TREE_MAX_KEYS + 1U];
+    Value_t split_values[TREE_MAX_KEYS + 1U];
+
+    memcpy(split_keys, leaf->keys, key_i * sizeof(Key_t));
+    memcpy(split_values, leaf->values, key_i * sizeof(Value_t));
+    split_keys[key_i]   = key;
+    split_values[key_i] = value;
+    memcpy(&split_keys[key_i + 1U], &leaf->keys[key_i], (TREE_MAX_KEYS - key_i) * sizeof(Key_t));
+    memcpy(&split_values[key_i + 1U], &leaf->values[key_i],
+           (TREE_MAX_KEYS - key_i) * sizeof(Value_t));
+
+    // Разделяем лист пополам и вставляем новый лист в список листьев.
+    uint32_t left_count  = (TREE_MAX_KEYS + 2U) / 2U;
+    uint32_t right_count = TREE_MAX_KEYS + 1U - left_count;
+
+    Node_t right_id = tree_node_allocate(tree, true);
+    TreeNode* right = tree_get(tree, right_id);
+
+    leaf->num_keys = left_count;
+    memcpy(leaf->keys, split_keys, left_count * sizeof(Key_t));
+    memcpy(leaf->values, split_values, left_count * sizeof(Value_t));
+
+    right->num_keys = right_count;
+    memcpy(right->keys, &split_keys[left_count], right_count * sizeof(Key_t));
+    memcpy(right->values, &split_values[left_count], right_count * sizeof(Value_t));
+
+    right->prev_id = leaf_id;
+    right->next_id = leaf->next_id;
+    if (leaf->next_id != NULL_NODE)
+    {
+        tree_get(tree, leaf->next_id)->prev_id = right_id;
+    }
+    leaf->next_id = right_id;
+
+    // Добавляем новый лист в родительский узел.
+    tree_insert_into_parent(tree, leaf_id, right->keys[0U], right_id);
+
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_remove
+// Назначение: Удаляет ключ из дерева с возвратом значения.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree  (in)  - B+-дерево.
+// key   (in)  - ключ, по которому производится удаление значения.
+// ret   (out) - значение для ключа.
+// found (out) - флаг успешности поиска ключа в дереве.
+//
+// Возвращаемое значение:
+// код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Разделяющие ключи внутренних узлов, равные удалённому ключу, не обновляются: они
+//   остаются корректными границами поддеревьев.
+//==================================================================================================
+RetCode tree_remove(Tree* tree, Key_t key, Value_t* ret, bool* found)
+{
+    if (tree == NULL || ret == NULL || found == NULL)
+    {
+        return RET_INVAL;
+    }
+
+    if (tree->root_id == NULL_NODE)
+    {   // В случае отсутствия ключа в дереве возвращаемся из функции.
+        *found = false;
+        return RET_OK;
+    }
+
+    // Производим поиск по ключу.
+    uint32_t depth;
+    Node_t leaf_id = tree_search_leaf(tree, key, &depth);
+    TreeNode* leaf = tree_get(tree, leaf_id);
+
+    uint32_t key_i = tree_node_rank(leaf, key, false);
+    if (key_i == leaf->num_keys || leaf->keys[key_i] != key)
+    {   // В случае отсутствия ключа в дереве возвращаемся из функции.
+        *found = false;
+        return RET_OK;
+    }
+
+    *ret = leaf->values[key_i];
+
+    // Удаляем пару ключ-значение из листа.
+    memmove(&leaf->keys[key_i], &leaf->keys[key_i + 1U],
+            (leaf->num_keys - key_i - 1U) * sizeof(Key_t));
+    memmove(&leaf->values[key_i], &leaf->values[key_i + 1U],
+            (leaf->num_keys - key_i - 1U) * sizeof(Value_t));
+    leaf->num_keys -= 1U;
+
+    tree->size -= 1U;
+
+    // Производим перебалансировку дерева.
+    tree_remove_fixup(tree, leaf_id);
+
+    *found = true;
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_build_sorted
+// Назначение: Строит дерево из массива ключей, отсортированного по возрастанию.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree   (in/out) - B+-дерево поиска, инициализированное функцией tree_alloc.
+// keys   (in)     - массив ключей, строго возрастающих.
+// values (in)     - массив значений для ключей.
+// n      (in)     - количество пар ключ-значение.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Предыдущее содержимое дерева заменяется.
+// - Массив узлов выделяется ровно на количество узлов построенного дерева. Листья
+//   заполняются по порядку и равномерно, затем уровень за уровнем строятся внутренние узлы.
+//   Построение выполняется за O(n) без разделений узлов.
+// - Узлы размещаются в массиве от листьев к корню, каждый уровень в порядке возрастания ключей.
+// - В случае неупорядоченных ключей возвращается RET_INVAL, а в случае нехватки памяти -
+//   RET_NOMEM. В обоих случаях дерево не изменяется.
+//==================================================================================================
+RetCode tree_build_sorted(Tree* tree, const Key_t keys[], const Value_t values[], size_t n)
+{
+    if (tree == NULL || (n != 0U && (keys == NULL || values == NULL)) || n >= NULL_NODE)
+    {
+        return RET_INVAL;
+    }
+
+    // Проверяем упорядоченность ключей до изменения дерева.
+    for (size_t i = 1U; i < n; ++i)
+    {
+        if (keys[i - 1U] >= keys[i])
+        {
+            return RET_INVAL;
+        }
+    }
+
+    // Вычисляем количество узлов на всех уровнях.
+    size_t num_leaves = (n + TREE_MAX_KEYS - 1U) / TREE_MAX_KEYS;
+    size_t num_nodes  = 0U;
+    for (size_t level_count = num_leaves; level_count != 0U;
+         level_count = (level_count == 1U)? 0U : (level_count + TREE_MAX_KEYS) / (TREE_MAX_KEYS + 1U))
+    {
+        num_nodes += level_count;
+    }
+
+    // Перевыделяем массив узлов под точное количество узлов.
+    size_t new_capacity = (num_nodes == 0U)? 1U : num_nodes;
+    if (new_capacity > tree->capacity && tree_resize_nodes(tree, new_capacity) != RET_OK)
+    {
+        return RET_NOMEM;
+    }
+
+    tree->num_nodes = num_nodes;
+    tree->size      = n;
+    tree->root_id   = NULL_NODE;
+
+    // Равномерно распределяем пары ключ-значение по листьям.
+    size_t key_i = 0U;
+    for (size_t leaf_id = 0U; leaf_id < num_leaves; ++leaf_id)
+    {
+        TreeNode* leaf = tree_get(tree, leaf_id);
+        memset(leaf, 0, sizeof(TreeNode));
+
+        leaf->parent_id = NULL_NODE;
+        leaf->is_leaf   = true;
+        leaf->num_keys  = n / num_leaves + ((leaf_id < n % num_leaves)? 1U : 0U);
+        leaf->prev_id   = (leaf_id == 0U)? NULL_NODE : leaf_id - 1U;
+        leaf->next_id   = (leaf_id + 1U == num_leaves)? NULL_NODE : leaf_id + 1U;
+
+        memcpy(leaf->keys, &keys[key_i], leaf->num_keys * sizeof(Key_t));
+        memcpy(leaf->values, &values[key_i], leaf->num_keys * sizeof(Value_t));
+
+        key_i += leaf->num_keys;
+    }
+
+    // Строим внутренние уровни, равномерно распределяя узлы нижнего уровня.
+    size_t level_first = 0U;
+    size_t level_count = num_leaves;
+    size_t next_id     = num_leaves;
+
+    while (level_count > 1U)
+    {
+        size_t num_parents = (level_count + TREE_MAX_KEYS) / (TREE_MAX_KEYS + 1U);
+        size_t child_id    = level_first;
+
+        level_first = next_id;
+
+        for (size_t parent_i = 0U; parent_i < num_parents; ++parent_i)
+        {
+            Node_t parent_id = next_id++;
+            TreeNode* parent = tree_get(tree, parent_id);
+            memset(parent, 0, sizeof(TreeNode));
+
+            parent->parent_id = NULL_NODE;
+            parent->is_leaf   = false;
+
+            size_t num_children =
+                level_count / num_parents + ((parent_i < level_count % num_parents)? 1U : 0U);
+            parent->num_keys = num_children - 1U;
+
+            for (size_t child_i = 0U; child_i < num_children; ++child_i, ++child_id)
+            {
+                parent->children[child_i] = child_id;
+                tree_get(tree, child_id)->parent_id = parent_id;
+
+                // Разделяющий ключ - минимальный ключ поддерева.
+                if (child_i != 0U)
+                {
+                    parent->keys[child_i - 1U] =
+                        tree_get(tree, tree_leftmost_leaf(tree, child_id))->keys[0U];
+                }
+            }
+        }
+
+        level_count = num_parents;
+    }
+
+    if (num_leaves != 0U)
+    {
+        tree->root_id = level_first;
+    }
+
+    // Освобождаем лишнюю память (при неудаче остаётся массив большего размера).
+    if (new_capacity < tree->capacity)
+    {
+        tree_resize_nodes(tree, new_capacity);
+    }
+
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_flatten
+// Назначение: Выгружает пары ключ-значение дерева в порядке возрастания ключей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree   (in)  - B+-дерево поиска.
+// keys   (out) - массив ключей размера не менее tree->size.
+// values (out) - массив значений размера не менее tree->size.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Обход выполняется по списку листьев за O(n).
+//==================================================================================================
+RetCode tree_flatten(Tree* tree, Key_t keys[], Value_t values[])
+{
+    if (tree == NULL || (tree->size != 0U && (keys == NULL || values == NULL)))
+    {
+        return RET_INVAL;
+    }
+
+    // Начинаем обход с листа с минимальными ключами.
+    Node_t cur_id = (tree->root_id == NULL_NODE)?
+                    NULL_NODE : tree_leftmost_leaf(tree, tree->root_id);
+
+    for (size_t i = 0U; cur_id != NULL_NODE; )
+    {
+        TreeNode* leaf = tree_get(tree, cur_id);
+
+        memcpy(&keys[i], leaf->keys, leaf->num_keys * sizeof(Key_t));
+        memcpy(&values[i], leaf->values, leaf->num_keys * sizeof(Value_t));
+        i += leaf->num_keys;
+
+        cur_id = leaf->next_id;
+    }
+
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_range_for_each
+// Назначение: Передаёт функции обратного вызова все пары ключ-значение с ключами из отрезка
+// [lo, hi] в порядке возрастания ключей.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree     (in) - B+-дерево поиска.
+// lo       (in) - нижняя граница ключей (включительно).
+// hi       (in) - верхняя граница ключей (включительно).
+// callback (in) - функция обратного вызова.
+// arg      (in) - пользовательский аргумент функции обратного вызова.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Пачкой служит участок листа: функция обратного вызова получает указатели на массивы
+//   ключей и значений листа без копирования.
+// - Спуск по дереву выполняется один раз, затем обход идёт по списку листьев за
+//   O(log n + k).
+// - Функция обратного вызова не должна изменять дерево.
+//==================================================================================================
+RetCode tree_range_for_each(Tree* tree, Key_t lo, Key_t hi, TreeRangeCallback callback, void* arg)
+{
+    if (tree == NULL || callback == NULL)
+    {
+        return RET_INVAL;
+    }
+
+    if (tree->root_id == NULL_NODE || hi < lo)
+    {   // Отрезок не содержит ключей.
+        return RET_OK;
+    }
+
+    uint32_t depth;
+    Node_t leaf_id = tree_search_leaf(tree, lo, &depth);
+
+    // Индекс первого ключа отрезка в текущем листе.
+    uint32_t first_i = tree_node_rank(tree_get(tree, leaf_id), lo, false);
+
+    while (leaf_id != NULL_NODE)
+    {
+        TreeNode* leaf = tree_get(tree, leaf_id);
+
+        // Индекс первого ключа за пределами отрезка.
+        uint32_t last_i = tree_node_rank(leaf, hi, true);
+
+        if (first_i < last_i && !callback(&leaf->keys[first_i], &leaf->values[first_i],
+                                          last_i - first_i, arg))
+        {   // Обход прерван функцией обратного вызова.
+            return RET_OK;
+        }
+
+        if (last_i < leaf->num_keys)
+        {   // Достигнут ключ, больший hi.
+            return RET_OK;
+        }
+
+        leaf_id = leaf->next_id;
+        first_i = 0U;
+    }
+
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_merge
+// Назначение: Добавляет в дерево все пары ключ-значение другого дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree  (in/out) - B+-дерево поиска, в которое добавляются элементы.
+// other (in)     - B+-дерево поиска, элементы которого добавляются.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Оба дерева выгружаются в отсортированные массивы, массивы сливаются, после чего дерево
+//   tree перестраивается функцией tree_build_sorted. Слияние выполняется за O(n + m)
+//   вместо O(m log(n + m)) для вставки элементов по одному.
+// - Для совпадающих ключей сохраняется значение из дерева other (как при вызове tree_set).
+// - Дерево other не изменяется.
+//==================================================================================================
+RetCode tree_merge(Tree* tree, Tree* other)
+{
+    if (tree == NULL || other == NULL || tree == other)
+    {
+        return RET_INVAL;
+    }
+
+    size_t tree_size  = tree->size;
+    size_t other_size = other->size;
+    if (other_size == 0U)
+    {   // Добавлять нечего.
+        return RET_OK;
+    }
+
+    // Элементы дерева tree выгружаются в конец общего массива, а элементы дерева other -
+    // в отдельный массив. Слияние пишет в начало общего массива и не обгоняет чтение.
+    Key_t*   merged_keys   = calloc(tree_size + other_size, sizeof(Key_t));
+    Value_t* merged_values = calloc(tree_size + other_size, sizeof(Value_t));
+    Key_t*   other_keys    = calloc(other_size, sizeof(Key_t));
+    Value_t* other_values  = calloc(other_size, sizeof(Value_t));
+
+    RetCode ret = RET_NOMEM;
+    if (merged_keys != NULL && merged_values != NULL && other_keys != NULL && other_values != NULL)
+    {
+        tree_flatten(tree,  merged_keys + other_size, merged_values + other_size);
+        tree_flatten(other, other_keys, other_values);
+
+        // Индексы чтения из двух отсортированных последовательностей и индекс записи.
+        size_t tree_i  = other_size;
+        size_t other_i = 0U;
+        size_t merged_i = 0U;
+
+        while (tree_i < tree_size + other_size || other_i < other_size)
+        {
+            if (other_i == other_size ||
+                (tree_i < tree_size + other_size && merged_keys[tree_i] < other_keys[other_i]))
+            {   // Следующий ключ берётся из дерева tree.
+                merged_keys[merged_i]   = merged_keys[tree_i];
+                merged_values[merged_i] = merged_values[tree_i];
+                tree_i += 1U;
+            }
+            else
+            {   // Следующий ключ берётся из дерева other, совпадающий ключ дерева tree пропускается.
+                if (tree_i < tree_size + other_size && merged_keys[tree_i] == other_keys[other_i])
+                {
+                    tree_i += 1U;
+                }
+
+                merged_keys[merged_i]   = other_keys[other_i];
+                merged_values[merged_i] = other_values[other_i];
+                other_i += 1U;
+            }
+
+            merged_i += 1U;
+        }
+
+        ret = tree_build_sorted(tree, merged_keys, merged_values, merged_i);
+    }
+
+    free(merged_keys);
+    free(merged_values);
+    free(other_keys);
+    free(other_values);
+
+    return ret;
+}
+
+//==================================================================================================
+// Функция: tree_relayout
+// Назначение: Перенумеровывает узлы дерева так, чтобы порядок узлов в памяти соответствовал
+// структуре дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree   (in/out) - B+-дерево поиска.
+// layout (in)     - порядок размещения узлов.
+//
+// Возвращаемое значение:
+// Код возврата.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Разделения и объединения узлов размещают новые узлы в конце массива, а функция
+//   tree_node_free переносит последний узел на место удалённого. После перенумерации узлы
+//   верхних уровней (TREE_LAYOUT_BFS) или близкие поддеревья (TREE_LAYOUT_VEB) лежат рядом,
+//   а листья - в порядке возрастания ключей.
+// - Перенумерация выполняется за O(n) с временным выделением памяти под копию массива узлов.
+// - Все ранее полученные идентификаторы узлов становятся недействительными.
+// - В случае нехватки памяти возвращается RET_NOMEM, дерево не изменяется.
+//==================================================================================================
+RetCode tree_relayout(Tree* tree, TreeLayout layout)
+{
+    if (tree == NULL || (layout != TREE_LAYOUT_BFS && layout != TREE_LAYOUT_VEB))
+    {
+        return RET_INVAL;
+    }
+
+    if (tree->num_nodes == 0U)
+    {   // Пустое дерево не требует перенумерации.
+        return RET_OK;
+    }
+
+    // Идентификаторы узлов в новом порядке: order[новый идентификатор] = старый идентификатор.
+    Node_t* order = calloc(tree->num_nodes, sizeof(Node_t));
+    // Отображение старых идентификаторов в новые.
+    Node_t* new_ids = calloc(tree->num_nodes, sizeof(Node_t));
+    // Новый массив узлов.
+    void* new_nodes = NULL;
+    if (posix_memalign(&new_nodes, TREE_CACHE_LINE_SIZE, tree->capacity * sizeof(TreeNode)) != 0)
+    {
+        new_nodes = NULL;
+    }
+
+    if (order == NULL || new_ids == NULL || new_nodes == NULL)
+    {
+        free(order);
+        free(new_ids);
+        free(new_nodes);
+
+        return RET_NOMEM;
+    }
+
+    // Вычисляем новый порядок узлов.
+    if (layout == TREE_LAYOUT_BFS)
+    {
+        tree_layout_bfs(tree, order);
+    }
+    else
+    {
+        size_t count = 0U;
+        tree_layout_veb(tree, tree->root_id, tree_depth(tree, tree->root_id), order, &count);
+    }
+
+    for (size_t new_id = 0U; new_id < tree->num_nodes; ++new_id)
+    {
+        new_ids[order[new_id]] = new_id;
+    }
+
+    // Копируем узлы в новом порядке с перенумерацией связей.
+    for (size_t new_id = 0U; new_id < tree->num_nodes; ++new_id)
+    {
+        TreeNode* node = &((TreeNode*) new_nodes)[new_id];
+        *node = *tree_get(tree, order[new_id]);
+
+        node->parent_id = (node->parent_id == NULL_NODE)? NULL_NODE : new_ids[node->parent_id];
+
+        if (node->is_leaf)
+        {
+            node->prev_id = (node->prev_id == NULL_NODE)? NULL_NODE : new_ids[node->prev_id];
+            node->next_id = (node->next_id == NULL_NODE)? NULL_NODE : new_ids[node->next_id];
+        }
+        else
+        {
+            for (uint32_t child_i = 0U; child_i <= node->num_keys; ++child_i)
+            {
+                node->children[child_i] = new_ids[node->children[child_i]];
+            }
+        }
+    }
+
+    tree->root_id = new_ids[tree->root_id];
+
+    free(tree->nodes);
+    tree->nodes = new_nodes;
+
+    free(order);
+    free(new_ids);
+
+    return RET_OK;
+}
+
+//==================================================================================================
+// Функция: tree_fragmentation
+// Назначение: Оценивает рассогласованность порядка узлов в памяти и структуры дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in) - B+-дерево поиска.
+//
+// Возвращаемое значение:
+// Доля связей от узла к дочернему узлу и от листа к следующему листу, ведущих в другую
+// страницу памяти (от 0 до 1).
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Узел B+-дерева занимает несколько кеш-линий, поэтому любая связь ведёт в другую
+//   кеш-линию. Рассогласованность оценивается по страницам (см. TREE_PAGE_SIZE), от которых
+//   зависят промахи TLB и работа аппаратной предвыборки при обходе листьев.
+// - Вычисляется за O(n) и может использоваться для решения о вызове tree_relayout.
+//==================================================================================================
+double tree_fragmentation(Tree* tree)
+{
+    // Количество связей между узлами.
+    size_t num_links = 0U;
+    // Количество связей, ведущих в другую страницу.
+    size_t num_crossing = 0U;
+
+    for (size_t node_id = 0U; node_id < tree->num_nodes; ++node_id)
+    {
+        TreeNode* node = tree_get(tree, node_id);
+
+        // Страница узла.
+        size_t page = node_id * sizeof(TreeNode) / TREE_PAGE_SIZE;
+
+        // Дочерние узлы внутреннего узла или следующий лист.
+        uint32_t num_targets = node->is_leaf? 1U : (node->num_keys + 1U);
+        for (uint32_t target_i = 0U; target_i < num_targets; ++target_i)
+        {
+            Node_t target_id = node->is_leaf? node->next_id : node->children[target_i];
+            if (target_id == NULL_NODE)
+            {
+                continue;
+            }
+
+            num_links += 1U;
+            if (target_id * sizeof(TreeNode) / TREE_PAGE_SIZE != page)
+            {
+                num_crossing += 1U;
+            }
+        }
+    }
+
+    return (num_links == 0U)? 0.0 : (double) num_crossing / num_links;
+}
+
+//==================================================================================================
+// Функция: tree_check
+// Назначение: Проверяет инварианты B+-дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in) - B+-дерево поиска.
+//
+// Возвращаемое значение:
+// Флаг корректности дерева.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// - Проверяются связи узлов с родителями, строгое возрастание ключей в узлах, соответствие
+//   ключей поддеревьев разделяющим ключам, заполненность узлов, одинаковая глубина листьев,
+//   соответствие количества узлов полю num_nodes, а также связность списка листьев и
+//   соответствие количества ключей в нём полю size.
+//==================================================================================================
+bool tree_check(Tree* tree)
+{
+    if (tree->root_id == NULL_NODE)
+    {
+        return tree->size == 0U && tree->num_nodes == 0U;
+    }
+
+    // Количество узлов, пройденных при обходе.
+    size_t num_visited = 0U;
+    if (tree_check_recursive(tree, tree->root_id, NULL_NODE, NULL, NULL, &num_visited) < 0 ||
+        num_visited != tree->num_nodes)
+    {
+        return false;
+    }
+
+    // Количество ключей в списке листьев.
+    size_t count = 0U;
+
+    Node_t prev_id = NULL_NODE;
+    Node_t cur_id  = tree_leftmost_leaf(tree, tree->root_id);
+    while (cur_id != NULL_NODE && count <= tree->size)
+    {
+        TreeNode* leaf = tree_get(tree, cur_id);
+        if (!leaf->is_leaf || leaf->prev_id != prev_id)
+        {
+            return false;
+        }
+
+        if (prev_id != NULL_NODE)
+        {
+            TreeNode* prev = tree_get(tree, prev_id);
+            if (prev->keys[prev->num_keys - 1U] >= leaf->keys[0U])
+            {
+                return false;
+            }
+        }
+
+        count += leaf->num_keys;
+
+        prev_id = cur_id;
+        cur_id  = leaf->next_id;
+    }
+
+    return count == tree->size;
+}
+
+//==================================================================================================
+// Функция: tree_print
+// Назначение: Производит печать B+-дерева.
+//--------------------------------------------------------------------------------------------------
+// Параметры:
+// tree (in) - B+-дерево.
+//
+// Возвращаемое значение:
+// отсутствует.
+//
+// Используемые внешние переменные:
+// отсутствуют
+//
+// Примечания:
+// отсутствуют
+//==================================================================================================
+void tree_print(Tree* tree)
+{
+    if (tree->root_id != NULL_NODE)
+    {
+        tree_print_recursive(tree, tree->root_id, 0U);
+    }
+}
+
+#endif // HEADER_GUARD_TREE_BPLUS_H_INCLUDED